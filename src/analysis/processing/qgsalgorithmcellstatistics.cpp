@@ -257,44 +257,15 @@ bool QgsCellStatisticsAlgorithm::prepareSpecificAlgorithmParameters( const QVari
 
 void QgsCellStatisticsAlgorithm::processRasterStack( QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int>( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-  mOutputRasterDataProvider->setEditable( true );
-  QgsRasterIterator outputIter( mOutputRasterDataProvider );
-  outputIter.startRasterRead( 1, mLayerWidth, mLayerHeight, mExtent );
-
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  QgsRectangle blockExtent;
-  std::unique_ptr< QgsRasterBlock > outputBlock;
-  while ( outputIter.readNextRasterPart( 1, iterCols, iterRows, outputBlock, iterLeft, iterTop, &blockExtent ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( QgsRasterAnalysisUtils::rasterBlockInputs( mInputs ), mOutputRasterDataProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    std::vector< std::unique_ptr< QgsRasterBlock > > inputBlocks;
-    for ( const QgsRasterAnalysisUtils::RasterLogicInput &i : std::as_const( mInputs ) )
-    {
-      if ( feedback->isCanceled() )
-        break; //in case some slow data sources are loaded
-      for ( int band : i.bands )
-      {
-        if ( feedback->isCanceled() )
-          break; //in case some slow data sources are loaded
-        std::unique_ptr< QgsRasterBlock > b( i.interface->block( band, blockExtent, iterCols, iterRows ) );
-        inputBlocks.emplace_back( std::move( b ) );
-      }
-    }
-
-    feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    for ( int row = 0; row < iterRows; row++ )
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback->isCanceled() )
         break;
 
-      for ( int col = 0; col < iterCols; col++ )
+      for ( int col = 0; col < outputBlock->width(); col++ )
       {
         double result = 0;
         bool noDataInStack = false;
@@ -362,9 +333,7 @@ void QgsCellStatisticsAlgorithm::processRasterStack( QgsProcessingFeedback *feed
         }
       }
     }
-    mOutputRasterDataProvider->writeBlock( outputBlock.get(), 1, iterLeft, iterTop );
-  }
-  mOutputRasterDataProvider->setEditable( false );
+  } );
 }
 
 //
@@ -434,44 +403,15 @@ bool QgsCellStatisticsPercentileAlgorithm::prepareSpecificAlgorithmParameters( c
 void QgsCellStatisticsPercentileAlgorithm::processRasterStack( QgsProcessingFeedback *feedback )
 {
 
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int>( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-  mOutputRasterDataProvider->setEditable( true );
-  QgsRasterIterator outputIter( mOutputRasterDataProvider );
-  outputIter.startRasterRead( 1, mLayerWidth, mLayerHeight, mExtent );
-
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  QgsRectangle blockExtent;
-  std::unique_ptr< QgsRasterBlock > outputBlock;
-  while ( outputIter.readNextRasterPart( 1, iterCols, iterRows, outputBlock, iterLeft, iterTop, &blockExtent ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( QgsRasterAnalysisUtils::rasterBlockInputs( mInputs ), mOutputRasterDataProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    std::vector< std::unique_ptr< QgsRasterBlock > > inputBlocks;
-    for ( const QgsRasterAnalysisUtils::RasterLogicInput &i : std::as_const( mInputs ) )
-    {
-      if ( feedback->isCanceled() )
-        break; //in case some slow data sources are loaded
-      for ( int band : i.bands )
-      {
-        if ( feedback->isCanceled() )
-          break; //in case some slow data sources are loaded
-        std::unique_ptr< QgsRasterBlock > b( i.interface->block( band, blockExtent, iterCols, iterRows ) );
-        inputBlocks.emplace_back( std::move( b ) );
-      }
-    }
-
-    feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    for ( int row = 0; row < iterRows; row++ )
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback->isCanceled() )
         break;
 
-      for ( int col = 0; col < iterCols; col++ )
+      for ( int col = 0; col < outputBlock->width(); col++ )
       {
         double result = 0;
         bool noDataInStack = false;
@@ -505,9 +445,7 @@ void QgsCellStatisticsPercentileAlgorithm::processRasterStack( QgsProcessingFeed
         }
       }
     }
-    mOutputRasterDataProvider->writeBlock( outputBlock.get(), 1, iterLeft, iterTop );
-  }
-  mOutputRasterDataProvider->setEditable( false );
+  } );
 }
 
 //
@@ -572,44 +510,15 @@ bool QgsCellStatisticsPercentRankFromValueAlgorithm::prepareSpecificAlgorithmPar
 void QgsCellStatisticsPercentRankFromValueAlgorithm::processRasterStack( QgsProcessingFeedback *feedback )
 {
 
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int>( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-  mOutputRasterDataProvider->setEditable( true );
-  QgsRasterIterator outputIter( mOutputRasterDataProvider );
-  outputIter.startRasterRead( 1, mLayerWidth, mLayerHeight, mExtent );
-
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  QgsRectangle blockExtent;
-  std::unique_ptr< QgsRasterBlock > outputBlock;
-  while ( outputIter.readNextRasterPart( 1, iterCols, iterRows, outputBlock, iterLeft, iterTop, &blockExtent ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( QgsRasterAnalysisUtils::rasterBlockInputs( mInputs ), mOutputRasterDataProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    std::vector< std::unique_ptr< QgsRasterBlock > > inputBlocks;
-    for ( const QgsRasterAnalysisUtils::RasterLogicInput &i : std::as_const( mInputs ) )
-    {
-      if ( feedback->isCanceled() )
-        break; //in case some slow data sources are loaded
-      for ( int band : i.bands )
-      {
-        if ( feedback->isCanceled() )
-          break; //in case some slow data sources are loaded
-        std::unique_ptr< QgsRasterBlock > b( i.interface->block( band, blockExtent, iterCols, iterRows ) );
-        inputBlocks.emplace_back( std::move( b ) );
-      }
-    }
-
-    feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    for ( int row = 0; row < iterRows; row++ )
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback->isCanceled() )
         break;
 
-      for ( int col = 0; col < iterCols; col++ )
+      for ( int col = 0; col < outputBlock->width(); col++ )
       {
         double result = 0;
         bool noDataInStack = false;
@@ -640,9 +549,7 @@ void QgsCellStatisticsPercentRankFromValueAlgorithm::processRasterStack( QgsProc
         }
       }
     }
-    mOutputRasterDataProvider->writeBlock( outputBlock.get(), 1, iterLeft, iterTop );
-  }
-  mOutputRasterDataProvider->setEditable( false );
+  } );
 }
 
 
@@ -715,46 +622,25 @@ bool QgsCellStatisticsPercentRankFromRasterAlgorithm::prepareSpecificAlgorithmPa
 
 void QgsCellStatisticsPercentRankFromRasterAlgorithm::processRasterStack( QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int>( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-  mOutputRasterDataProvider->setEditable( true );
-  QgsRasterIterator outputIter( mOutputRasterDataProvider );
-  outputIter.startRasterRead( 1, mLayerWidth, mLayerHeight, mExtent );
-
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  QgsRectangle blockExtent;
-  std::unique_ptr< QgsRasterBlock > outputBlock;
-  while ( outputIter.readNextRasterPart( 1, iterCols, iterRows, outputBlock, iterLeft, iterTop, &blockExtent ) )
-  {
-    std::unique_ptr< QgsRasterBlock > valueBlock( mValueRasterInterface->block( mValueRasterBand, blockExtent, iterCols, iterRows ) );
+  // the value raster is read as the last input
+  std::vector< QgsRasterAnalysisUtils::RasterBlockInput > inputs = QgsRasterAnalysisUtils::rasterBlockInputs( mInputs );
+  QgsRasterAnalysisUtils::RasterBlockInput valueInput;
+  valueInput.interface = mValueRasterInterface.get();
+  valueInput.band = mValueRasterBand;
+  inputs.emplace_back( valueInput );
 
-    std::vector< std::unique_ptr< QgsRasterBlock > > inputBlocks;
-    for ( const QgsRasterAnalysisUtils::RasterLogicInput &i : std::as_const( mInputs ) )
-    {
-      if ( feedback->isCanceled() )
-        break; //in case some slow data sources are loaded
-      for ( int band : i.bands )
-      {
-        if ( feedback->isCanceled() )
-          break; //in case some slow data sources are loaded
-        std::unique_ptr< QgsRasterBlock > b( i.interface->block( band, blockExtent, iterCols, iterRows ) );
-        inputBlocks.emplace_back( std::move( b ) );
-      }
-    }
+  QgsRasterAnalysisUtils::processRasterBlocks( inputs, mOutputRasterDataProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
+  {
+    std::unique_ptr< QgsRasterBlock > valueBlock = std::move( inputBlocks.back() );
+    inputBlocks.pop_back();
 
-    feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    for ( int row = 0; row < iterRows; row++ )
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback->isCanceled() )
         break;
 
-      for ( int col = 0; col < iterCols; col++ )
+      for ( int col = 0; col < outputBlock->width(); col++ )
       {
         bool percentRankValueIsNoData = false;
         double percentRankValue = valueBlock->valueAndNoData( row, col, percentRankValueIsNoData );
@@ -788,9 +674,7 @@ void QgsCellStatisticsPercentRankFromRasterAlgorithm::processRasterStack( QgsPro
         }
       }
     }
-    mOutputRasterDataProvider->writeBlock( outputBlock.get(), 1, iterLeft, iterTop );
-  }
-  mOutputRasterDataProvider->setEditable( false );
+  } );
 }
 
 ///@endcond
@@ -83,6 +83,10 @@ void QgsDifferenceAlgorithm::initAlgorithm( const QVariantMap & )
   addParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "INPUT" ), QObject::tr( "Input layer" ) ) );
   addParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "OVERLAY" ), QObject::tr( "Overlay layer" ) ) );
   addParameter( new QgsProcessingParameterFeatureSink( QStringLiteral( "OUTPUT" ), QObject::tr( "Difference" ) ) );
+
+  std::unique_ptr< QgsProcessingParameterBoolean > parallel = std::make_unique< QgsProcessingParameterBoolean >( QStringLiteral( "PARALLEL" ), QObject::tr( "Process features in parallel" ), false, true );
+  parallel->setFlags( parallel->flags() | QgsProcessingParameterDefinition::FlagAdvanced );
+  addParameter( parallel.release() );
 }
 
 
@@ -106,9 +110,10 @@ QVariantMap QgsDifferenceAlgorithm::processAlgorithm( const QVariantMap &paramet
   QVariantMap outputs;
   outputs.insert( QStringLiteral( "OUTPUT" ), dest );
 
+  const bool parallel = parameterAsBoolean( parameters, QStringLiteral( "PARALLEL" ), context );
   int count = 0;
   int total = sourceA->featureCount();
-  QgsOverlayUtils::difference( *sourceA, *sourceB, *sink, context, feedback, count, total, QgsOverlayUtils::OutputA );
+  QgsOverlayUtils::difference( *sourceA, *sourceB, *sink, context, feedback, count, total, QgsOverlayUtils::OutputA, parallel );
 
   return outputs;
 }
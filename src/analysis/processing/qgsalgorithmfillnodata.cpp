@@ -142,16 +142,17 @@ QVariantMap QgsFillNoDataAlgorithm::processAlgorithm( const QVariantMap &paramet
       continue;
     }
 
-    for ( int row = 0; row < iterRows; row++ )
+    filledRasterBlock->visitView( [this]( auto view )
     {
-      if ( feedback && feedback->isCanceled() )
-        break;
-      for ( int column = 0; column < iterCols; column++ )
+      typedef typename decltype( view )::ValueType ValueType;
+      const ValueType fillValue = static_cast< ValueType >( mFillValue );
+      const qgssize count = view.count();
+      for ( qgssize i = 0; i < count; ++i )
       {
-        if ( filledRasterBlock->isNoData( row, column ) )
-          filledRasterBlock->setValue( row, column, mFillValue );
+        if ( view.isNoDataValue( view[i] ) )
+          view[i] = fillValue;
       }
-    }
+    } );
     destinationRasterProvider->writeBlock( filledRasterBlock.get(), mBand, iterLeft, iterTop );
   }
   destinationRasterProvider->setEditable( false );
@@ -17,6 +17,7 @@
 
 #include "qgsalgorithmfuzzifyraster.h"
 #include "qgsrasterfilewriter.h"
+#include "qgsrasteranalysisutils.h"
 #include "qgsstringutils.h"
 
 ///@cond PRIVATE
@@ -95,7 +96,6 @@ QVariantMap QgsFuzzifyRasterAlgorithmBase::processAlgorithm( const QVariantMap &
 
   provider->setNoDataValue( 1, mNoDataValue );
   mDestinationRasterProvider = provider.get();
-  mDestinationRasterProvider->setEditable( true );
   qgssize layerSize = static_cast< qgssize >( mLayerWidth ) * static_cast< qgssize >( mLayerHeight );
 
   fuzzify( feedback );
@@ -167,31 +167,16 @@ bool QgsFuzzifyRasterLinearMembershipAlgorithm::prepareAlgorithmFuzzificationPar
 
 void QgsFuzzifyRasterLinearMembershipAlgorithm::fuzzify( QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-
-  QgsRasterIterator iter( mInterface.get() );
-  iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  bool isNoData = false;
-  std::unique_ptr< QgsRasterBlock > rasterBlock;
-  while ( iter.readNextRasterPart( mBand, iterCols, iterRows, rasterBlock, iterLeft, iterTop ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( { { mInterface.get(), mBand } }, mDestinationRasterProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    if ( feedback )
-      feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    std::unique_ptr< QgsRasterBlock > fuzzifiedBlock = std::make_unique< QgsRasterBlock >( mDestinationRasterProvider->dataType( 1 ), iterCols, iterRows );
-
-    for ( int row = 0; row < iterRows; row++ )
+    const std::unique_ptr< QgsRasterBlock > &rasterBlock = inputBlocks.front();
+    bool isNoData = false;
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback && feedback->isCanceled() )
         break;
-      for ( int column = 0; column < iterCols; column++ )
+      for ( int column = 0; column < outputBlock->width(); column++ )
       {
         if ( feedback && feedback->isCanceled() )
           break;
@@ -226,12 +211,10 @@ void QgsFuzzifyRasterLinearMembershipAlgorithm::fuzzify( QgsProcessingFeedback *
           throw QgsProcessingException( QObject::tr( "Please choose varying values for the high and low membership parameters" ) );
         }
 
-        fuzzifiedBlock->setValue( row, column, fuzzifiedValue );
+        outputBlock->setValue( row, column, fuzzifiedValue );
       }
     }
-    mDestinationRasterProvider->writeBlock( fuzzifiedBlock.get(), mBand, iterLeft, iterTop );
-  }
-  mDestinationRasterProvider->setEditable( false );
+  } );
 }
 
 
@@ -294,31 +277,16 @@ bool QgsFuzzifyRasterPowerMembershipAlgorithm::prepareAlgorithmFuzzificationPara
 
 void QgsFuzzifyRasterPowerMembershipAlgorithm::fuzzify( QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-
-  QgsRasterIterator iter( mInterface.get() );
-  iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  bool isNoData = false;
-  std::unique_ptr< QgsRasterBlock > rasterBlock;
-  while ( iter.readNextRasterPart( mBand, iterCols, iterRows, rasterBlock, iterLeft, iterTop ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( { { mInterface.get(), mBand } }, mDestinationRasterProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    if ( feedback )
-      feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    std::unique_ptr< QgsRasterBlock > fuzzifiedBlock = std::make_unique< QgsRasterBlock >( mDestinationRasterProvider->dataType( 1 ), iterCols, iterRows );
-
-    for ( int row = 0; row < iterRows; row++ )
+    const std::unique_ptr< QgsRasterBlock > &rasterBlock = inputBlocks.front();
+    bool isNoData = false;
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback && feedback->isCanceled() )
         break;
-      for ( int column = 0; column < iterCols; column++ )
+      for ( int column = 0; column < outputBlock->width(); column++ )
       {
         if ( feedback && feedback->isCanceled() )
           break;
@@ -353,12 +321,10 @@ void QgsFuzzifyRasterPowerMembershipAlgorithm::fuzzify( QgsProcessingFeedback *f
           throw QgsProcessingException( QObject::tr( "Please choose varying values for the high and low membership parameters" ) );
         }
 
-        fuzzifiedBlock->setValue( row, column, fuzzifiedValue );
+        outputBlock->setValue( row, column, fuzzifiedValue );
       }
     }
-    mDestinationRasterProvider->writeBlock( fuzzifiedBlock.get(), mBand, iterLeft, iterTop );
-  }
-  mDestinationRasterProvider->setEditable( false );
+  } );
 }
 
 //
@@ -416,31 +382,16 @@ bool QgsFuzzifyRasterLargeMembershipAlgorithm::prepareAlgorithmFuzzificationPara
 
 void QgsFuzzifyRasterLargeMembershipAlgorithm::fuzzify( QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-
-  QgsRasterIterator iter( mInterface.get() );
-  iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  bool isNoData = false;
-  std::unique_ptr< QgsRasterBlock > rasterBlock;
-  while ( iter.readNextRasterPart( mBand, iterCols, iterRows, rasterBlock, iterLeft, iterTop ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( { { mInterface.get(), mBand } }, mDestinationRasterProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    if ( feedback )
-      feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    std::unique_ptr< QgsRasterBlock > fuzzifiedBlock = std::make_unique< QgsRasterBlock >( mDestinationRasterProvider->dataType( 1 ), iterCols, iterRows );
-
-    for ( int row = 0; row < iterRows; row++ )
+    const std::unique_ptr< QgsRasterBlock > &rasterBlock = inputBlocks.front();
+    bool isNoData = false;
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback && feedback->isCanceled() )
         break;
-      for ( int column = 0; column < iterCols; column++ )
+      for ( int column = 0; column < outputBlock->width(); column++ )
       {
         if ( feedback && feedback->isCanceled() )
           break;
@@ -457,12 +408,10 @@ void QgsFuzzifyRasterLargeMembershipAlgorithm::fuzzify( QgsProcessingFeedback *f
           fuzzifiedValue = 1 / ( 1 + std::pow( value / mFuzzifyMidpoint, -mFuzzifySpread ) );
         }
 
-        fuzzifiedBlock->setValue( row, column, fuzzifiedValue );
+        outputBlock->setValue( row, column, fuzzifiedValue );
       }
     }
-    mDestinationRasterProvider->writeBlock( fuzzifiedBlock.get(), mBand, iterLeft, iterTop );
-  }
-  mDestinationRasterProvider->setEditable( false );
+  } );
 }
 
 
@@ -521,31 +470,16 @@ bool QgsFuzzifyRasterSmallMembershipAlgorithm::prepareAlgorithmFuzzificationPara
 
 void QgsFuzzifyRasterSmallMembershipAlgorithm::fuzzify( QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-
-  QgsRasterIterator iter( mInterface.get() );
-  iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  bool isNoData = false;
-  std::unique_ptr< QgsRasterBlock > rasterBlock;
-  while ( iter.readNextRasterPart( mBand, iterCols, iterRows, rasterBlock, iterLeft, iterTop ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( { { mInterface.get(), mBand } }, mDestinationRasterProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    if ( feedback )
-      feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    std::unique_ptr< QgsRasterBlock > fuzzifiedBlock = std::make_unique< QgsRasterBlock >( mDestinationRasterProvider->dataType( 1 ), iterCols, iterRows );
-
-    for ( int row = 0; row < iterRows; row++ )
+    const std::unique_ptr< QgsRasterBlock > &rasterBlock = inputBlocks.front();
+    bool isNoData = false;
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback && feedback->isCanceled() )
         break;
-      for ( int column = 0; column < iterCols; column++ )
+      for ( int column = 0; column < outputBlock->width(); column++ )
       {
         if ( feedback && feedback->isCanceled() )
           break;
@@ -562,12 +496,10 @@ void QgsFuzzifyRasterSmallMembershipAlgorithm::fuzzify( QgsProcessingFeedback *f
           fuzzifiedValue = 1 / ( 1 + std::pow( value / mFuzzifyMidpoint, mFuzzifySpread ) );
         }
 
-        fuzzifiedBlock->setValue( row, column, fuzzifiedValue );
+        outputBlock->setValue( row, column, fuzzifiedValue );
       }
     }
-    mDestinationRasterProvider->writeBlock( fuzzifiedBlock.get(), mBand, iterLeft, iterTop );
-  }
-  mDestinationRasterProvider->setEditable( false );
+  } );
 }
 
 
@@ -626,31 +558,16 @@ bool QgsFuzzifyRasterGaussianMembershipAlgorithm::prepareAlgorithmFuzzificationP
 
 void QgsFuzzifyRasterGaussianMembershipAlgorithm::fuzzify( QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-
-  QgsRasterIterator iter( mInterface.get() );
-  iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  bool isNoData = false;
-  std::unique_ptr< QgsRasterBlock > rasterBlock;
-  while ( iter.readNextRasterPart( mBand, iterCols, iterRows, rasterBlock, iterLeft, iterTop ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( { { mInterface.get(), mBand } }, mDestinationRasterProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    if ( feedback )
-      feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    std::unique_ptr< QgsRasterBlock > fuzzifiedBlock = std::make_unique< QgsRasterBlock >( mDestinationRasterProvider->dataType( 1 ), iterCols, iterRows );
-
-    for ( int row = 0; row < iterRows; row++ )
+    const std::unique_ptr< QgsRasterBlock > &rasterBlock = inputBlocks.front();
+    bool isNoData = false;
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback && feedback->isCanceled() )
         break;
-      for ( int column = 0; column < iterCols; column++ )
+      for ( int column = 0; column < outputBlock->width(); column++ )
       {
         if ( feedback && feedback->isCanceled() )
           break;
@@ -667,12 +584,10 @@ void QgsFuzzifyRasterGaussianMembershipAlgorithm::fuzzify( QgsProcessingFeedback
           fuzzifiedValue = std::exp( -mFuzzifySpread * std::pow( value - mFuzzifyMidpoint, 2 ) );
         }
 
-        fuzzifiedBlock->setValue( row, column, fuzzifiedValue );
+        outputBlock->setValue( row, column, fuzzifiedValue );
       }
     }
-    mDestinationRasterProvider->writeBlock( fuzzifiedBlock.get(), mBand, iterLeft, iterTop );
-  }
-  mDestinationRasterProvider->setEditable( false );
+  } );
 }
 
 
@@ -732,31 +647,16 @@ bool QgsFuzzifyRasterNearMembershipAlgorithm::prepareAlgorithmFuzzificationParam
 
 void QgsFuzzifyRasterNearMembershipAlgorithm::fuzzify( QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-
-  QgsRasterIterator iter( mInterface.get() );
-  iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  bool isNoData = false;
-  std::unique_ptr< QgsRasterBlock > rasterBlock;
-  while ( iter.readNextRasterPart( mBand, iterCols, iterRows, rasterBlock, iterLeft, iterTop ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( { { mInterface.get(), mBand } }, mDestinationRasterProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    if ( feedback )
-      feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    std::unique_ptr< QgsRasterBlock > fuzzifiedBlock = std::make_unique< QgsRasterBlock >( mDestinationRasterProvider->dataType( 1 ), iterCols, iterRows );
-
-    for ( int row = 0; row < iterRows; row++ )
+    const std::unique_ptr< QgsRasterBlock > &rasterBlock = inputBlocks.front();
+    bool isNoData = false;
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback && feedback->isCanceled() )
         break;
-      for ( int column = 0; column < iterCols; column++ )
+      for ( int column = 0; column < outputBlock->width(); column++ )
       {
         if ( feedback && feedback->isCanceled() )
           break;
@@ -773,12 +673,10 @@ void QgsFuzzifyRasterNearMembershipAlgorithm::fuzzify( QgsProcessingFeedback *fe
           fuzzifiedValue = 1 / ( 1 + mFuzzifySpread * std::pow( value - mFuzzifyMidpoint, 2 ) );
         }
 
-        fuzzifiedBlock->setValue( row, column, fuzzifiedValue );
+        outputBlock->setValue( row, column, fuzzifiedValue );
       }
     }
-    mDestinationRasterProvider->writeBlock( fuzzifiedBlock.get(), mBand, iterLeft, iterTop );
-  }
-  mDestinationRasterProvider->setEditable( false );
+  } );
 }
 
 
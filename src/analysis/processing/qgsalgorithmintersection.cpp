@@ -74,6 +74,10 @@ void QgsIntersectionAlgorithm::initAlgorithm( const QVariantMap & )
 
   addParameter( new QgsProcessingParameterFeatureSink( QStringLiteral( "OUTPUT" ), QObject::tr( "Intersection" ) ) );
 
+  std::unique_ptr< QgsProcessingParameterBoolean > parallel = std::make_unique< QgsProcessingParameterBoolean >( QStringLiteral( "PARALLEL" ), QObject::tr( "Process features in parallel" ), false, true );
+  parallel->setFlags( parallel->flags() | QgsProcessingParameterDefinition::FlagAdvanced );
+  addParameter( parallel.release() );
+
 }
 
 
@@ -109,10 +113,11 @@ QVariantMap QgsIntersectionAlgorithm::processAlgorithm( const QVariantMap &param
   QVariantMap outputs;
   outputs.insert( QStringLiteral( "OUTPUT" ), dest );
 
+  const bool parallel = parameterAsBoolean( parameters, QStringLiteral( "PARALLEL" ), context );
   int count = 0;
   int total = sourceA->featureCount();
 
-  QgsOverlayUtils::intersection( *sourceA, *sourceB, *sink, context, feedback, count, total, fieldIndicesA, fieldIndicesB );
+  QgsOverlayUtils::intersection( *sourceA, *sourceB, *sink, context, feedback, count, total, fieldIndicesA, fieldIndicesB, parallel );
 
   return outputs;
 }
@@ -22,9 +22,19 @@
 #include "qgsapplication.h"
 #include "qgsfeature.h"
 #include "qgsfeaturesource.h"
+#include "qgsspatialindexpackedrtree.h"
+
+#include <QCache>
+#include <QtConcurrent>
 
 ///@cond PRIVATE
 
+//! Maximum number of prepared join geometries kept by each task of the parallel join
+static const int MAX_PREPARED_ENGINES_PER_WORKER = 1000;
+
+// the join gets its own pool, so that it does not compete with rendering or other tasks for the global pool
+Q_GLOBAL_STATIC( QThreadPool, sJoinByLocationPool )
+
 
 void QgsJoinByLocationAlgorithm::initAlgorithm( const QVariantMap & )
 {
@@ -69,6 +79,11 @@ void QgsJoinByLocationAlgorithm::initAlgorithm( const QVariantMap & )
   addParameter( new QgsProcessingParameterFeatureSink( QStringLiteral( "OUTPUT" ), QObject::tr( "Joined layer" ), QgsProcessing::TypeVectorAnyGeometry, QVariant(), true, true ) );
   addParameter( new QgsProcessingParameterFeatureSink( QStringLiteral( "NON_MATCHING" ), QObject::tr( "Unjoinable features from first layer" ), QgsProcessing::TypeVectorAnyGeometry, QVariant(), true, false ) );
   addOutput( new QgsProcessingOutputNumber( QStringLiteral( "JOINED_COUNT" ), QObject::tr( "Number of joined features from input table" ) ) );
+
+  std::unique_ptr< QgsProcessingParameterBoolean > parallelParam = std::make_unique< QgsProcessingParameterBoolean >( QStringLiteral( "PARALLEL" ),
+      QObject::tr( "Evaluate spatial predicates in parallel" ), false, true );
+  parallelParam->setFlags( parallelParam->flags() | QgsProcessingParameterDefinition::FlagAdvanced );
+  addParameter( parallelParam.release() );
 }
 
 QString QgsJoinByLocationAlgorithm::name() const
@@ -102,7 +117,10 @@ QString QgsJoinByLocationAlgorithm::shortHelpString() const
                       "that is an extended version of the input one, with additional attributes in its attribute table.\n\n"
                       "The additional attributes and their values are taken from a second vector layer. "
                       "A spatial criteria is applied to select the values from the second layer that are added "
-                      "to each feature from the first layer in the resulting one." );
+                      "to each feature from the first layer in the resulting one.\n\n"
+                      "If the parallel option is checked, the join layer is loaded into memory and the spatial "
+                      "criteria are evaluated on multiple threads. Features are written in the order of the input layer, "
+                      "and where a single match is taken the first match is the first matching feature from the join layer." );
 }
 
 QString QgsJoinByLocationAlgorithm::shortDescription() const
@@ -180,32 +198,41 @@ QVariantMap QgsJoinByLocationAlgorithm::processAlgorithm( const QVariantMap &par
   if ( parameters.value( QStringLiteral( "NON_MATCHING" ) ).isValid() && !mUnjoinedFeatures )
     throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "NON_MATCHING" ) ) );
 
-  switch ( mJoinMethod )
+  mParallel = parameterAsBoolean( parameters, QStringLiteral( "PARALLEL" ), context );
+
+  if ( mParallel )
   {
-    case OneToMany:
-    case JoinToFirst:
+    processAlgorithmInParallel( context, feedback );
+  }
+  else
+  {
+    switch ( mJoinMethod )
     {
-      if ( mBaseSource->featureCount() > 0 && mJoinSource->featureCount() > 0 && mBaseSource->featureCount() < mJoinSource->featureCount() )
-      {
-        // joining FEWER features to a layer with MORE features. So we iterate over the FEW features and find matches from the MANY
-        processAlgorithmByIteratingOverInputSource( context, feedback );
-      }
-      else
+      case OneToMany:
+      case JoinToFirst:
       {
-        // default -- iterate over the join source and match back to the base source. We do this on the assumption that the most common
-        // use case is joining a points layer to a polygon layer (taking polygon attributes and adding them to the points), so by iterating
-        // over the polygons we can take advantage of prepared geometries for the spatial relationship test.
+        if ( mBaseSource->featureCount() > 0 && mJoinSource->featureCount() > 0 && mBaseSource->featureCount() < mJoinSource->featureCount() )
+        {
+          // joining FEWER features to a layer with MORE features. So we iterate over the FEW features and find matches from the MANY
+          processAlgorithmByIteratingOverInputSource( context, feedback );
+        }
+        else
+        {
+          // default -- iterate over the join source and match back to the base source. We do this on the assumption that the most common
+          // use case is joining a points layer to a polygon layer (taking polygon attributes and adding them to the points), so by iterating
+          // over the polygons we can take advantage of prepared geometries for the spatial relationship test.
 
-        // TODO - consider using more heuristics to determine whether it's always best to iterate over the join
-        // source.
-        processAlgorithmByIteratingOverJoinedSource( context, feedback );
+          // TODO - consider using more heuristics to determine whether it's always best to iterate over the join
+          // source.
+          processAlgorithmByIteratingOverJoinedSource( context, feedback );
+        }
+        break;
       }
-      break;
-    }
 
-    case JoinToLargestOverlap:
-      processAlgorithmByIteratingOverInputSource( context, feedback );
-      break;
+      case JoinToLargestOverlap:
+        processAlgorithmByIteratingOverInputSource( context, feedback );
+        break;
+    }
   }
 
   QVariantMap outputs;
@@ -388,6 +415,209 @@ void QgsJoinByLocationAlgorithm::processAlgorithmByIteratingOverInputSource( Qgs
   }
 }
 
+void QgsJoinByLocationAlgorithm::processAlgorithmInParallel( QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  // The join features are loaded into memory once, and then the input features are processed in chunks.
+  // Each chunk is partitioned into slices, and every slice is processed by a task which tests the spatial
+  // predicates against prepared join geometries. GEOS handles must not be shared between threads, so each
+  // task prepares its own engines on the thread which runs it, and destroys them before it finishes. A task
+  // only keeps its most recently used engines, so memory does not grow with the number of join features.
+  // Results are written from the main thread in input feature order, so the output does not depend on
+  // thread scheduling.
+
+  QgsFeatureIterator joinIter = mJoinSource->getFeatures( QgsFeatureRequest().setDestinationCrs( mBaseSource->sourceCrs(), context.transformContext() ).setSubsetOfAttributes( mJoinedFieldIndices ) );
+  std::vector< QgsGeometry > joinGeometries;
+  std::vector< QgsAttributes > joinAttributes;
+  QVector< QPair< QgsFeatureId, QgsRectangle > > joinBounds;
+  QgsFeature f;
+  while ( joinIter.nextFeature( f ) )
+  {
+    if ( feedback->isCanceled() )
+      return;
+
+    if ( !f.hasGeometry() )
+      continue;
+
+    QgsAttributes attributes;
+    attributes.reserve( mJoinedFieldIndices.size() );
+    for ( int ix : std::as_const( mJoinedFieldIndices ) )
+      attributes.append( f.attribute( ix ) );
+
+    joinBounds.append( qMakePair( static_cast< QgsFeatureId >( joinGeometries.size() ), f.geometry().boundingBox() ) );
+    joinGeometries.emplace_back( f.geometry() );
+    joinAttributes.emplace_back( attributes );
+  }
+  const QgsSpatialIndexPackedRTree joinIndex( joinBounds );
+
+  const int workerCount = std::max( 1, sJoinByLocationPool()->maxThreadCount() );
+
+  // for each input feature, the indices of matching join features (or the single best match)
+  const auto matchFeature = [this, &joinIndex, &joinGeometries]( const QgsFeature & baseFeature, QCache< qint64, QgsGeometryEngine > &engines ) -> QList< qint64 >
+  {
+    QList< qint64 > matches;
+    if ( !baseFeature.hasGeometry() )
+      return matches;
+
+    const QgsGeometry baseGeom = baseFeature.geometry();
+    QList< QgsFeatureId > candidates = joinIndex.intersects( baseGeom.boundingBox() );
+    std::sort( candidates.begin(), candidates.end() );
+
+    double largestOverlap = std::numeric_limits< double >::lowest();
+    for ( QgsFeatureId candidate : std::as_const( candidates ) )
+    {
+      // engines are only evicted when another one is inserted, so this one stays valid for the rest of the iteration
+      QgsGeometryEngine *engine = engines.object( candidate );
+      if ( !engine )
+      {
+        engine = QgsGeometry::createGeometryEngine( joinGeometries[ candidate ].constGet() );
+        engine->prepareGeometry();
+        engines.insert( candidate, engine );
+      }
+
+      if ( !featureFilter( baseFeature, engine, false ) )
+        continue;
+
+      switch ( mJoinMethod )
+      {
+        case OneToMany:
+          matches << candidate;
+          break;
+
+        case JoinToFirst:
+          matches << candidate;
+          return matches;
+
+        case JoinToLargestOverlap:
+        {
+          std::unique_ptr< QgsAbstractGeometry > intersection( engine->intersection( baseGeom.constGet() ) );
+          double overlap = 0;
+          if ( intersection )
+          {
+            switch ( QgsWkbTypes::geometryType( intersection->wkbType() ) )
+            {
+              case QgsWkbTypes::LineGeometry:
+                overlap = intersection->length();
+                break;
+
+              case QgsWkbTypes::PolygonGeometry:
+                overlap = intersection->area();
+                break;
+
+              case QgsWkbTypes::UnknownGeometry:
+              case QgsWkbTypes::PointGeometry:
+              case QgsWkbTypes::NullGeometry:
+                break;
+            }
+          }
+
+          if ( overlap > largestOverlap )
+          {
+            largestOverlap = overlap;
+            matches = QList< qint64 >() << candidate;
+          }
+          break;
+        }
+      }
+    }
+    return matches;
+  };
+
+  QgsAttributes emptyAttributes;
+  emptyAttributes.reserve( mJoinedFieldIndices.count() );
+  for ( int i = 0; i < mJoinedFieldIndices.count(); ++i )
+    emptyAttributes << QVariant();
+
+  const int chunkSize = 1000 * workerCount;
+  const double step = mBaseSource->featureCount() > 0 ? 100.0 / mBaseSource->featureCount() : 1;
+  long processed = 0;
+
+  QgsFeatureIterator it = mBaseSource->getFeatures();
+  QVector< QgsFeature > chunk;
+  chunk.reserve( chunkSize );
+  bool finished = false;
+  while ( !finished )
+  {
+    chunk.clear();
+    while ( chunk.size() < chunkSize && it.nextFeature( f ) )
+      chunk << f;
+    finished = chunk.size() < chunkSize;
+    if ( chunk.isEmpty() || feedback->isCanceled() )
+      break;
+
+    // partition the chunk into contiguous slices, one per worker
+    std::vector< QList< qint64 > > results( chunk.size() );
+    const int sliceSize = static_cast< int >( std::ceil( static_cast< double >( chunk.size() ) / workerCount ) );
+    std::vector< std::exception_ptr > errors( workerCount );
+    std::vector< QFuture< void > > futures;
+    for ( int worker = 0; worker < workerCount; ++worker )
+    {
+      const int sliceStart = worker * sliceSize;
+      const int sliceEnd = std::min( sliceStart + sliceSize, static_cast< int >( chunk.size() ) );
+      if ( sliceStart >= sliceEnd )
+        break;
+
+      futures.push_back( QtConcurrent::run( sJoinByLocationPool(), [&, worker, sliceStart, sliceEnd]
+      {
+        try
+        {
+          // engines are created and destroyed on this thread only
+          QCache< qint64, QgsGeometryEngine > engines( MAX_PREPARED_ENGINES_PER_WORKER );
+          for ( int i = sliceStart; i < sliceEnd && !feedback->isCanceled(); ++i )
+            results[ i ] = matchFeature( chunk.at( i ), engines );
+        }
+        catch ( ... )
+        {
+          // exceptions can't cross the thread boundary, so they are rethrown from the calling thread
+          errors[ worker ] = std::current_exception();
+        }
+      } ) );
+    }
+    for ( QFuture< void > &future : futures )
+      future.waitForFinished();
+
+    for ( const std::exception_ptr &error : errors )
+    {
+      if ( error )
+        std::rethrow_exception( error );
+    }
+
+    if ( feedback->isCanceled() )
+      break;
+
+    for ( int i = 0; i < chunk.size(); ++i )
+    {
+      const QgsFeature &baseFeature = chunk.at( i );
+      const QList< qint64 > &matches = results[ i ];
+      if ( matches.isEmpty() )
+      {
+        if ( mJoinedFeatures && !mDiscardNonMatching )
+        {
+          QgsFeature outputFeature( baseFeature );
+          outputFeature.setAttributes( baseFeature.attributes() + emptyAttributes );
+          mJoinedFeatures->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+        }
+        if ( mUnjoinedFeatures )
+          mUnjoinedFeatures->addFeature( baseFeature, QgsFeatureSink::FastInsert );
+        continue;
+      }
+
+      if ( mJoinedFeatures )
+      {
+        for ( qint64 match : matches )
+        {
+          QgsFeature outputFeature( baseFeature );
+          outputFeature.setAttributes( baseFeature.attributes() + joinAttributes[ match ] );
+          mJoinedFeatures->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+        }
+      }
+      mJoinedCount++;
+    }
+
+    processed += chunk.size();
+    feedback->setProgress( processed * step );
+  }
+}
+
 void QgsJoinByLocationAlgorithm::sortPredicates( QList<int> &predicates )
 {
   // Sort predicate list so that faster predicates are earlier in the list
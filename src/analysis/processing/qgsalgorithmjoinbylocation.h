@@ -58,6 +58,7 @@ class QgsJoinByLocationAlgorithm : public QgsProcessingAlgorithm
 
     void processAlgorithmByIteratingOverJoinedSource( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
     void processAlgorithmByIteratingOverInputSource( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
+    void processAlgorithmInParallel( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
 
     enum JoinMethod
     {
@@ -75,6 +76,7 @@ class QgsJoinByLocationAlgorithm : public QgsProcessingAlgorithm
     std::unique_ptr< QgsFeatureSink > mUnjoinedFeatures;
     JoinMethod mJoinMethod = OneToMany;
     QList<int> mPredicates;
+    bool mParallel = false;
 
     static void sortPredicates( QList<int > &predicates );
 };
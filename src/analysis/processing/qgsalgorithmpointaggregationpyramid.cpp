@@ -0,0 +1,116 @@
+/***************************************************************************
+                         qgsalgorithmpointaggregationpyramid.cpp
+                         ------------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsalgorithmpointaggregationpyramid.h"
+#include "qgspointaggregationpyramid.h"
+#include "qgsproviderregistry.h"
+#include "qgsvectorlayer.h"
+
+///@cond PRIVATE
+
+QString QgsPointAggregationPyramidAlgorithm::name() const
+{
+  return QStringLiteral( "createpointaggregationpyramid" );
+}
+
+QString QgsPointAggregationPyramidAlgorithm::displayName() const
+{
+  return QObject::tr( "Create point aggregation pyramid" );
+}
+
+QStringList QgsPointAggregationPyramidAlgorithm::tags() const
+{
+  return QObject::tr( "point,aggregate,pyramid,overview,level,detail,lod,render,index,create,vector" ).split( ',' );
+}
+
+QString QgsPointAggregationPyramidAlgorithm::group() const
+{
+  return QObject::tr( "Vector general" );
+}
+
+QString QgsPointAggregationPyramidAlgorithm::groupId() const
+{
+  return QStringLiteral( "vectorgeneral" );
+}
+
+QgsProcessingAlgorithm::Flags QgsPointAggregationPyramidAlgorithm::flags() const
+{
+  return QgsProcessingAlgorithm::flags() | QgsProcessingAlgorithm::FlagNoThreading;
+}
+
+QString QgsPointAggregationPyramidAlgorithm::shortHelpString() const
+{
+  return QObject::tr( "Creates a multi-resolution aggregation of the points in a file based "
+                      "point layer.\n\n"
+                      "When the layer is rendered at small scales with a single symbol, the "
+                      "aggregated points are drawn instead of the individual features, which "
+                      "greatly speeds up rendering of layers with millions of points. The "
+                      "individual features are still used once the map is zoomed in.\n\n"
+                      "The aggregation is stored in the user profile and is discarded "
+                      "automatically if the layer's file is modified." );
+}
+
+QgsPointAggregationPyramidAlgorithm *QgsPointAggregationPyramidAlgorithm::createInstance() const
+{
+  return new QgsPointAggregationPyramidAlgorithm();
+}
+
+void QgsPointAggregationPyramidAlgorithm::initAlgorithm( const QVariantMap & )
+{
+  addParameter( new QgsProcessingParameterVectorLayer( QStringLiteral( "INPUT" ), QObject::tr( "Input layer" ), QList< int >() << QgsProcessing::TypeVectorPoint ) );
+
+  addOutput( new QgsProcessingOutputFile( QStringLiteral( "OUTPUT" ), QObject::tr( "Aggregation pyramid" ) ) );
+  addOutput( new QgsProcessingOutputNumber( QStringLiteral( "POINT_COUNT" ), QObject::tr( "Number of aggregated points" ) ) );
+  addOutput( new QgsProcessingOutputNumber( QStringLiteral( "LEVEL_COUNT" ), QObject::tr( "Number of pyramid levels" ) ) );
+}
+
+QVariantMap QgsPointAggregationPyramidAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  QgsVectorLayer *layer = parameterAsVectorLayer( parameters, QStringLiteral( "INPUT" ), context );
+
+  if ( !layer )
+    throw QgsProcessingException( QObject::tr( "Could not load source layer for %1." ).arg( QLatin1String( "INPUT" ) ) );
+
+  if ( layer->geometryType() != QgsWkbTypes::PointGeometry )
+    throw QgsProcessingException( QObject::tr( "Aggregation pyramids can only be created for point layers" ) );
+
+  const QString sourcePath = QgsProviderRegistry::instance()->decodeUri( layer->providerType(), layer->source() ).value( QStringLiteral( "path" ) ).toString();
+  if ( sourcePath.isEmpty() )
+    throw QgsProcessingException( QObject::tr( "Aggregation pyramids can only be created for file based layers" ) );
+
+  QgsFeatureIterator it = layer->dataProvider()->getFeatures( QgsFeatureRequest().setNoAttributes() );
+  std::unique_ptr< QgsPointAggregationPyramid > pyramid = QgsPointAggregationPyramid::build( it, layer->dataProvider()->extent(), feedback );
+  if ( !pyramid )
+  {
+    if ( feedback->isCanceled() )
+      return QVariantMap();
+    throw QgsProcessingException( QObject::tr( "Could not create point aggregation pyramid" ) );
+  }
+
+  QString error;
+  if ( !QgsPointAggregationPyramid::write( layer->source(), sourcePath, *pyramid, &error ) )
+    throw QgsProcessingException( error );
+
+  feedback->pushInfo( QObject::tr( "Aggregated %1 points into %2 levels" ).arg( pyramid->pointCount() ).arg( pyramid->levelCount() ) );
+
+  QVariantMap outputs;
+  outputs.insert( QStringLiteral( "OUTPUT" ), QgsPointAggregationPyramid::sidecarPath( layer->source(), sourcePath ) );
+  outputs.insert( QStringLiteral( "POINT_COUNT" ), pyramid->pointCount() );
+  outputs.insert( QStringLiteral( "LEVEL_COUNT" ), pyramid->levelCount() );
+  return outputs;
+}
+
+///@endcond
@@ -0,0 +1,54 @@
+/***************************************************************************
+                         qgsalgorithmpointaggregationpyramid.h
+                         ------------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSALGORITHMPOINTAGGREGATIONPYRAMID_H
+#define QGSALGORITHMPOINTAGGREGATIONPYRAMID_H
+
+#define SIP_NO_FILE
+
+#include "qgis_sip.h"
+#include "qgsprocessingalgorithm.h"
+
+///@cond PRIVATE
+
+/**
+ * Native create point aggregation pyramid algorithm.
+ */
+class QgsPointAggregationPyramidAlgorithm : public QgsProcessingAlgorithm
+{
+
+  public:
+
+    QgsPointAggregationPyramidAlgorithm() = default;
+    void initAlgorithm( const QVariantMap &configuration = QVariantMap() ) override;
+    QString name() const override;
+    QString displayName() const override;
+    QStringList tags() const override;
+    QString group() const override;
+    QString groupId() const override;
+    Flags flags() const override;
+    QString shortHelpString() const override;
+    QgsPointAggregationPyramidAlgorithm *createInstance() const override SIP_FACTORY;
+
+  protected:
+
+    QVariantMap processAlgorithm( const QVariantMap &parameters,
+                                  QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+};
+
+///@endcond PRIVATE
+
+#endif // QGSALGORITHMPOINTAGGREGATIONPYRAMID_H
@@ -123,45 +123,15 @@ QVariantMap QgsRasterStackPositionAlgorithmBase::processAlgorithm( const QVarian
   provider->setNoDataValue( 1, mNoDataValue );
   qgssize layerSize = static_cast< qgssize >( mLayerWidth ) * static_cast< qgssize >( mLayerHeight );
 
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int>( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-  provider->setEditable( true );
-
-  QgsRasterIterator iter( provider.get() );
-  iter.startRasterRead( 1, mLayerWidth, mLayerHeight, mExtent );
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  QgsRectangle blockExtent;
-
-  std::unique_ptr< QgsRasterBlock > outputBlock;
-  while ( iter.readNextRasterPart( 1, iterCols, iterRows, outputBlock, iterLeft, iterTop, &blockExtent ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( QgsRasterAnalysisUtils::rasterBlockInputs( mInputs ), provider.get(), mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    std::vector< std::unique_ptr< QgsRasterBlock > > inputBlocks;
-    for ( const QgsRasterAnalysisUtils::RasterLogicInput &i : mInputs )
-    {
-      if ( feedback->isCanceled() )
-        break; //in case some slow data sources are loaded
-      for ( int band : i.bands )
-      {
-        if ( feedback->isCanceled() )
-          break; //in case some slow data sources are loaded
-        std::unique_ptr< QgsRasterBlock > b( i.interface->block( band, blockExtent, iterCols, iterRows ) );
-        inputBlocks.emplace_back( std::move( b ) );
-      }
-    }
-
-    feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    for ( int row = 0; row < iterRows; row++ )
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
       if ( feedback->isCanceled() )
         break;
 
-      for ( int col = 0; col < iterCols; col++ )
+      for ( int col = 0; col < outputBlock->width(); col++ )
       {
         bool noDataInStack = false;
 
@@ -187,9 +157,7 @@ QVariantMap QgsRasterStackPositionAlgorithmBase::processAlgorithm( const QVarian
         }
       }
     }
-    provider->writeBlock( outputBlock.get(), 1, iterLeft, iterTop );
-  }
-  provider->setEditable( false );
+  } );
 
   QVariantMap outputs;
   outputs.insert( QStringLiteral( "EXTENT" ), mExtent.toString() );
@@ -159,26 +159,26 @@ QVariantMap QgsRescaleRasterAlgorithm::processAlgorithm( const QVariantMap &para
     std::unique_ptr< QgsRasterBlock > outputBlock( new QgsRasterBlock( destProvider->dataType( 1 ), iterCols, iterRows ) );
     feedback->setProgress( 100 * ( ( iterTop / blockHeight * numBlocksX ) + iterLeft / blockWidth ) / numBlocks );
 
-    for ( int row = 0; row < iterRows; row++ )
+    const QgsRasterBlockView< float > outputView = outputBlock->view< float >();
+    const float noData = static_cast< float >( mNoData );
+    inputBlock->visitView( [&]( auto inputView )
     {
-      if ( feedback->isCanceled() )
-        break;
-
-      for ( int col = 0; col < iterCols; col++ )
+      for ( int row = 0; row < iterRows; row++ )
       {
-        bool isNoData = false;
-        double val = inputBlock->valueAndNoData( row, col, isNoData );
-        if ( isNoData )
-        {
-          outputBlock->setValue( row, col, mNoData );
-        }
-        else
+        if ( feedback->isCanceled() )
+          break;
+
+        const auto *input = inputView.row( row );
+        float *output = outputView.row( row );
+        for ( int col = 0; col < iterCols; col++ )
         {
-          double newValue = ( ( val - stats.minimumValue ) * ( mMaximum - mMinimum ) / ( stats.maximumValue - stats.minimumValue ) ) + mMinimum;
-          outputBlock->setValue( row, col, newValue );
+          if ( inputView.isNoData( row, col ) )
+            output[col] = noData;
+          else
+            output[col] = static_cast< float >( ( ( static_cast< double >( input[col] ) - stats.minimumValue ) * ( mMaximum - mMinimum ) / ( stats.maximumValue - stats.minimumValue ) ) + mMinimum );
         }
       }
-    }
+    } );
     destProvider->writeBlock( outputBlock.get(), mBand, iterLeft, iterTop );
   }
   destProvider->setEditable( false );
@@ -17,6 +17,7 @@
 
 #include "qgsalgorithmroundrastervalues.h"
 #include "qgsrasterfilewriter.h"
+#include "qgsrasteranalysisutils.h"
 
 ///@cond PRIVATE
 
@@ -139,85 +140,67 @@ QVariantMap QgsRoundRasterValuesAlgorithm::processAlgorithm( const QVariantMap &
   //prepare output provider
   QgsRasterDataProvider *destinationRasterProvider;
   destinationRasterProvider = provider.get();
-  destinationRasterProvider->setEditable( true );
   destinationRasterProvider->setNoDataValue( 1, mInputNoDataValue );
 
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * mLayerWidth / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-
-  QgsRasterIterator iter( mInterface.get() );
-  iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  std::unique_ptr< QgsRasterBlock > analysisRasterBlock;
-  while ( iter.readNextRasterPart( mBand, iterCols, iterRows, analysisRasterBlock, iterLeft, iterTop ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( { { mInterface.get(), mBand } }, destinationRasterProvider, mLayerWidth, mLayerHeight, mExtent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    if ( feedback )
-      feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
+    const std::unique_ptr< QgsRasterBlock > &analysisRasterBlock = inputBlocks.front();
     if ( mIsInteger && mDecimalPrecision > -1 )
     {
-      //nothing to round, just write raster block
-      analysisRasterBlock->setNoDataValue( mInputNoDataValue );
-      destinationRasterProvider->writeBlock( analysisRasterBlock.get(), mBand, iterLeft, iterTop );
+      //nothing to round, just copy the raster block
+      outputBlock->setData( analysisRasterBlock->data() );
+      return;
     }
-    else
+
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
-      for ( int row = 0; row < iterRows; row++ )
+      if ( feedback && feedback->isCanceled() )
+        break;
+      for ( int column = 0; column < outputBlock->width(); column++ )
       {
-        if ( feedback && feedback->isCanceled() )
-          break;
-        for ( int column = 0; column < iterCols; column++ )
+        bool isNoData = false;
+        double val = analysisRasterBlock->valueAndNoData( row, column, isNoData );
+        if ( isNoData )
+        {
+          outputBlock->setValue( row, column, mInputNoDataValue );
+        }
+        else
         {
-          bool isNoData = false;
-          double val = analysisRasterBlock->valueAndNoData( row, column, isNoData );
-          if ( isNoData )
+          double roundedVal = mInputNoDataValue;
+          if ( mRoundingDirection == 0 && mDecimalPrecision < 0 )
+          {
+            roundedVal = roundUpBaseN( val );
+          }
+          else if ( mRoundingDirection == 0 && mDecimalPrecision > -1 )
+          {
+            double m = ( val < 0.0 ) ? -1.0 : 1.0;
+            roundedVal = roundUp( val, m );
+          }
+          else if ( mRoundingDirection == 1 && mDecimalPrecision < 0 )
+          {
+            roundedVal = roundNearestBaseN( val );
+          }
+          else if ( mRoundingDirection == 1 && mDecimalPrecision > -1 )
           {
-            analysisRasterBlock->setValue( row, column, mInputNoDataValue );
+            double m = ( val < 0.0 ) ? -1.0 : 1.0;
+            roundedVal = roundNearest( val, m );
+          }
+          else if ( mRoundingDirection == 2 && mDecimalPrecision < 0 )
+          {
+            roundedVal = roundDownBaseN( val );
           }
           else
           {
-            double roundedVal = mInputNoDataValue;
-            if ( mRoundingDirection == 0 && mDecimalPrecision < 0 )
-            {
-              roundedVal = roundUpBaseN( val );
-            }
-            else if ( mRoundingDirection == 0 && mDecimalPrecision > -1 )
-            {
-              double m = ( val < 0.0 ) ? -1.0 : 1.0;
-              roundedVal = roundUp( val, m );
-            }
-            else if ( mRoundingDirection == 1 && mDecimalPrecision < 0 )
-            {
-              roundedVal = roundNearestBaseN( val );
-            }
-            else if ( mRoundingDirection == 1 && mDecimalPrecision > -1 )
-            {
-              double m = ( val < 0.0 ) ? -1.0 : 1.0;
-              roundedVal = roundNearest( val, m );
-            }
-            else if ( mRoundingDirection == 2 && mDecimalPrecision < 0 )
-            {
-              roundedVal = roundDownBaseN( val );
-            }
-            else
-            {
-              double m = ( val < 0.0 ) ? -1.0 : 1.0;
-              roundedVal = roundDown( val,  m );
-            }
-            //integer values get automatically cast to double when reading and back to int when writing
-            analysisRasterBlock->setValue( row, column, roundedVal );
+            double m = ( val < 0.0 ) ? -1.0 : 1.0;
+            roundedVal = roundDown( val,  m );
           }
+          //integer values get automatically cast to double when reading and back to int when writing
+          outputBlock->setValue( row, column, roundedVal );
         }
       }
-      destinationRasterProvider->writeBlock( analysisRasterBlock.get(), mBand, iterLeft, iterTop );
     }
-  }
-  destinationRasterProvider->setEditable( false );
+  } );
 
   QVariantMap outputs;
   outputs.insert( QStringLiteral( "OUTPUT" ), outputFile );
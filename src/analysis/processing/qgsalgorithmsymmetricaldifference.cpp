@@ -66,6 +66,10 @@ void QgsSymmetricalDifferenceAlgorithm::initAlgorithm( const QVariantMap & )
   addParameter( prefix.release() );
 
   addParameter( new QgsProcessingParameterFeatureSink( QStringLiteral( "OUTPUT" ), QObject::tr( "Symmetrical difference" ) ) );
+
+  std::unique_ptr< QgsProcessingParameterBoolean > parallel = std::make_unique< QgsProcessingParameterBoolean >( QStringLiteral( "PARALLEL" ), QObject::tr( "Process features in parallel" ), false, true );
+  parallel->setFlags( parallel->flags() | QgsProcessingParameterDefinition::FlagAdvanced );
+  addParameter( parallel.release() );
 }
 
 
@@ -92,12 +96,13 @@ QVariantMap QgsSymmetricalDifferenceAlgorithm::processAlgorithm( const QVariantM
   QVariantMap outputs;
   outputs.insert( QStringLiteral( "OUTPUT" ), dest );
 
+  const bool parallel = parameterAsBoolean( parameters, QStringLiteral( "PARALLEL" ), context );
   int count = 0;
   int total = sourceA->featureCount() + sourceB->featureCount();
 
-  QgsOverlayUtils::difference( *sourceA, *sourceB, *sink, context, feedback, count, total, QgsOverlayUtils::OutputAB );
+  QgsOverlayUtils::difference( *sourceA, *sourceB, *sink, context, feedback, count, total, QgsOverlayUtils::OutputAB, parallel );
 
-  QgsOverlayUtils::difference( *sourceB, *sourceA, *sink, context, feedback, count, total, QgsOverlayUtils::OutputBA );
+  QgsOverlayUtils::difference( *sourceB, *sourceA, *sink, context, feedback, count, total, QgsOverlayUtils::OutputBA, parallel );
 
   return outputs;
 }
@@ -122,6 +122,7 @@
 #include "qgsalgorithmpointsinpolygon.h"
 #include "qgsalgorithmpointonsurface.h"
 #include "qgsalgorithmpointtolayer.h"
+#include "qgsalgorithmpointaggregationpyramid.h"
 #include "qgsalgorithmpointsalonggeometry.h"
 #include "qgsalgorithmpointslayerfromtable.h"
 #include "qgsalgorithmpointstopaths.h"
@@ -376,6 +377,7 @@ void QgsNativeAlgorithms::loadAlgorithms()
   addAlgorithm( new QgsPointsInPolygonAlgorithm() );
   addAlgorithm( new QgsPointOnSurfaceAlgorithm() );
   addAlgorithm( new QgsPointToLayerAlgorithm() );
+  addAlgorithm( new QgsPointAggregationPyramidAlgorithm() );
   addAlgorithm( new QgsPointsAlongGeometryAlgorithm() );
   addAlgorithm( new QgsPointsLayerFromTableAlgorithm() );
   addAlgorithm( new QgsPointsToPathsAlgorithm() );
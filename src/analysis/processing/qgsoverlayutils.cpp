@@ -17,6 +17,11 @@
 
 #include "qgsgeometryengine.h"
 #include "qgsprocessingalgorithm.h"
+#include "qgsspatialindex.h"
+#include "qgsspatialindexpackedrtree.h"
+
+#include <QtConcurrent>
+#include <exception>
 
 ///@cond PRIVATE
 
@@ -82,29 +87,248 @@ static bool sanitizeDifferenceResult( QgsGeometry &geom, QgsWkbTypes::GeometryTy
 }
 
 
-void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, QgsOverlayUtils::DifferenceOutput outputAttrs )
+//! Computes the difference of a feature from A and the candidate geometries from B, returns FALSE if nothing is left
+static bool differenceFeature( const QgsFeature &featA, const QVector<QgsGeometry> &candidatesB, QgsWkbTypes::GeometryType geometryType, QgsOverlayUtils::DifferenceOutput outputAttrs, int fieldsCountA, int fieldsCountB, QgsFeature &outFeat )
+{
+  QgsGeometry geom( featA.geometry() );
+
+  QVector<QgsGeometry> geometriesB;
+  if ( !candidatesB.isEmpty() )
+  {
+    // use prepared geometries for faster intersection tests
+    std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( geom.constGet() ) );
+    engine->prepareGeometry();
+    for ( const QgsGeometry &geomB : candidatesB )
+    {
+      if ( engine->intersects( geomB.constGet() ) )
+        geometriesB << geomB;
+    }
+  }
+
+  if ( !geometriesB.isEmpty() )
+  {
+    QgsGeometry geomB = QgsGeometry::unaryUnion( geometriesB );
+    if ( !geomB.lastError().isEmpty() )
+    {
+      // This may happen if input geometries from a layer do not line up well (for example polygons
+      // that are nearly touching each other, but there is a very tiny overlap or gap at one of the edges).
+      // It is possible to get rid of this issue in two steps:
+      // 1. snap geometries with a small tolerance (e.g. 1cm) using QgsGeometrySnapperSingleSource
+      // 2. fix geometries (removes polygons collapsed to lines etc.) using MakeValid
+      throw QgsProcessingException( QStringLiteral( "%1\n\n%2" ).arg( QObject::tr( "GEOS geoprocessing error: unary union failed." ), geomB.lastError() ) );
+    }
+    geom = geom.difference( geomB );
+  }
+
+  if ( !sanitizeDifferenceResult( geom, geometryType ) )
+    return false;
+
+  QgsAttributes attrs;
+  attrs.resize( outputAttrs == QgsOverlayUtils::OutputA ? fieldsCountA : ( fieldsCountA + fieldsCountB ) );
+  const QgsAttributes attrsA( featA.attributes() );
+  switch ( outputAttrs )
+  {
+    case QgsOverlayUtils::OutputA:
+      attrs = attrsA;
+      break;
+    case QgsOverlayUtils::OutputAB:
+      for ( int i = 0; i < fieldsCountA; ++i )
+        attrs[i] = attrsA[i];
+      break;
+    case QgsOverlayUtils::OutputBA:
+      for ( int i = 0; i < fieldsCountA; ++i )
+        attrs[i + fieldsCountB] = attrsA[i];
+      break;
+  }
+
+  outFeat = QgsFeature();
+  outFeat.setGeometry( geom );
+  outFeat.setAttributes( attrs );
+  return true;
+}
+
+//! Computes the intersections of a feature from A with the candidate features from B
+static void intersectFeature( const QgsFeature &featA, const QVector<QgsFeature> &candidatesB, QgsWkbTypes::GeometryType geometryType, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB, QgsFeatureList &outFeatures )
+{
+  if ( candidatesB.isEmpty() )
+    return;
+
+  const QgsGeometry geom( featA.geometry() );
+
+  // use prepared geometries for faster intersection tests
+  std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( geom.constGet() ) );
+  engine->prepareGeometry();
+
+  QgsAttributes outAttributes( fieldIndicesA.count() + fieldIndicesB.count() );
+  const QgsAttributes attrsA( featA.attributes() );
+  for ( int i = 0; i < fieldIndicesA.count(); ++i )
+    outAttributes[i] = attrsA[fieldIndicesA[i]];
+
+  for ( const QgsFeature &featB : candidatesB )
+  {
+    QgsGeometry tmpGeom( featB.geometry() );
+    if ( !engine->intersects( tmpGeom.constGet() ) )
+      continue;
+
+    QgsGeometry intGeom = geom.intersection( tmpGeom );
+    if ( !QgsOverlayUtils::sanitizeIntersectionResult( intGeom, geometryType ) )
+      continue;
+
+    const QgsAttributes attrsB( featB.attributes() );
+    for ( int i = 0; i < fieldIndicesB.count(); ++i )
+      outAttributes[fieldIndicesA.count() + i] = attrsB[fieldIndicesB[i]];
+
+    QgsFeature outFeat;
+    outFeat.setGeometry( intGeom );
+    outFeat.setAttributes( outAttributes );
+    outFeatures << outFeat;
+  }
+}
+
+//! Loads all features with geometry from a source into memory, and returns a spatial index of them
+static QgsSpatialIndexPackedRTree loadFeatures( const QgsFeatureSource &source, const QgsFeatureRequest &request, QHash< QgsFeatureId, QgsFeature > &features, QgsProcessingFeedback *feedback )
+{
+  QVector< QPair< QgsFeatureId, QgsRectangle > > bounds;
+  QgsFeature f;
+  QgsFeatureIterator it = source.getFeatures( request );
+  while ( it.nextFeature( f ) )
+  {
+    if ( feedback->isCanceled() )
+      break;
+
+    if ( !f.hasGeometry() )
+      continue;
+
+    bounds.append( qMakePair( f.id(), f.geometry().boundingBox() ) );
+    features.insert( f.id(), f );
+  }
+  return QgsSpatialIndexPackedRTree( bounds );
+}
+
+/**
+ * Runs \a processFeature for all features from \a fitA on multiple threads. Features are read in chunks,
+ * and each chunk is split into contiguous slices which are processed concurrently. The output features
+ * are written to the \a sink in the same order as the input features.
+ */
+template <typename Func>
+static void processFeaturesInParallel( QgsFeatureIterator &fitA, QgsFeatureSink &sink, QgsProcessingFeedback *feedback, int &count, int totalCount, const Func &processFeature )
+{
+  const int workerCount = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  const int chunkSize = 100 * workerCount;
+
+  QVector< QgsFeature > chunk;
+  chunk.reserve( chunkSize );
+  QgsFeature featA;
+  bool finished = false;
+  while ( !finished && !feedback->isCanceled() )
+  {
+    chunk.clear();
+    while ( chunk.size() < chunkSize && fitA.nextFeature( featA ) )
+      chunk << featA;
+    finished = chunk.size() < chunkSize;
+    if ( chunk.isEmpty() )
+      break;
+
+    std::vector< QgsFeatureList > results( chunk.size() );
+    const int sliceSize = static_cast< int >( std::ceil( static_cast< double >( chunk.size() ) / workerCount ) );
+    std::vector< std::exception_ptr > errors( workerCount );
+    std::vector< QFuture< void > > futures;
+    for ( int worker = 0; worker < workerCount; ++worker )
+    {
+      const int sliceStart = worker * sliceSize;
+      const int sliceEnd = std::min( sliceStart + sliceSize, static_cast< int >( chunk.size() ) );
+      if ( sliceStart >= sliceEnd )
+        break;
+
+      futures.push_back( QtConcurrent::run( [&, worker, sliceStart, sliceEnd]
+      {
+        try
+        {
+          for ( int i = sliceStart; i < sliceEnd && !feedback->isCanceled(); ++i )
+            processFeature( chunk.at( i ), results[ i ] );
+        }
+        catch ( ... )
+        {
+          // exceptions can't cross the thread boundary, so they are rethrown from the calling thread
+          errors[ worker ] = std::current_exception();
+        }
+      } ) );
+    }
+    for ( QFuture< void > &future : futures )
+      future.waitForFinished();
+
+    for ( const std::exception_ptr &error : errors )
+    {
+      if ( error )
+        std::rethrow_exception( error );
+    }
+
+    for ( int i = 0; i < chunk.size(); ++i )
+    {
+      if ( feedback->isCanceled() )
+        return;
+
+      for ( QgsFeature &outFeat : results[ i ] )
+        sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
+
+      ++count;
+      feedback->setProgress( count / ( double ) totalCount * 100. );
+    }
+  }
+}
+
+void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, QgsOverlayUtils::DifferenceOutput outputAttrs, bool parallel )
 {
   QgsWkbTypes::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
   QgsFeatureRequest requestB;
   requestB.setNoAttributes();
   if ( outputAttrs != OutputBA )
     requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
-  QgsSpatialIndex indexB( sourceB.getFeatures( requestB ), feedback );
 
   int fieldsCountA = sourceA.fields().count();
   int fieldsCountB = sourceB.fields().count();
-  QgsAttributes attrs;
-  attrs.resize( outputAttrs == OutputA ? fieldsCountA : ( fieldsCountA + fieldsCountB ) );
 
   if ( totalCount == 0 )
     totalCount = 1;  // avoid division by zero
 
-  QgsFeature featA;
   QgsFeatureRequest requestA;
   requestA.setInvalidGeometryCheck( context.invalidGeometryCheck() );
   if ( outputAttrs == OutputBA )
     requestA.setDestinationCrs( sourceB.sourceCrs(), context.transformContext() );
   QgsFeatureIterator fitA = sourceA.getFeatures( requestA );
+
+  if ( parallel )
+  {
+    QHash< QgsFeatureId, QgsFeature > featuresB;
+    const QgsSpatialIndexPackedRTree indexB = loadFeatures( sourceB, requestB, featuresB, feedback );
+
+    processFeaturesInParallel( fitA, sink, feedback, count, totalCount, [&]( const QgsFeature & featA, QgsFeatureList & outFeatures )
+    {
+      if ( !featA.hasGeometry() )
+      {
+        // TODO: should we write out features that do not have geometry?
+        outFeatures << featA;
+        return;
+      }
+
+      QList< QgsFeatureId > intersects = indexB.intersects( featA.geometry().boundingBox() );
+      std::sort( intersects.begin(), intersects.end() );
+      QVector<QgsGeometry> candidatesB;
+      candidatesB.reserve( intersects.size() );
+      for ( QgsFeatureId id : std::as_const( intersects ) )
+        candidatesB << featuresB.value( id ).geometry();
+
+      QgsFeature outFeat;
+      if ( differenceFeature( featA, candidatesB, geometryType, outputAttrs, fieldsCountA, fieldsCountB, outFeat ) )
+        outFeatures << outFeat;
+    } );
+    return;
+  }
+
+  QgsFeatureIterator fitIndexB = sourceB.getFeatures( requestB );
+  const QgsSpatialIndexPackedRTree indexB( fitIndexB, feedback );
+
+  QgsFeature featA;
   while ( fitA.nextFeature( featA ) )
   {
     if ( feedback->isCanceled() )
@@ -112,8 +336,7 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
 
     if ( featA.hasGeometry() )
     {
-      QgsGeometry geom( featA.geometry() );
-      QgsFeatureIds intersects = qgis::listToSet( indexB.intersects( geom.boundingBox() ) );
+      QgsFeatureIds intersects = qgis::listToSet( indexB.intersects( featA.geometry().boundingBox() ) );
 
       QgsFeatureRequest request;
       request.setFilterFids( intersects );
@@ -121,15 +344,7 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
       if ( outputAttrs != OutputBA )
         request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
 
-      std::unique_ptr< QgsGeometryEngine > engine;
-      if ( !intersects.isEmpty() )
-      {
-        // use prepared geometries for faster intersection tests
-        engine.reset( QgsGeometry::createGeometryEngine( geom.constGet() ) );
-        engine->prepareGeometry();
-      }
-
-      QVector<QgsGeometry> geometriesB;
+      QVector<QgsGeometry> candidatesB;
       QgsFeature featB;
       QgsFeatureIterator fitB = sourceB.getFeatures( request );
       while ( fitB.nextFeature( featB ) )
@@ -137,47 +352,13 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
         if ( feedback->isCanceled() )
           break;
 
-        if ( engine->intersects( featB.geometry().constGet() ) )
-          geometriesB << featB.geometry();
-      }
-
-      if ( !geometriesB.isEmpty() )
-      {
-        QgsGeometry geomB = QgsGeometry::unaryUnion( geometriesB );
-        if ( !geomB.lastError().isEmpty() )
-        {
-          // This may happen if input geometries from a layer do not line up well (for example polygons
-          // that are nearly touching each other, but there is a very tiny overlap or gap at one of the edges).
-          // It is possible to get rid of this issue in two steps:
-          // 1. snap geometries with a small tolerance (e.g. 1cm) using QgsGeometrySnapperSingleSource
-          // 2. fix geometries (removes polygons collapsed to lines etc.) using MakeValid
-          throw QgsProcessingException( QStringLiteral( "%1\n\n%2" ).arg( QObject::tr( "GEOS geoprocessing error: unary union failed." ), geomB.lastError() ) );
-        }
-        geom = geom.difference( geomB );
+        candidatesB << featB.geometry();
       }
 
-      if ( !sanitizeDifferenceResult( geom, geometryType ) )
+      QgsFeature outFeat;
+      if ( !differenceFeature( featA, candidatesB, geometryType, outputAttrs, fieldsCountA, fieldsCountB, outFeat ) )
         continue;
 
-      const QgsAttributes attrsA( featA.attributes() );
-      switch ( outputAttrs )
-      {
-        case OutputA:
-          attrs = attrsA;
-          break;
-        case OutputAB:
-          for ( int i = 0; i < fieldsCountA; ++i )
-            attrs[i] = attrsA[i];
-          break;
-        case OutputBA:
-          for ( int i = 0; i < fieldsCountA; ++i )
-            attrs[i + fieldsCountB] = attrsA[i];
-          break;
-      }
-
-      QgsFeature outFeat;
-      outFeat.setGeometry( geom );
-      outFeat.setAttributes( attrs );
       sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
     }
     else
@@ -192,23 +373,48 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
 }
 
 
-void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB )
+void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB, bool parallel )
 {
   QgsWkbTypes::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
-  int attrCount = fieldIndicesA.count() + fieldIndicesB.count();
+
+  if ( totalCount == 0 )
+    totalCount = 1;  // avoid division by zero
+
+  QgsFeatureIterator fitA = sourceA.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( fieldIndicesA ) );
+
+  if ( parallel )
+  {
+    QgsFeatureRequest requestB;
+    requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+    requestB.setSubsetOfAttributes( fieldIndicesB );
+    QHash< QgsFeatureId, QgsFeature > featuresB;
+    const QgsSpatialIndexPackedRTree indexB = loadFeatures( sourceB, requestB, featuresB, feedback );
+
+    processFeaturesInParallel( fitA, sink, feedback, count, totalCount, [&]( const QgsFeature & featA, QgsFeatureList & outFeatures )
+    {
+      if ( !featA.hasGeometry() )
+        return;
+
+      QList< QgsFeatureId > intersects = indexB.intersects( featA.geometry().boundingBox() );
+      std::sort( intersects.begin(), intersects.end() );
+      QVector<QgsFeature> candidatesB;
+      candidatesB.reserve( intersects.size() );
+      for ( QgsFeatureId id : std::as_const( intersects ) )
+        candidatesB << featuresB.value( id );
+
+      intersectFeature( featA, candidatesB, geometryType, fieldIndicesA, fieldIndicesB, outFeatures );
+    } );
+    return;
+  }
 
   QgsFeatureRequest request;
   request.setNoAttributes();
   request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
 
-  QgsFeature outFeat;
-  QgsSpatialIndex indexB( sourceB.getFeatures( request ), feedback );
-
-  if ( totalCount == 0 )
-    totalCount = 1;  // avoid division by zero
+  QgsFeatureIterator fitIndexB = sourceB.getFeatures( request );
+  const QgsSpatialIndexPackedRTree indexB( fitIndexB, feedback );
 
   QgsFeature featA;
-  QgsFeatureIterator fitA = sourceA.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( fieldIndicesA ) );
   while ( fitA.nextFeature( featA ) )
   {
     if ( feedback->isCanceled() )
@@ -217,27 +423,14 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
     if ( !featA.hasGeometry() )
       continue;
 
-    QgsGeometry geom( featA.geometry() );
-    QgsFeatureIds intersects = qgis::listToSet( indexB.intersects( geom.boundingBox() ) );
+    QgsFeatureIds intersects = qgis::listToSet( indexB.intersects( featA.geometry().boundingBox() ) );
 
     QgsFeatureRequest request;
     request.setFilterFids( intersects );
     request.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
     request.setSubsetOfAttributes( fieldIndicesB );
 
-    std::unique_ptr< QgsGeometryEngine > engine;
-    if ( !intersects.isEmpty() )
-    {
-      // use prepared geometries for faster intersection tests
-      engine.reset( QgsGeometry::createGeometryEngine( geom.constGet() ) );
-      engine->prepareGeometry();
-    }
-
-    QgsAttributes outAttributes( attrCount );
-    const QgsAttributes attrsA( featA.attributes() );
-    for ( int i = 0; i < fieldIndicesA.count(); ++i )
-      outAttributes[i] = attrsA[fieldIndicesA[i]];
-
+    QVector<QgsFeature> candidatesB;
     QgsFeature featB;
     QgsFeatureIterator fitB = sourceB.getFeatures( request );
     while ( fitB.nextFeature( featB ) )
@@ -245,22 +438,13 @@ void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFe
       if ( feedback->isCanceled() )
         break;
 
-      QgsGeometry tmpGeom( featB.geometry() );
-      if ( !engine->intersects( tmpGeom.constGet() ) )
-        continue;
-
-      QgsGeometry intGeom = geom.intersection( tmpGeom );
-      if ( !sanitizeIntersectionResult( intGeom, geometryType ) )
-        continue;
-
-      const QgsAttributes attrsB( featB.attributes() );
-      for ( int i = 0; i < fieldIndicesB.count(); ++i )
-        outAttributes[fieldIndicesA.count() + i] = attrsB[fieldIndicesB[i]];
+      candidatesB << featB;
+    }
 
-      outFeat.setGeometry( intGeom );
-      outFeat.setAttributes( outAttributes );
+    QgsFeatureList outFeatures;
+    intersectFeature( featA, candidatesB, geometryType, fieldIndicesA, fieldIndicesB, outFeatures );
+    for ( QgsFeature &outFeat : outFeatures )
       sink.addFeature( outFeat, QgsFeatureSink::FastInsert );
-    }
 
     ++count;
     feedback->setProgress( count / ( double ) totalCount * 100. );
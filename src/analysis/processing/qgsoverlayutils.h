@@ -41,9 +41,21 @@ namespace QgsOverlayUtils
     OutputBA,  //!< Write attributes of both layers, inverted (first attributes of B, then attributes of A)
   };
 
-  void difference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, DifferenceOutput outputAttrs );
+  /**
+   * Writes the parts of features from \a sourceA which are not covered by features from \a sourceB to the \a sink.
+   *
+   * If \a parallel is TRUE, \a sourceB is loaded into memory and the features from \a sourceA are
+   * processed on multiple threads. Output features are still written in the order of the features from \a sourceA.
+   */
+  void difference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, DifferenceOutput outputAttrs, bool parallel = false );
 
-  void intersection( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB );
+  /**
+   * Writes the intersections of features from \a sourceA with features from \a sourceB to the \a sink.
+   *
+   * If \a parallel is TRUE, \a sourceB is loaded into memory and the features from \a sourceA are
+   * processed on multiple threads. Output features are still written in the order of the features from \a sourceA.
+   */
+  void intersection( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, int &count, int totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB, bool parallel = false );
 
   //! Makes sure that what came out from intersection of two geometries is good to be used in the output
   bool sanitizeIntersectionResult( QgsGeometry &geom, QgsWkbTypes::GeometryType geometryType );
@@ -18,12 +18,22 @@
 #include "qgsfeedback.h"
 #include "qgsrasterblock.h"
 #include "qgsrasteriterator.h"
-#include "qgsgeos.h"
+#include "qgsgeometry.h"
 #include "qgsprocessingparameters.h"
+#include "qgsrasterdataprovider.h"
+
+#include <QQueue>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
 #include <cmath>
+#include <utility>
 ///@cond PRIVATE
 
 void QgsRasterAnalysisUtils::cellInfoForBBox( const QgsRectangle &rasterBBox, const QgsRectangle &featureBBox, double cellSizeX, double cellSizeY,
@@ -59,16 +69,225 @@ void QgsRasterAnalysisUtils::cellInfoForBBox( const QgsRectangle &rasterBBox, co
                                     rasterBBox.yMaximum() - ( nCellsY + offsetY ) * cellSizeY );
 }
 
-void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox,  const std::function<void( double )> &addValue, bool skipNodata )
+QgsRasterAnalysisUtils::PolygonCellScanner::PolygonCellScanner( const QgsGeometry &poly, const QgsRectangle &windowExtent, double cellSizeX, double cellSizeY, int nCellsX )
+  : mCellsX( std::max( nCellsX, 0 ) )
+{
+  QgsGeometry geometry( poly );
+  if ( QgsWkbTypes::isCurvedType( geometry.wkbType() ) )
+    geometry.convertToStraightSegment();
+  if ( geometry.type() != QgsWkbTypes::PolygonGeometry )
+    return;
+
+  QgsMultiPolygonXY parts;
+  if ( geometry.isMultipart() )
+    parts = geometry.asMultiPolygon();
+  else
+    parts << geometry.asPolygon();
+
+  for ( const QgsPolygonXY &part : std::as_const( parts ) )
+  {
+    for ( int ringIndex = 0; ringIndex < part.size(); ++ringIndex )
+    {
+      const QgsPolylineXY &ring = part.at( ringIndex );
+      if ( ring.size() < 3 )
+        continue;
+
+      // convert to cell coordinates, with rows increasing downwards
+      std::vector< double > xs( ring.size() );
+      std::vector< double > ys( ring.size() );
+      double signedArea = 0;
+      for ( int i = 0; i < ring.size(); ++i )
+      {
+        xs[i] = ( ring.at( i ).x() - windowExtent.xMinimum() ) / cellSizeX;
+        ys[i] = ( windowExtent.yMaximum() - ring.at( i ).y() ) / cellSizeY;
+        if ( i > 0 )
+          signedArea += xs[i - 1] * ys[i] - xs[i] * ys[i - 1];
+      }
+
+      // coverage is accumulated as a winding number, so holes must wind opposite to exterior rings
+      // regardless of how the rings are oriented in the source geometry
+      const bool isExterior = ringIndex == 0;
+      const double direction = ( signedArea >= 0 ) == isExterior ? 1 : -1;
+      for ( int i = 1; i < ring.size(); ++i )
+      {
+        addClippedSegment( xs[i - 1], ys[i - 1], xs[i], ys[i], direction );
+      }
+      if ( !qgsDoubleNear( xs.front(), xs.back() ) || !qgsDoubleNear( ys.front(), ys.back() ) )
+        addClippedSegment( xs.back(), ys.back(), xs.front(), ys.front(), direction );
+    }
+  }
+
+  std::sort( mEdges.begin(), mEdges.end(), []( const Edge & a, const Edge & b ) { return a.y0 < b.y0; } );
+}
+
+void QgsRasterAnalysisUtils::PolygonCellScanner::addClippedSegment( double xa, double ya, double xb, double yb, double direction )
 {
-  std::unique_ptr< QgsGeometryEngine > polyEngine( QgsGeometry::createGeometryEngine( poly.constGet( ) ) );
-  if ( !polyEngine )
+  // split the segment where it leaves the window horizontally. Parts outside the window are then
+  // flattened onto its left or right border, which keeps the winding of all cells inside the window.
+  double splits[2];
+  int splitCount = 0;
+  const double width = mCellsX;
+  for ( const double border : { 0.0, width } )
+  {
+    if ( ( xa < border && xb > border ) || ( xa > border && xb < border ) )
+      splits[splitCount++] = ( border - xa ) / ( xb - xa );
+  }
+  if ( splitCount == 2 && splits[0] > splits[1] )
+    std::swap( splits[0], splits[1] );
+
+  double startX = xa;
+  double startY = ya;
+  for ( int i = 0; i < splitCount; ++i )
   {
+    const double endX = xa + splits[i] * ( xb - xa );
+    const double endY = ya + splits[i] * ( yb - ya );
+    addSegment( std::clamp( startX, 0.0, width ), startY, std::clamp( endX, 0.0, width ), endY, direction );
+    startX = endX;
+    startY = endY;
+  }
+  addSegment( std::clamp( startX, 0.0, width ), startY, std::clamp( xb, 0.0, width ), yb, direction );
+}
+
+void QgsRasterAnalysisUtils::PolygonCellScanner::addSegment( double xa, double ya, double xb, double yb, double direction )
+{
+  // horizontal segments neither cross scanlines nor contribute to the coverage
+  if ( ya == yb )
     return;
+
+  Edge edge;
+  if ( ya < yb )
+  {
+    edge.x0 = xa;
+    edge.y0 = ya;
+    edge.x1 = xb;
+    edge.y1 = yb;
+    edge.direction = direction;
+  }
+  else
+  {
+    edge.x0 = xb;
+    edge.y0 = yb;
+    edge.x1 = xa;
+    edge.y1 = ya;
+    edge.direction = -direction;
   }
-  polyEngine->prepareGeometry();
+  edge.dxdy = ( edge.x1 - edge.x0 ) / ( edge.y1 - edge.y0 );
+  mEdges.emplace_back( edge );
+}
 
+void QgsRasterAnalysisUtils::PolygonCellScanner::updateActiveEdges( int row )
+{
+  while ( mNextEdge < mEdges.size() && mEdges[mNextEdge].y0 < row + 1 )
+  {
+    mActiveEdges.emplace_back( mNextEdge++ );
+  }
+  mActiveEdges.erase( std::remove_if( mActiveEdges.begin(), mActiveEdges.end(), [this, row]( std::size_t index ) { return mEdges[index].y1 <= row; } ), mActiveEdges.end() );
+}
+
+void QgsRasterAnalysisUtils::PolygonCellScanner::cellCentersInRow( int row, std::vector<std::pair<int, int> > &spans )
+{
+  spans.clear();
+  updateActiveEdges( row );
+
+  const double centerY = row + 0.5;
+  mCrossings.clear();
+  for ( const std::size_t index : mActiveEdges )
+  {
+    const Edge &edge = mEdges[index];
+    if ( edge.y0 <= centerY && centerY < edge.y1 )
+      mCrossings.emplace_back( edge.x0 + ( centerY - edge.y0 ) * edge.dxdy );
+  }
+  std::sort( mCrossings.begin(), mCrossings.end() );
+
+  // cell centers are at column + 0.5, so the cells between two crossings are those with
+  // start - 0.5 <= column < end - 0.5
+  for ( std::size_t i = 0; i + 1 < mCrossings.size(); i += 2 )
+  {
+    const int first = std::max( 0, static_cast< int >( std::ceil( mCrossings[i] - 0.5 ) ) );
+    const int last = std::min( mCellsX, static_cast< int >( std::ceil( mCrossings[i + 1] - 0.5 ) ) );
+    if ( last > first )
+      spans.emplace_back( first, last );
+  }
+}
+
+void QgsRasterAnalysisUtils::PolygonCellScanner::coverageForRow( int row, std::vector<double> &coverage )
+{
+  coverage.assign( static_cast< std::size_t >( mCellsX ), 0 );
+  updateActiveEdges( row );
+  if ( mActiveEdges.empty() )
+    return;
+
+  mAccumulation.assign( static_cast< std::size_t >( mCellsX ) + 2, 0 );
+  double *acc = mAccumulation.data();
+  for ( const std::size_t index : mActiveEdges )
+  {
+    const Edge &edge = mEdges[index];
+    const double top = std::max( edge.y0, static_cast< double >( row ) );
+    const double bottom = std::min( edge.y1, static_cast< double >( row ) + 1 );
+    if ( bottom <= top )
+      continue;
+
+    // deposit the signed area between the part of the edge within this row and the right border
+    // of each cell, so that a running sum along the row gives the covered area of each cell
+    const double xTop = edge.x0 + ( top - edge.y0 ) * edge.dxdy;
+    const double xBottom = edge.x0 + ( bottom - edge.y0 ) * edge.dxdy;
+    const double d = ( bottom - top ) * edge.direction;
+    const double x0 = std::min( xTop, xBottom );
+    const double x1 = std::max( xTop, xBottom );
+    const double x0Floor = std::floor( x0 );
+    const int x0i = static_cast< int >( x0Floor );
+    const double x1Ceil = std::ceil( x1 );
+    const int x1i = static_cast< int >( x1Ceil );
+    if ( x1i <= x0i + 1 )
+    {
+      // the edge lies within a single column
+      const double xmf = 0.5 * ( xTop + xBottom ) - x0Floor;
+      acc[x0i] += d - d * xmf;
+      acc[x0i + 1] += d * xmf;
+    }
+    else
+    {
+      const double s = 1.0 / ( x1 - x0 );
+      const double x0f = x0 - x0Floor;
+      const double a0 = 0.5 * s * ( 1.0 - x0f ) * ( 1.0 - x0f );
+      const double x1f = x1 - x1Ceil + 1.0;
+      const double am = 0.5 * s * x1f * x1f;
+      acc[x0i] += d * a0;
+      if ( x1i == x0i + 2 )
+      {
+        acc[x0i + 1] += d * ( 1.0 - a0 - am );
+      }
+      else
+      {
+        const double a1 = s * ( 1.5 - x0f );
+        acc[x0i + 1] += d * ( a1 - a0 );
+        for ( int xi = x0i + 2; xi < x1i - 1; ++xi )
+          acc[xi] += d * s;
+        const double a2 = a1 + ( x1i - x0i - 3 ) * s;
+        acc[x1i - 1] += d * ( 1.0 - a2 - am );
+      }
+      acc[x1i] += d * am;
+    }
+  }
+
+  double sum = 0;
+  for ( int col = 0; col < mCellsX; ++col )
+  {
+    sum += acc[col];
+    const double covered = std::fabs( sum );
+    // discard rounding noise from the running sum
+    coverage[col] = covered < 1E-9 ? 0 : std::min( covered, 1.0 );
+  }
+}
+
+void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox,  const std::function<void( double )> &addValue, bool skipNodata )
+{
+  PolygonCellScanner scanner( poly, rasterBBox, cellSizeX, cellSizeY, nCellsX );
+
+  // read blocks spanning the whole width of the window, so that rows are scanned in order
   QgsRasterIterator iter( rasterInterface );
+  iter.setMaximumTileWidth( std::max( nCellsX, 1 ) );
+  iter.setMaximumTileHeight( std::max( 1, QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH * QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT / std::max( nCellsX, 1 ) ) );
   iter.startRasterRead( rasterBand, nCellsX, nCellsY, rasterBBox );
 
   std::unique_ptr< QgsRasterBlock > block;
@@ -76,50 +295,58 @@ void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *
   int iterTop = 0;
   int iterCols = 0;
   int iterRows = 0;
-  QgsRectangle blockExtent;
-  bool isNoData = false;
-  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop, &blockExtent ) )
+  std::vector< std::pair< int, int > > spans;
+  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop ) )
   {
-    double cellCenterY = blockExtent.yMaximum() - 0.5 * cellSizeY;
-
-    for ( int row = 0; row < iterRows; ++row )
+    // scan the block through a view of its native type, to avoid converting every value through valueAndNoData()
+    const auto scanBlock = [&]( auto valueAndNoData )
     {
-      double cellCenterX = blockExtent.xMinimum() + 0.5 * cellSizeX;
-      for ( int col = 0; col < iterCols; ++col )
+      bool isNoData = false;
+      for ( int row = 0; row < iterRows; ++row )
       {
-        const double pixelValue = block->valueAndNoData( row, col, isNoData );
-        if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
+        scanner.cellCentersInRow( iterTop + row, spans );
+        for ( const std::pair< int, int > &span : spans )
         {
-          QgsPoint cellCenter( cellCenterX, cellCenterY );
-          if ( polyEngine->contains( &cellCenter ) )
+          const int firstCol = std::max( span.first - iterLeft, 0 );
+          const int lastCol = std::min( span.second - iterLeft, iterCols );
+          for ( int col = firstCol; col < lastCol; ++col )
           {
-            addValue( pixelValue );
+            const double pixelValue = valueAndNoData( row, col, isNoData );
+            if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
+            {
+              addValue( pixelValue );
+            }
           }
         }
-        cellCenterX += cellSizeX;
       }
-      cellCenterY -= cellSizeY;
+    };
+
+    const bool viewed = std::as_const( *block ).visitView( [&]( auto view )
+    {
+      scanBlock( [&view]( int row, int col, bool &isNoData )
+      {
+        isNoData = view.isNoData( row, col );
+        return static_cast< double >( view.row( row )[col] );
+      } );
+    } );
+    if ( !viewed )
+    {
+      scanBlock( [&block]( int row, int col, bool &isNoData )
+      {
+        return block->valueAndNoData( row, col, isNoData );
+      } );
     }
   }
 }
 
 void QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox,  const std::function<void( double, double )> &addValue, bool skipNodata )
 {
-  QgsGeometry pixelRectGeometry;
-
-  double hCellSizeX = cellSizeX / 2.0;
-  double hCellSizeY = cellSizeY / 2.0;
-  double pixelArea = cellSizeX * cellSizeY;
-  double weight = 0;
-
-  std::unique_ptr< QgsGeometryEngine > polyEngine( QgsGeometry::createGeometryEngine( poly.constGet( ) ) );
-  if ( !polyEngine )
-  {
-    return;
-  }
-  polyEngine->prepareGeometry();
+  PolygonCellScanner scanner( poly, rasterBBox, cellSizeX, cellSizeY, nCellsX );
 
+  // read blocks spanning the whole width of the window, so that rows are scanned in order
   QgsRasterIterator iter( rasterInterface );
+  iter.setMaximumTileWidth( std::max( nCellsX, 1 ) );
+  iter.setMaximumTileHeight( std::max( 1, QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH * QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT / std::max( nCellsX, 1 ) ) );
   iter.startRasterRead( rasterBand, nCellsX, nCellsY, rasterBBox );
 
   std::unique_ptr< QgsRasterBlock > block;
@@ -127,40 +354,45 @@ void QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( QgsRasterInterfa
   int iterTop = 0;
   int iterCols = 0;
   int iterRows = 0;
-  QgsRectangle blockExtent;
-  bool isNoData = false;
-  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop, &blockExtent ) )
+  std::vector< double > coverage;
+  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop ) )
   {
-    double currentY = blockExtent.yMaximum() - 0.5 * cellSizeY;
-    for ( int row = 0; row < iterRows; ++row )
+    // scan the block through a view of its native type, to avoid converting every value through valueAndNoData()
+    const auto scanBlock = [&]( auto valueAndNoData )
     {
-      double currentX = blockExtent.xMinimum() + 0.5 * cellSizeX;
-      for ( int col = 0; col < iterCols; ++col )
+      bool isNoData = false;
+      for ( int row = 0; row < iterRows; ++row )
       {
-        const double pixelValue = block->valueAndNoData( row, col, isNoData );
-        if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
+        scanner.coverageForRow( iterTop + row, coverage );
+        for ( int col = 0; col < iterCols; ++col )
         {
-          pixelRectGeometry = QgsGeometry::fromRect( QgsRectangle( currentX - hCellSizeX, currentY - hCellSizeY, currentX + hCellSizeX, currentY + hCellSizeY ) );
-          // GEOS intersects tests on prepared geometry is MAGNITUDES faster than calculating the intersection itself,
-          // so we first test to see if there IS an intersection before doing the actual calculation
-          if ( !pixelRectGeometry.isNull() && polyEngine->intersects( pixelRectGeometry.constGet() ) )
+          const double weight = coverage[ static_cast< std::size_t >( iterLeft + col ) ];
+          if ( weight <= 0 )
+            continue;
+
+          const double pixelValue = valueAndNoData( row, col, isNoData );
+          if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
           {
-            //intersection
-            QgsGeometry intersectGeometry = pixelRectGeometry.intersection( poly );
-            if ( !intersectGeometry.isEmpty() )
-            {
-              double intersectionArea = intersectGeometry.area();
-              if ( intersectionArea > 0.0 )
-              {
-                weight = intersectionArea / pixelArea;
-                addValue( pixelValue, weight );
-              }
-            }
+            addValue( pixelValue, weight );
           }
         }
-        currentX += cellSizeX;
       }
-      currentY -= cellSizeY;
+    };
+
+    const bool viewed = std::as_const( *block ).visitView( [&]( auto view )
+    {
+      scanBlock( [&view]( int row, int col, bool &isNoData )
+      {
+        isNoData = view.isNoData( row, col );
+        return static_cast< double >( view.row( row )[col] );
+      } );
+    } );
+    if ( !viewed )
+    {
+      scanBlock( [&block]( int row, int col, bool &isNoData )
+      {
+        return block->valueAndNoData( row, col, isNoData );
+      } );
     }
   }
 }
@@ -228,63 +460,181 @@ Qgis::DataType QgsRasterAnalysisUtils::rasterTypeChoiceToDataType( int choice )
   return sDataTypes.value( choice ).second;
 }
 
-void QgsRasterAnalysisUtils::applyRasterLogicOperator( const std::vector< QgsRasterAnalysisUtils::RasterLogicInput > &inputs, QgsRasterDataProvider *destinationRaster, double outputNoDataValue, const bool treatNoDataAsFalse,
-    int width, int height, const QgsRectangle &extent, QgsFeedback *feedback,
-    std::function<void( const std::vector< std::unique_ptr< QgsRasterBlock > > &, bool &, bool &, int, int, bool )> &applyLogicFunc,
-    qgssize &noDataCount, qgssize &trueCount, qgssize &falseCount )
+std::vector< QgsRasterAnalysisUtils::RasterBlockInput > QgsRasterAnalysisUtils::rasterBlockInputs( const std::vector< QgsRasterAnalysisUtils::RasterLogicInput > &inputs )
+{
+  std::vector< RasterBlockInput > blockInputs;
+  for ( const RasterLogicInput &input : inputs )
+  {
+    for ( int band : input.bands )
+    {
+      RasterBlockInput blockInput;
+      blockInput.interface = input.interface;
+      blockInput.band = band;
+      blockInputs.emplace_back( blockInput );
+    }
+  }
+  return blockInputs;
+}
+
+///@cond PRIVATE
+
+// processing algorithms run from tasks which already occupy threads from the global pool
+Q_GLOBAL_STATIC( QThreadPool, sRasterBlockPool )
+
+//! Maximum total size of the input and output blocks of all blocks in progress
+static const qgssize MAX_BLOCKS_IN_PROGRESS_BYTES = static_cast< qgssize >( QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH ) * QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT * 64;
+
+struct RasterBlockJob
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-  int nbBlocksWidth = static_cast< int>( std::ceil( 1.0 * width / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * height / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
+  std::vector< std::unique_ptr< QgsRasterBlock > > inputBlocks;
+  std::unique_ptr< QgsRasterBlock > outputBlock;
+  int left = 0;
+  int top = 0;
+  std::exception_ptr exception;
+  QFuture< void > future;
+};
+
+///@endcond
+
+void QgsRasterAnalysisUtils::processRasterBlocks( const std::vector< QgsRasterAnalysisUtils::RasterBlockInput > &inputs, QgsRasterDataProvider *destinationRaster,
+    int width, int height, const QgsRectangle &extent, QgsFeedback *feedback, const RasterBlockKernel &kernel )
+{
+  const Qgis::DataType outputDataType = destinationRaster->dataType( 1 );
+  const bool outputHasNoDataValue = destinationRaster->sourceHasNoDataValue( 1 );
+  const double outputNoDataValue = destinationRaster->sourceNoDataValue( 1 );
+
+  // shrink blocks for large stacks of inputs, so that all blocks in progress together stay within the budget
+  int maxBlocksInProgress = std::max( 1, sRasterBlockPool()->maxThreadCount() ) + 1;
+  qgssize bytesPerPixel = static_cast< qgssize >( QgsRasterBlock::typeSize( outputDataType ) );
+  for ( const RasterBlockInput &input : inputs )
+    bytesPerPixel += static_cast< qgssize >( QgsRasterBlock::typeSize( input.interface->dataType( input.band ) ) );
+  bytesPerPixel = std::max< qgssize >( bytesPerPixel, 1 );
+  const int blockWidth = std::max( 1, std::min( width, QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH ) );
+  const int blockHeight = static_cast< int >( std::clamp< qgssize >( MAX_BLOCKS_IN_PROGRESS_BYTES / maxBlocksInProgress / bytesPerPixel / blockWidth,
+                          1, QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT ) );
+  // when even single row blocks exceed their share of the budget, process fewer blocks at once instead
+  const qgssize blockBytes = bytesPerPixel * blockWidth * blockHeight;
+  maxBlocksInProgress = static_cast< int >( std::clamp< qgssize >( MAX_BLOCKS_IN_PROGRESS_BYTES / blockBytes, 1, maxBlocksInProgress ) );
+  const int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * width / blockWidth ) );
+  const int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * height / blockHeight ) );
+  const int nbBlocks = nbBlocksWidth * nbBlocksHeight;
 
   destinationRaster->setEditable( true );
   QgsRasterIterator outputIter( destinationRaster );
+  outputIter.setMaximumTileWidth( blockWidth );
+  outputIter.setMaximumTileHeight( blockHeight );
   outputIter.startRasterRead( 1, width, height, extent );
 
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  QgsRectangle blockExtent;
-  std::unique_ptr< QgsRasterBlock > outputBlock;
-  while ( outputIter.readNextRasterPart( 1, iterCols, iterRows, outputBlock, iterLeft, iterTop, &blockExtent ) )
+  QQueue< std::shared_ptr< RasterBlockJob > > jobs;
+  std::exception_ptr exception;
+  int blocksWritten = 0;
+  bool moreBlocks = true;
+  while ( true )
   {
-    std::vector< std::unique_ptr< QgsRasterBlock > > inputBlocks;
-    for ( const QgsRasterAnalysisUtils::RasterLogicInput &i : inputs )
+    // read ahead while the workers process the blocks already read
+    while ( moreBlocks && !exception && jobs.size() < maxBlocksInProgress && !( feedback && feedback->isCanceled() ) )
     {
-      for ( int band : i.bands )
+      int iterCols = 0;
+      int iterRows = 0;
+      QgsRectangle blockExtent;
+      std::shared_ptr< RasterBlockJob > job = std::make_shared< RasterBlockJob >();
+      moreBlocks = outputIter.next( 1, iterCols, iterRows, job->left, job->top, blockExtent );
+      if ( !moreBlocks )
+        break;
+
+      job->inputBlocks.reserve( inputs.size() );
+      for ( const RasterBlockInput &input : inputs )
       {
-        std::unique_ptr< QgsRasterBlock > b( i.interface->block( band, blockExtent, iterCols, iterRows ) );
-        inputBlocks.emplace_back( std::move( b ) );
+        if ( feedback && feedback->isCanceled() )
+          break; //in case some slow data sources are loaded
+        job->inputBlocks.emplace_back( input.interface->block( input.band, blockExtent, iterCols, iterRows ) );
       }
+      if ( feedback && feedback->isCanceled() )
+        break;
+
+      job->outputBlock = std::make_unique< QgsRasterBlock >( outputDataType, iterCols, iterRows );
+      if ( outputHasNoDataValue )
+        job->outputBlock->setNoDataValue( outputNoDataValue );
+
+      RasterBlockJob *jobPtr = job.get();
+      job->future = QtConcurrent::run( sRasterBlockPool(), [&kernel, jobPtr]
+      {
+        try
+        {
+          kernel( jobPtr->inputBlocks, jobPtr->outputBlock.get() );
+        }
+        catch ( ... )
+        {
+          jobPtr->exception = std::current_exception();
+        }
+      } );
+      jobs.enqueue( job );
     }
 
-    feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    for ( int row = 0; row < iterRows; row++ )
+    if ( jobs.empty() )
+      break;
+
+    std::shared_ptr< RasterBlockJob > job = jobs.dequeue();
+    job->future.waitForFinished();
+    if ( job->exception && !exception )
+      exception = job->exception;
+    if ( exception || ( feedback && feedback->isCanceled() ) )
+      continue;
+
+    destinationRaster->writeBlock( job->outputBlock.get(), 1, job->left, job->top );
+    blocksWritten++;
+    if ( feedback )
+      feedback->setProgress( 100.0 * blocksWritten / nbBlocks );
+  }
+  destinationRaster->setEditable( false );
+
+  if ( exception )
+    std::rethrow_exception( exception );
+}
+
+void QgsRasterAnalysisUtils::applyRasterLogicOperator( const std::vector< QgsRasterAnalysisUtils::RasterLogicInput > &inputs, QgsRasterDataProvider *destinationRaster, double outputNoDataValue, const bool treatNoDataAsFalse,
+    int width, int height, const QgsRectangle &extent, QgsFeedback *feedback,
+    std::function<void( const std::vector< std::unique_ptr< QgsRasterBlock > > &, bool &, bool &, int, int, bool )> &applyLogicFunc,
+    qgssize &noDataCount, qgssize &trueCount, qgssize &falseCount )
+{
+  std::atomic< qgssize > totalNoDataCount( 0 );
+  std::atomic< qgssize > totalTrueCount( 0 );
+  std::atomic< qgssize > totalFalseCount( 0 );
+
+  processRasterBlocks( rasterBlockInputs( inputs ), destinationRaster, width, height, extent, feedback,
+                       [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
+  {
+    qgssize blockNoDataCount = 0;
+    qgssize blockTrueCount = 0;
+    qgssize blockFalseCount = 0;
+    for ( int row = 0; row < outputBlock->height(); row++ )
     {
-      if ( feedback->isCanceled() )
+      if ( feedback && feedback->isCanceled() )
         break;
 
-      for ( int column = 0; column < iterCols; column++ )
+      for ( int column = 0; column < outputBlock->width(); column++ )
       {
         bool res = false;
         bool resIsNoData = false;
         applyLogicFunc( inputBlocks, res, resIsNoData, row, column, treatNoDataAsFalse );
         if ( resIsNoData )
-          noDataCount++;
+          blockNoDataCount++;
         else if ( res )
-          trueCount++;
+          blockTrueCount++;
         else
-          falseCount++;
+          blockFalseCount++;
 
         outputBlock->setValue( row, column, resIsNoData ? outputNoDataValue : ( res ? 1 : 0 ) );
       }
     }
-    destinationRaster->writeBlock( outputBlock.get(), 1, iterLeft, iterTop );
-  }
-  destinationRaster->setEditable( false );
+    totalNoDataCount += blockNoDataCount;
+    totalTrueCount += blockTrueCount;
+    totalFalseCount += blockFalseCount;
+  } );
+
+  noDataCount += totalNoDataCount;
+  trueCount += totalTrueCount;
+  falseCount += totalFalseCount;
 }
 
 std::vector<double> QgsRasterAnalysisUtils::getCellValuesFromBlockStack( const std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, int &row, int &col, bool &noDataInStack )
@@ -46,6 +46,60 @@ namespace QgsRasterAnalysisUtils
                         int rasterWidth, int rasterHeight,
                         QgsRectangle &rasterBlockExtent );
 
+  /**
+   * Scans the cells of a raster window which are covered by a polygon, one row at a time.
+   *
+   * The polygon rings are converted once to an edge table in cell coordinates, so the covered
+   * cells of a row are found by intersecting the edges spanning that row instead of testing
+   * every cell against the polygon geometry.
+   *
+   * Rows must be scanned in increasing order.
+   */
+  class ANALYSIS_EXPORT PolygonCellScanner
+  {
+    public:
+
+      /**
+       * Constructor for PolygonCellScanner, for the polygon \a poly over a window of \a nCellsX
+       * columns with the specified cell size, whose top left corner is the top left of \a windowExtent.
+       */
+      PolygonCellScanner( const QgsGeometry &poly, const QgsRectangle &windowExtent, double cellSizeX, double cellSizeY, int nCellsX );
+
+      /**
+       * Sets \a spans to the column ranges of the cells in \a row with their center point within
+       * the polygon. The first column of each range is inclusive, the second exclusive.
+       */
+      void cellCentersInRow( int row, std::vector< std::pair< int, int > > &spans );
+
+      /**
+       * Sets \a coverage to the fraction of the area of each cell in \a row which is covered by the polygon.
+       */
+      void coverageForRow( int row, std::vector< double > &coverage );
+
+    private:
+
+      struct Edge
+      {
+        double x0 = 0;
+        double y0 = 0;
+        double x1 = 0;
+        double y1 = 0;
+        double dxdy = 0;
+        double direction = 1;
+      };
+
+      void addSegment( double xa, double ya, double xb, double yb, double direction );
+      void addClippedSegment( double xa, double ya, double xb, double yb, double direction );
+      void updateActiveEdges( int row );
+
+      int mCellsX = 0;
+      std::vector< Edge > mEdges;
+      std::size_t mNextEdge = 0;
+      std::vector< std::size_t > mActiveEdges;
+      std::vector< double > mCrossings;
+      std::vector< double > mAccumulation;
+  };
+
   //! Returns statistics by considering the pixels where the center point is within the polygon (fast)
   void statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY,
                                       double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const std::function<void( double )> &addValue, bool skipNodata = true );
@@ -86,6 +140,45 @@ namespace QgsRasterAnalysisUtils
     std::vector< int > bands { 1 };
   };
 
+  /**
+   * Represents a single band read by processRasterBlocks().
+   */
+  struct RasterBlockInput
+  {
+    QgsRasterInterface *interface = nullptr;
+    int band = 1;
+  };
+
+  /**
+   * Returns the bands of all \a inputs, in the order of the inputs and their bands.
+   */
+  std::vector< RasterBlockInput > rasterBlockInputs( const std::vector< RasterLogicInput > &inputs );
+
+  /**
+   * Function called by processRasterBlocks() for every block, with the blocks read from the inputs
+   * (in the same order as the inputs) and the output block to fill.
+   *
+   * Kernels are called concurrently from worker threads, so they must not touch any shared state
+   * without synchronization.
+   */
+  typedef std::function< void( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock *outputBlock ) > RasterBlockKernel;
+
+  /**
+   * Processes a raster of \a width by \a height pixels covering \a extent block by block, calling \a kernel
+   * to compute band 1 of \a destinationRaster from the corresponding blocks of the \a inputs.
+   *
+   * Input blocks are read ahead on the calling thread, since raster interfaces can't be used from several
+   * threads, while kernels run on a thread pool for as many blocks at once as there are processor cores.
+   * Output blocks are written in order on the calling thread. The input and output blocks of all blocks
+   * in progress share a fixed memory budget, so blocks are made smaller for large stacks of inputs, and
+   * fewer blocks are processed at once if even single row blocks would exceed their share of it.
+   *
+   * Exceptions thrown by \a kernel are rethrown on the calling thread, after all blocks in progress
+   * have finished. If \a feedback is canceled then no further blocks are written.
+   */
+  ANALYSIS_EXPORT void processRasterBlocks( const std::vector< RasterBlockInput > &inputs, QgsRasterDataProvider *destinationRaster,
+      int width, int height, const QgsRectangle &extent, QgsFeedback *feedback, const RasterBlockKernel &kernel );
+
   ANALYSIS_EXPORT void applyRasterLogicOperator( const std::vector< QgsRasterAnalysisUtils::RasterLogicInput > &inputs, QgsRasterDataProvider *destinationRaster, double outputNoDataValue, const bool treatNoDataAsFalse,
       int width, int height, const QgsRectangle &extent, QgsFeedback *feedback,
       std::function<void( const std::vector< std::unique_ptr< QgsRasterBlock > > &, bool &, bool &, int, int, bool )> &applyLogicFunc,
@@ -21,11 +21,69 @@
 #include "qgsrasterblock.h"
 #include "qgsprocessingfeedback.h"
 #include "qgsrasterdataprovider.h"
+#include "qgsrasteranalysisutils.h"
 
 #include "qgis.h"
 
+#include <limits>
+#include <type_traits>
+#include <vector>
+
 ///@cond PRIVATE
 
+/**
+ * Reclassifies the values of a \a source view to the \a destination view, which must have the same size.
+ *
+ * For 8 and 16 bit integer sources the output of every possible input value is computed up front,
+ * so that the classes are not searched for every pixel.
+ */
+template <typename SourceView, typename DestinationView>
+static void reclassifyView( const QVector<QgsReclassifyUtils::RasterClass> &classes, const SourceView &source, const DestinationView &destination,
+                            double destNoDataValue, bool useNoDataForMissingValues )
+{
+  typedef typename SourceView::ValueType SourceType;
+  typedef typename DestinationView::ValueType DestinationType;
+
+  const DestinationType noData = static_cast< DestinationType >( destNoDataValue );
+  const qgssize count = source.count();
+  bool reclassed = false;
+
+  if constexpr ( std::is_integral< SourceType >::value && sizeof( SourceType ) <= 2 )
+  {
+    const int minimum = static_cast< int >( std::numeric_limits< SourceType >::lowest() );
+    const int maximum = static_cast< int >( std::numeric_limits< SourceType >::max() );
+    std::vector< DestinationType > lookup( static_cast< std::size_t >( maximum - minimum + 1 ) );
+    for ( int value = minimum; value <= maximum; ++value )
+    {
+      const double newValue = QgsReclassifyUtils::reclassifyValue( classes, value, reclassed );
+      lookup[ value - minimum ] = reclassed ? static_cast< DestinationType >( newValue )
+                                  : ( useNoDataForMissingValues ? noData : static_cast< DestinationType >( value ) );
+    }
+
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      destination[i] = source.isNoData( i ) ? noData : lookup[ static_cast< int >( source[i] ) - minimum ];
+    }
+    return;
+  }
+
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    if ( source.isNoData( i ) )
+    {
+      destination[i] = noData;
+      continue;
+    }
+
+    const double value = static_cast< double >( source[i] );
+    const double newValue = QgsReclassifyUtils::reclassifyValue( classes, value, reclassed );
+    if ( reclassed )
+      destination[i] = static_cast< DestinationType >( newValue );
+    else
+      destination[i] = useNoDataForMissingValues ? noData : static_cast< DestinationType >( value );
+  }
+}
+
 void QgsReclassifyUtils::reportClasses( const QVector<QgsReclassifyUtils::RasterClass> &classes, QgsProcessingFeedback *feedback )
 {
   int i = 1;
@@ -65,54 +123,17 @@ void QgsReclassifyUtils::reclassify( const QVector<QgsReclassifyUtils::RasterCla
                                      QgsRasterDataProvider *destinationRaster, double destNoDataValue, bool useNoDataForMissingValues,
                                      QgsProcessingFeedback *feedback )
 {
-  int maxWidth = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH;
-  int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
-
-  QgsRasterIterator iter( sourceRaster );
-  iter.startRasterRead( band, sourceWidthPixels, sourceHeightPixels, extent );
-
-  int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * sourceWidthPixels / maxWidth ) );
-  int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * sourceHeightPixels / maxHeight ) );
-  int nbBlocks = nbBlocksWidth * nbBlocksHeight;
-
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-  destinationRaster->setEditable( true );
-  std::unique_ptr< QgsRasterBlock > rasterBlock;
-  bool reclassed = false;
-  bool isNoData = false;
-  while ( iter.readNextRasterPart( band, iterCols, iterRows, rasterBlock, iterLeft, iterTop ) )
+  QgsRasterAnalysisUtils::processRasterBlocks( { { sourceRaster, band } }, destinationRaster, sourceWidthPixels, sourceHeightPixels, extent, feedback,
+      [&]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
   {
-    if ( feedback )
-      feedback->setProgress( 100 * ( ( iterTop / maxHeight * nbBlocksWidth ) + iterLeft / maxWidth ) / nbBlocks );
-    if ( feedback && feedback->isCanceled() )
-      break;
-    std::unique_ptr< QgsRasterBlock > reclassifiedBlock = std::make_unique< QgsRasterBlock >( destinationRaster->dataType( 1 ), iterCols, iterRows );
-
-    for ( int row = 0; row < iterRows; row++ )
+    inputBlocks.front()->visitView( [&]( auto sourceView )
     {
-      if ( feedback && feedback->isCanceled() )
-        break;
-      for ( int column = 0; column < iterCols; column++ )
+      outputBlock->visitView( [&]( auto destinationView )
       {
-        const double value = rasterBlock->valueAndNoData( row, column, isNoData );
-        if ( isNoData )
-          reclassifiedBlock->setValue( row, column, destNoDataValue );
-        else
-        {
-          double newValue = reclassifyValue( classes, value, reclassed );
-          if ( reclassed )
-            reclassifiedBlock->setValue( row, column, newValue );
-          else
-            reclassifiedBlock->setValue( row, column, useNoDataForMissingValues ? destNoDataValue : value );
-        }
-      }
-    }
-    destinationRaster->writeBlock( reclassifiedBlock.get(), 1, iterLeft, iterTop );
-  }
-  destinationRaster->setEditable( false );
+        reclassifyView( classes, sourceView, destinationView, destNoDataValue, useNoDataForMissingValues );
+      } );
+    } );
+  } );
 }
 
 
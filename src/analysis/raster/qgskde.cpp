@@ -17,9 +17,28 @@
 #include "qgsfeaturesource.h"
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
+#include "qgsfeedback.h"
+
+#include <QQueue>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include <memory>
 
 #define NO_DATA -9999
 
+///@cond PRIVATE
+
+// the surface is commonly calculated from tasks which already occupy threads from the global pool
+Q_GLOBAL_STATIC( QThreadPool, sKdeTilePool )
+
+//! Width and height of the tiles of the output raster, in pixels
+static const int KDE_TILE_SIZE = 1024;
+//! Number of binned points above which the tiles are written to the raster while features are still being added
+static const std::size_t MAX_BINNED_KERNEL_POINTS = 1000000;
+
+///@endcond
+
 QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEstimation::Parameters &parameters, const QString &outputFile, const QString &outputFormat )
   : mSource( parameters.source )
   , mOutputFile( outputFile )
@@ -83,12 +102,20 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
   if ( mBounds.isNull() )
     return InvalidParameters;
 
-  int rows = std::max( std::ceil( mBounds.height() / mPixelSize ) + 1, 1.0 );
-  int cols = std::max( std::ceil( mBounds.width() / mPixelSize ) + 1, 1.0 );
+  mRows = std::max( std::ceil( mBounds.height() / mPixelSize ) + 1, 1.0 );
+  mColumns = std::max( std::ceil( mBounds.width() / mPixelSize ) + 1, 1.0 );
 
-  if ( !createEmptyLayer( driver, mBounds, rows, cols ) )
+  if ( !createEmptyLayer( driver, mBounds, mRows, mColumns ) )
     return FileCreationError;
 
+  // points are binned by the output tiles covered by their footprint, and the tiles are calculated in finalise()
+  mTileCountX = ( mColumns + KDE_TILE_SIZE - 1 ) / KDE_TILE_SIZE;
+  mTileCountY = ( mRows + KDE_TILE_SIZE - 1 ) / KDE_TILE_SIZE;
+  mTilePoints.clear();
+  mTilePoints.resize( static_cast< std::size_t >( mTileCountX ) * mTileCountY );
+  mTileWritten.assign( mTilePoints.size(), false );
+  mBinnedPointCount = 0;
+
   // open the raster in GA_Update mode
   mDatasetH.reset( GDALOpen( mOutputFile.toUtf8().constData(), GA_Update ) );
   if ( !mDatasetH )
@@ -157,59 +184,188 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
     }
 
     // calculate the pixel position
-    unsigned int xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
-
-
-    // get the data
-    float *dataBuffer = ( float * ) CPLMalloc( sizeof( float ) * blockSize * blockSize );
-    if ( GDALRasterIO( mRasterBandH, GF_Read, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
+    const double xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
+    const double yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
+    const double yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
+
+    // the whole footprint must be within the raster
+    if ( blockSize <= 0 || xPosition <= -1 || yPosition <= -1 || yPositionIO <= -1
+         || static_cast< unsigned int >( xPosition ) + blockSize > static_cast< unsigned int >( mColumns )
+         || static_cast< unsigned int >( yPositionIO ) + blockSize > static_cast< unsigned int >( mRows ) )
     {
       result = RasterIoError;
+      continue;
     }
 
-    for ( int xp = 0; xp < blockSize; xp++ )
+    KernelPoint point;
+    point.x = ( *pointIt ).x();
+    point.y = ( *pointIt ).y();
+    point.radius = radius;
+    point.weight = weight;
+    point.buffer = buffer;
+    point.xPosition = static_cast< unsigned int >( xPosition );
+    point.yPosition = static_cast< unsigned int >( yPosition );
+    point.yPositionIO = static_cast< unsigned int >( yPositionIO );
+
+    const int firstTileX = static_cast< int >( point.xPosition ) / KDE_TILE_SIZE;
+    const int lastTileX = ( static_cast< int >( point.xPosition ) + blockSize - 1 ) / KDE_TILE_SIZE;
+    const int firstTileY = static_cast< int >( point.yPositionIO ) / KDE_TILE_SIZE;
+    const int lastTileY = ( static_cast< int >( point.yPositionIO ) + blockSize - 1 ) / KDE_TILE_SIZE;
+    for ( int tileY = firstTileY; tileY <= lastTileY; ++tileY )
     {
-      for ( int yp = 0; yp < blockSize; yp++ )
+      for ( int tileX = firstTileX; tileX <= lastTileX; ++tileX )
       {
-        double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
-        double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
-
-        double distance = std::sqrt( std::pow( pixelCentroidX - ( *pointIt ).x(), 2.0 ) + std::pow( pixelCentroidY - ( *pointIt ).y(), 2.0 ) );
-
-        // is pixel outside search bandwidth of feature?
-        if ( distance > radius )
-        {
-          continue;
-        }
-
-        double pixelValue = weight * calculateKernelValue( distance, radius, mShape, mOutputValues );
-        int pos = xp + blockSize * yp;
-        if ( dataBuffer[ pos ] == NO_DATA )
-        {
-          dataBuffer[ pos ] = 0;
-        }
-        dataBuffer[ pos ] += pixelValue;
+        mTilePoints[ static_cast< std::size_t >( tileY ) * mTileCountX + tileX ].emplace_back( point );
+        mBinnedPointCount++;
       }
     }
-    if ( GDALRasterIO( mRasterBandH, GF_Write, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      result = RasterIoError;
-    }
-    CPLFree( dataBuffer );
   }
 
+  // the surface is additive, so the points binned so far can be added to the raster early to bound their memory
+  if ( mBinnedPointCount > MAX_BINNED_KERNEL_POINTS && writeTiles( false, nullptr ) != Success )
+    result = RasterIoError;
+
   return result;
 }
 
-QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
+void QgsKernelDensityEstimation::addPointToTile( const KernelPoint &point, int tileLeft, int tileTop, int tileColumns, int tileRows, std::vector< float > &data, std::vector< double > &offsets ) const
 {
+  const int blockSize = 2 * point.buffer + 1;
+  const int firstColumn = std::max( tileLeft - static_cast< int >( point.xPosition ), 0 );
+  const int lastColumn = std::min( tileLeft + tileColumns - static_cast< int >( point.xPosition ), blockSize );
+  const int firstRow = std::max( tileTop - static_cast< int >( point.yPositionIO ), 0 );
+  const int lastRow = std::min( tileTop + tileRows - static_cast< int >( point.yPositionIO ), blockSize );
+
+  // the squared horizontal offsets from the point are shared by all rows of the footprint
+  offsets.resize( static_cast< std::size_t >( blockSize ) );
+  for ( int xp = firstColumn; xp < lastColumn; xp++ )
+  {
+    const double pixelCentroidX = ( point.xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
+    offsets[ xp ] = std::pow( pixelCentroidX - point.x, 2.0 );
+  }
+
+  for ( int yp = firstRow; yp < lastRow; yp++ )
+  {
+    const double pixelCentroidY = ( point.yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
+    const double yOffset = std::pow( pixelCentroidY - point.y, 2.0 );
+    float *row = data.data() + static_cast< std::size_t >( point.yPositionIO + yp - tileTop ) * tileColumns + ( point.xPosition - tileLeft );
+    for ( int xp = firstColumn; xp < lastColumn; xp++ )
+    {
+      const double distance = std::sqrt( offsets[ xp ] + yOffset );
+
+      // is pixel outside search bandwidth of feature?
+      if ( distance > point.radius )
+      {
+        continue;
+      }
+
+      const double pixelValue = point.weight * calculateKernelValue( distance, point.radius, mShape, mOutputValues );
+      if ( row[ xp ] == NO_DATA )
+      {
+        row[ xp ] = 0;
+      }
+      row[ xp ] += pixelValue;
+    }
+  }
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise( QgsFeedback *feedback )
+{
+  Result result = Success;
+  if ( mRasterBandH )
+    result = writeTiles( true, feedback );
+
+  mTilePoints.clear();
+  mTileWritten.clear();
+  mBinnedPointCount = 0;
   mDatasetH.reset();
   mRasterBandH = nullptr;
-  return Success;
+  return result;
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::writeTiles( bool allTiles, QgsFeedback *feedback )
+{
+  // tiles are calculated in parallel, and read and written in order from this thread
+  struct Tile
+  {
+    int left = 0;
+    int top = 0;
+    int columns = 0;
+    int rows = 0;
+    std::size_t index = 0;
+    std::shared_ptr< std::vector< float > > data;
+  };
+
+  auto calculateTile = [this]( const Tile & tile ) -> std::shared_ptr< std::vector< float > >
+  {
+    std::vector< double > offsets;
+    std::vector< KernelPoint > &points = mTilePoints[ tile.index ];
+    for ( const KernelPoint &point : points )
+    {
+      addPointToTile( point, tile.left, tile.top, tile.columns, tile.rows, *tile.data, offsets );
+    }
+    std::vector< KernelPoint >().swap( points );
+    return tile.data;
+  };
+
+  std::vector< std::size_t > tiles;
+  for ( std::size_t index = 0; index < mTilePoints.size(); ++index )
+  {
+    if ( !mTilePoints[ index ].empty() || ( allTiles && !mTileWritten[ index ] ) )
+      tiles.emplace_back( index );
+  }
+
+  Result result = Success;
+  const int maxTilesInProgress = std::max( 1, sKdeTilePool()->maxThreadCount() ) + 1;
+  QQueue< QPair< Tile, QFuture< std::shared_ptr< std::vector< float > > > > > pending;
+  std::size_t nextTile = 0;
+  std::size_t writtenTiles = 0;
+  while ( nextTile < tiles.size() || !pending.isEmpty() )
+  {
+    while ( nextTile < tiles.size() && pending.size() < maxTilesInProgress && !( feedback && feedback->isCanceled() ) )
+    {
+      Tile tile;
+      tile.index = tiles[ nextTile++ ];
+      tile.left = static_cast< int >( tile.index % mTileCountX ) * KDE_TILE_SIZE;
+      tile.top = static_cast< int >( tile.index / mTileCountX ) * KDE_TILE_SIZE;
+      tile.columns = std::min( KDE_TILE_SIZE, mColumns - tile.left );
+      tile.rows = std::min( KDE_TILE_SIZE, mRows - tile.top );
+      tile.data = std::make_shared< std::vector< float > >( static_cast< std::size_t >( tile.columns ) * tile.rows, static_cast< float >( NO_DATA ) );
+
+      // tiles which were already written keep accumulating onto their existing values
+      if ( mTileWritten[ tile.index ] && GDALRasterIO( mRasterBandH, GF_Read, tile.left, tile.top, tile.columns, tile.rows,
+           tile.data->data(), tile.columns, tile.rows, GDT_Float32, 0, 0 ) != CE_None )
+      {
+        result = RasterIoError;
+      }
+      pending.enqueue( qMakePair( tile, QtConcurrent::run( sKdeTilePool(), calculateTile, tile ) ) );
+    }
+
+    if ( pending.isEmpty() )
+      break;
+
+    const QPair< Tile, QFuture< std::shared_ptr< std::vector< float > > > > next = pending.dequeue();
+    const Tile &tile = next.first;
+    std::shared_ptr< std::vector< float > > data = next.second.result();
+    if ( feedback && feedback->isCanceled() )
+      continue;
+
+    if ( GDALRasterIO( mRasterBandH, GF_Write, tile.left, tile.top, tile.columns, tile.rows,
+                       data->data(), tile.columns, tile.rows, GDT_Float32, 0, 0 ) != CE_None )
+    {
+      result = RasterIoError;
+    }
+    mTileWritten[ tile.index ] = true;
+
+    if ( feedback )
+      feedback->setProgress( 100.0 * static_cast< double >( ++writtenTiles ) / tiles.size() );
+  }
+
+  mBinnedPointCount = 0;
+  if ( feedback && feedback->isCanceled() )
+    return Canceled;
+
+  return result;
 }
 
 int QgsKernelDensityEstimation::radiusSizeInPixels( double radius ) const
@@ -243,21 +399,7 @@ bool QgsKernelDensityEstimation::createEmptyLayer( GDALDriverH driver, const Qgs
   if ( GDALSetRasterNoDataValue( poBand, NO_DATA ) != CE_None )
     return false;
 
-  float *line = static_cast< float * >( CPLMalloc( sizeof( float ) * columns ) );
-  for ( int i = 0; i < columns; i++ )
-  {
-    line[i] = NO_DATA;
-  }
-  // Write the empty raster
-  for ( int i = 0; i < rows ; i++ )
-  {
-    if ( GDALRasterIO( poBand, GF_Write, 0, i, columns, 1, line, columns, 1, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      return false;
-    }
-  }
-
-  CPLFree( line );
+  // the raster values are all written by finalise(), tile by tile
   return true;
 }
 
@@ -19,6 +19,7 @@
 #include "qgsrectangle.h"
 #include "qgsogrutils.h"
 #include <QString>
+#include <vector>
 
 // GDAL includes
 #include <gdal.h>
@@ -28,6 +29,7 @@
 
 class QgsFeatureSource;
 class QgsFeature;
+class QgsFeedback;
 
 
 /**
@@ -65,6 +67,7 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
       InvalidParameters, //!< Input parameters were not valid
       FileCreationError, //!< Error creating output file
       RasterIoError, //!< Error writing to raster
+      Canceled, //!< Operation was canceled. Since QGIS 3.20
     };
 
     //! KDE parameters
@@ -129,10 +132,14 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     /**
      * Finalises the output file. Must be called after adding all features via addFeature().
+     *
+     * Since QGIS 3.20 an optional \a feedback can be specified, which receives the progress of the
+     * surface calculation and can be used to cancel it.
+     *
      * \see prepare()
      * \see addFeature()
      */
-    Result finalise();
+    Result finalise( QgsFeedback *feedback = nullptr );
 
   private:
 
@@ -151,6 +158,28 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     QgsRectangle calculateBounds() const;
 
+    //! A point added to the surface, together with the position of its kernel footprint in the output raster
+    struct KernelPoint
+    {
+      double x = 0;
+      double y = 0;
+      double radius = 0;
+      double weight = 1;
+      int buffer = 0;
+      unsigned int xPosition = 0;
+      unsigned int yPosition = 0;
+      unsigned int yPositionIO = 0;
+    };
+
+    //! Adds the kernel footprint of \a point to the \a data of the output tile with the specified extent in pixels
+    void addPointToTile( const KernelPoint &point, int tileLeft, int tileTop, int tileColumns, int tileRows, std::vector< float > &data, std::vector< double > &offsets ) const;
+
+    /**
+     * Adds the points binned for each output tile to the tile's values in the raster, and releases them.
+     * If \a allTiles is TRUE, tiles which were never written are written even if no points cover them.
+     */
+    Result writeTiles( bool allTiles, QgsFeedback *feedback );
+
     QgsFeatureSource *mSource = nullptr;
 
     QString mOutputFile;
@@ -168,6 +197,18 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     int mBufferSize;
 
+    int mRows = 0;
+    int mColumns = 0;
+    int mTileCountX = 0;
+    int mTileCountY = 0;
+
+    //! Points with a footprint intersecting each output tile, in the order they were added
+    std::vector< std::vector< KernelPoint > > mTilePoints;
+    //! Whether each output tile already holds values written to the raster
+    std::vector< bool > mTileWritten;
+    //! Number of points currently binned in mTilePoints
+    std::size_t mBinnedPointCount = 0;
+
     gdal::dataset_unique_ptr mDatasetH;
     GDALRasterBandH mRasterBandH;
 
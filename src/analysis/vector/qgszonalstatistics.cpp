@@ -27,8 +27,25 @@
 #include "qgsrasterlayer.h"
 #include "qgslogger.h"
 #include "qgsproject.h"
+#include "qgsrasteriterator.h"
+#include "qgsrasterblock.h"
 
 #include <QFile>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+///@cond PRIVATE
+
+// zonal statistics are commonly calculated from tasks which already occupy threads from the global pool
+Q_GLOBAL_STATIC( QThreadPool, sZonalStatisticsPool )
+
+//! Minimum number of raster rows per strip when sweeping multiple zones in parallel
+static const int MIN_ROWS_PER_STRIP = 256;
+//! Maximum number of zones whose geometries are held in memory and swept together
+static const int MAX_ZONES_PER_SWEEP = 10000;
+//! Minimum fraction of the swept cells which must lie within a zone's bounding box for a sweep to be used instead of reading each zone separately
+static const double MIN_SWEEP_COVERAGE = 0.5;
+///@endcond
 
 QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix, int rasterBand, QgsZonalStatistics::Statistics stats )
   : QgsZonalStatistics( polygonLayer,
@@ -121,36 +138,61 @@ QgsZonalStatistics::Result QgsZonalStatistics::calculateStatistics( QgsFeedback
 
   int featureCounter = 0;
 
+  // zones are processed in batches, which bounds the number of geometries held in memory and
+  // keeps the results of the zones already processed when the calculation is canceled
   QgsChangedAttributesMap changeMap;
-  while ( fi.nextFeature( feature ) )
+  QVector< QgsFeatureId > featureIds;
+  QVector< QgsGeometry > geometries;
+  auto processBatch = [&]
   {
-    ++featureCounter;
-    if ( feedback && feedback->isCanceled() )
+    QgsFeedback batchFeedback;
+    if ( feedback )
     {
-      break;
+      const double batchStart = featureCount > 0 ? 100.0 * static_cast< double >( featureCounter - geometries.size() ) / featureCount : 0;
+      const double batchProgress = featureCount > 0 ? static_cast< double >( geometries.size() ) / featureCount : 0;
+      QObject::connect( feedback, &QgsFeedback::canceled, &batchFeedback, &QgsFeedback::cancel, Qt::DirectConnection );
+      QObject::connect( &batchFeedback, &QgsFeedback::progressChanged, feedback, [ = ]( double progress )
+      {
+        feedback->setProgress( batchStart + batchProgress * progress );
+      }, Qt::DirectConnection );
     }
 
-    if ( feedback )
+    const QList<QMap<QgsZonalStatistics::Statistic, QVariant> > results = calculateStatistics( mRasterInterface, geometries, mCellSizeX, mCellSizeY, mRasterBand, mStatistics, feedback ? &batchFeedback : nullptr );
+    for ( int i = 0; i < results.size(); ++i )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
-    }
+      if ( results.at( i ).empty() )
+        continue;
 
-    QgsGeometry featureGeometry = feature.geometry();
+      QgsAttributeMap changeAttributeMap;
+      for ( auto it = results.at( i ).constBegin(); it != results.at( i ).constEnd(); ++it )
+      {
+        changeAttributeMap.insert( statFieldIndexes.value( it.key() ), it.value() );
+      }
 
-    QMap<QgsZonalStatistics::Statistic, QVariant> results = calculateStatistics( mRasterInterface, featureGeometry, mCellSizeX, mCellSizeY, mRasterBand, mStatistics );
+      changeMap.insert( featureIds.at( i ), changeAttributeMap );
+    }
 
-    if ( results.empty() )
-      continue;
+    featureIds.clear();
+    geometries.clear();
+  };
 
-    QgsAttributeMap changeAttributeMap;
-    for ( const auto &result : results.toStdMap() )
+  while ( fi.nextFeature( feature ) )
+  {
+    ++featureCounter;
+    if ( feedback && feedback->isCanceled() )
     {
-      changeAttributeMap.insert( statFieldIndexes.value( result.first ), result.second );
+      break;
     }
 
-    changeMap.insert( feature.id(), changeAttributeMap );
+    featureIds << feature.id();
+    geometries << feature.geometry();
+    if ( geometries.size() >= MAX_ZONES_PER_SWEEP )
+      processBatch();
   }
 
+  if ( !geometries.isEmpty() && ( !feedback || !feedback->isCanceled() ) )
+    processBatch();
+
   vectorProvider->changeAttributeValues( changeMap );
   mPolygonLayer->updateFields();
 
@@ -339,6 +381,13 @@ QMap<QgsZonalStatistics::Statistic, QVariant> QgsZonalStatistics::calculateStati
     QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( rasterInterface, rasterBand, geometry, nCellsX, nCellsY, cellSizeX, cellSizeY, rasterBlockExtent, [ &featureStats ]( double value, double weight ) { featureStats.addValue( value, weight ); } );
   }
 
+  return statisticsFromFeatureStats( featureStats, statistics );
+}
+
+QMap<QgsZonalStatistics::Statistic, QVariant> QgsZonalStatistics::statisticsFromFeatureStats( FeatureStats &featureStats, QgsZonalStatistics::Statistics statistics )
+{
+  QMap<QgsZonalStatistics::Statistic, QVariant> results;
+
   // calculate the statistics
 
   if ( statistics & QgsZonalStatistics::Count )
@@ -410,3 +459,286 @@ QMap<QgsZonalStatistics::Statistic, QVariant> QgsZonalStatistics::calculateStati
 
   return results;
 }
+
+QList<QMap<QgsZonalStatistics::Statistic, QVariant> > QgsZonalStatistics::calculateStatistics( QgsRasterInterface *rasterInterface, const QVector<QgsGeometry> &geometries, double cellSizeX, double cellSizeY, int rasterBand, QgsZonalStatistics::Statistics statistics, QgsFeedback *feedback )
+{
+  QList<QMap<QgsZonalStatistics::Statistic, QVariant> > results;
+  results.reserve( geometries.size() );
+  for ( int i = 0; i < geometries.size(); ++i )
+    results.append( QMap<QgsZonalStatistics::Statistic, QVariant>() );
+
+  if ( !rasterInterface || geometries.isEmpty() )
+    return results;
+
+  const QgsRectangle rasterBBox = rasterInterface->extent();
+  const int nCellsXProvider = rasterInterface->xSize();
+  const int nCellsYProvider = rasterInterface->ySize();
+  if ( nCellsXProvider <= 0 || nCellsYProvider <= 0 )
+    return results;
+
+  // find the raster rows and columns covered by each zone
+  std::vector< std::pair< int, int > > zoneRows( static_cast< std::size_t >( geometries.size() ), std::make_pair( 0, 0 ) );
+  std::vector< std::pair< int, int > > zoneCols( static_cast< std::size_t >( geometries.size() ), std::make_pair( 0, 0 ) );
+  int sweepFirstRow = nCellsYProvider;
+  int sweepLastRow = 0;
+  int sweepFirstCol = nCellsXProvider;
+  int sweepLastCol = 0;
+  double zoneCells = 0;
+  for ( int i = 0; i < geometries.size(); ++i )
+  {
+    const QgsGeometry &geometry = geometries.at( i );
+    if ( geometry.isEmpty() )
+      continue;
+
+    const QgsRectangle featureRect = geometry.boundingBox().intersect( rasterBBox );
+    if ( featureRect.isEmpty() )
+      continue;
+
+    int nCellsX, nCellsY;
+    QgsRectangle rasterBlockExtent;
+    QgsRasterAnalysisUtils::cellInfoForBBox( rasterBBox, featureRect, cellSizeX, cellSizeY, nCellsX, nCellsY, nCellsXProvider, nCellsYProvider, rasterBlockExtent );
+    if ( nCellsX <= 0 || nCellsY <= 0 )
+      continue;
+
+    const int firstRow = static_cast< int >( std::round( ( rasterBBox.yMaximum() - rasterBlockExtent.yMaximum() ) / cellSizeY ) );
+    const int firstCol = static_cast< int >( std::round( ( rasterBlockExtent.xMinimum() - rasterBBox.xMinimum() ) / cellSizeX ) );
+    zoneRows[ static_cast< std::size_t >( i ) ] = std::make_pair( firstRow, firstRow + nCellsY );
+    zoneCols[ static_cast< std::size_t >( i ) ] = std::make_pair( firstCol, firstCol + nCellsX );
+    sweepFirstRow = std::min( sweepFirstRow, firstRow );
+    sweepLastRow = std::max( sweepLastRow, firstRow + nCellsY );
+    sweepFirstCol = std::min( sweepFirstCol, firstCol );
+    sweepLastCol = std::max( sweepLastCol, firstCol + nCellsX );
+    zoneCells += static_cast< double >( nCellsX ) * nCellsY;
+  }
+  if ( sweepLastRow <= sweepFirstRow || sweepLastCol <= sweepFirstCol )
+    return results;
+
+  // when the zones are sparse, most of the cells swept would not be covered by any zone, so it is
+  // cheaper to read the block under each zone separately
+  const double sweptCells = static_cast< double >( sweepLastRow - sweepFirstRow ) * ( sweepLastCol - sweepFirstCol );
+  if ( geometries.size() == 1 || zoneCells < sweptCells * MIN_SWEEP_COVERAGE )
+  {
+    for ( int i = 0; i < geometries.size(); ++i )
+    {
+      if ( feedback && feedback->isCanceled() )
+        break;
+
+      if ( zoneRows[ static_cast< std::size_t >( i ) ].second > zoneRows[ static_cast< std::size_t >( i ) ].first )
+        results[i] = calculateStatistics( rasterInterface, geometries.at( i ), cellSizeX, cellSizeY, rasterBand, statistics );
+
+      if ( feedback )
+        feedback->setProgress( 100.0 * ( i + 1 ) / geometries.size() );
+    }
+    return results;
+  }
+
+  const bool statsStoreValues = ( statistics & QgsZonalStatistics::Median ) ||
+                                ( statistics & QgsZonalStatistics::StDev ) ||
+                                ( statistics & QgsZonalStatistics::Variance );
+  const bool statsStoreValueCount = ( statistics & QgsZonalStatistics::Minority ) ||
+                                    ( statistics & QgsZonalStatistics::Majority );
+
+  // split the swept rows into one strip per thread, each reading from its own clone of the raster
+  const int sweepRows = sweepLastRow - sweepFirstRow;
+  int stripCount = std::max( 1, std::min( std::max( 1, sZonalStatisticsPool()->maxThreadCount() ), sweepRows / MIN_ROWS_PER_STRIP ) );
+  std::vector< std::unique_ptr< QgsRasterInterface > > clones;
+  if ( stripCount > 1 )
+  {
+    for ( int strip = 0; strip < stripCount; ++strip )
+    {
+      std::unique_ptr< QgsRasterInterface > clone( rasterInterface->clone() );
+      if ( !clone )
+      {
+        // can't read in parallel, sweep the whole raster in this thread instead
+        clones.clear();
+        stripCount = 1;
+        break;
+      }
+      clones.emplace_back( std::move( clone ) );
+    }
+  }
+  const int rowsPerStrip = ( sweepRows + stripCount - 1 ) / stripCount;
+
+  std::vector< std::map< int, FeatureStats > > stripStats( static_cast< std::size_t >( stripCount ) );
+  if ( stripCount == 1 )
+  {
+    accumulateStrip( rasterInterface, rasterBand, geometries, zoneRows, zoneCols, sweepFirstRow, sweepLastRow, cellSizeX, cellSizeY,
+                     statsStoreValues, statsStoreValueCount, stripStats[0], feedback, true );
+  }
+  else
+  {
+    QList< QFuture< void > > futures;
+    for ( int strip = 0; strip < stripCount; ++strip )
+    {
+      const int firstRow = sweepFirstRow + strip * rowsPerStrip;
+      const int lastRow = std::min( sweepLastRow, firstRow + rowsPerStrip );
+      QgsRasterInterface *stripInterface = clones[ static_cast< std::size_t >( strip ) ].get();
+      std::map< int, FeatureStats > *stats = &stripStats[ static_cast< std::size_t >( strip ) ];
+      futures << QtConcurrent::run( sZonalStatisticsPool(), [ =, &geometries, &zoneRows, &zoneCols ]
+      {
+        accumulateStrip( stripInterface, rasterBand, geometries, zoneRows, zoneCols, firstRow, lastRow, cellSizeX, cellSizeY,
+                         statsStoreValues, statsStoreValueCount, *stats, feedback, false );
+      } );
+    }
+
+    for ( int strip = 0; strip < futures.size(); ++strip )
+    {
+      futures[strip].waitForFinished();
+      if ( feedback )
+        feedback->setProgress( 100.0 * ( strip + 1 ) / futures.size() );
+    }
+  }
+
+  if ( feedback && feedback->isCanceled() )
+    return results;
+
+  // merge the strips in order, so that values are collected in the same order as for a single zone
+  std::vector< FeatureStats > zoneStats( static_cast< std::size_t >( geometries.size() ), FeatureStats( statsStoreValues, statsStoreValueCount ) );
+  for ( const std::map< int, FeatureStats > &stats : stripStats )
+  {
+    for ( const auto &zone : stats )
+      zoneStats[ static_cast< std::size_t >( zone.first ) ].merge( zone.second );
+  }
+
+  for ( int i = 0; i < geometries.size(); ++i )
+  {
+    const std::pair< int, int > &rows = zoneRows[ static_cast< std::size_t >( i ) ];
+    if ( rows.second <= rows.first )
+      continue;
+
+    FeatureStats &stats = zoneStats[ static_cast< std::size_t >( i ) ];
+    if ( stats.count <= 1 )
+    {
+      // the cell resolution is probably larger than the polygon area, so use the precise pixel - polygon intersection
+      results[i] = calculateStatistics( rasterInterface, geometries.at( i ), cellSizeX, cellSizeY, rasterBand, statistics );
+    }
+    else
+    {
+      results[i] = statisticsFromFeatureStats( stats, statistics );
+    }
+  }
+
+  return results;
+}
+
+void QgsZonalStatistics::accumulateStrip( QgsRasterInterface *rasterInterface, int rasterBand, const QVector<QgsGeometry> &geometries,
+    const std::vector<std::pair<int, int> > &zoneRows, const std::vector<std::pair<int, int> > &zoneCols, int firstRow, int lastRow,
+    double cellSizeX, double cellSizeY, bool storeValues, bool storeValueCounts, std::map<int, FeatureStats> &stats, QgsFeedback *feedback, bool reportProgress )
+{
+  // zones overlapping the strip, in order of their first row
+  std::vector< int > zones;
+  for ( int i = 0; i < geometries.size(); ++i )
+  {
+    const std::pair< int, int > &rows = zoneRows[ static_cast< std::size_t >( i ) ];
+    if ( rows.second > rows.first && rows.first < lastRow && rows.second > firstRow )
+      zones.emplace_back( i );
+  }
+  if ( zones.empty() )
+    return;
+
+  std::stable_sort( zones.begin(), zones.end(), [&zoneRows]( int a, int b ) { return zoneRows[ static_cast< std::size_t >( a ) ].first < zoneRows[ static_cast< std::size_t >( b ) ].first; } );
+
+  // only read the rows and columns of the strip which are covered by a zone
+  int stripFirstRow = lastRow;
+  int stripLastRow = firstRow;
+  int stripFirstCol = std::numeric_limits< int >::max();
+  int stripLastCol = 0;
+  for ( int zone : zones )
+  {
+    const std::pair< int, int > &rows = zoneRows[ static_cast< std::size_t >( zone ) ];
+    const std::pair< int, int > &cols = zoneCols[ static_cast< std::size_t >( zone ) ];
+    stripFirstRow = std::min( stripFirstRow, std::max( rows.first, firstRow ) );
+    stripLastRow = std::max( stripLastRow, std::min( rows.second, lastRow ) );
+    stripFirstCol = std::min( stripFirstCol, cols.first );
+    stripLastCol = std::max( stripLastCol, cols.second );
+  }
+
+  const QgsRectangle rasterBBox = rasterInterface->extent();
+  const int nCellsX = stripLastCol - stripFirstCol;
+  const QgsRectangle stripExtent( rasterBBox.xMinimum() + stripFirstCol * cellSizeX, rasterBBox.yMaximum() - stripLastRow * cellSizeY,
+                                  rasterBBox.xMinimum() + stripLastCol * cellSizeX, rasterBBox.yMaximum() - stripFirstRow * cellSizeY );
+
+  // read blocks spanning the whole width of the strip, so that each zone's rows are scanned in order
+  QgsRasterIterator iter( rasterInterface );
+  iter.setMaximumTileWidth( nCellsX );
+  iter.setMaximumTileHeight( std::max( 1, QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH * QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT / nCellsX ) );
+  iter.startRasterRead( rasterBand, nCellsX, stripLastRow - stripFirstRow, stripExtent );
+
+  std::map< int, std::unique_ptr< QgsRasterAnalysisUtils::PolygonCellScanner > > scanners;
+  std::size_t nextZone = 0;
+  std::unique_ptr< QgsRasterBlock > block;
+  int iterLeft = 0;
+  int iterTop = 0;
+  int iterCols = 0;
+  int iterRows = 0;
+  std::vector< std::pair< int, int > > spans;
+  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    const int blockFirstRow = stripFirstRow + iterTop;
+    const int blockLastRow = blockFirstRow + iterRows;
+
+    while ( nextZone < zones.size() && zoneRows[ static_cast< std::size_t >( zones[nextZone] ) ].first < blockLastRow )
+    {
+      const int zone = zones[nextZone++];
+      scanners[zone] = std::make_unique< QgsRasterAnalysisUtils::PolygonCellScanner >( geometries.at( zone ), stripExtent, cellSizeX, cellSizeY, nCellsX );
+      stats.emplace( zone, FeatureStats( storeValues, storeValueCounts ) );
+    }
+
+    // scans the zones overlapping the block, reading pixels with valueAndNoData( row, col, isNoData )
+    auto scanBlock = [&]( const auto & valueAndNoData )
+    {
+      bool isNoData = false;
+      for ( auto it = scanners.begin(); it != scanners.end(); )
+      {
+        const std::pair< int, int > &rows = zoneRows[ static_cast< std::size_t >( it->first ) ];
+        FeatureStats &zoneStats = stats.at( it->first );
+        const int zoneFirstRow = std::max( rows.first, blockFirstRow );
+        const int zoneLastRow = std::min( rows.second, blockLastRow );
+        for ( int row = zoneFirstRow; row < zoneLastRow; ++row )
+        {
+          it->second->cellCentersInRow( row - stripFirstRow, spans );
+          for ( const std::pair< int, int > &span : spans )
+          {
+            const int firstCol = std::max( span.first - iterLeft, 0 );
+            const int lastCol = std::min( span.second - iterLeft, iterCols );
+            for ( int col = firstCol; col < lastCol; ++col )
+            {
+              const double pixelValue = valueAndNoData( row - blockFirstRow, col, isNoData );
+              if ( QgsRasterAnalysisUtils::validPixel( pixelValue ) && !isNoData )
+              {
+                zoneStats.addValue( pixelValue );
+              }
+            }
+          }
+        }
+
+        if ( rows.second <= blockLastRow )
+          it = scanners.erase( it );
+        else
+          ++it;
+      }
+    };
+
+    const bool viewed = std::as_const( *block ).visitView( [&]( auto view )
+    {
+      scanBlock( [&view]( int row, int col, bool &isNoData )
+      {
+        isNoData = view.isNoData( row, col );
+        return static_cast< double >( view.row( row )[col] );
+      } );
+    } );
+    if ( !viewed )
+    {
+      scanBlock( [&block]( int row, int col, bool &isNoData )
+      {
+        return block->valueAndNoData( row, col, isNoData );
+      } );
+    }
+
+    if ( reportProgress && feedback )
+      feedback->setProgress( 100.0 * ( blockLastRow - stripFirstRow ) / ( stripLastRow - stripFirstRow ) );
+  }
+}
@@ -20,9 +20,13 @@
 
 #include <QString>
 #include <QMap>
+#include <QList>
+#include <QVector>
 
 #include <limits>
 #include <cfloat>
+#include <map>
+#include <vector>
 
 #include "qgis_analysis.h"
 #include "qgsfeedback.h"
@@ -157,6 +161,25 @@ class ANALYSIS_EXPORT QgsZonalStatistics
      */
 #ifndef SIP_RUN
     static QMap<QgsZonalStatistics::Statistic, QVariant> calculateStatistics( QgsRasterInterface *rasterInterface, const QgsGeometry &geometry, double cellSizeX, double cellSizeY, int rasterBand, QgsZonalStatistics::Statistics statistics );
+
+    /**
+     * Calculates the specified \a statistics for the pixels of \a rasterBand
+     * in \a rasterInterface (a raster layer dataProvider() ) within each of the polygon \a geometries.
+     *
+     * When the zones densely cover the area they span, the raster is swept once in horizontal
+     * strips and each pixel is read a single time, regardless of how many zones cover it. Strips
+     * are processed in parallel using clones of \a rasterInterface, and the per zone statistics
+     * of all strips are merged afterwards. Sparse zones are calculated separately instead, as
+     * for calculateStatistics() with a single geometry.
+     *
+     * The \a geometries must be in the same CRS as the raster.
+     *
+     * Returns a list of maps of statistic to result value, in the same order as \a geometries.
+     * Empty maps are returned for geometries which do not intersect the raster.
+     *
+     * \since QGIS 3.20
+     */
+    static QList< QMap<QgsZonalStatistics::Statistic, QVariant> > calculateStatistics( QgsRasterInterface *rasterInterface, const QVector< QgsGeometry > &geometries, double cellSizeX, double cellSizeY, int rasterBand, QgsZonalStatistics::Statistics statistics, QgsFeedback *feedback = nullptr );
 #endif
 
 ///@cond PRIVATE
@@ -214,6 +237,19 @@ class ANALYSIS_EXPORT QgsZonalStatistics
           if ( mStoreValues )
             values.append( value );
         }
+
+        //! Merges the values accumulated by \a other into these statistics
+        void merge( const FeatureStats &other )
+        {
+          sum += other.sum;
+          count += other.count;
+          min = std::min( min, other.min );
+          max = std::max( max, other.max );
+          for ( auto it = other.valueCount.constBegin(); it != other.valueCount.constEnd(); ++it )
+            valueCount.insert( it.key(), valueCount.value( it.key(), 0 ) + it.value() );
+          values.append( other.values );
+        }
+
         double sum = 0.0;
         double count = 0.0;
         double max = std::numeric_limits<double>::lowest();
@@ -228,6 +264,20 @@ class ANALYSIS_EXPORT QgsZonalStatistics
 
     QString getUniqueFieldName( const QString &fieldName, const QList<QgsField> &newFields );
 
+    //! Returns the requested \a statistics from the values accumulated in \a featureStats
+    static QMap<QgsZonalStatistics::Statistic, QVariant> statisticsFromFeatureStats( FeatureStats &featureStats, QgsZonalStatistics::Statistics statistics );
+
+    /**
+     * Accumulates the pixels of rows \a firstRow (inclusive) to \a lastRow (exclusive) of the raster
+     * into \a stats for all zones covering these rows, where \a zoneRows and \a zoneCols give the range
+     * of rows and columns covered by each geometry. If \a reportProgress is TRUE, the progress of the
+     * strip is reported to \a feedback.
+     */
+    static void accumulateStrip( QgsRasterInterface *rasterInterface, int rasterBand, const QVector< QgsGeometry > &geometries,
+                                 const std::vector< std::pair< int, int > > &zoneRows, const std::vector< std::pair< int, int > > &zoneCols,
+                                 int firstRow, int lastRow, double cellSizeX, double cellSizeY, bool storeValues, bool storeValueCounts,
+                                 std::map< int, FeatureStats > &stats, QgsFeedback *feedback, bool reportProgress );
+
     QgsRasterInterface *mRasterInterface = nullptr;
     QgsCoordinateReferenceSystem mRasterCrs;
 
@@ -25,8 +25,10 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgslogger.h"
 #include "qgspolygon.h"
 #include "qgsgeometryeditutils.h"
+#include "qgsconfig.h"
 #include <limits>
 #include <cstdio>
+#include <QThreadStorage>
 
 #define DEFAULT_QUADRANT_SEGMENTS 8
 
@@ -113,7 +115,26 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh ) = delete;
 };
 
-Q_GLOBAL_STATIC( GEOSInit, geosinit )
+/**
+ * Returns the GEOS context for the current thread. GEOS context handles
+ * must not be used from several threads at once, so a new context is
+ * created for every thread.
+ */
+#if defined(USE_THREAD_LOCAL) && !defined(Q_OS_WIN)
+static GEOSInit *geosinit()
+{
+  static thread_local GEOSInit sGeosInit;
+  return &sGeosInit;
+}
+#else
+static GEOSInit *geosinit()
+{
+  static QThreadStorage< GEOSInit * > sGeosInit;
+  if ( !sGeosInit.hasLocalData() )
+    sGeosInit.setLocalData( new GEOSInit() );
+  return sGeosInit.localData();
+}
+#endif
 
 void geos::GeosDeleter::operator()( GEOSGeometry *geom )
 {
@@ -541,6 +541,11 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     static geos::unique_ptr asGeos( const QgsAbstractGeometry *geometry, double precision = 0 );
     static QgsPoint coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM );
 
+    /**
+     * Returns the GEOS context handle for the current thread.
+     *
+     * Every thread uses its own context, so handles must not be passed between threads.
+     */
     static GEOSContextHandle_t getGEOSHandler();
 
 
@@ -0,0 +1,200 @@
+/***************************************************************************
+                         qgswkbgeometryview.cpp
+                         ----------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswkbgeometryview.h"
+#include "qgswkbptr.h"
+#include "qgslogger.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+QgsWkbGeometryView::QgsWkbGeometryView( const QByteArray &wkb )
+  : mWkb( wkb )
+{
+}
+
+QgsWkbTypes::Type QgsWkbGeometryView::wkbType() const
+{
+  if ( mWkbTypeRead )
+    return mWkbType;
+
+  mWkbTypeRead = true;
+  if ( mWkb.isEmpty() )
+    return mWkbType;
+
+  try
+  {
+    QgsConstWkbPtr wkbPtr( mWkb );
+    mWkbType = wkbPtr.readHeader();
+  }
+  catch ( const QgsWkbException &e )
+  {
+    Q_UNUSED( e )
+    QgsDebugMsg( "WKB exception while reading header: " + e.what() );
+    mWkbType = QgsWkbTypes::Unknown;
+  }
+  return mWkbType;
+}
+
+QgsRectangle QgsWkbGeometryView::boundingBox() const
+{
+  if ( mBoundingBoxCalculated )
+    return mBoundingBox;
+
+  mBoundingBoxCalculated = true;
+  if ( mWkb.isEmpty() )
+    return mBoundingBox;
+
+  if ( !mMaterialized )
+  {
+    double xMin = std::numeric_limits< double >::max();
+    double yMin = std::numeric_limits< double >::max();
+    double xMax = -std::numeric_limits< double >::max();
+    double yMax = -std::numeric_limits< double >::max();
+    bool scanned = false;
+    try
+    {
+      QgsConstWkbPtr wkbPtr( mWkb );
+      scanned = extendBounds( wkbPtr, xMin, yMin, xMax, yMax );
+    }
+    catch ( const QgsWkbException &e )
+    {
+      Q_UNUSED( e )
+      QgsDebugMsg( "WKB exception while calculating bounding box: " + e.what() );
+      return mBoundingBox;
+    }
+
+    if ( scanned )
+    {
+      mHasBounds = xMin <= xMax && yMin <= yMax;
+      if ( mHasBounds )
+        mBoundingBox = QgsRectangle( xMin, yMin, xMax, yMax, false );
+      return mBoundingBox;
+    }
+  }
+
+  // curved geometries require the full geometry to calculate an exact bounding box
+  const QgsGeometry g = geometry();
+  mHasBounds = !g.isNull() && !g.isEmpty();
+  if ( mHasBounds )
+    mBoundingBox = g.boundingBox();
+  return mBoundingBox;
+}
+
+bool QgsWkbGeometryView::boundingBoxIntersects( const QgsRectangle &rectangle ) const
+{
+  // bounding boxes of single points are degenerate (and may be "null" for a point at the origin),
+  // so we can't rely on QgsRectangle::isNull() to detect empty geometries here
+  const QgsRectangle bounds = boundingBox();
+  return mHasBounds && rectangle.intersects( bounds );
+}
+
+QgsGeometry QgsWkbGeometryView::geometry() const
+{
+  if ( !mMaterialized )
+  {
+    mMaterialized = true;
+    if ( !mWkb.isEmpty() )
+      mGeometry.fromWkb( mWkb );
+  }
+  return mGeometry;
+}
+
+bool QgsWkbGeometryView::extendBounds( QgsConstWkbPtr &wkbPtr, double &xMin, double &yMin, double &xMax, double &yMax )
+{
+  const QgsWkbTypes::Type type = wkbPtr.readHeader();
+  const int coordDimensions = QgsWkbTypes::coordDimensions( type );
+
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    {
+      double x = 0;
+      double y = 0;
+      wkbPtr >> x >> y;
+      wkbPtr += ( coordDimensions - 2 ) * static_cast< int >( sizeof( double ) );
+      // empty points are represented by NaN coordinates
+      if ( !std::isnan( x ) && !std::isnan( y ) )
+      {
+        xMin = std::min( xMin, x );
+        yMin = std::min( yMin, y );
+        xMax = std::max( xMax, x );
+        yMax = std::max( yMax, y );
+      }
+      return true;
+    }
+
+    case QgsWkbTypes::LineString:
+      extendBoundsWithPoints( wkbPtr, coordDimensions, xMin, yMin, xMax, yMax );
+      return true;
+
+    case QgsWkbTypes::Polygon:
+    case QgsWkbTypes::Triangle:
+    {
+      int numRings = 0;
+      wkbPtr >> numRings;
+      for ( int ring = 0; ring < numRings; ++ring )
+        extendBoundsWithPoints( wkbPtr, coordDimensions, xMin, yMin, xMax, yMax );
+      return true;
+    }
+
+    case QgsWkbTypes::MultiPoint:
+    case QgsWkbTypes::MultiLineString:
+    case QgsWkbTypes::MultiPolygon:
+    case QgsWkbTypes::GeometryCollection:
+    {
+      int numGeometries = 0;
+      wkbPtr >> numGeometries;
+      for ( int part = 0; part < numGeometries; ++part )
+      {
+        if ( !extendBounds( wkbPtr, xMin, yMin, xMax, yMax ) )
+          return false;
+      }
+      return true;
+    }
+
+    case QgsWkbTypes::CircularString:
+    case QgsWkbTypes::CompoundCurve:
+    case QgsWkbTypes::CurvePolygon:
+    case QgsWkbTypes::MultiCurve:
+    case QgsWkbTypes::MultiSurface:
+    case QgsWkbTypes::Unknown:
+    case QgsWkbTypes::NoGeometry:
+    default:
+      return false;
+  }
+}
+
+void QgsWkbGeometryView::extendBoundsWithPoints( QgsConstWkbPtr &wkbPtr, int coordDimensions, double &xMin, double &yMin, double &xMax, double &yMax )
+{
+  int numPoints = 0;
+  wkbPtr >> numPoints;
+  const int skipZM = ( coordDimensions - 2 ) * static_cast< int >( sizeof( double ) );
+  for ( int i = 0; i < numPoints; ++i )
+  {
+    double x = 0;
+    double y = 0;
+    wkbPtr >> x >> y;
+    if ( skipZM > 0 )
+      wkbPtr += skipZM;
+
+    xMin = std::min( xMin, x );
+    yMin = std::min( yMin, y );
+    xMax = std::max( xMax, x );
+    yMax = std::max( yMax, y );
+  }
+}
@@ -0,0 +1,137 @@
+/***************************************************************************
+                         qgswkbgeometryview.h
+                         --------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWKBGEOMETRYVIEW_H
+#define QGSWKBGEOMETRYVIEW_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgswkbtypes.h"
+#include "qgsrectangle.h"
+#include "qgsgeometry.h"
+
+#include <QByteArray>
+
+class QgsConstWkbPtr;
+
+/**
+ * \ingroup core
+ * \class QgsWkbGeometryView
+ * \brief A lightweight, lazily parsed geometry backed by a raw WKB buffer.
+ *
+ * QgsWkbGeometryView wraps a WKB byte array without parsing it into a
+ * QgsAbstractGeometry tree. The geometry type, bounding box and WKB representation
+ * can be retrieved directly from the buffer, without allocating any geometry
+ * objects. A full QgsGeometry is only created when geometry() is called, and
+ * is then cached for subsequent calls.
+ *
+ * The WKB buffer is implicitly shared, so constructing a view from an existing
+ * QByteArray does not copy the geometry data.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.20
+ */
+class CORE_EXPORT QgsWkbGeometryView
+{
+  public:
+
+    /**
+     * Constructor for a null QgsWkbGeometryView.
+     */
+    QgsWkbGeometryView() = default;
+
+    /**
+     * Constructor for a QgsWkbGeometryView backed by the specified \a wkb buffer.
+     *
+     * The buffer is not parsed or validated until one of the accessors is called.
+     */
+    explicit QgsWkbGeometryView( const QByteArray &wkb );
+
+    /**
+     * Returns TRUE if the view does not reference any WKB content.
+     */
+    bool isNull() const { return mWkb.isEmpty(); }
+
+    /**
+     * Returns the WKB type of the geometry, read directly from the WKB header.
+     *
+     * Returns QgsWkbTypes::Unknown if the view is null or the header is invalid.
+     */
+    QgsWkbTypes::Type wkbType() const;
+
+    /**
+     * Returns the bounding box of the geometry.
+     *
+     * For geometries consisting only of straight segments the bounding box is calculated
+     * by scanning the coordinates directly from the WKB buffer, without creating any
+     * geometry objects. Geometries containing curved segments are materialized, since
+     * the bounding box of a curve may extend beyond its control points.
+     *
+     * A null rectangle is returned if the view is null, empty or invalid.
+     */
+    QgsRectangle boundingBox() const;
+
+    /**
+     * Returns TRUE if the bounding box of the geometry intersects with a \a rectangle.
+     *
+     * \see boundingBox()
+     */
+    bool boundingBoxIntersects( const QgsRectangle &rectangle ) const;
+
+    /**
+     * Returns the WKB buffer backing the view. This does not require any parsing
+     * of the geometry and does not copy the geometry data.
+     */
+    QByteArray asWkb() const { return mWkb; }
+
+    /**
+     * Returns the geometry represented by the view, parsing the WKB buffer on the first call.
+     *
+     * The parsed geometry is cached, so subsequent calls are cheap.
+     */
+    QgsGeometry geometry() const;
+
+    /**
+     * Returns TRUE if the geometry has already been materialized by a call to geometry().
+     */
+    bool isMaterialized() const { return mMaterialized; }
+
+  private:
+
+    QByteArray mWkb;
+
+    mutable QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
+    mutable bool mWkbTypeRead = false;
+
+    mutable QgsRectangle mBoundingBox;
+    mutable bool mBoundingBoxCalculated = false;
+    mutable bool mHasBounds = false;
+
+    mutable QgsGeometry mGeometry;
+    mutable bool mMaterialized = false;
+
+    /**
+     * Extends the bounds by the coordinates of the geometry at the current position
+     * of \a wkbPtr. Returns FALSE if a curved geometry was encountered and the
+     * bounds could not be calculated from the WKB content alone.
+     */
+    static bool extendBounds( QgsConstWkbPtr &wkbPtr, double &xMin, double &yMin, double &xMax, double &yMax );
+
+    static void extendBoundsWithPoints( QgsConstWkbPtr &wkbPtr, int coordDimensions, double &xMin, double &yMin, double &xMax, double &yMax );
+};
+
+#endif // QGSWKBGEOMETRYVIEW_H
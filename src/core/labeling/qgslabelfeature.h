@@ -178,6 +178,25 @@ class CORE_EXPORT QgsLabelFeature
     //! Sets coordinates of the fixed position (relevant only if hasFixedPosition() returns TRUE)
     void setFixedPosition( const QgsPointXY &point ) { mFixedPosition = point; }
 
+    /**
+     * Returns TRUE if the fixed position of the label was taken from a previous render of the map,
+     * rather than being set by the user.
+     *
+     * \see setPositionReused()
+     * \see QgsLabelingEngine::setPreviousLabelPositions()
+     * \since QGIS 3.20
+     */
+    bool positionReused() const { return mPositionReused; }
+
+    /**
+     * Sets whether the fixed position of the label was taken from a previous render of the map,
+     * rather than being set by the user.
+     *
+     * \see positionReused()
+     * \since QGIS 3.20
+     */
+    void setPositionReused( bool reused ) { mPositionReused = reused; }
+
     /**
      * In case of quadrand or aligned positioning, this is set to the anchor point.
      * This can be used for proper vector based output like DXF.
@@ -568,6 +587,8 @@ class CORE_EXPORT QgsLabelFeature
     bool mHasFixedPosition = false;
     //! fixed position for the label (instead of automatic placement)
     QgsPointXY mFixedPosition;
+    //! whether the fixed position was reused from a previous render
+    bool mPositionReused = false;
     //! whether mFixedAngle should be respected
     bool mHasFixedAngle = false;
     //! fixed rotation for the label (instead of automatic choice)
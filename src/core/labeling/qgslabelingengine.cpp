@@ -277,6 +277,7 @@ void QgsLabelingEngine::registerLabels( QgsRenderContext &context )
 
   mPal->setShowPartialLabels( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
   mPal->setPlacementVersion( settings.placementVersion() );
+  mPal->setParallelLabeling( settings.testFlag( QgsLabelingEngineSettings::ParallelLabeling ) );
 
   // for each provider: get labels and register them in PAL
   for ( QgsAbstractLabelProvider *provider : std::as_const( mProviders ) )
@@ -533,6 +534,57 @@ QgsLabelingResults *QgsLabelingEngine::takeResults()
   return mResults.release();
 }
 
+void QgsLabelingEngine::setPreviousLabelPositions( const QList<QgsLabelPosition> &positions, const QgsRectangle &previousExtent )
+{
+  mPreviousLabelPositions.clear();
+
+  // labels close to the edges of either extent may have been constrained by the map boundary, or may now have
+  // a better position in the newly exposed area, so only labels well inside both extents are reused
+  const QgsRectangle visibleExtent = mMapSettings.visibleExtent();
+  const QgsRectangle overlap = visibleExtent.intersect( previousExtent );
+  if ( overlap.isEmpty() )
+    return;
+
+  const double margin = 0.05 * std::max( visibleExtent.width(), visibleExtent.height() );
+  if ( overlap.width() <= 2 * margin || overlap.height() <= 2 * margin )
+    return;
+  const QgsRectangle stableExtent = overlap.buffered( -margin );
+
+  // features with several labels, e.g. curved labels, can't be matched to a single position
+  QHash< QPair< QString, QString >, QHash< QgsFeatureId, int > > labelCounts;
+  for ( const QgsLabelPosition &position : positions )
+  {
+    labelCounts[ qMakePair( position.layerID, position.providerID ) ][ position.featureId ]++;
+  }
+
+  for ( const QgsLabelPosition &position : positions )
+  {
+    if ( position.isDiagram || position.isUnplaced || position.cornerPoints.size() != 4 )
+      continue;
+
+    const QPair< QString, QString > key = qMakePair( position.layerID, position.providerID );
+    if ( labelCounts.value( key ).value( position.featureId ) != 1 )
+      continue;
+
+    if ( stableExtent.contains( position.labelRect ) )
+      mPreviousLabelPositions[ key ].insert( position.featureId, position );
+  }
+}
+
+bool QgsLabelingEngine::previousLabelPosition( const QString &layerId, const QString &providerId, QgsFeatureId id, QgsLabelPosition &position ) const
+{
+  auto layerIt = mPreviousLabelPositions.constFind( qMakePair( layerId, providerId ) );
+  if ( layerIt == mPreviousLabelPositions.constEnd() )
+    return false;
+
+  auto it = layerIt->constFind( id );
+  if ( it == layerIt->constEnd() )
+    return false;
+
+  position = *it;
+  return true;
+}
+
 
 //
 //  QgsDefaultLabelingEngine
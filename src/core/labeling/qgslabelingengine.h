@@ -24,6 +24,7 @@
 #include "qgspallabeling.h"
 #include "qgslabelingenginesettings.h"
 #include "qgslabeling.h"
+#include "qgslabelposition.h"
 
 class QgsLabelingEngine;
 class QgsLabelingResults;
@@ -266,6 +267,34 @@ class CORE_EXPORT QgsLabelingEngine
     //! For internal use by the providers
     QgsLabelingResults *results() const { return mResults.get(); }
 
+    /**
+     * Sets the label \a positions placed by a previous render of the map, which covered
+     * the specified \a previousExtent.
+     *
+     * Labels from the previous render which lie well inside both the previous extent and the
+     * visible extent of the current map settings are kept at their previous position, so only
+     * features near the edges of the map or in newly exposed areas are labeled again. This keeps
+     * label placement stable and greatly reduces the labeling work when a map is panned slightly.
+     *
+     * The previous render must have used the same destination CRS, scale and rotation as the
+     * current map settings. This method must be called after setMapSettings().
+     *
+     * \see previousLabelPosition()
+     * \since QGIS 3.20
+     */
+    void setPreviousLabelPositions( const QList< QgsLabelPosition > &positions, const QgsRectangle &previousExtent );
+
+    /**
+     * Retrieves the previous \a position of the label for the feature with matching \a id, from the
+     * provider with the specified \a layerId and \a providerId.
+     *
+     * Returns FALSE if there is no previous position which can be reused for the feature.
+     *
+     * \see setPreviousLabelPositions()
+     * \since QGIS 3.20
+     */
+    bool previousLabelPosition( const QString &layerId, const QString &providerId, QgsFeatureId id, QgsLabelPosition &position ) const;
+
   protected:
     void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p );
 
@@ -318,6 +347,9 @@ class CORE_EXPORT QgsLabelingEngine
     //! Resulting labeling layout
     std::unique_ptr< QgsLabelingResults > mResults;
 
+    //! Reusable label positions from a previous render, by layer and provider ID
+    QHash< QPair< QString, QString >, QHash< QgsFeatureId, QgsLabelPosition > > mPreviousLabelPositions;
+
     std::unique_ptr< pal::Pal > mPal;
     std::unique_ptr< pal::Problem > mProblem;
     QList<pal::LabelPosition *> mUnlabeled;
@@ -40,6 +40,8 @@ class CORE_EXPORT QgsLabelingEngineSettings
       DrawLabelRectOnly     = 1 << 4,  //!< Whether to only draw the label rect and not the actual label text (used for unit tests)
       DrawCandidates        = 1 << 5,  //!< Whether to draw rectangles of generated candidates (good for debugging)
       DrawUnplacedLabels    = 1 << 6,  //!< Whether to render unplaced labels as an indicator/warning for users
+      ParallelLabeling      = 1 << 7,  //!< Whether to generate candidates and solve independent groups of conflicting labels using multiple threads (since QGIS 3.20)
+      IncrementalLabeling   = 1 << 8,  //!< Whether labels placed by the previous render of a map canvas are kept in place when the map is panned (since QGIS 3.20)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -56,6 +56,7 @@
 #include "qgsvectorlayerlabeling.h"
 #include "qgstextrendererutils.h"
 #include "qgstextfragment.h"
+#include "qgstextlayoutcache.h"
 
 #include "qgslogger.h"
 #include "qgsvectorlayer.h"
@@ -1406,12 +1407,23 @@ bool QgsPalLayerSettings::checkMinimumSizeMM( const QgsRenderContext &ct, const
 }
 
 void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, const QString &text, double &labelX, double &labelY, const QgsFeature *f, QgsRenderContext *context, double *rotatedLabelX, double *rotatedLabelY, QgsTextDocument *document )
+{
+  calculateLabelSizeForFont( fm, nullptr, text, labelX, labelY, f, context, rotatedLabelX, rotatedLabelY, document );
+}
+
+void QgsPalLayerSettings::calculateLabelSizeForFont( const QFontMetricsF *fm, const QFont *font, const QString &text, double &labelX, double &labelY, const QgsFeature *f, QgsRenderContext *context, double *rotatedLabelX, double *rotatedLabelY, QgsTextDocument *document )
 {
   if ( !fm || !f )
   {
     return;
   }
 
+  // when the font is known, share shaped line widths with the text renderer instead of reshaping here
+  auto horizontalAdvance = [fm, font]( const QString & string ) -> double
+  {
+    return font ? QgsTextLayoutCache::horizontalAdvance( *font, string ) : fm->horizontalAdvance( string );
+  };
+
   QString textCopy( text );
 
   //try to keep < 2.12 API - handle no passed render context
@@ -1547,7 +1559,7 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, const QSt
   {
     QString dirSym = leftDirSymb;
 
-    if ( fm->horizontalAdvance( rightDirSymb ) > fm->horizontalAdvance( dirSym ) )
+    if ( horizontalAdvance( rightDirSymb ) > horizontalAdvance( dirSym ) )
       dirSym = rightDirSymb;
 
     switch ( placeDirSymb )
@@ -1588,7 +1600,7 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, const QSt
 
       for ( const auto &line : multiLineSplit )
       {
-        w = std::max( w, fm->horizontalAdvance( line ) );
+        w = std::max( w, horizontalAdvance( line ) );
       }
       break;
     }
@@ -1613,7 +1625,7 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, const QSt
       double widthHorizontal = 0.0;
       for ( const auto &line : multiLineSplit )
       {
-        widthHorizontal = std::max( w, fm->horizontalAdvance( line ) );
+        widthHorizontal = std::max( w, horizontalAdvance( line ) );
       }
 
       double widthVertical = 0.0;
@@ -1943,7 +1955,7 @@ void QgsPalLayerSettings::registerFeature( const QgsFeature &f, QgsRenderContext
     doc = QgsTextDocument::fromHtml( QStringList() << labelText );
 
   // also applies the line split to doc!
-  calculateLabelSize( labelFontMetrics.get(), labelText, labelX, labelY, mCurFeat, &context, &rotatedLabelX, &rotatedLabelY, format().allowHtmlFormatting() ? &doc : nullptr );
+  calculateLabelSizeForFont( labelFontMetrics.get(), &labelFont, labelText, labelX, labelY, mCurFeat, &context, &rotatedLabelX, &rotatedLabelY, format().allowHtmlFormatting() ? &doc : nullptr );
 
   // maximum angle between curved label characters (hardcoded defaults used in QGIS <2.0)
   //
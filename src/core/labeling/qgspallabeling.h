@@ -1075,6 +1075,13 @@ class CORE_EXPORT QgsPalLayerSettings
      */
     void registerObstacleFeature( const QgsFeature &f, QgsRenderContext &context, QgsLabelFeature **obstacleFeature, const QgsGeometry &obstacleGeometry = QgsGeometry() );
 
+    /**
+     * Calculates the space required to render the provided \a text in map units, as calculateLabelSize().
+     * If \a font is specified then line widths are retrieved from the shared QgsTextLayoutCache
+     * instead of being measured using \a fm.
+     */
+    void calculateLabelSizeForFont( const QFontMetricsF *fm, const QFont *font, const QString &text, double &labelX, double &labelY, const QgsFeature *f, QgsRenderContext *context, double *rotatedLabelX, double *rotatedLabelY, QgsTextDocument *document );
+
     QMap<Property, QVariant> dataDefinedValues;
 
     //! Property collection for data defined label settings
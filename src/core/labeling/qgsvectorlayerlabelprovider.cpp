@@ -196,7 +196,32 @@ void QgsVectorLayerLabelProvider::registerFeature( const QgsFeature &feature, Qg
 
   mSettings.registerFeature( feature, context, &label, obstacleGeometry, symbol );
   if ( label )
+  {
+    reusePreviousLabelPosition( label );
     mLabels << label;
+  }
+}
+
+void QgsVectorLayerLabelProvider::reusePreviousLabelPosition( QgsLabelFeature *label ) const
+{
+  // features which may result in several labels can't be matched to a single previous position
+  if ( !mEngine || label->hasFixedPosition() || mSettings.repeatDistance > 0 || mSettings.labelPerPart || mSettings.lineSettings().mergeLines() )
+    return;
+
+  QgsLabelPosition position;
+  if ( !mEngine->previousLabelPosition( mLayerId, mProviderId, label->id(), position ) )
+    return;
+
+  // if the label size has changed, e.g. due to data defined properties, the previous position is no longer valid
+  const QSizeF size = label->size( position.rotation );
+  if ( !qgsDoubleNear( size.width(), position.width, position.width * 1e-6 ) || !qgsDoubleNear( size.height(), position.height, position.height * 1e-6 ) )
+    return;
+
+  label->setHasFixedPosition( true );
+  label->setFixedPosition( position.cornerPoints.at( 0 ) );
+  label->setHasFixedAngle( true );
+  label->setFixedAngle( position.rotation );
+  label->setPositionReused( true );
 }
 
 QgsGeometry QgsVectorLayerLabelProvider::getPointObstacleGeometry( QgsFeature &fet, QgsRenderContext &context, const QgsSymbolList &symbols )
@@ -461,7 +486,7 @@ void QgsVectorLayerLabelProvider::drawLabel( QgsRenderContext &context, pal::Lab
 
   // add to the results
   QString labeltext = label->getFeaturePart()->feature()->labelText();
-  mEngine->results()->mLabelSearchTree->insertLabel( label, label->getFeaturePart()->featureId(), mLayerId, labeltext, dFont, false, lf->hasFixedPosition(), mProviderId );
+  mEngine->results()->mLabelSearchTree->insertLabel( label, label->getFeaturePart()->featureId(), mLayerId, labeltext, dFont, false, lf->hasFixedPosition() && !lf->positionReused(), mProviderId );
 }
 
 void QgsVectorLayerLabelProvider::drawUnplacedLabel( QgsRenderContext &context, LabelPosition *label ) const
@@ -479,7 +504,7 @@ void QgsVectorLayerLabelProvider::drawUnplacedLabel( QgsRenderContext &context,
 
   // add to the results
   QString labeltext = label->getFeaturePart()->feature()->labelText();
-  mEngine->results()->mLabelSearchTree->insertLabel( label, label->getFeaturePart()->featureId(), mLayerId, labeltext, tmpLyr.format().font(), false, lf->hasFixedPosition(), mProviderId, true );
+  mEngine->results()->mLabelSearchTree->insertLabel( label, label->getFeaturePart()->featureId(), mLayerId, labeltext, tmpLyr.format().font(), false, lf->hasFixedPosition() && !lf->positionReused(), mProviderId, true );
 }
 
 void QgsVectorLayerLabelProvider::drawLabelPrivate( pal::LabelPosition *label, QgsRenderContext &context, QgsPalLayerSettings &tmpLyr, QgsTextRenderer::TextPart drawType, double dpiRatio ) const
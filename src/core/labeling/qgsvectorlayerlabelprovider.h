@@ -146,6 +146,9 @@ class CORE_EXPORT QgsVectorLayerLabelProvider : public QgsAbstractLabelProvider
 
     friend class TestQgsLabelingEngine;
     void drawCallout( QgsRenderContext &context, pal::LabelPosition *label ) const;
+
+    //! Fixes the position of a \a label to its position from the previous render, if the engine allows it
+    void reusePreviousLabelPosition( QgsLabelFeature *label ) const;
 };
 
 #endif // QGSVECTORLAYERLABELPROVIDER_H
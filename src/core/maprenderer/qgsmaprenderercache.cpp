@@ -50,6 +50,25 @@ void QgsMapRendererCache::clearInternal()
   }
   mCachedImages.clear();
   mConnectedLayers.clear();
+
+  for ( const CachedLayerFeatures &cached : std::as_const( mCachedFeatures ) )
+  {
+    if ( cached.layer.data() )
+    {
+      disconnect( cached.layer.data(), &QgsMapLayer::dataChanged, this, &QgsMapRendererCache::layerDataChanged );
+      disconnect( cached.layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerDataChanged );
+      disconnect( cached.layer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedFeatureRepaint );
+    }
+    for ( const QgsWeakMapLayerPointer &dependentLayer : cached.dependentLayers )
+    {
+      if ( !dependentLayer.data() )
+        continue;
+      disconnect( dependentLayer.data(), &QgsMapLayer::dataChanged, this, &QgsMapRendererCache::dependentLayerChanged );
+      disconnect( dependentLayer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::dependentLayerChanged );
+      disconnect( dependentLayer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::dependentLayerChanged );
+    }
+  }
+  mCachedFeatures.clear();
 }
 
 void QgsMapRendererCache::dropUnusedConnections()
@@ -268,6 +287,113 @@ QImage QgsMapRendererCache::transformedCacheImage( const QString &cacheKey, cons
   }
 }
 
+void QgsMapRendererCache::setCacheLabelPositions( const QString &cacheKey, const QList<QgsLabelPosition> &positions, const QgsCoordinateReferenceSystem &crs )
+{
+  QMutexLocker lock( &mMutex );
+
+  auto it = mCachedImages.find( cacheKey );
+  if ( it == mCachedImages.end() )
+    return;
+
+  it->labelPositions = positions;
+  it->labelPositionsCrs = crs;
+}
+
+QList<QgsLabelPosition> QgsMapRendererCache::cacheLabelPositions( const QString &cacheKey, QgsRectangle &extent, QgsMapToPixel &mapToPixel, QgsCoordinateReferenceSystem &crs ) const
+{
+  QMutexLocker lock( &mMutex );
+
+  auto it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() )
+    return QList< QgsLabelPosition >();
+
+  extent = it->cachedExtent;
+  mapToPixel = it->cachedMtp;
+  crs = it->labelPositionsCrs;
+  return it->labelPositions;
+}
+
+bool QgsMapRendererCache::setCacheFeatures( const QString &cacheKey, std::shared_ptr<const CachedFeatures> features, QgsMapLayer *layer, const QList<QgsMapLayer *> &dependentLayers )
+{
+  if ( !layer || !features )
+    return false;
+
+  QMutexLocker lock( &mMutex );
+
+  if ( features->memoryUsage > mMaximumFeatureMemory )
+  {
+    mCachedFeatures.remove( cacheKey );
+    return false;
+  }
+
+  CachedLayerFeatures cached;
+  cached.features = std::move( features );
+  cached.layer = layer;
+  cached.dependentLayers = _qgis_listRawToQPointer( dependentLayers );
+  cached.lastUsed = ++mFeatureUseCounter;
+  mCachedFeatures[cacheKey] = cached;
+
+  // discard the least recently used features of other layers until everything fits in the budget
+  qint64 totalMemory = 0;
+  for ( const CachedLayerFeatures &entry : std::as_const( mCachedFeatures ) )
+    totalMemory += entry.features->memoryUsage;
+
+  while ( totalMemory > mMaximumFeatureMemory )
+  {
+    QMap<QString, CachedLayerFeatures>::iterator oldest = mCachedFeatures.end();
+    for ( auto it = mCachedFeatures.begin(); it != mCachedFeatures.end(); ++it )
+    {
+      if ( it.key() != cacheKey && ( oldest == mCachedFeatures.end() || it->lastUsed < oldest->lastUsed ) )
+        oldest = it;
+    }
+    if ( oldest == mCachedFeatures.end() )
+      break;
+
+    totalMemory -= oldest->features->memoryUsage;
+    mCachedFeatures.erase( oldest );
+  }
+
+  // the features only need to be discarded when the layer's data changes or may have been reloaded, not on every repaint
+  connect( layer, &QgsMapLayer::dataChanged, this, &QgsMapRendererCache::layerDataChanged, Qt::UniqueConnection );
+  connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerDataChanged, Qt::UniqueConnection );
+  connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedFeatureRepaint, Qt::UniqueConnection );
+
+  // edits to joined layers only request a repaint, so any repaint of a dependent layer discards the features
+  for ( QgsMapLayer *dependentLayer : dependentLayers )
+  {
+    if ( !dependentLayer )
+      continue;
+    connect( dependentLayer, &QgsMapLayer::dataChanged, this, &QgsMapRendererCache::dependentLayerChanged, Qt::UniqueConnection );
+    connect( dependentLayer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::dependentLayerChanged, Qt::UniqueConnection );
+    connect( dependentLayer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::dependentLayerChanged, Qt::UniqueConnection );
+  }
+  return true;
+}
+
+std::shared_ptr<const QgsMapRendererCache::CachedFeatures> QgsMapRendererCache::cacheFeatures( const QString &cacheKey ) const
+{
+  QMutexLocker lock( &mMutex );
+
+  auto it = mCachedFeatures.constFind( cacheKey );
+  if ( it == mCachedFeatures.constEnd() || !it->layer.data() )
+    return nullptr;
+
+  it->lastUsed = ++mFeatureUseCounter;
+  return it->features;
+}
+
+void QgsMapRendererCache::setMaximumFeatureMemory( qint64 bytes )
+{
+  QMutexLocker lock( &mMutex );
+  mMaximumFeatureMemory = bytes;
+}
+
+qint64 QgsMapRendererCache::maximumFeatureMemory() const
+{
+  QMutexLocker lock( &mMutex );
+  return mMaximumFeatureMemory;
+}
+
 QList< QgsMapLayer * > QgsMapRendererCache::dependentLayers( const QString &cacheKey ) const
 {
   auto it = mCachedImages.constFind( cacheKey );
@@ -285,6 +411,70 @@ void QgsMapRendererCache::layerRequestedRepaint()
   invalidateCacheForLayer( layer );
 }
 
+void QgsMapRendererCache::layerDataChanged()
+{
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+  clearCachedFeaturesInternal( layer );
+}
+
+void QgsMapRendererCache::layerRequestedFeatureRepaint( bool deferredUpdate )
+{
+  // deferred repaints are requested when the layer is automatically refreshed, after its data may have been reloaded
+  if ( !deferredUpdate )
+    return;
+
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+  clearCachedFeaturesInternal( layer );
+}
+
+void QgsMapRendererCache::dependentLayerChanged()
+{
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+  QMap<QString, CachedLayerFeatures>::iterator it = mCachedFeatures.begin();
+  for ( ; it != mCachedFeatures.end(); )
+  {
+    if ( it->dependentLayers.contains( layer ) )
+      it = mCachedFeatures.erase( it );
+    else
+      ++it;
+  }
+
+  disconnect( layer, &QgsMapLayer::dataChanged, this, &QgsMapRendererCache::dependentLayerChanged );
+  disconnect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::dependentLayerChanged );
+  disconnect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::dependentLayerChanged );
+}
+
+void QgsMapRendererCache::clearCachedFeaturesInternal( QgsMapLayer *layer )
+{
+  QMap<QString, CachedLayerFeatures>::iterator it = mCachedFeatures.begin();
+  for ( ; it != mCachedFeatures.end(); )
+  {
+    if ( it->layer.data() && it->layer.data() != layer )
+    {
+      ++it;
+      continue;
+    }
+
+    it = mCachedFeatures.erase( it );
+  }
+
+  disconnect( layer, &QgsMapLayer::dataChanged, this, &QgsMapRendererCache::layerDataChanged );
+  disconnect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerDataChanged );
+  disconnect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedFeatureRepaint );
+}
+
 void QgsMapRendererCache::invalidateCacheForLayer( QgsMapLayer *layer )
 {
   if ( !layer )
@@ -20,9 +20,13 @@
 #include <QMap>
 #include <QImage>
 #include <QMutex>
+#include <memory>
 
 #include "qgsrectangle.h"
 #include "qgsmaplayer.h"
+#include "qgslabelposition.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgsfeature.h"
 
 
 /**
@@ -39,6 +43,10 @@
  * for particular layers between the first render update and the moment the layer
  * actually has partially rendered something in the resulting image.
  *
+ * The cache can also keep the features which were fetched to render a vector layer (see setCacheFeatures()).
+ * Unlike images, these are kept when a layer is restyled or the map is zoomed, and are only discarded when
+ * the layer's data changes.
+ *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
  * \since QGIS 2.4
@@ -48,6 +56,37 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     Q_OBJECT
   public:
 
+#ifndef SIP_RUN
+
+    /**
+     * \brief Features fetched for rendering a vector layer, as stored in a QgsMapRendererCache.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    struct CachedFeatures
+    {
+      //! Features which intersect the extent, with geometries in the layer's CRS
+      QgsFeatureList features;
+      //! Filter extent used when fetching the features, in the layer's CRS
+      QgsRectangle extent;
+      //! Names of the attributes fetched for the features
+      QSet< QString > attributes;
+      //! Subset string of the layer when the features were fetched
+      QString subsetString;
+      //! Fields of the layer when the features were fetched
+      QgsFields fields;
+      //! Estimated memory used by the features, in bytes
+      qint64 memoryUsage = 0;
+
+      /**
+       * TRUE if the features within the extent exceed the memory budget of the cache, in which case
+       * no features are stored and requests covering the same extent and attributes are not worth caching.
+       */
+      bool exceedsMemoryBudget = false;
+    };
+#endif
+
     QgsMapRendererCache();
 
     /**
@@ -154,6 +193,84 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     QImage transformedCacheImage( const QString &cacheKey, const QgsMapToPixel &mtp ) const;
 
+    /**
+     * Attaches the label \a positions placed by a render to the cached image for the specified
+     * \a cacheKey, along with the destination \a crs of that render.
+     *
+     * The positions are discarded together with the cached image, e.g. when one of the image's
+     * dependent layers triggers a repaint. This method has no effect if no image is cached
+     * for \a cacheKey.
+     *
+     * \see cacheLabelPositions()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    void setCacheLabelPositions( const QString &cacheKey, const QList< QgsLabelPosition > &positions, const QgsCoordinateReferenceSystem &crs ) SIP_SKIP;
+
+    /**
+     * Returns the label positions attached to the cached image for the specified \a cacheKey.
+     *
+     * The \a extent, \a mapToPixel and \a crs arguments will be set to the parameters of the
+     * render which placed the labels.
+     *
+     * \see setCacheLabelPositions()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    QList< QgsLabelPosition > cacheLabelPositions( const QString &cacheKey, QgsRectangle &extent, QgsMapToPixel &mapToPixel, QgsCoordinateReferenceSystem &crs ) const SIP_SKIP;
+
+    /**
+     * Sets the \a features which were fetched for rendering the specified vector \a layer, to be
+     * reused by later renders with the same \a cacheKey.
+     *
+     * The features are kept when the layer is restyled or requests a repaint, and are discarded
+     * when the layer's data changes, the layer requests a deferred repaint (e.g. when it is
+     * automatically refreshed), the layer is deleted or the cache is cleared.
+     *
+     * A list of \a dependentLayers should be passed containing all layers from which the
+     * features take attributes, such as joined layers. The features are discarded whenever any of
+     * these layers changes its data or requests a repaint (e.g. after edits to its features).
+     *
+     * The features kept for all layers share the memory budget set by setMaximumFeatureMemory(). The least
+     * recently used features of other layers are discarded to make room for new features.
+     *
+     * Returns FALSE if the features exceed the whole memory budget, in which case they are not stored.
+     *
+     * \see cacheFeatures()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    bool setCacheFeatures( const QString &cacheKey, std::shared_ptr< const CachedFeatures > features, QgsMapLayer *layer,
+                           const QList< QgsMapLayer * > &dependentLayers = QList< QgsMapLayer * >() ) SIP_SKIP;
+
+    /**
+     * Returns the features stored for the specified \a cacheKey, or NULLPTR if no features are cached.
+     *
+     * \see setCacheFeatures()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    std::shared_ptr< const CachedFeatures > cacheFeatures( const QString &cacheKey ) const SIP_SKIP;
+
+    /**
+     * Sets the maximum memory, in \a bytes, used by the features kept for all layers.
+     *
+     * \see maximumFeatureMemory()
+     * \see setCacheFeatures()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    void setMaximumFeatureMemory( qint64 bytes ) SIP_SKIP;
+
+    /**
+     * Returns the maximum memory, in bytes, used by the features kept for all layers.
+     *
+     * \see setMaximumFeatureMemory()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    qint64 maximumFeatureMemory() const SIP_SKIP;
+
     /**
      * Returns a list of map layers on which an image in the cache depends.
      * \since QGIS 3.0
@@ -177,6 +294,15 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! Remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
 
+    //! Remove cached features of the layer which emitted the signal
+    void layerDataChanged();
+
+    //! Remove cached features of the layer which emitted the signal, if its data may have been reloaded
+    void layerRequestedFeatureRepaint( bool deferredUpdate );
+
+    //! Remove cached features which take attributes from the layer which emitted the signal
+    void dependentLayerChanged();
+
   private:
 
     struct CacheParameters
@@ -185,6 +311,8 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
       QgsWeakMapLayerPointerList dependentLayers;
       QgsRectangle cachedExtent;
       QgsMapToPixel cachedMtp;
+      QList< QgsLabelPosition > labelPositions;
+      QgsCoordinateReferenceSystem labelPositionsCrs;
     };
 
     //! Invalidate cache contents (without locking)
@@ -195,6 +323,9 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
 
     QSet< QgsWeakMapLayerPointer > dependentLayers() const;
 
+    //! Removes the cached features of \a layer and of deleted layers (without locking)
+    void clearCachedFeaturesInternal( QgsMapLayer *layer );
+
     mutable QMutex mMutex;
     QgsRectangle mExtent;
     QgsMapToPixel mMtp;
@@ -205,6 +336,23 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     QMap<QString, CacheParameters> mCachedImages;
     //! List of all layers on which this cache is currently connected
     QSet< QgsWeakMapLayerPointer > mConnectedLayers;
+
+#ifndef SIP_RUN
+    struct CachedLayerFeatures
+    {
+      std::shared_ptr< const CachedFeatures > features;
+      QgsWeakMapLayerPointer layer;
+      QgsWeakMapLayerPointerList dependentLayers;
+      //! Value of mFeatureUseCounter when the features were last used
+      mutable quint64 lastUsed = 0;
+    };
+
+    //! Map of cache key to cached vector layer features
+    QMap<QString, CachedLayerFeatures> mCachedFeatures;
+    //! Incremented whenever cached features are stored or used, for discarding the least recently used features
+    mutable quint64 mFeatureUseCounter = 0;
+    qint64 mMaximumFeatureMemory = 256 * 1024 * 1024;
+#endif
 };
 
 
@@ -31,6 +31,7 @@
 #include "qgspallabeling.h"
 #include "qgsexception.h"
 #include "qgslabelingengine.h"
+#include "qgslabelingresults.h"
 #include "qgsmaplayerlistutils.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgssettings.h"
@@ -447,7 +448,11 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
     layerTime.start();
     job.renderer = ml->createMapRenderer( job.context );
     if ( job.renderer )
+    {
       job.renderer->setLayerRenderingTimeHint( job.estimatedRenderingTime );
+      if ( mCache )
+        job.renderer->setMapRendererCache( mCache );
+    }
 
     // If we are drawing with an alternative blending mode then we need to render to a separate image
     // before compositing this on the map. This effectively flattens the layer and prevents
@@ -670,6 +675,23 @@ LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabe
     {
       job.img = allocateImage( QStringLiteral( "labels" ) );
     }
+
+    if ( mCache && labelingEngine2 && mSettings.labelingEngineSettings().testFlag( QgsLabelingEngineSettings::IncrementalLabeling ) )
+    {
+      // reuse label positions from the previous render, as long as only the map extent has changed since
+      QgsRectangle previousExtent;
+      QgsMapToPixel previousMapToPixel;
+      QgsCoordinateReferenceSystem previousCrs;
+      const QList< QgsLabelPosition > previousPositions = mCache->cacheLabelPositions( LABEL_PREVIEW_CACHE_ID, previousExtent, previousMapToPixel, previousCrs );
+      if ( !previousPositions.isEmpty()
+           && previousCrs == mSettings.destinationCrs()
+           && qgsDoubleNear( previousMapToPixel.mapUnitsPerPixel(), mSettings.mapToPixel().mapUnitsPerPixel() )
+           && qgsDoubleNear( previousMapToPixel.mapRotation(), 0 )
+           && qgsDoubleNear( mSettings.rotation(), 0 ) )
+      {
+        labelingEngine2->setPreviousLabelPositions( previousPositions, previousExtent );
+      }
+    }
   }
 
   return job;
@@ -757,6 +779,11 @@ void QgsMapRendererJob::cleanupLabelJob( LabelRenderJob &job )
       QgsDebugMsgLevel( QStringLiteral( "caching label result image" ), 2 );
       mCache->setCacheImageWithParameters( LABEL_CACHE_ID, *job.img, mSettings.visibleExtent(), mSettings.mapToPixel(), _qgis_listQPointerToRaw( job.participatingLayers ) );
       mCache->setCacheImageWithParameters( LABEL_PREVIEW_CACHE_ID, *job.img, mSettings.visibleExtent(), mSettings.mapToPixel(), _qgis_listQPointerToRaw( job.participatingLayers ) );
+
+      if ( mSettings.labelingEngineSettings().testFlag( QgsLabelingEngineSettings::IncrementalLabeling ) && job.context.labelingEngine() && job.context.labelingEngine()->results() )
+      {
+        mCache->setCacheLabelPositions( LABEL_PREVIEW_CACHE_ID, job.context.labelingEngine()->results()->labelsWithinRect( mSettings.visibleExtent() ), mSettings.destinationCrs() );
+      }
     }
 
     delete job.img;
@@ -155,12 +155,20 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
     QMutexLocker locker( &layer->mMutex );
 
+    // when labeling in parallel the candidates for all feature parts are generated up front, but parts are still
+    // processed below in their original order so that candidate ids don't depend on the thread scheduling
+    std::vector< std::vector< std::unique_ptr< LabelPosition > > > parallelCandidates;
+    if ( mParallelLabeling )
+      parallelCandidates = createVisibleCandidatesInParallel( layer, mapBoundaryGeos.get() );
+
     // generate candidates for all features
-    for ( const std::unique_ptr< FeaturePart > &featurePart : std::as_const( layer->mFeatureParts ) )
+    for ( std::size_t partIndex = 0; partIndex < layer->mFeatureParts.size(); ++partIndex )
     {
       if ( isCanceled() )
         break;
 
+      const std::unique_ptr< FeaturePart > &featurePart = layer->mFeatureParts[ partIndex ];
+
       // Holes of the feature are obstacles
       for ( int i = 0; i < featurePart->getNumSelfObstacles(); i++ )
       {
@@ -175,19 +183,8 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
       }
 
       // generate candidates for the feature part
-      std::vector< std::unique_ptr< LabelPosition > > candidates = featurePart->createCandidates( this );
-
-      if ( isCanceled() )
-        break;
-
-      // purge candidates that are outside the bbox
-      candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [&mapBoundaryPrepared, this]( std::unique_ptr< LabelPosition > &candidate )
-      {
-        if ( showPartialLabels() )
-          return !candidate->intersects( mapBoundaryPrepared.get() );
-        else
-          return !candidate->within( mapBoundaryPrepared.get() );
-      } ), candidates.end() );
+      std::vector< std::unique_ptr< LabelPosition > > candidates = mParallelLabeling ? std::move( parallelCandidates[ partIndex ] )
+          : createVisibleCandidates( featurePart.get(), mapBoundaryPrepared.get() );
 
       if ( isCanceled() )
         break;
@@ -485,6 +482,73 @@ std::unique_ptr<Problem> Pal::extractProblem( const QgsRectangle &extent, const
   return extract( extent, mapBoundary );
 }
 
+std::vector< std::unique_ptr< LabelPosition > > Pal::createVisibleCandidates( FeaturePart *featurePart, const GEOSPreparedGeometry *mapBoundary )
+{
+  std::vector< std::unique_ptr< LabelPosition > > candidates = featurePart->createCandidates( this );
+
+  if ( isCanceled() )
+    return candidates;
+
+  // purge candidates that are outside the bbox
+  candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [mapBoundary, this]( std::unique_ptr< LabelPosition > &candidate )
+  {
+    if ( showPartialLabels() )
+      return !candidate->intersects( mapBoundary );
+    else
+      return !candidate->within( mapBoundary );
+  } ), candidates.end() );
+
+  return candidates;
+}
+
+std::vector< std::vector< std::unique_ptr< LabelPosition > > > Pal::createVisibleCandidatesInParallel( Layer *layer, const GEOSGeometry *mapBoundary )
+{
+  const int partCount = static_cast< int >( layer->mFeatureParts.size() );
+  std::vector< std::vector< std::unique_ptr< LabelPosition > > > candidates( partCount );
+
+  // prepared geometries can't be queried from several threads at once, so every worker gets its own copy of the map boundary
+  GEOSContextHandle_t geosctxt = QgsGeos::getGEOSHandler();
+  const int workerCount = Util::parallelWorkerCount();
+  std::vector< geos::unique_ptr > boundaries;
+  std::vector< geos::prepared_unique_ptr > preparedBoundaries;
+  boundaries.reserve( workerCount );
+  preparedBoundaries.reserve( workerCount );
+  for ( int worker = 0; worker < workerCount; ++worker )
+  {
+    boundaries.emplace_back( GEOSGeom_clone_r( geosctxt, mapBoundary ) );
+    preparedBoundaries.emplace_back( GEOSPrepare_r( geosctxt, boundaries.back().get() ) );
+  }
+
+  // the parts of a multipart feature share the prepared permissible zone of their label feature, which builds its
+  // indexes lazily on first use -- so all parts of a label feature are handled one after another by the same worker
+  std::vector< std::vector< int > > featureParts;
+  QHash< QgsLabelFeature *, int > featureIndex;
+  for ( int index = 0; index < partCount; ++index )
+  {
+    QgsLabelFeature *labelFeature = layer->mFeatureParts[ index ]->feature();
+    auto it = featureIndex.constFind( labelFeature );
+    if ( it == featureIndex.constEnd() )
+    {
+      it = featureIndex.insert( labelFeature, static_cast< int >( featureParts.size() ) );
+      featureParts.emplace_back();
+    }
+    featureParts[ *it ].emplace_back( index );
+  }
+
+  Util::parallelFor( static_cast< int >( featureParts.size() ), [&]( int feature, int worker )
+  {
+    for ( int index : featureParts[ feature ] )
+    {
+      if ( isCanceled() )
+        return;
+
+      candidates[ index ] = createVisibleCandidates( layer->mFeatureParts[ index ].get(), preparedBoundaries[ worker ].get() );
+    }
+  } );
+
+  return candidates;
+}
+
 QList<LabelPosition *> Pal::solveProblem( Problem *prob, bool displayAll, QList<LabelPosition *> *unlabeled )
 {
   if ( !prob )
@@ -494,7 +558,10 @@ QList<LabelPosition *> Pal::solveProblem( Problem *prob, bool displayAll, QList<
 
   try
   {
-    prob->chain_search();
+    if ( mParallelLabeling )
+      prob->chain_search_parallel();
+    else
+      prob->chain_search();
   }
   catch ( InternalException::Empty & )
   {
@@ -558,12 +625,17 @@ bool Pal::candidatesAreConflicting( const LabelPosition *lp1, const LabelPositio
   // per candidate during the labeling problem solving
 
   // conflicts are commutative - so we always store them in the cache using the smaller id as the first element of the key pair
+  // the cache is shared by the threads solving independent parts of the problem when labeling in parallel
   auto key = qMakePair( std::min( lp1->globalId(), lp2->globalId() ), std::max( lp1->globalId(), lp2->globalId() ) );
-  auto it = mCandidateConflicts.constFind( key );
-  if ( it != mCandidateConflicts.constEnd() )
-    return *it;
+  {
+    QReadLocker locker( &mCandidateConflictsLock );
+    auto it = mCandidateConflicts.constFind( key );
+    if ( it != mCandidateConflicts.constEnd() )
+      return *it;
+  }
 
   const bool res = lp1->isInConflict( lp2 );
+  QWriteLocker locker( &mCandidateConflictsLock );
   mCandidateConflicts.insert( key, res );
   return res;
 }
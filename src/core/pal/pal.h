@@ -42,6 +42,7 @@
 #include <iostream>
 #include <ctime>
 #include <QMutex>
+#include <QReadWriteLock>
 #include <QStringList>
 #include <unordered_map>
 
@@ -51,6 +52,7 @@ class QgsAbstractLabelProvider;
 
 namespace pal
 {
+  class FeaturePart;
   class Layer;
   class LabelPosition;
   class PalStat;
@@ -163,6 +165,27 @@ namespace pal
        */
       bool showPartialLabels() const;
 
+      /**
+       * Sets whether labeling should use multiple threads.
+       *
+       * When enabled, candidates for the features of each layer are generated in parallel, and
+       * the placement problem is split into independent groups of features whose candidates
+       * conflict with each other, which are then solved concurrently. The results are
+       * deterministic, but may differ slightly from the results of serial labeling.
+       *
+       * \see parallelLabeling()
+       * \since QGIS 3.20
+       */
+      void setParallelLabeling( bool parallel ) { mParallelLabeling = parallel; }
+
+      /**
+       * Returns TRUE if labeling uses multiple threads.
+       *
+       * \see setParallelLabeling()
+       * \since QGIS 3.20
+       */
+      bool parallelLabeling() const { return mParallelLabeling; }
+
       /**
        * Returns the maximum number of line label candidate positions per map unit.
        *
@@ -266,12 +289,15 @@ namespace pal
 
       unsigned int mNextCandidateId = 1;
       mutable QHash< QPair< unsigned int, unsigned int >, bool > mCandidateConflicts;
+      mutable QReadWriteLock mCandidateConflictsLock;
 
       /**
        * \brief show partial labels (cut-off by the map canvas) or not
        */
       bool mShowPartialLabels = true;
 
+      bool mParallelLabeling = false;
+
       double mMaxLineCandidatesPerMapUnit = 0;
       double mMaxPolygonCandidatesPerMapUnitSquared = 0;
 
@@ -293,6 +319,21 @@ namespace pal
        */
       std::unique_ptr< Problem > extract( const QgsRectangle &extent, const QgsGeometry &mapBoundary );
 
+      /**
+       * Generates the candidates for a single \a featurePart, discarding any candidates which
+       * fall outside of the prepared \a mapBoundary.
+       */
+      std::vector< std::unique_ptr< LabelPosition > > createVisibleCandidates( FeaturePart *featurePart, const GEOSPreparedGeometry *mapBoundary );
+
+      /**
+       * Generates the visible candidates for all feature parts from a \a layer using multiple threads.
+       *
+       * The returned vector contains the candidates for each feature part, in the same order as the layer's
+       * feature parts. The layer must be locked by the caller. All parts of a label feature are processed
+       * by the same worker, since they share its prepared permissible zone.
+       */
+      std::vector< std::vector< std::unique_ptr< LabelPosition > > > createVisibleCandidatesInParallel( Layer *layer, const GEOSGeometry *mapBoundary );
+
       /**
        * \brief Choose the size of popmusic subpart's
        * \param r subpart size
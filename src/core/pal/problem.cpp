@@ -39,6 +39,7 @@
 #include "internalexception.h"
 #include <cfloat>
 #include <limits> //for std::numeric_limits<int>::max()
+#include <numeric>
 
 #include "qgslabelingengine.h"
 
@@ -55,7 +56,8 @@ inline void delete_chain( Chain *chain )
 }
 
 Problem::Problem( const QgsRectangle &extent )
-  : mAllCandidatesIndex( extent )
+  : mMaxCoordinateExtent( extent )
+  , mAllCandidatesIndex( extent )
   , mActiveCandidatesIndex( extent )
 {
 
@@ -659,6 +661,177 @@ void Problem::chain_search()
   delete[] ok;
 }
 
+std::vector< std::vector< int > > Problem::conflictingFeatureGroups()
+{
+  // union-find over the features, joining all features which have conflicting candidates
+  std::vector< int > parent( mFeatureCount );
+  std::iota( parent.begin(), parent.end(), 0 );
+  auto findRoot = [&parent]( int feature ) -> int
+  {
+    while ( parent[ feature ] != feature )
+    {
+      parent[ feature ] = parent[ parent[ feature ] ];
+      feature = parent[ feature ];
+    }
+    return feature;
+  };
+
+  double amin[2];
+  double amax[2];
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    if ( pal->isCanceled() )
+      return std::vector< std::vector< int > >();
+
+    for ( int j = 0; j < mFeatNbLp[i]; j++ )
+    {
+      const LabelPosition *lp = mLabelPositions[ mFeatStartId[i] + j ].get();
+      lp->getBoundingBox( amin, amax );
+      mAllCandidatesIndex.intersects( QgsRectangle( amin[0], amin[1], amax[0], amax[1] ), [lp, &parent, &findRoot, this]( const LabelPosition * lp2 ) -> bool
+      {
+        if ( candidatesAreConflicting( lp, lp2 ) )
+        {
+          const int root1 = findRoot( lp->getProblemFeatureId() );
+          const int root2 = findRoot( lp2->getProblemFeatureId() );
+          // always keep the smallest feature index as root, so that the grouping doesn't depend on the order of the index results
+          if ( root1 != root2 )
+            parent[ std::max( root1, root2 ) ] = std::min( root1, root2 );
+        }
+        return true;
+      } );
+    }
+  }
+
+  std::vector< std::vector< int > > groups;
+  std::vector< int > groupForRoot( mFeatureCount, -1 );
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    const int root = findRoot( static_cast< int >( i ) );
+    if ( groupForRoot[ root ] < 0 )
+    {
+      groupForRoot[ root ] = static_cast< int >( groups.size() );
+      groups.emplace_back();
+    }
+    groups[ groupForRoot[ root ] ].emplace_back( static_cast< int >( i ) );
+  }
+  return groups;
+}
+
+std::unique_ptr< Problem > Problem::createSubProblem( const std::vector< int > &features )
+{
+  std::unique_ptr< Problem > subProblem = std::make_unique< Problem >( mMaxCoordinateExtent );
+  subProblem->pal = pal;
+  subProblem->mDisplayAll = mDisplayAll;
+  subProblem->mFeatureCount = features.size();
+  subProblem->mFeatStartId.resize( features.size() );
+  subProblem->mFeatNbLp.resize( features.size() );
+  subProblem->mInactiveCost.resize( features.size() );
+
+  int subId = 0;
+  for ( std::size_t i = 0; i < features.size(); i++ )
+  {
+    const int feature = features[i];
+    subProblem->mFeatStartId[i] = subId;
+    subProblem->mFeatNbLp[i] = mFeatNbLp[feature];
+    subProblem->mInactiveCost[i] = mInactiveCost[feature];
+
+    // only the candidates which survived reduce() are moved, the others are no longer referenced by the solver
+    for ( int j = 0; j < mFeatNbLp[feature]; j++ )
+    {
+      std::unique_ptr< LabelPosition > lp = std::move( mLabelPositions[ mFeatStartId[feature] + j ] );
+      lp->setProblemIds( static_cast< int >( i ), subId++ );
+      lp->insertIntoIndex( subProblem->mAllCandidatesIndex );
+      subProblem->mLabelPositions.emplace_back( std::move( lp ) );
+    }
+  }
+  subProblem->mTotalCandidates = subId;
+  subProblem->mAllNblp = subId;
+  return subProblem;
+}
+
+void Problem::mergeSubProblem( Problem *subProblem, const std::vector< int > &features )
+{
+  for ( std::size_t i = 0; i < features.size(); i++ )
+  {
+    const int feature = features[i];
+    const int subStartId = subProblem->mFeatStartId[i];
+    for ( int j = 0; j < mFeatNbLp[feature]; j++ )
+    {
+      std::unique_ptr< LabelPosition > lp = std::move( subProblem->mLabelPositions[ subStartId + j ] );
+      lp->setProblemIds( feature, mFeatStartId[feature] + j );
+      mLabelPositions[ mFeatStartId[feature] + j ] = std::move( lp );
+    }
+
+    const int subLabelId = subProblem->mSol.activeLabelIds.empty() ? -1 : subProblem->mSol.activeLabelIds[i];
+    mSol.activeLabelIds[feature] = subLabelId < 0 ? -1 : mFeatStartId[feature] + subLabelId - subStartId;
+  }
+}
+
+void Problem::chain_search_parallel()
+{
+  if ( mFeatureCount == 0 )
+    return;
+
+  const std::vector< std::vector< int > > groups = conflictingFeatureGroups();
+  if ( pal->isCanceled() )
+    return;
+
+  mSol.init( mFeatureCount );
+
+  std::vector< int > subProblemGroups;
+  for ( int group = 0; group < static_cast< int >( groups.size() ); group++ )
+  {
+    if ( groups[ group ].size() > 1 )
+    {
+      subProblemGroups.emplace_back( group );
+    }
+    else
+    {
+      // a feature without conflicts always gets its best candidate -- candidates are sorted by cost
+      const int feature = groups[ group ].front();
+      if ( mFeatNbLp[feature] > 0 )
+        mSol.activeLabelIds[feature] = mFeatStartId[feature];
+    }
+  }
+
+  // start with the largest groups, as they take longest to solve
+  std::stable_sort( subProblemGroups.begin(), subProblemGroups.end(), [&groups]( int group1, int group2 )
+  {
+    return groups[ group1 ].size() > groups[ group2 ].size();
+  } );
+
+  std::vector< std::unique_ptr< Problem > > subProblems;
+  subProblems.reserve( subProblemGroups.size() );
+  for ( int group : subProblemGroups )
+    subProblems.emplace_back( createSubProblem( groups[ group ] ) );
+
+  try
+  {
+    Util::parallelFor( static_cast< int >( subProblems.size() ), [&subProblems]( int index, int )
+    {
+      subProblems[ index ]->chain_search();
+    } );
+  }
+  catch ( ... )
+  {
+    // candidates must always be returned to this problem, which owns them
+    for ( std::size_t i = 0; i < subProblems.size(); i++ )
+      mergeSubProblem( subProblems[i].get(), groups[ subProblemGroups[i] ] );
+    throw;
+  }
+
+  for ( std::size_t i = 0; i < subProblems.size(); i++ )
+    mergeSubProblem( subProblems[i].get(), groups[ subProblemGroups[i] ] );
+
+  for ( std::size_t i = 0; i < mFeatureCount; i++ )
+  {
+    if ( mSol.activeLabelIds[i] >= 0 )
+      mLabelPositions[ mSol.activeLabelIds[i] ]->insertIntoIndex( mActiveCandidatesIndex );
+  }
+
+  solution_cost();
+}
+
 QList<LabelPosition *> Problem::getSolution( bool returnInactive, QList<LabelPosition *> *unlabeled )
 {
   QList<LabelPosition *> finalLabelPlacements;
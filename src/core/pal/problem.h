@@ -119,6 +119,18 @@ namespace pal
        */
       void chain_search();
 
+      /**
+       * Solves the problem using multiple threads.
+       *
+       * Features are split into independent groups, where no candidate from one group conflicts
+       * with a candidate from another group. Every group with more than one feature is then solved
+       * with chain_search() on its own, with the groups distributed over the global thread pool.
+       * Features which don't conflict with any other feature are assigned their best candidate.
+       *
+       * The result is deterministic and does not depend on the number of threads used.
+       */
+      void chain_search_parallel();
+
       /**
        * Solves the labeling problem, selecting the best candidate locations for all labels and returns a list of these
        * calculated label positions.
@@ -161,6 +173,26 @@ namespace pal
        */
       bool candidatesAreConflicting( const LabelPosition *lp1, const LabelPosition *lp2 ) const;
 
+      /**
+       * Returns the features of the problem grouped into connected components of the
+       * conflict graph. Components and the features within them are sorted by feature index.
+       */
+      std::vector< std::vector< int > > conflictingFeatureGroups();
+
+      /**
+       * Moves the candidates of the specified \a features into a new problem, which can be solved
+       * independently of this one. Candidates must be moved back with mergeSubProblem().
+       */
+      std::unique_ptr< Problem > createSubProblem( const std::vector< int > &features );
+
+      /**
+       * Moves the candidates of a \a subProblem created for \a features back into this problem,
+       * and copies its solution.
+       */
+      void mergeSubProblem( Problem *subProblem, const std::vector< int > &features );
+
+      QgsRectangle mMaxCoordinateExtent;
+
       /**
        * Total number of layers containing labels
        */
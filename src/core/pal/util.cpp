@@ -36,6 +36,11 @@
 
 #include "qgslogger.h"
 #include <cfloat>
+#include <exception>
+
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 QLinkedList<const GEOSGeometry *> *pal::Util::unmulti( const GEOSGeometry *the_geom )
 {
@@ -83,5 +88,52 @@ QLinkedList<const GEOSGeometry *> *pal::Util::unmulti( const GEOSGeometry *the_g
   return final_queue;
 }
 
+int pal::Util::parallelWorkerCount()
+{
+  return std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+}
+
+void pal::Util::parallelFor( int count, const std::function< void( int, int ) > &function )
+{
+  if ( count <= 0 )
+    return;
+
+  const int workerCount = std::min( parallelWorkerCount(), count );
+  if ( workerCount == 1 )
+  {
+    for ( int i = 0; i < count; ++i )
+      function( i, 0 );
+    return;
+  }
 
+  // work is handed out one index at a time, so that a few expensive items don't leave the other workers idle
+  QAtomicInt nextIndex( 0 );
+  std::vector< std::exception_ptr > errors( workerCount );
+  std::vector< QFuture< void > > futures;
+  futures.reserve( workerCount );
+  for ( int worker = 0; worker < workerCount; ++worker )
+  {
+    futures.push_back( QtConcurrent::run( [&, worker]
+    {
+      try
+      {
+        for ( int i = nextIndex.fetchAndAddRelaxed( 1 ); i < count; i = nextIndex.fetchAndAddRelaxed( 1 ) )
+          function( i, worker );
+      }
+      catch ( ... )
+      {
+        // exceptions can't cross the thread boundary, so they are rethrown from the calling thread
+        errors[ worker ] = std::current_exception();
+        nextIndex.fetchAndStoreRelaxed( count );
+      }
+    } ) );
+  }
+  for ( QFuture< void > &future : futures )
+    future.waitForFinished();
 
+  for ( const std::exception_ptr &error : errors )
+  {
+    if ( error )
+      std::rethrow_exception( error );
+  }
+}
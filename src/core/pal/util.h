@@ -36,6 +36,7 @@
 #include <QList>
 #include <vector>
 #include <memory>
+#include <functional>
 
 namespace pal
 {
@@ -88,6 +89,23 @@ namespace pal
     public:
 
       static QLinkedList<const GEOSGeometry *> *unmulti( const GEOSGeometry *the_geom );
+
+      /**
+       * Returns the number of worker threads used by parallelFor().
+       */
+      static int parallelWorkerCount();
+
+      /**
+       * Calls \a function once for every index in the range [0, \a count), distributing the calls
+       * over the threads of the global thread pool, and blocks until all calls have finished.
+       *
+       * The \a function is called with the index to process and the index of the worker
+       * thread processing it, which is always less than parallelWorkerCount(). Calls made by
+       * the same worker never run concurrently, so per-worker state can be used without locking.
+       *
+       * Any exception thrown by \a function is rethrown in the calling thread.
+       */
+      static void parallelFor( int count, const std::function< void( int index, int worker ) > &function );
   };
 
 
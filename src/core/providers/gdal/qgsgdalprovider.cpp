@@ -56,6 +56,15 @@
 #include <QTextDocument>
 #include <QDebug>
 #include <QRegularExpression>
+#include <QQueue>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include <gdalwarper.h>
 #include <gdal.h>
@@ -1681,6 +1690,34 @@ QStringList QgsGdalProvider::subLayers( GDALDatasetH dataset )
   return subLayers;
 }
 
+///@cond PRIVATE
+static bool defaultHistogramMatches( double minVal, double maxVal, int binCount, double expectedMinVal, double expectedMaxVal, int expectedBinCount )
+{
+  // min/max are stored as text in aux file => use threshold
+  return binCount == expectedBinCount &&
+         std::fabs( minVal - expectedMinVal ) <= std::fabs( expectedMinVal ) / 10e6 &&
+         std::fabs( maxVal - expectedMaxVal ) <= std::fabs( expectedMaxVal ) / 10e6;
+}
+
+//! Band metadata domain for items written by QGIS
+static const char *QGIS_METADATA_DOMAIN = "QGIS";
+//! Band metadata item holding the minimum, maximum and bin count of a default histogram which QGIS calculated exactly
+static const char *EXACT_HISTOGRAM_METADATA_ITEM = "EXACT_DEFAULT_HISTOGRAM";
+
+/**
+ * Returns TRUE if the default histogram of \a band with the specified parameters was calculated exactly by QGIS.
+ * Default histograms stored by other applications, e.g. in the PAM .aux.xml, may be approximate.
+ */
+static bool defaultHistogramIsExact( GDALRasterBandH band, double minVal, double maxVal, int binCount )
+{
+  const QStringList parts = QString( GDALGetMetadataItem( band, EXACT_HISTOGRAM_METADATA_ITEM, QGIS_METADATA_DOMAIN ) ).split( ' ' );
+  if ( parts.size() != 3 )
+    return false;
+
+  return defaultHistogramMatches( minVal, maxVal, binCount, parts.at( 0 ).toDouble(), parts.at( 1 ).toDouble(), parts.at( 2 ).toInt() );
+}
+///@endcond
+
 bool QgsGdalProvider::hasHistogram( int bandNo,
                                     int binCount,
                                     double minimum, double maximum,
@@ -1752,15 +1789,20 @@ bool QgsGdalProvider::hasHistogram( int bandNo,
   myExpectedMinVal -= dfHalfBucket;
   myExpectedMaxVal += dfHalfBucket;
 
-  // min/max are stored as text in aux file => use threshold
-  if ( myBinCount != myHistogram.binCount ||
-       std::fabs( myMinVal - myExpectedMinVal ) > std::fabs( myExpectedMinVal ) / 10e6 ||
-       std::fabs( myMaxVal - myExpectedMaxVal ) > std::fabs( myExpectedMaxVal ) / 10e6 )
+  if ( !defaultHistogramMatches( myMinVal, myMaxVal, myBinCount, myExpectedMinVal, myExpectedMaxVal, myHistogram.binCount ) )
   {
     QgsDebugMsgLevel( QStringLiteral( "Params do not match binCount: %1 x %2, minVal: %3 x %4, maxVal: %5 x %6" ).arg( myBinCount ).arg( myHistogram.binCount ).arg( myMinVal ).arg( myExpectedMinVal ).arg( myMaxVal ).arg( myExpectedMaxVal ), 2 );
     return false;
   }
 
+  // the default histogram may be approximate, so it is only sufficient for exact requests if QGIS calculated it
+  const bool approxOK = sampleSize > 0 && ( static_cast<double>( xSize() ) * static_cast<double>( ySize() ) / sampleSize ) > 2;
+  if ( !approxOK && !defaultHistogramIsExact( myGdalBand, myMinVal, myMaxVal, myBinCount ) )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Default GDAL histogram may be approximate" ), 2 );
+    return false;
+  }
+
   QgsDebugMsgLevel( QStringLiteral( "GDAL has cached histogram" ), 2 );
 
   // This should be enough, possible call to histogram() should retrieve the histogram cached in GDAL
@@ -1887,17 +1929,58 @@ QgsRasterHistogram QgsGdalProvider::histogram( int bandNo,
   }
 #endif
 
-  GUIntBig *myHistogramArray = new GUIntBig[myHistogram.binCount];
-  CPLErr myError = GDALGetRasterHistogramEx( myGdalBand, myMinVal, myMaxVal,
-                   myHistogram.binCount, myHistogramArray,
-                   includeOutOfRange, bApproxOK, progressCallback,
-                   &myProg ); //this is the arg for our custom gdal progress callback
-
-  if ( myError != CE_None || ( feedback && feedback->isCanceled() ) )
+  // reuse the default histogram if it matches, e.g. when it was persisted to the PAM .aux.xml
+  // by a previous call. Default histograms may be approximate, so for exact requests they are
+  // only reused if QGIS calculated them exactly
+  double myDefaultMinVal = 0;
+  double myDefaultMaxVal = 0;
+  int myDefaultBinCount = 0;
+  GUIntBig *myHistogramArray = nullptr;
+  CPLErr myError = GDALGetDefaultHistogramEx( myGdalBand, &myDefaultMinVal, &myDefaultMaxVal,
+                   &myDefaultBinCount, &myHistogramArray, false,
+                   nullptr, nullptr );
+  if ( myError == CE_None && myHistogramArray && !includeOutOfRange &&
+       defaultHistogramMatches( myDefaultMinVal, myDefaultMaxVal, myDefaultBinCount, myMinVal, myMaxVal, myHistogram.binCount ) &&
+       ( bApproxOK || defaultHistogramIsExact( myGdalBand, myDefaultMinVal, myDefaultMaxVal, myDefaultBinCount ) ) )
   {
-    QgsDebugMsgLevel( QStringLiteral( "Cannot get histogram" ), 2 );
-    delete [] myHistogramArray;
-    return myHistogram;
+    QgsDebugMsgLevel( QStringLiteral( "Using default GDAL histogram" ), 2 );
+  }
+  else
+  {
+    if ( myHistogramArray )
+      VSIFree( myHistogramArray ); // use VSIFree because allocated by GDAL
+
+    myHistogramArray = static_cast< GUIntBig * >( VSIMalloc2( sizeof( GUIntBig ), myHistogram.binCount ) );
+    if ( !myHistogramArray )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Cannot allocate histogram" ), 2 );
+      return myHistogram;
+    }
+
+    myError = GDALGetRasterHistogramEx( myGdalBand, myMinVal, myMaxVal,
+                                        myHistogram.binCount, myHistogramArray,
+                                        includeOutOfRange, bApproxOK, progressCallback,
+                                        &myProg ); //this is the arg for our custom gdal progress callback
+
+    if ( myError != CE_None || ( feedback && feedback->isCanceled() ) )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Cannot get histogram" ), 2 );
+      VSIFree( myHistogramArray );
+      return myHistogram;
+    }
+
+    // store exact histograms as the band default histogram, so that GDAL persists them in the PAM
+    // .aux.xml and they don't have to be calculated again when the dataset is next opened
+    if ( !bApproxOK && !includeOutOfRange )
+    {
+      CPLPushErrorHandler( CPLQuietErrorHandler );
+      if ( GDALSetDefaultHistogramEx( myGdalBand, myMinVal, myMaxVal, myHistogram.binCount, myHistogramArray ) == CE_None )
+      {
+        const QString exactHistogram = QStringLiteral( "%1 %2 %3" ).arg( qgsDoubleToString( myMinVal, 17 ), qgsDoubleToString( myMaxVal, 17 ) ).arg( myHistogram.binCount );
+        GDALSetMetadataItem( myGdalBand, EXACT_HISTOGRAM_METADATA_ITEM, exactHistogram.toUtf8().constData(), QGIS_METADATA_DOMAIN );
+      }
+      CPLPopErrorHandler();
+    }
   }
 
 #endif
@@ -1910,7 +1993,7 @@ QgsRasterHistogram QgsGdalProvider::histogram( int bandNo,
 
   myHistogram.valid = true;
 
-  delete [] myHistogramArray;
+  VSIFree( myHistogramArray );
 
   QgsDebugMsgLevel( ">>>>> Histogram vector now contains " + QString::number( myHistogram.histogramVector.size() ) + " elements", 3 );
 
@@ -1918,6 +2001,334 @@ QgsRasterHistogram QgsGdalProvider::histogram( int bandNo,
   return myHistogram;
 }
 
+///@cond PRIVATE
+
+Q_GLOBAL_STATIC( QThreadPool, sPyramidPool )
+
+//! Maximum width and height of the source windows read when building pyramids natively
+static const int PYRAMID_SOURCE_TILE_SIZE = 2048;
+
+//! Maximum total size of the source and resampled values of all windows in progress when building pyramids natively
+static const qgssize MAX_PYRAMID_TILES_IN_PROGRESS_BYTES = static_cast< qgssize >( PYRAMID_SOURCE_TILE_SIZE ) * PYRAMID_SOURCE_TILE_SIZE * 8 * 4;
+
+/**
+ * A window of an overview level, together with the window of the level it is
+ * resampled from.
+ */
+struct PyramidTile
+{
+  int xOffset = 0;
+  int yOffset = 0;
+  int width = 0;
+  int height = 0;
+  int srcXOffset = 0;
+  int srcYOffset = 0;
+  int srcWidth = 0;
+  int srcHeight = 0;
+  //! Source column of each column of the tile, relative to srcXOffset, for nearest neighbour resampling
+  std::vector< int > nearestColumns;
+  //! Source values, replaced by the resampled values by resamplePyramidTile()
+  std::vector< double > data;
+};
+
+/**
+ * Returns the source pixel sampled for the overview pixel  destIndex by nearest neighbour resampling,
+ * i.e. the pixel under its center, in the same way as GDAL.
+ */
+/**
+ * Returns the memory used by \a tile while it is in progress, i.e. its source values and the resampled values.
+ */
+static qgssize pyramidTileBytes( const PyramidTile &tile )
+{
+  return ( static_cast< qgssize >( tile.srcWidth ) * tile.srcHeight + static_cast< qgssize >( tile.width ) * tile.height ) * sizeof( double );
+}
+
+static int nearestPyramidSourceIndex( int destIndex, int srcSize, int destSize )
+{
+  const double ratio = static_cast< double >( srcSize ) / destSize;
+  return std::min( static_cast< int >( ( destIndex + 0.5 ) * ratio ), srcSize - 1 );
+}
+
+/**
+ * Returns TRUE if the overviews of \a dataset can be built by buildPyramidsNatively()
+ * using the specified resampling method.
+ */
+static bool supportsNativePyramids( GDALDatasetH dataset, const QString &resamplingMethod )
+{
+  if ( resamplingMethod.compare( QLatin1String( "NEAREST" ), Qt::CaseInsensitive ) != 0 &&
+       resamplingMethod.compare( QLatin1String( "AVERAGE" ), Qt::CaseInsensitive ) != 0 )
+    return false;
+
+  const int bandCount = GDALGetRasterCount( dataset );
+  if ( bandCount < 1 )
+    return false;
+
+  for ( int i = 1; i <= bandCount; ++i )
+  {
+    GDALRasterBandH band = GDALGetRasterBand( dataset, i );
+    if ( GDALDataTypeIsComplex( GDALGetRasterDataType( band ) ) )
+      return false;
+
+    // per dataset masks and alpha bands are left to GDAL
+    if ( !( GDALGetMaskFlags( band ) & ( GMF_ALL_VALID | GMF_NODATA ) ) )
+      return false;
+  }
+  return true;
+}
+
+static void resamplePyramidTile( PyramidTile &tile, int factor, bool average, bool hasNoData, double noData )
+{
+  std::vector< double > result( static_cast< std::size_t >( tile.width ) * tile.height );
+  const bool noDataIsNan = hasNoData && std::isnan( noData );
+  double *out = result.data();
+  if ( !average )
+  {
+    // the rows sampled by nearest neighbour resampling are read one by one, so only the columns are left to pick
+    for ( int row = 0; row < tile.height; ++row )
+    {
+      const double *values = tile.data.data() + static_cast< std::size_t >( row ) * tile.srcWidth;
+      for ( int col = 0; col < tile.width; ++col )
+        *out++ = values[tile.nearestColumns[col]];
+    }
+    tile.data.swap( result );
+    return;
+  }
+
+  for ( int row = 0; row < tile.height; ++row )
+  {
+    const int srcRow0 = row * factor;
+    const int srcRow1 = std::min( srcRow0 + factor, tile.srcHeight );
+    for ( int col = 0; col < tile.width; ++col )
+    {
+      const int srcCol0 = col * factor;
+      const int srcCol1 = std::min( srcCol0 + factor, tile.srcWidth );
+      double sum = 0;
+      int count = 0;
+      for ( int srcRow = srcRow0; srcRow < srcRow1; ++srcRow )
+      {
+        const double *values = tile.data.data() + static_cast< std::size_t >( srcRow ) * tile.srcWidth;
+        for ( int srcCol = srcCol0; srcCol < srcCol1; ++srcCol )
+        {
+          const double value = values[srcCol];
+          if ( std::isnan( value ) || ( hasNoData && !noDataIsNan && value == noData ) )
+            continue;
+          sum += value;
+          count++;
+        }
+      }
+      *out++ = count > 0 ? sum / count : ( hasNoData ? noData : std::numeric_limits< double >::quiet_NaN() );
+    }
+  }
+  tile.data.swap( result );
+}
+
+/**
+ * Resamples \a srcBand by \a factor into the overview band \a destBand.
+ *
+ * The source windows are read on the calling thread, as GDAL handles can't be shared between
+ * threads, resampled in parallel and written in order on the calling thread. At most \a threadCount
+ * windows are in progress at once, and fewer if they would exceed MAX_PYRAMID_TILES_IN_PROGRESS_BYTES together.
+ * \a tileDone is called after each window is written, and should return FALSE to cancel.
+ */
+static bool buildPyramidLevel( GDALRasterBandH srcBand, GDALRasterBandH destBand, int factor, bool average,
+                               int threadCount, const std::function< bool() > &tileDone )
+{
+  int hasNoDataValue = 0;
+  const double noData = GDALGetRasterNoDataValue( srcBand, &hasNoDataValue );
+  const bool hasNoData = hasNoDataValue;
+
+  const int srcXSize = GDALGetRasterBandXSize( srcBand );
+  const int srcYSize = GDALGetRasterBandYSize( srcBand );
+  const int destXSize = GDALGetRasterBandXSize( destBand );
+  const int destYSize = GDALGetRasterBandYSize( destBand );
+  const int tileSize = std::max( 16, PYRAMID_SOURCE_TILE_SIZE / factor );
+
+  QVector< PyramidTile > tiles;
+  for ( int yOffset = 0; yOffset < destYSize; yOffset += tileSize )
+  {
+    for ( int xOffset = 0; xOffset < destXSize; xOffset += tileSize )
+    {
+      PyramidTile tile;
+      tile.xOffset = xOffset;
+      tile.yOffset = yOffset;
+      tile.width = std::min( tileSize, destXSize - xOffset );
+      tile.height = std::min( tileSize, destYSize - yOffset );
+      if ( average )
+      {
+        tile.srcXOffset = xOffset * factor;
+        tile.srcYOffset = yOffset * factor;
+        tile.srcWidth = std::min( tile.width * factor, srcXSize - tile.srcXOffset );
+        tile.srcHeight = std::min( tile.height * factor, srcYSize - tile.srcYOffset );
+      }
+      else
+      {
+        tile.srcXOffset = nearestPyramidSourceIndex( xOffset, srcXSize, destXSize );
+        tile.srcWidth = nearestPyramidSourceIndex( xOffset + tile.width - 1, srcXSize, destXSize ) - tile.srcXOffset + 1;
+        tile.srcHeight = tile.height;
+        tile.nearestColumns.reserve( tile.width );
+        for ( int col = 0; col < tile.width; ++col )
+          tile.nearestColumns.emplace_back( nearestPyramidSourceIndex( xOffset + col, srcXSize, destXSize ) - tile.srcXOffset );
+      }
+      if ( tile.srcWidth <= 0 || tile.srcHeight <= 0 )
+        return false;
+      tiles.append( tile );
+    }
+  }
+
+  QQueue< QFuture< std::shared_ptr< PyramidTile > > > pending;
+  qgssize pendingBytes = 0;
+  int nextTile = 0;
+  bool result = true;
+  for ( int i = 0; i < tiles.size() && result; ++i )
+  {
+    // always keep at least one window in progress, even if it exceeds the budget by itself
+    while ( nextTile < tiles.size() && pending.size() < threadCount
+            && ( pending.isEmpty() || pendingBytes + pyramidTileBytes( tiles.at( nextTile ) ) <= MAX_PYRAMID_TILES_IN_PROGRESS_BYTES ) )
+    {
+      pendingBytes += pyramidTileBytes( tiles.at( nextTile ) );
+      std::shared_ptr< PyramidTile > tile = std::make_shared< PyramidTile >( tiles.at( nextTile++ ) );
+      tile->data.resize( static_cast< std::size_t >( tile->srcWidth ) * tile->srcHeight );
+      if ( average )
+      {
+        result = GDALRasterIO( srcBand, GF_Read, tile->srcXOffset, tile->srcYOffset, tile->srcWidth, tile->srcHeight,
+                               tile->data.data(), tile->srcWidth, tile->srcHeight, GDT_Float64, 0, 0 ) == CE_None;
+      }
+      else
+      {
+        // only the source rows under the centers of the tile's rows are read
+        for ( int row = 0; row < tile->height && result; ++row )
+        {
+          const int srcRow = nearestPyramidSourceIndex( tile->yOffset + row, srcYSize, destYSize );
+          result = GDALRasterIO( srcBand, GF_Read, tile->srcXOffset, srcRow, tile->srcWidth, 1,
+                                 tile->data.data() + static_cast< std::size_t >( row ) * tile->srcWidth, tile->srcWidth, 1, GDT_Float64, 0, 0 ) == CE_None;
+        }
+      }
+      if ( !result )
+        break;
+      pending.enqueue( QtConcurrent::run( sPyramidPool(), [tile, factor, average, hasNoData, noData]
+      {
+        resamplePyramidTile( *tile, factor, average, hasNoData, noData );
+        return tile;
+      } ) );
+    }
+    if ( !result || pending.isEmpty() )
+      break;
+
+    std::shared_ptr< PyramidTile > tile = pending.dequeue().result();
+    pendingBytes -= pyramidTileBytes( *tile );
+    if ( GDALRasterIO( destBand, GF_Write, tile->xOffset, tile->yOffset, tile->width, tile->height,
+                       tile->data.data(), tile->width, tile->height, GDT_Float64, 0, 0 ) != CE_None || !tileDone() )
+    {
+      result = false;
+    }
+  }
+
+  for ( QFuture< std::shared_ptr< PyramidTile > > &future : pending )
+    future.waitForFinished();
+
+  return result;
+}
+
+/**
+ * Builds the overview \a levels of \a dataset without GDAL's resampling.
+ *
+ * The overview bands are created empty by GDAL and then filled level by level. As with GDAL, average
+ * levels are calculated from the previous level if their decimation factor is a multiple of the previous
+ * one, while nearest neighbour levels always sample the full resolution band at the center of each
+ * overview pixel, so that the sampled pixels don't drift between levels. Windows of each level are
+ * resampled in parallel.
+ *
+ * Returns an empty string on success, "CANCELED" if canceled via \a feedback, or "FAILED_NOT_SUPPORTED" if
+ * the overviews couldn't be built, in which case they should be built using GDALBuildOverviews().
+ */
+static QString buildPyramidsNatively( GDALDatasetH dataset, QVector< int > levels, const QString &resamplingMethod, QgsRasterBlockFeedback *feedback )
+{
+  std::sort( levels.begin(), levels.end() );
+  levels.erase( std::unique( levels.begin(), levels.end() ), levels.end() );
+  if ( levels.isEmpty() || levels.first() < 2 )
+    return QStringLiteral( "FAILED_NOT_SUPPORTED" );
+
+  if ( GDALBuildOverviews( dataset, "NONE", levels.size(), levels.data(), 0, nullptr, nullptr, nullptr ) != CE_None )
+    return QStringLiteral( "FAILED_NOT_SUPPORTED" );
+
+  const bool average = resamplingMethod.compare( QLatin1String( "AVERAGE" ), Qt::CaseInsensitive ) == 0;
+  const int bandCount = GDALGetRasterCount( dataset );
+  const int xSize = GDALGetRasterXSize( dataset );
+  const int ySize = GDALGetRasterYSize( dataset );
+  const int threadCount = std::max( 1, sPyramidPool()->maxThreadCount() );
+
+  // total number of windows, for progress reports
+  qint64 tileCount = 0;
+  int previousLevel = 1;
+  for ( int level : std::as_const( levels ) )
+  {
+    const qint64 levelXSize = ( xSize + level - 1 ) / level;
+    const qint64 levelYSize = ( ySize + level - 1 ) / level;
+    const int factor = average && level % previousLevel == 0 ? level / previousLevel : level;
+    const qint64 tileSize = std::max( 16, PYRAMID_SOURCE_TILE_SIZE / factor );
+    tileCount += ( ( levelXSize + tileSize - 1 ) / tileSize ) * ( ( levelYSize + tileSize - 1 ) / tileSize );
+    previousLevel = level;
+  }
+  tileCount *= bandCount;
+
+  qint64 tilesDone = 0;
+  auto tileDone = [&tilesDone, tileCount, feedback]
+  {
+    tilesDone++;
+    if ( !feedback )
+      return true;
+    feedback->setProgress( 100.0 * tilesDone / tileCount );
+    return !feedback->isCanceled();
+  };
+
+  for ( int bandNo = 1; bandNo <= bandCount; ++bandNo )
+  {
+    GDALRasterBandH band = GDALGetRasterBand( dataset, bandNo );
+    GDALRasterBandH previousBand = band;
+    int previousLevel = 1;
+    for ( int level : std::as_const( levels ) )
+    {
+      const int levelXSize = ( xSize + level - 1 ) / level;
+      const int levelYSize = ( ySize + level - 1 ) / level;
+      GDALRasterBandH overviewBand = nullptr;
+      for ( int i = 0; i < GDALGetOverviewCount( band ); ++i )
+      {
+        GDALRasterBandH overview = GDALGetOverview( band, i );
+        if ( GDALGetRasterBandXSize( overview ) == levelXSize && GDALGetRasterBandYSize( overview ) == levelYSize )
+        {
+          overviewBand = overview;
+          break;
+        }
+      }
+      if ( !overviewBand )
+        return QStringLiteral( "FAILED_NOT_SUPPORTED" );
+
+      GDALRasterBandH srcBand = band;
+      int factor = level;
+      if ( average && level % previousLevel == 0 )
+      {
+        srcBand = previousBand;
+        factor = level / previousLevel;
+      }
+
+      if ( !buildPyramidLevel( srcBand, overviewBand, factor, average, threadCount, tileDone ) )
+      {
+        if ( feedback && feedback->isCanceled() )
+          return QStringLiteral( "CANCELED" );
+        return QStringLiteral( "FAILED_NOT_SUPPORTED" );
+      }
+
+      previousBand = overviewBand;
+      previousLevel = level;
+    }
+  }
+
+  GDALFlushCache( dataset );
+  return QString();
+}
+
+///@endcond
+
 /*
  * This will speed up performance at the expense of hard drive space.
  * Also, write access to the file is required for creating internal pyramids,
@@ -2075,10 +2486,31 @@ QString QgsGdalProvider::buildPyramids( const QList<QgsRasterPyramid> &rasterPyr
     myProg.type = QgsRaster::ProgressPyramids;
     myProg.provider = this;
     myProg.feedback = feedback;
-    myError = GDALBuildOverviews( mGdalBaseDataset, method,
-                                  myOverviewLevelsVector.size(), myOverviewLevelsVector.data(),
-                                  0, nullptr,
-                                  progressCallback, &myProg ); //this is the arg for the gdal progress callback
+    QString nativeResult = QStringLiteral( "FAILED_NOT_SUPPORTED" );
+    if ( format != QgsRaster::PyramidsErdas && supportsNativePyramids( mGdalBaseDataset, resamplingMethod ) )
+    {
+      // nearest and average overviews are built without GDAL, in parallel and each level from the previous one
+      CPLErrorReset();
+      nativeResult = buildPyramidsNatively( mGdalBaseDataset, myOverviewLevelsVector, resamplingMethod, feedback );
+      QgsDebugMsgLevel( QStringLiteral( "Native pyramid building result: [%1]" ).arg( nativeResult ), 2 );
+    }
+
+    if ( nativeResult.isEmpty() )
+    {
+      myError = CE_None;
+    }
+    else if ( nativeResult == QLatin1String( "CANCELED" ) )
+    {
+      myError = CE_Failure;
+    }
+    else
+    {
+      CPLErrorReset();
+      myError = GDALBuildOverviews( mGdalBaseDataset, method,
+                                    myOverviewLevelsVector.size(), myOverviewLevelsVector.data(),
+                                    0, nullptr,
+                                    progressCallback, &myProg ); //this is the arg for the gdal progress callback
+    }
 
     if ( ( feedback && feedback->isCanceled() ) || myError == CE_Failure || CPLGetLastErrorNo() == CPLE_NotSupported )
     {
@@ -29,6 +29,8 @@
 #include "qgswkbtypes.h"
 #include "qgsogrtransaction.h"
 #include "qgssymbol.h"
+#include "qgsspatialindexpackedrtree.h"
+#include "qgswkbgeometryview.h"
 
 #include <QTextCodec>
 #include <QFile>
@@ -171,6 +173,12 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
     mFetchGeometry = true;
   }
 
+  mBoundingBoxOnlyFilter = !mFilterRect.isNull()
+                           && ( mRequest.flags() & QgsFeatureRequest::NoGeometry )
+                           && !( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+                           && mSource->mOgrGeometryTypeFilter == wkbUnknown
+                           && !( request.filterType() == QgsFeatureRequest::FilterExpression && request.filterExpression()->needsGeometry() );
+
   // make sure we fetch just relevant fields
   // unless it's a VRT data source filtered by geometry as we don't know which
   // attributes make up the geometry and OGR won't fetch them to evaluate the
@@ -182,6 +190,20 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
       QgsOgrProviderUtils::setRelevantFields( mOgrLayerOri, mSource->mFields.count(), mFetchGeometry, attrs, mSource->mFirstFieldIsFid, mSource->mSubsetString );
   }
 
+  // use the sidecar spatial index to select features by id, which avoids a full scan
+  // of formats without a native spatial index
+  mUseSidecarIndex = mSource->mSidecarIndex
+                     && !mFilterRect.isNull()
+                     && mRequest.filterType() == QgsFeatureRequest::FilterNone
+                     && mAllowResetReading
+                     && mSource->mSubsetString.isEmpty();
+  if ( mUseSidecarIndex )
+  {
+    const QList<QgsFeatureId> ids = mSource->mSidecarIndex->intersects( mFilterRect );
+    mFilterFids = std::set<QgsFeatureId>( ids.constBegin(), ids.constEnd() );
+    mFilterFidsIt = mFilterFids.begin();
+  }
+
   // spatial query to select features
   if ( mAllowResetReading )
   {
@@ -330,7 +352,7 @@ bool QgsOgrFeatureIterator::checkFeature( gdal::ogr_feature_unique_ptr &fet, Qgs
   if ( !readFeature( std::move( fet ), feature ) )
     return false;
 
-  if ( !mFilterRect.isNull() && ( !feature.hasGeometry() || feature.geometry().isEmpty() ) )
+  if ( !mFilterRect.isNull() && !mBoundingBoxOnlyFilter && ( !feature.hasGeometry() || feature.geometry().isEmpty() ) )
     return false;
 
   // we have a feature, end this cycle
@@ -362,7 +384,7 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
     close(); // the feature has been read or was not found: we have finished here
     return result;
   }
-  else if ( mRequest.filterType() == QgsFeatureRequest::FilterFids )
+  else if ( mRequest.filterType() == QgsFeatureRequest::FilterFids || mUseSidecarIndex )
   {
     while ( mFilterFidsIt != mFilterFids.end() )
     {
@@ -503,6 +525,26 @@ void QgsOgrFeatureIterator::getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature
   f.setAttribute( attindex, value );
 }
 
+///@cond PRIVATE
+//! Returns TRUE if QgsOgrUtils::ogrGeometryToQgsGeometry() converts \a geom through its WKB representation
+static bool convertedThroughWkb( OGRGeometryH geom )
+{
+  switch ( wkbFlatten( OGR_G_GetGeometryType( geom ) ) )
+  {
+    case wkbPoint:
+    case wkbMultiPoint:
+    case wkbLineString:
+    case wkbMultiLineString:
+    case wkbPolygon:
+    case wkbMultiPolygon:
+      return false;
+
+    default:
+      return true;
+  }
+}
+///@endcond
+
 bool QgsOgrFeatureIterator::readFeature( const gdal::ogr_feature_unique_ptr &fet, QgsFeature &feature ) const
 {
   feature.setId( OGR_F_GetFID( fet.get() ) );
@@ -511,13 +553,42 @@ bool QgsOgrFeatureIterator::readFeature( const gdal::ogr_feature_unique_ptr &fet
 
   bool useIntersect = !mRequest.filterRect().isNull();
   bool geometryTypeFilter = mSource->mOgrGeometryTypeFilter != wkbUnknown;
-  if ( mFetchGeometry || useIntersect || geometryTypeFilter )
+
+  if ( mBoundingBoxOnlyFilter )
+  {
+    // the geometry is only required for a bounding box test, so use the OGR envelope directly
+    // instead of materializing a full QgsGeometry which would be immediately discarded
+    OGRGeometryH geom = OGR_F_GetGeometryRef( fet.get() );
+    if ( !geom || OGR_G_IsEmpty( geom ) )
+      return false;
+
+    OGREnvelope env;
+    OGR_G_GetEnvelope( geom, &env );
+    if ( !mFilterRect.intersects( QgsRectangle( env.MinX, env.MinY, env.MaxX, env.MaxY, false ) ) )
+      return false;
+
+    feature.clearGeometry();
+  }
+  else if ( mFetchGeometry || useIntersect || geometryTypeFilter )
   {
     OGRGeometryH geom = OGR_F_GetGeometryRef( fet.get() );
 
     if ( geom )
     {
-      QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+      QgsGeometry g;
+      if ( useIntersect && !( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) && convertedThroughWkb( geom ) )
+      {
+        // curves and collections are converted through WKB, so test their bounding box on the WKB
+        // and only parse the geometries of the features which pass the filter
+        const QgsWkbGeometryView view = QgsOgrUtils::ogrGeometryToWkbGeometryView( geom );
+        if ( !view.boundingBoxIntersects( mFilterRect ) )
+          return false;
+        g = view.geometry();
+      }
+      else
+      {
+        g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+      }
 
       // Insure that multipart datasets return multipart geometry
       if ( QgsWkbTypes::isMultiType( mSource->mWkbType ) && !g.isMultipart() )
@@ -596,6 +667,8 @@ QgsOgrFeatureSource::QgsOgrFeatureSource( const QgsOgrProvider *p )
   , mWkbType( p->wkbType() )
   , mSharedDS( nullptr )
 {
+  if ( QgsSpatialIndexPackedRTree *index = p->sidecarIndex() )
+    mSidecarIndex = std::make_unique< QgsSpatialIndexPackedRTree >( *index );
   if ( p->mTransaction )
   {
     mTransaction = p->mTransaction;
@@ -31,6 +31,7 @@
 class QgsOgrFeatureIterator;
 class QgsOgrProvider;
 class QgsOgrDataset;
+class QgsSpatialIndexPackedRTree;
 using QgsOgrDatasetSharedPtr = std::shared_ptr< QgsOgrDataset>;
 
 class QgsOgrFeatureSource final: public QgsAbstractFeatureSource
@@ -58,6 +59,7 @@ class QgsOgrFeatureSource final: public QgsAbstractFeatureSource
     QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
     QgsOgrDatasetSharedPtr mSharedDS = nullptr;
     QgsTransaction *mTransaction = nullptr;
+    std::unique_ptr< QgsSpatialIndexPackedRTree > mSidecarIndex;
 
     friend class QgsOgrFeatureIterator;
     friend class QgsOgrExpressionCompiler;
@@ -94,6 +96,12 @@ class QgsOgrFeatureIterator final: public QgsAbstractFeatureIteratorFromSource<Q
     //! Sets to true, if geometry is in the requested columns
     bool mFetchGeometry = false;
 
+    //! Sets to true if the geometry is only required for a bounding box filter test, and is not returned
+    bool mBoundingBoxOnlyFilter = false;
+
+    //! Sets to true if the features matching the filter rectangle are fetched by id using the source's sidecar spatial index
+    bool mUseSidecarIndex = false;
+
     bool mExpressionCompiled = false;
     // use std::set to get sorted ids (needed for efficient QgsFeatureRequest::FilterFids requests on OSM datasource)
     std::set<QgsFeatureId> mFilterFids;
@@ -51,6 +51,8 @@ email                : sherman at mrcc.com
 #include "qgsmetadatautils.h"
 #include "qgssymbol.h"
 #include "qgszipitem.h"
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsspatialindexsidecar.h"
 
 #define CPL_SUPRESS_CPLUSPLUS  //#spellok
 #include <gdal.h>         // to collect version information
@@ -680,6 +682,39 @@ QgsAbstractFeatureSource *QgsOgrProvider::featureSource() const
   return new QgsOgrFeatureSource( this );
 }
 
+bool QgsOgrProvider::canUseSidecarIndex() const
+{
+  // Only file based formats without a native spatial index, which can efficiently
+  // fetch features by id, benefit from a sidecar index
+  if ( !mOgrLayer || mTransaction || !mSubsetString.isEmpty() || mFilePath.isEmpty() )
+    return false;
+
+  if ( mGDALDriverName != QLatin1String( "GeoJSON" ) &&
+       mGDALDriverName != QLatin1String( "GeoJSONSeq" ) &&
+       mGDALDriverName != QLatin1String( "CSV" ) &&
+       mGDALDriverName != QLatin1String( "GML" ) &&
+       mGDALDriverName != QLatin1String( "KML" ) )
+    return false;
+
+  return !mOgrLayer->TestCapability( OLCFastSpatialFilter ) && mOgrLayer->TestCapability( OLCRandomRead );
+}
+
+QgsSpatialIndexPackedRTree *QgsOgrProvider::sidecarIndex() const
+{
+  if ( !canUseSidecarIndex() )
+    return nullptr;
+
+  const QFileInfo fi( mFilePath );
+  if ( fi.size() != mSidecarIndexSourceSize || fi.lastModified() != mSidecarIndexSourceModified )
+  {
+    // the file has changed (or we haven't looked for a sidecar yet)
+    mSidecarIndex = QgsSpatialIndexSidecar::load( mFilePath, mLayerName.isEmpty() ? QString::number( mLayerIndex ) : mLayerName );
+    mSidecarIndexSourceSize = fi.size();
+    mSidecarIndexSourceModified = fi.lastModified();
+  }
+  return mSidecarIndex.get();
+}
+
 bool QgsOgrProvider::setSubsetString( const QString &theSQL, bool updateFeatureCount )
 {
   return _setSubsetString( theSQL, updateFeatureCount, true );
@@ -3079,6 +3114,23 @@ bool QgsOgrProvider::createSpatialIndex()
 
   if ( !mOgrOrigLayer )
     return false;
+
+  if ( canUseSidecarIndex() )
+  {
+    // no native spatial index support - persist a sidecar index instead. This doesn't need
+    // write access to the source, so it must be done before doInitialActionsForEdition()
+    QgsFeatureIterator it = getFeatures( QgsFeatureRequest().setNoAttributes() );
+    QString error;
+    if ( !QgsSpatialIndexSidecar::write( mFilePath, mLayerName.isEmpty() ? QString::number( mLayerIndex ) : mLayerName, it, nullptr, &error ) )
+    {
+      pushError( tr( "Could not create spatial index: %1" ).arg( error ) );
+      return false;
+    }
+    // force the sidecar to be reloaded
+    mSidecarIndexSourceSize = -1;
+    return sidecarIndex() != nullptr;
+  }
+
   if ( !doInitialActionsForEdition() )
     return false;
 
@@ -3375,6 +3427,10 @@ void QgsOgrProvider::computeCapabilities()
       ability |= CreateSpatialIndex;
       ability |= CreateAttributeIndex;
     }
+    else if ( canUseSidecarIndex() )
+    {
+      ability |= CreateSpatialIndex;
+    }
 
     /* Curve geometries are available in some drivers starting with GDAL 2.0 */
     if ( mOgrLayer->TestCapability( "CurveGeometries" ) )
@@ -4541,6 +4597,8 @@ QgsFeatureSource::SpatialIndexPresence QgsOgrProvider::hasSpatialIndex() const
 
   if ( mOgrLayer && mOgrLayer->TestCapability( OLCFastSpatialFilter ) )
     return QgsFeatureSource::SpatialIndexPresent;
+  else if ( sidecarIndex() )
+    return QgsFeatureSource::SpatialIndexPresent;
   else if ( mOgrLayer )
     return QgsFeatureSource::SpatialIndexNotPresent;
   else
@@ -19,6 +19,7 @@ email                : sherman at mrcc.com
 #define QGSOGRPROVIDER_H
 
 #include "QTextCodec"
+#include <QDateTime>
 
 #include "qgsrectangle.h"
 #include "qgsvectordataprovider.h"
@@ -39,6 +40,7 @@ class QgsOgrFeatureIterator;
 
 class QgsOgrLayer;
 class QgsOgrTransaction;
+class QgsSpatialIndexPackedRTree;
 
 /**
  * Releases a QgsOgrLayer
@@ -234,6 +236,12 @@ class QgsOgrProvider final: public QgsVectorDataProvider
 
     QStringList _subLayers( bool withFeatureCount ) const;
 
+    //! Returns TRUE if the layer lacks a native spatial index and can use a persisted sidecar index instead
+    bool canUseSidecarIndex() const;
+
+    //! Returns the sidecar spatial index for the layer, or NULLPTR if none is available or it is out of date
+    QgsSpatialIndexPackedRTree *sidecarIndex() const;
+
     QgsFields mAttributeFields;
 
     //! Map of field index to default value
@@ -241,6 +249,12 @@ class QgsOgrProvider final: public QgsVectorDataProvider
 
     bool mFirstFieldIsFid = false;
     mutable std::unique_ptr< OGREnvelope > mExtent;
+
+    //! Persisted sidecar spatial index, and the size and modification time of the file it was loaded for
+    mutable std::unique_ptr< QgsSpatialIndexPackedRTree > mSidecarIndex;
+    mutable qint64 mSidecarIndexSourceSize = -1;
+    mutable QDateTime mSidecarIndexSourceModified;
+
     bool mForceRecomputeExtent = false;
 
     QList<int> mPrimaryKeyAttrs;
@@ -890,6 +890,9 @@ const int PREVIEW_JOB_DELAY_MS = 250;
 //! Maximum rendering time for a layer of a preview job
 const int MAXIMUM_LAYER_PREVIEW_TIME_MS = 250;
 
+//! Minimum previous rendering time of a layer for a progressive canvas refresh to start with a draft render
+const int MINIMUM_LAYER_DRAFT_TIME_MS = 500;
+
 ///@endcond
 
 #endif
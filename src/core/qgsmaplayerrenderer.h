@@ -23,6 +23,7 @@
 
 class QgsFeedback;
 class QgsRenderContext;
+class QgsMapRendererCache;
 
 /**
  * \ingroup core
@@ -137,6 +138,18 @@ class CORE_EXPORT QgsMapLayerRenderer
      */
     virtual void setLayerRenderingTimeHint( int time ) SIP_SKIP { Q_UNUSED( time ) }
 
+    /**
+     * Sets the map renderer \a cache of the job which is rendering the layer.
+     *
+     * Layer renderer subclasses can use this to store and reuse intermediate results, such as
+     * the features fetched for a vector layer, across renders. The cache is guaranteed to
+     * outlive the layer renderer.
+     *
+     * \note Not available in Python bindings.
+     * \since QGIS 3.20
+     */
+    virtual void setMapRendererCache( QgsMapRendererCache *cache ) SIP_SKIP { Q_UNUSED( cache ) }
+
   protected:
     QStringList mErrors;
     QString mLayerID;
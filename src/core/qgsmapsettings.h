@@ -411,6 +411,11 @@ class CORE_EXPORT QgsMapSettings : public QgsTemporalRangeObject
       RenderBlocking           = 0x800, //!< Render and load remote sources in the same thread to ensure rendering remote sources (svg and images). WARNING: this flag must NEVER be used from GUI based applications (like the main QGIS application) or crashes will result. Only for use in external scripts or QGIS server.
       LosslessImageRendering   = 0x1000, //!< Render images losslessly whenever possible, instead of the default lossy jpeg rendering used for some destination devices (e.g. PDF). This flag only works with builds based on Qt 5.13 or later.
       Render3DMap              = 0x2000, //!< Render is for a 3D map
+      CullSubPixelFeatures     = 0x4000, //!< Collapse line and polygon features smaller than a pixel to a single dot, and drop vertices closer than the simplification threshold after transforming to painter coordinates. Trades exact rendering for speed in zoomed out views of dense layers. Since QGIS 3.20
+      CacheMarkerSprites       = 0x8000, //!< Rasterize each distinct marker symbol appearance once per render and draw the cached image for subsequent points. Greatly speeds up rendering of dense point layers with complex or SVG markers, at the cost of sub-pixel positioning accuracy. Since QGIS 3.20
+      RenderVectorLayersInTiles = 0x10000, //!< Split the rendering of each eligible vector layer into horizontal tiles which are drawn in parallel threads and then composited. Speeds up maps dominated by a single heavy layer. Since QGIS 3.20
+      CacheVectorFeatures      = 0x20000, //!< Keep the features fetched for vector layers in the map renderer cache, so that restyling the layers or zooming within the cached area does not read them from the data provider again. Only applies to jobs with a QgsMapRendererCache. Since QGIS 3.20
+      RenderDraftPreview       = 0x40000, //!< Render is a fast, low quality draft which will be followed by a full quality render. Vector layers are simplified aggressively and only a limited number of features is drawn for each layer. Since QGIS 3.20
       // TODO: ignore scale-based visibility (overview)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -35,6 +35,7 @@
 #include "qgsfillsymbol.h"
 #include "qgslinesymbol.h"
 #include "qgsmarkersymbol.h"
+#include "qgswkbgeometryview.h"
 
 #include <QTextCodec>
 #include <QUuid>
@@ -758,23 +759,31 @@ QgsGeometry QgsOgrUtils::ogrGeometryToQgsGeometry( OGRGeometryH geom )
   }
 
   // Fallback to inefficient WKB conversions
+  return ogrGeometryToWkbGeometryView( geom ).geometry();
+}
+
+QgsWkbGeometryView QgsOgrUtils::ogrGeometryToWkbGeometryView( OGRGeometryH geom )
+{
+  if ( !geom )
+    return QgsWkbGeometryView();
 
-  if ( wkbFlatten( wkbType ) == wkbGeometryCollection )
+  if ( wkbFlatten( OGR_G_GetGeometryType( geom ) ) == wkbGeometryCollection )
   {
     // Shapefile MultiPatch can be reported as GeometryCollectionZ of TINZ
     if ( OGR_G_GetGeometryCount( geom ) >= 1 &&
          wkbFlatten( OGR_G_GetGeometryType( OGR_G_GetGeometryRef( geom, 0 ) ) ) == wkbTIN )
     {
       auto newGeom = OGR_G_ForceToMultiPolygon( OGR_G_Clone( geom ) );
-      auto ret = ogrGeometryToQgsGeometry( newGeom );
+      auto ret = ogrGeometryToWkbGeometryView( newGeom );
       OGR_G_DestroyGeometry( newGeom );
       return ret;
     }
   }
 
   // get the wkb representation
-  int memorySize = OGR_G_WkbSize( geom );
-  unsigned char *wkb = new unsigned char[memorySize];
+  const int memorySize = OGR_G_WkbSize( geom );
+  QByteArray wkbArray( memorySize, Qt::Uninitialized );
+  unsigned char *wkb = reinterpret_cast< unsigned char * >( wkbArray.data() );
   OGR_G_ExportToWkb( geom, static_cast<OGRwkbByteOrder>( QgsApplication::endian() ), wkb );
 
   // Read original geometry type
@@ -835,9 +844,7 @@ QgsGeometry QgsOgrUtils::ogrGeometryToQgsGeometry( OGRGeometryH geom )
     memcpy( wkb + 1, &newType, sizeof( uint32_t ) );
   }
 
-  QgsGeometry g;
-  g.fromWkb( wkb, memorySize );
-  return g;
+  return QgsWkbGeometryView( wkbArray );
 }
 
 QgsFeatureList QgsOgrUtils::stringToFeatureList( const QString &string, const QgsFields &fields, QTextCodec *encoding )
@@ -28,6 +28,7 @@
 #include "cpl_string.h"
 
 class QTextCodec;
+class QgsWkbGeometryView;
 
 namespace gdal
 {
@@ -243,6 +244,21 @@ class CORE_EXPORT QgsOgrUtils
      */
     static QgsGeometry ogrGeometryToQgsGeometry( OGRGeometryH geom );
 
+    /**
+     * Converts an OGR geometry representation to a QgsWkbGeometryView over its WKB representation,
+     * without parsing it into a QgsGeometry. TINs and polyhedral surfaces are mapped to multipolygons.
+     *
+     * This is how ogrGeometryToQgsGeometry() converts geometry types without an optimised conversion,
+     * such as curves and collections. It allows these geometries to be tested against a bounding box
+     * before they are parsed.
+     *
+     * \param geom OGR geometry handle
+     * \returns geometry view, which is null if \a geom is NULLPTR
+     * \see ogrGeometryToQgsGeometry()
+     * \since QGIS 3.20
+     */
+    static QgsWkbGeometryView ogrGeometryToWkbGeometryView( OGRGeometryH geom );
+
     /**
      * Attempts to parse a string representing a collection of features using OGR. For example, this method can be
      * used to convert a GeoJSON encoded collection to a list of QgsFeatures.
@@ -0,0 +1,320 @@
+/***************************************************************************
+                             qgspointaggregationpyramid.cpp
+                             ------------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspointaggregationpyramid.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeedback.h"
+#include "qgsgeometry.h"
+#include "qgsspatialindexsidecar.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+
+///@cond PRIVATE
+static const quint32 PYRAMID_MAGIC = 0x41504751; // "QGPA"
+static const quint32 PYRAMID_VERSION = 3;
+
+struct QgsPointAggregationPyramidCacheEntry
+{
+  std::shared_ptr< const QgsPointAggregationPyramid > pyramid;
+  QString sourceState;
+  qint64 sidecarLastModified = -1;
+};
+
+struct QgsPointAggregationPyramidCache
+{
+  QMutex mutex;
+  QHash< QString, QgsPointAggregationPyramidCacheEntry > entries;
+};
+
+Q_GLOBAL_STATIC( QgsPointAggregationPyramidCache, sPyramidCache )
+///@endcond
+
+std::unique_ptr<QgsPointAggregationPyramid> QgsPointAggregationPyramid::build( QgsFeatureIterator &iterator, const QgsRectangle &extent, QgsFeedback *feedback )
+{
+  std::unique_ptr< QgsPointAggregationPyramid > pyramid( new QgsPointAggregationPyramid() );
+  pyramid->mExtent = extent;
+  pyramid->mSize = std::max( extent.width(), extent.height() );
+  if ( pyramid->mSize <= 0 || !std::isfinite( pyramid->mSize ) )
+    pyramid->mSize = 1;
+
+  // merges the cells of a level into the cells of the next coarser level
+  auto parentCells = []( const QHash< quint64, Cell > &cells, int level )
+  {
+    const quint64 cellsPerSide = static_cast< quint64 >( 1 ) << level;
+    QHash< quint64, Cell > result;
+    for ( auto it = cells.constBegin(); it != cells.constEnd(); ++it )
+    {
+      const quint64 index = ( it->index / cellsPerSide / 2 ) * ( cellsPerSide / 2 ) + ( it->index % cellsPerSide ) / 2;
+      Cell &cell = result[ index ];
+      cell.index = index;
+      cell.sumX += it->sumX;
+      cell.sumY += it->sumY;
+      cell.count += it->count;
+    }
+    return result;
+  };
+
+  // points are accumulated at the finest possible level, which is made coarser whenever
+  // the number of distinct cells would exceed the memory budget
+  int accumulationLevel = MAX_LEVEL;
+  QHash< quint64, Cell > accumulated;
+  QgsFeature f;
+  while ( iterator.nextFeature( f ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return nullptr;
+
+    if ( !f.hasGeometry() )
+      continue;
+
+    const quint64 cellsPerSide = static_cast< quint64 >( 1 ) << accumulationLevel;
+    const double cellSize = pyramid->mSize / cellsPerSide;
+    const QgsGeometry geometry = f.geometry();
+    for ( auto it = geometry.vertices_begin(); it != geometry.vertices_end(); ++it )
+    {
+      const QgsPoint &point = *it;
+      const quint64 column = static_cast< quint64 >( std::clamp( std::floor( ( point.x() - extent.xMinimum() ) / cellSize ), 0.0, static_cast< double >( cellsPerSide - 1 ) ) );
+      const quint64 row = static_cast< quint64 >( std::clamp( std::floor( ( point.y() - extent.yMinimum() ) / cellSize ), 0.0, static_cast< double >( cellsPerSide - 1 ) ) );
+      Cell &cell = accumulated[ row * cellsPerSide + column ];
+      cell.index = row * cellsPerSide + column;
+      cell.sumX += point.x();
+      cell.sumY += point.y();
+      cell.count++;
+      pyramid->mPointCount++;
+    }
+
+    if ( accumulated.size() > MAX_CELL_COUNT && accumulationLevel > 0 )
+    {
+      accumulated = parentCells( accumulated, accumulationLevel );
+      accumulationLevel--;
+    }
+  }
+
+  auto sortedCells = []( const QHash< quint64, Cell > &cells )
+  {
+    QVector< Cell > result;
+    result.reserve( cells.size() );
+    for ( auto it = cells.constBegin(); it != cells.constEnd(); ++it )
+      result.append( it.value() );
+    std::sort( result.begin(), result.end(), []( const Cell & a, const Cell & b ) { return a.index < b.index; } );
+    return result;
+  };
+
+  // the finest level kept is the coarsest one where cells hold at most two points on average,
+  // as drawing the cells of finer levels would cost about as much as drawing the points themselves
+  int finestLevel = accumulationLevel;
+  QVector< QVector< Cell > > levels( accumulationLevel + 1 );
+  QHash< quint64, Cell > cells = accumulated;
+  for ( int level = accumulationLevel; level >= 0; --level )
+  {
+    if ( level < accumulationLevel )
+      cells = parentCells( cells, level + 1 );
+
+    if ( static_cast< qint64 >( cells.size() ) * 2 >= pyramid->mPointCount )
+    {
+      for ( int finer = level + 1; finer <= finestLevel; ++finer )
+        levels[ finer ].clear();
+      finestLevel = level;
+    }
+    levels[ level ] = sortedCells( cells );
+  }
+  levels.resize( finestLevel + 1 );
+  pyramid->mLevels = levels;
+
+  return pyramid;
+}
+
+int QgsPointAggregationPyramid::levelCount() const
+{
+  return mLevels.size();
+}
+
+double QgsPointAggregationPyramid::cellSize( int level ) const
+{
+  return mSize / ( static_cast< quint64 >( 1 ) << std::clamp( level, 0, MAX_LEVEL ) );
+}
+
+bool QgsPointAggregationPyramid::bins( const QgsRectangle &rectangle, double maximumCellSize, QVector<Bin> &bins ) const
+{
+  bins.clear();
+  const int finestLevel = mLevels.size() - 1;
+  if ( finestLevel < 0 || cellSize( finestLevel ) > maximumCellSize )
+    return false;
+
+  int level = 0;
+  while ( level < finestLevel && cellSize( level ) > maximumCellSize )
+    level++;
+
+  const QgsRectangle rect = rectangle.intersect( mExtent );
+  if ( rect.isNull() )
+    return true;
+
+  const quint64 cellsPerSide = static_cast< quint64 >( 1 ) << level;
+  const double size = cellSize( level );
+  auto cellCoordinate = [size, cellsPerSide]( double value )
+  {
+    return static_cast< quint64 >( std::clamp( std::floor( value / size ), 0.0, static_cast< double >( cellsPerSide - 1 ) ) );
+  };
+  const quint64 columnMin = cellCoordinate( rect.xMinimum() - mExtent.xMinimum() );
+  const quint64 columnMax = cellCoordinate( rect.xMaximum() - mExtent.xMinimum() );
+  const quint64 rowMin = cellCoordinate( rect.yMinimum() - mExtent.yMinimum() );
+  const quint64 rowMax = cellCoordinate( rect.yMaximum() - mExtent.yMinimum() );
+
+  // cells are sorted in row-major order, so each row of the query is a contiguous range
+  const QVector< Cell > &cells = mLevels.at( level );
+  auto it = cells.constBegin();
+  for ( quint64 row = rowMin; row <= rowMax && it != cells.constEnd(); ++row )
+  {
+    const quint64 first = row * cellsPerSide + columnMin;
+    const quint64 last = row * cellsPerSide + columnMax;
+    it = std::lower_bound( it, cells.constEnd(), first, []( const Cell & cell, quint64 index ) { return cell.index < index; } );
+    for ( ; it != cells.constEnd() && it->index <= last; ++it )
+    {
+      Bin bin;
+      bin.x = it->sumX / it->count;
+      bin.y = it->sumY / it->count;
+      bin.count = it->count;
+      bins.append( bin );
+    }
+  }
+  return true;
+}
+
+QString QgsPointAggregationPyramid::sidecarPath( const QString &source, const QString &sourcePath )
+{
+  return QgsSpatialIndexSidecar::sidecarPath( sourcePath, source, QStringLiteral( "qpa" ) );
+}
+
+bool QgsPointAggregationPyramid::write( const QString &source, const QString &sourcePath, const QgsPointAggregationPyramid &pyramid, QString *error )
+{
+  if ( !QFileInfo::exists( sourcePath ) )
+  {
+    if ( error )
+      *error = QObject::tr( "Source file %1 does not exist" ).arg( sourcePath );
+    return false;
+  }
+
+  const QString path = sidecarPath( source, sourcePath );
+  QSaveFile file( path );
+  if ( !QgsSpatialIndexSidecar::openForWriting( file, error ) )
+    return false;
+
+  QDataStream out( &file );
+  out.setByteOrder( QDataStream::LittleEndian );
+  QgsSpatialIndexSidecar::writeHeader( out, PYRAMID_MAGIC, PYRAMID_VERSION, sourcePath, source );
+  out << pyramid.mExtent.xMinimum() << pyramid.mExtent.yMinimum() << pyramid.mExtent.xMaximum() << pyramid.mExtent.yMaximum()
+      << pyramid.mSize << pyramid.mPointCount << static_cast< qint32 >( pyramid.mLevels.size() );
+  for ( const QVector< Cell > &cells : pyramid.mLevels )
+  {
+    out << static_cast< qint64 >( cells.size() );
+    for ( const Cell &cell : cells )
+      out << cell.index << cell.sumX << cell.sumY << cell.count;
+  }
+
+  if ( out.status() != QDataStream::Ok || !file.commit() )
+  {
+    if ( error )
+      *error = QObject::tr( "Could not write point aggregation pyramid to %1: %2" ).arg( path, file.errorString() );
+    return false;
+  }
+  return true;
+}
+
+std::unique_ptr<QgsPointAggregationPyramid> QgsPointAggregationPyramid::load( const QString &source, const QString &sourcePath )
+{
+  QFile file( sidecarPath( source, sourcePath ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return nullptr;
+
+  QDataStream in( &file );
+  in.setByteOrder( QDataStream::LittleEndian );
+  if ( !QgsSpatialIndexSidecar::readHeader( in, PYRAMID_MAGIC, PYRAMID_VERSION, sourcePath, source ) )
+    return nullptr;
+
+  std::unique_ptr< QgsPointAggregationPyramid > pyramid( new QgsPointAggregationPyramid() );
+  double xMin = 0;
+  double yMin = 0;
+  double xMax = 0;
+  double yMax = 0;
+  qint32 levelCount = 0;
+  in >> xMin >> yMin >> xMax >> yMax >> pyramid->mSize >> pyramid->mPointCount >> levelCount;
+  if ( in.status() != QDataStream::Ok || levelCount < 1 || levelCount > MAX_LEVEL + 1 )
+    return nullptr;
+  pyramid->mExtent = QgsRectangle( xMin, yMin, xMax, yMax, false );
+
+  pyramid->mLevels.resize( levelCount );
+  for ( int level = 0; level < levelCount; ++level )
+  {
+    qint64 cellCount = 0;
+    in >> cellCount;
+    // each cell is stored as a 64 bit index followed by two doubles and a 64 bit count
+    if ( in.status() != QDataStream::Ok || cellCount < 0 || cellCount * 32 > file.size() - file.pos() )
+      return nullptr;
+
+    QVector< Cell > &cells = pyramid->mLevels[ level ];
+    cells.resize( static_cast< int >( cellCount ) );
+    for ( Cell &cell : cells )
+      in >> cell.index >> cell.sumX >> cell.sumY >> cell.count;
+  }
+  if ( in.status() != QDataStream::Ok )
+    return nullptr;
+
+  return pyramid;
+}
+
+std::shared_ptr<const QgsPointAggregationPyramid> QgsPointAggregationPyramid::cachedPyramid( const QString &source, const QString &sourcePath )
+{
+  const QFileInfo sidecarInfo( sidecarPath( source, sourcePath ) );
+  if ( !sidecarInfo.exists() )
+    return nullptr;
+
+  const QString sourceState = QgsSpatialIndexSidecar::sourceState( sourcePath );
+  const qint64 sidecarLastModified = sidecarInfo.lastModified().toMSecsSinceEpoch();
+
+  QgsPointAggregationPyramidCache *cache = sPyramidCache();
+  QMutexLocker locker( &cache->mutex );
+  auto it = cache->entries.constFind( source );
+  if ( it != cache->entries.constEnd() && it->sourceState == sourceState && it->sidecarLastModified == sidecarLastModified )
+    return it->pyramid;
+
+  QgsPointAggregationPyramidCacheEntry entry;
+  entry.pyramid = load( source, sourcePath );
+  entry.sourceState = sourceState;
+  entry.sidecarLastModified = sidecarLastModified;
+  cache->entries.insert( source, entry );
+  return entry.pyramid;
+}
+
+bool QgsPointAggregationPyramid::remove( const QString &source, const QString &sourcePath )
+{
+  {
+    QgsPointAggregationPyramidCache *cache = sPyramidCache();
+    QMutexLocker locker( &cache->mutex );
+    cache->entries.remove( source );
+  }
+
+  const QString path = sidecarPath( source, sourcePath );
+  return !QFile::exists( path ) || QFile::remove( path );
+}
@@ -0,0 +1,177 @@
+/***************************************************************************
+                             qgspointaggregationpyramid.h
+                             ----------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPOINTAGGREGATIONPYRAMID_H
+#define QGSPOINTAGGREGATIONPYRAMID_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsrectangle.h"
+
+#include <QString>
+#include <QVector>
+#include <memory>
+
+class QgsFeatureIterator;
+class QgsFeedback;
+
+/**
+ * \ingroup core
+ * \class QgsPointAggregationPyramid
+ * \brief A precomputed multi-resolution aggregation of the points in a layer.
+ *
+ * The pyramid divides a square region covering the layer's extent into a grid of cells at
+ * each level, with level 0 consisting of a single cell and each subsequent level halving
+ * the cell size. Each non-empty cell stores the number of points it contains and the sum of
+ * their coordinates.
+ *
+ * The depth of the pyramid follows the density of the points: levels are added until the
+ * cells hold no more than two points on average, up to MAX_LEVEL. Sparse points spread over
+ * a large extent therefore still get levels fine enough to aggregate them at large scales.
+ *
+ * When a layer is rendered at a scale where a pixel covers at least one cell of the finest
+ * level, the cells of a matching level can be drawn in place of the individual points. This
+ * makes the cost of rendering zoomed out views of very large point layers proportional to
+ * the output size instead of the number of features.
+ *
+ * Pyramids are persisted to sidecar files alongside the spatial index sidecars of
+ * QgsSpatialIndexSidecar, keyed by the source file and layer source. The sidecar is ignored
+ * if the source file has changed since it was written, including edits to a GeoPackage which
+ * are still pending in its write-ahead log (see QgsSpatialIndexSidecar::sourceState()).
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.20
+ */
+class CORE_EXPORT QgsPointAggregationPyramid
+{
+  public:
+
+    //! Deepest possible pyramid level, with 2^MAX_LEVEL cells along each side of the grid
+    static constexpr int MAX_LEVEL = 24;
+
+    /**
+     * Maximum number of distinct cells accumulated while building a pyramid. Denser points
+     * reduce the depth of the pyramid to keep the memory used by the build bounded.
+     */
+    static constexpr int MAX_CELL_COUNT = 1 << 20;
+
+    //! Aggregated points contained in a single pyramid cell
+    struct Bin
+    {
+      //! Mean x coordinate of the points in the cell
+      double x = 0;
+      //! Mean y coordinate of the points in the cell
+      double y = 0;
+      //! Number of points in the cell
+      qint64 count = 0;
+    };
+
+    /**
+     * Builds a pyramid from the point features returned by \a iterator, which must all be
+     * located within \a extent. Multipoint features contribute each of their parts.
+     *
+     * The optional \a feedback argument can be used to cancel the build, in which case NULLPTR
+     * is returned.
+     */
+    static std::unique_ptr< QgsPointAggregationPyramid > build( QgsFeatureIterator &iterator, const QgsRectangle &extent, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Returns the extent covered by the pyramid.
+     */
+    QgsRectangle extent() const { return mExtent; }
+
+    /**
+     * Returns the total number of points aggregated in the pyramid.
+     */
+    qint64 pointCount() const { return mPointCount; }
+
+    /**
+     * Returns the number of levels stored in the pyramid, the finest of which is levelCount() - 1.
+     */
+    int levelCount() const;
+
+    /**
+     * Returns the width and height of the cells at the specified \a level.
+     */
+    double cellSize( int level ) const;
+
+    /**
+     * Returns the aggregated bins intersecting \a rectangle, using the coarsest pyramid level
+     * with a cell size no larger than \a maximumCellSize.
+     *
+     * Returns FALSE if even the cells of the finest level are larger than \a maximumCellSize,
+     * in which case the individual points must be used instead.
+     */
+    bool bins( const QgsRectangle &rectangle, double maximumCellSize, QVector< Bin > &bins ) const;
+
+    /**
+     * Returns the path of the sidecar file for the layer \a source, which is read from the file
+     * at \a sourcePath.
+     */
+    static QString sidecarPath( const QString &source, const QString &sourcePath );
+
+    /**
+     * Writes the \a pyramid to the sidecar for the layer \a source, which is read from the file
+     * at \a sourcePath.
+     *
+     * Returns FALSE if the sidecar could not be written, in which case \a error will be
+     * set to a descriptive error message.
+     */
+    static bool write( const QString &source, const QString &sourcePath, const QgsPointAggregationPyramid &pyramid, QString *error = nullptr );
+
+    /**
+     * Loads the pyramid sidecar for the layer \a source, which is read from the file at \a sourcePath.
+     *
+     * Returns NULLPTR if no sidecar exists, or it is out of date with respect to the source file.
+     */
+    static std::unique_ptr< QgsPointAggregationPyramid > load( const QString &source, const QString &sourcePath );
+
+    /**
+     * Returns the pyramid for the layer \a source, loading the sidecar on first use and keeping it
+     * in memory for subsequent calls as long as the source file is unchanged.
+     *
+     * Returns NULLPTR if no valid sidecar exists. This method is thread safe.
+     */
+    static std::shared_ptr< const QgsPointAggregationPyramid > cachedPyramid( const QString &source, const QString &sourcePath );
+
+    /**
+     * Removes the pyramid sidecar for the layer \a source, which is read from the file at
+     * \a sourcePath, if one exists.
+     */
+    static bool remove( const QString &source, const QString &sourcePath );
+
+  private:
+
+    struct Cell
+    {
+      quint64 index = 0;
+      double sumX = 0;
+      double sumY = 0;
+      qint64 count = 0;
+    };
+
+    QgsRectangle mExtent;
+    double mSize = 1;
+    qint64 mPointCount = 0;
+
+    //! Non-empty cells for each level, sorted by row-major cell index
+    QVector< QVector< Cell > > mLevels;
+
+    friend class TestQgsPointAggregationPyramid;
+};
+
+#endif // QGSPOINTAGGREGATIONPYRAMID_H
@@ -221,6 +221,11 @@ QgsRenderContext QgsRenderContext::fromMapSettings( const QgsMapSettings &mapSet
   ctx.setFlag( RenderBlocking, mapSettings.testFlag( QgsMapSettings::RenderBlocking ) );
   ctx.setFlag( LosslessImageRendering, mapSettings.testFlag( QgsMapSettings::LosslessImageRendering ) );
   ctx.setFlag( Render3DMap, mapSettings.testFlag( QgsMapSettings::Render3DMap ) );
+  ctx.setFlag( CullSubPixelFeatures, mapSettings.testFlag( QgsMapSettings::CullSubPixelFeatures ) );
+  ctx.setFlag( CacheMarkerSprites, mapSettings.testFlag( QgsMapSettings::CacheMarkerSprites ) );
+  ctx.setFlag( RenderVectorLayersInTiles, mapSettings.testFlag( QgsMapSettings::RenderVectorLayersInTiles ) );
+  ctx.setFlag( CacheVectorFeatures, mapSettings.testFlag( QgsMapSettings::CacheVectorFeatures ) );
+  ctx.setFlag( RenderDraftPreview, mapSettings.testFlag( QgsMapSettings::RenderDraftPreview ) );
   ctx.setScaleFactor( mapSettings.outputDpi() / 25.4 ); // = pixels per mm
   ctx.setDpiTarget( mapSettings.dpiTarget() >= 0.0 ? mapSettings.dpiTarget() : -1.0 );
   ctx.setRendererScale( mapSettings.scale() );
@@ -86,6 +86,11 @@ class CORE_EXPORT QgsRenderContext : public QgsTemporalRangeObject
       ApplyScalingWorkaroundForTextRendering = 0x2000, //!< Whether a scaling workaround designed to stablise the rendering of small font sizes (or for painters scaled out by a large amount) when rendering text. Generally this is recommended, but it may incur some performance cost.
       Render3DMap              = 0x4000, //!< Render is for a 3D map
       ApplyClipAfterReprojection = 0x8000, //!< Feature geometry clipping to mapExtent() must be performed after the geometries are transformed using coordinateTransform(). Usually feature geometry clipping occurs using the extent() in the layer's CRS prior to geometry transformation, but in some cases when extent() could not be accurately calculated it is necessary to clip geometries to mapExtent() AFTER transforming them using coordinateTransform().
+      CullSubPixelFeatures     = 0x10000, //!< Line and polygon features smaller than a pixel are collapsed to a single dot (and skipped if that pixel has already been drawn), and vertices closer than the simplification threshold are dropped after transforming to painter coordinates. Features are only collapsed for single symbol, categorized, graduated and rule based renderers, with symbols drawn in a plain color. Since QGIS 3.20
+      CacheMarkerSprites       = 0x20000, //!< Marker symbols are rasterized once per distinct appearance (including evaluated data defined properties) and the cached image is drawn for each subsequent point. Only applies when rendering to a raster image. Since QGIS 3.20
+      RenderVectorLayersInTiles = 0x40000, //!< Eligible vector layers are split into horizontal tiles which are rendered in parallel threads and composited in order. Only applies when rendering to a raster image. Since QGIS 3.20
+      CacheVectorFeatures      = 0x80000, //!< Features fetched for vector layers are kept in the map renderer cache and reused by later renders. Since QGIS 3.20
+      RenderDraftPreview       = 0x100000, //!< Render is a fast, low quality draft which will be followed by a full quality render, so accuracy can be traded for speed. Since QGIS 3.20
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
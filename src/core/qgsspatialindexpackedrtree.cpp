@@ -0,0 +1,411 @@
+/***************************************************************************
+                             qgsspatialindexpackedrtree.cpp
+                             ------------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeedback.h"
+#include "qgsfeaturesource.h"
+#include "qgsspatialindexpackedrtree_p.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+///@cond PRIVATE
+
+QgsPackedHilbertRTree::QgsPackedHilbertRTree( QgsFeatureIterator &fi, QgsFeedback *feedback )
+{
+  std::vector< double > boxes;
+  std::vector< qint64 > ids;
+
+  QgsFeature f;
+  while ( fi.nextFeature( f ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return;
+
+    if ( !f.hasGeometry() || f.geometry().isEmpty() )
+      continue;
+
+    const QgsRectangle bounds = f.geometry().boundingBox();
+    boxes.push_back( bounds.xMinimum() );
+    boxes.push_back( bounds.yMinimum() );
+    boxes.push_back( bounds.xMaximum() );
+    boxes.push_back( bounds.yMaximum() );
+    ids.push_back( f.id() );
+  }
+
+  load( boxes, ids );
+}
+
+QgsPackedHilbertRTree::QgsPackedHilbertRTree( const QVector<QPair<QgsFeatureId, QgsRectangle> > &entries )
+{
+  std::vector< double > boxes;
+  std::vector< qint64 > ids;
+  boxes.reserve( 4 * entries.size() );
+  ids.reserve( entries.size() );
+  for ( const QPair< QgsFeatureId, QgsRectangle > &entry : entries )
+  {
+    boxes.push_back( entry.second.xMinimum() );
+    boxes.push_back( entry.second.yMinimum() );
+    boxes.push_back( entry.second.xMaximum() );
+    boxes.push_back( entry.second.yMaximum() );
+    ids.push_back( entry.first );
+  }
+
+  load( boxes, ids );
+}
+
+void QgsPackedHilbertRTree::load( const std::vector<double> &boxes, const std::vector<qint64> &ids )
+{
+  mNumItems = ids.size();
+  if ( mNumItems == 0 )
+    return;
+
+  // sort items by the Hilbert value of their centers, so that spatially close items are packed into the same nodes
+  double xMin = std::numeric_limits< double >::max();
+  double yMin = std::numeric_limits< double >::max();
+  double xMax = -std::numeric_limits< double >::max();
+  double yMax = -std::numeric_limits< double >::max();
+  for ( std::size_t i = 0; i < mNumItems; ++i )
+  {
+    xMin = std::min( xMin, boxes[4 * i] );
+    yMin = std::min( yMin, boxes[4 * i + 1] );
+    xMax = std::max( xMax, boxes[4 * i + 2] );
+    yMax = std::max( yMax, boxes[4 * i + 3] );
+  }
+
+  const double hilbertMax = ( 1 << 16 ) - 1;
+  const double width = xMax - xMin;
+  const double height = yMax - yMin;
+  std::vector< quint32 > hilbertValues( mNumItems );
+  for ( std::size_t i = 0; i < mNumItems; ++i )
+  {
+    const double cx = ( boxes[4 * i] + boxes[4 * i + 2] ) / 2;
+    const double cy = ( boxes[4 * i + 1] + boxes[4 * i + 3] ) / 2;
+    const quint32 hx = width > 0 ? static_cast< quint32 >( std::floor( hilbertMax * ( cx - xMin ) / width ) ) : 0;
+    const quint32 hy = height > 0 ? static_cast< quint32 >( std::floor( hilbertMax * ( cy - yMin ) / height ) ) : 0;
+    hilbertValues[i] = hilbert( hx, hy );
+  }
+
+  std::vector< std::size_t > order( mNumItems );
+  std::iota( order.begin(), order.end(), 0 );
+  std::sort( order.begin(), order.end(), [&hilbertValues]( std::size_t a, std::size_t b )
+  {
+    return hilbertValues[a] < hilbertValues[b] || ( hilbertValues[a] == hilbertValues[b] && a < b );
+  } );
+
+  // calculate the total number of nodes, and the bounds of each level
+  std::size_t count = mNumItems;
+  std::size_t numNodes = mNumItems;
+  mLevelBounds.push_back( numNodes );
+  do
+  {
+    count = ( count + NODE_SIZE - 1 ) / NODE_SIZE;
+    numNodes += count;
+    mLevelBounds.push_back( numNodes );
+  }
+  while ( count != 1 );
+
+  mBoxes.resize( 4 * numNodes );
+  mIndices.resize( numNodes );
+
+  for ( std::size_t i = 0; i < mNumItems; ++i )
+  {
+    const std::size_t source = order[i];
+    std::copy( boxes.begin() + 4 * source, boxes.begin() + 4 * source + 4, mBoxes.begin() + 4 * i );
+    mIndices[i] = ids[source];
+  }
+
+  build();
+}
+
+void QgsPackedHilbertRTree::build()
+{
+  // generate nodes at each tree level, bottom-up
+  std::size_t pos = 0;
+  for ( std::size_t level = 0; level < mLevelBounds.size() - 1; ++level )
+  {
+    const std::size_t end = mLevelBounds[level];
+    std::size_t parent = end;
+
+    while ( pos < end )
+    {
+      const std::size_t firstChild = pos;
+      double nodeXMin = std::numeric_limits< double >::max();
+      double nodeYMin = std::numeric_limits< double >::max();
+      double nodeXMax = -std::numeric_limits< double >::max();
+      double nodeYMax = -std::numeric_limits< double >::max();
+      for ( int i = 0; i < NODE_SIZE && pos < end; ++i, ++pos )
+      {
+        nodeXMin = std::min( nodeXMin, mBoxes[4 * pos] );
+        nodeYMin = std::min( nodeYMin, mBoxes[4 * pos + 1] );
+        nodeXMax = std::max( nodeXMax, mBoxes[4 * pos + 2] );
+        nodeYMax = std::max( nodeYMax, mBoxes[4 * pos + 3] );
+      }
+
+      mBoxes[4 * parent] = nodeXMin;
+      mBoxes[4 * parent + 1] = nodeYMin;
+      mBoxes[4 * parent + 2] = nodeXMax;
+      mBoxes[4 * parent + 3] = nodeYMax;
+      mIndices[parent] = static_cast< qint64 >( firstChild );
+      parent++;
+    }
+  }
+}
+
+std::size_t QgsPackedHilbertRTree::levelEnd( std::size_t nodeIndex ) const
+{
+  return *std::upper_bound( mLevelBounds.begin(), mLevelBounds.end(), nodeIndex );
+}
+
+void QgsPackedHilbertRTree::intersects( double xMin, double yMin, double xMax, double yMax, const std::function<bool ( QgsFeatureId, const QgsRectangle & )> &visitor ) const
+{
+  if ( mNumItems == 0 )
+    return;
+
+  std::size_t nodeIndex = mIndices.size() - 1;
+  std::vector< std::size_t > queue;
+
+  while ( true )
+  {
+    const std::size_t end = std::min( nodeIndex + NODE_SIZE, levelEnd( nodeIndex ) );
+    const bool isLeafLevel = nodeIndex < mNumItems;
+
+    for ( std::size_t pos = nodeIndex; pos < end; ++pos )
+    {
+      if ( xMax < mBoxes[4 * pos] || yMax < mBoxes[4 * pos + 1] || xMin > mBoxes[4 * pos + 2] || yMin > mBoxes[4 * pos + 3] )
+        continue;
+
+      if ( isLeafLevel )
+      {
+        if ( !visitor( mIndices[pos], boxAt( pos ) ) )
+          return;
+      }
+      else
+      {
+        queue.push_back( static_cast< std::size_t >( mIndices[pos] ) );
+      }
+    }
+
+    if ( queue.empty() )
+      break;
+
+    nodeIndex = queue.back();
+    queue.pop_back();
+  }
+}
+
+void QgsPackedHilbertRTree::nearestNeighbor( double x, double y, double maxDistance, const std::function<bool ( QgsFeatureId, double )> &visitor ) const
+{
+  if ( mNumItems == 0 )
+    return;
+
+  struct QueueItem
+  {
+    double distanceSquared;
+    std::size_t index;
+    bool isLeaf;
+  };
+
+  auto compare = []( const QueueItem & a, const QueueItem & b )
+  {
+    // min-heap on distance, with ties resolved by position for deterministic results
+    return a.distanceSquared > b.distanceSquared || ( a.distanceSquared == b.distanceSquared && a.index > b.index );
+  };
+  std::priority_queue< QueueItem, std::vector< QueueItem >, decltype( compare ) > queue( compare );
+
+  const double maxDistanceSquared = maxDistance > 0 ? maxDistance * maxDistance : std::numeric_limits< double >::max();
+
+  std::size_t nodeIndex = mIndices.size() - 1;
+  while ( true )
+  {
+    const std::size_t end = std::min( nodeIndex + NODE_SIZE, levelEnd( nodeIndex ) );
+    const bool isLeafLevel = nodeIndex < mNumItems;
+
+    for ( std::size_t pos = nodeIndex; pos < end; ++pos )
+    {
+      const double dx = x < mBoxes[4 * pos] ? mBoxes[4 * pos] - x : ( x > mBoxes[4 * pos + 2] ? x - mBoxes[4 * pos + 2] : 0 );
+      const double dy = y < mBoxes[4 * pos + 1] ? mBoxes[4 * pos + 1] - y : ( y > mBoxes[4 * pos + 3] ? y - mBoxes[4 * pos + 3] : 0 );
+      const double distanceSquared = dx * dx + dy * dy;
+      if ( distanceSquared > maxDistanceSquared )
+        continue;
+
+      if ( isLeafLevel )
+        queue.push( { distanceSquared, pos, true } );
+      else
+        queue.push( { distanceSquared, static_cast< std::size_t >( mIndices[pos] ), false } );
+    }
+
+    // a leaf at the top of the queue is guaranteed to be closer than any item remaining in the unvisited nodes
+    while ( !queue.empty() && queue.top().isLeaf )
+    {
+      const QueueItem item = queue.top();
+      queue.pop();
+      if ( !visitor( mIndices[item.index], std::sqrt( item.distanceSquared ) ) )
+        return;
+    }
+
+    if ( queue.empty() )
+      break;
+
+    nodeIndex = queue.top().index;
+    queue.pop();
+  }
+}
+
+quint32 QgsPackedHilbertRTree::hilbert( quint32 x, quint32 y )
+{
+  // Fast Hilbert curve index calculation for a 16 bit grid, based on the public domain
+  // algorithm from https://github.com/rawrunprotected/hilbert_curves
+  quint32 a = x ^ y;
+  quint32 b = 0xFFFF ^ a;
+  quint32 c = 0xFFFF ^ ( x | y );
+  quint32 d = x & ( y ^ 0xFFFF );
+
+  quint32 A = a | ( b >> 1 );
+  quint32 B = ( a >> 1 ) ^ a;
+  quint32 C = ( ( c >> 1 ) ^ ( b & ( d >> 1 ) ) ) ^ c;
+  quint32 D = ( ( a & ( c >> 1 ) ) ^ ( d >> 1 ) ) ^ d;
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ( ( a & ( a >> 2 ) ) ^ ( b & ( b >> 2 ) ) );
+  B = ( ( a & ( b >> 2 ) ) ^ ( b & ( ( a ^ b ) >> 2 ) ) );
+  C ^= ( ( a & ( c >> 2 ) ) ^ ( b & ( d >> 2 ) ) );
+  D ^= ( ( b & ( c >> 2 ) ) ^ ( ( a ^ b ) & ( d >> 2 ) ) );
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ( ( a & ( a >> 4 ) ) ^ ( b & ( b >> 4 ) ) );
+  B = ( ( a & ( b >> 4 ) ) ^ ( b & ( ( a ^ b ) >> 4 ) ) );
+  C ^= ( ( a & ( c >> 4 ) ) ^ ( b & ( d >> 4 ) ) );
+  D ^= ( ( b & ( c >> 4 ) ) ^ ( ( a ^ b ) & ( d >> 4 ) ) );
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  C ^= ( ( a & ( c >> 8 ) ) ^ ( b & ( d >> 8 ) ) );
+  D ^= ( ( b & ( c >> 8 ) ) ^ ( ( a ^ b ) & ( d >> 8 ) ) );
+
+  a = C ^ ( C >> 1 );
+  b = D ^ ( D >> 1 );
+
+  quint32 i0 = x ^ y;
+  quint32 i1 = b | ( 0xFFFF ^ ( i0 | a ) );
+
+  auto interleave = []( quint32 v ) -> quint32
+  {
+    v = ( v | ( v << 8 ) ) & 0x00FF00FF;
+    v = ( v | ( v << 4 ) ) & 0x0F0F0F0F;
+    v = ( v | ( v << 2 ) ) & 0x33333333;
+    v = ( v | ( v << 1 ) ) & 0x55555555;
+    return v;
+  };
+
+  return ( interleave( i1 ) << 1 ) | interleave( i0 );
+}
+
+///@endcond
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( QgsFeatureIterator &fi, QgsFeedback *feedback )
+  : d( new QgsSpatialIndexPackedRTreePrivate( fi, feedback ) )
+{
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( const QgsFeatureSource &source, QgsFeedback *feedback )
+  : d( new QgsSpatialIndexPackedRTreePrivate( source, feedback ) )
+{
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( const QVector<QPair<QgsFeatureId, QgsRectangle> > &entries )
+  : d( new QgsSpatialIndexPackedRTreePrivate( entries ) )
+{
+}
+
+QgsSpatialIndexPackedRTree::QgsSpatialIndexPackedRTree( const QgsSpatialIndexPackedRTree &other )
+  : d( other.d )
+{
+  d->ref.ref();
+}
+
+QgsSpatialIndexPackedRTree &QgsSpatialIndexPackedRTree::operator=( const QgsSpatialIndexPackedRTree &other )
+{
+  if ( this != &other )
+  {
+    if ( !d->ref.deref() )
+    {
+      delete d;
+    }
+
+    d = other.d;
+    d->ref.ref();
+  }
+  return *this;
+}
+
+QgsSpatialIndexPackedRTree::~QgsSpatialIndexPackedRTree()
+{
+  if ( !d->ref.deref() )
+    delete d;
+}
+
+QList<QgsFeatureId> QgsSpatialIndexPackedRTree::intersects( const QgsRectangle &rectangle ) const
+{
+  QList<QgsFeatureId> result;
+  d->index->intersects( rectangle.xMinimum(), rectangle.yMinimum(), rectangle.xMaximum(), rectangle.yMaximum(), [&result]( QgsFeatureId id, const QgsRectangle & )
+  {
+    result << id;
+    return true;
+  } );
+  return result;
+}
+
+void QgsSpatialIndexPackedRTree::intersects( const QgsRectangle &rectangle, const std::function<bool ( QgsFeatureId, const QgsRectangle & )> &visitor ) const
+{
+  d->index->intersects( rectangle.xMinimum(), rectangle.yMinimum(), rectangle.xMaximum(), rectangle.yMaximum(), visitor );
+}
+
+QList<QgsFeatureId> QgsSpatialIndexPackedRTree::nearestNeighbor( const QgsPointXY &point, int neighbors, double maxDistance ) const
+{
+  QList<QgsFeatureId> result;
+  if ( neighbors <= 0 )
+    return result;
+
+  d->index->nearestNeighbor( point.x(), point.y(), maxDistance, [&result, neighbors]( QgsFeatureId id, double )
+  {
+    result << id;
+    return result.size() < neighbors;
+  } );
+  return result;
+}
+
+void QgsSpatialIndexPackedRTree::nearestNeighbor( const QgsPointXY &point, const std::function<bool ( QgsFeatureId, double )> &visitor, double maxDistance ) const
+{
+  d->index->nearestNeighbor( point.x(), point.y(), maxDistance, visitor );
+}
+
+qgssize QgsSpatialIndexPackedRTree::size() const
+{
+  return d->index->size();
+}
@@ -0,0 +1,148 @@
+/***************************************************************************
+                             qgsspatialindexpackedrtree.h
+                             ----------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALINDEXPACKEDRTREE_H
+#define QGSSPATIALINDEXPACKEDRTREE_H
+
+#define SIP_NO_FILE
+
+class QgsFeatureIterator;
+class QgsFeedback;
+class QgsFeatureSource;
+class QgsSpatialIndexPackedRTreePrivate;
+class QgsRectangle;
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+#include "qgspointxy.h"
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <functional>
+
+/**
+ * \class QgsSpatialIndexPackedRTree
+ * \ingroup core
+ *
+ * \brief A fast, memory efficient static spatial index for feature bounding boxes, based on a packed Hilbert R-tree.
+ *
+ * All feature bounding boxes are sorted along a Hilbert curve and packed bottom-up into a
+ * single contiguous array, so the whole tree is built in one pass after loading and has
+ * no per-node allocations.
+ *
+ * Compared to QgsSpatialIndex, this index:
+ *
+ * - is static (features cannot be added or removed from the index after construction)
+ * - is much faster to build and query, and uses considerably less memory
+ * - offers visitor based queries which allow early termination
+ *
+ * Compared to QgsSpatialIndexKDBush, this index supports features of any geometry type,
+ * indexing their bounding boxes.
+ *
+ * QgsSpatialIndexPackedRTree objects are implicitly shared and can be inexpensively copied.
+ *
+ * \see QgsSpatialIndex, which is an general, mutable index for geometry bounding boxes.
+ * \see QgsSpatialIndexKDBush, which is a static index for point features.
+ * \note not available in Python bindings
+ * \since QGIS 3.20
+*/
+class CORE_EXPORT QgsSpatialIndexPackedRTree
+{
+  public:
+
+    /**
+     * Constructor - creates the index and bulk loads it with features from the iterator.
+     *
+     * The optional \a feedback object can be used to allow cancellation of bulk feature loading. Ownership
+     * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
+     * that of the spatial index construction.
+     *
+     * Features without geometry are ignored and not included in the index.
+     */
+    explicit QgsSpatialIndexPackedRTree( QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Constructor - creates the index and bulk loads it with features from the source.
+     *
+     * The optional \a feedback object can be used to allow cancellation of bulk feature loading. Ownership
+     * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
+     * that of the spatial index construction.
+     *
+     * Features without geometry are ignored and not included in the index.
+     */
+    explicit QgsSpatialIndexPackedRTree( const QgsFeatureSource &source, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Constructor - creates the index and bulk loads it from a list of feature IDs and their bounding boxes.
+     */
+    explicit QgsSpatialIndexPackedRTree( const QVector< QPair< QgsFeatureId, QgsRectangle > > &entries );
+
+    //! Copy constructor
+    QgsSpatialIndexPackedRTree( const QgsSpatialIndexPackedRTree &other );
+
+    //! Assignment operator
+    QgsSpatialIndexPackedRTree &operator=( const QgsSpatialIndexPackedRTree &other );
+
+    ~QgsSpatialIndexPackedRTree();
+
+    /**
+     * Returns the list of IDs of features with a bounding box which intersects the specified \a rectangle.
+     */
+    QList<QgsFeatureId> intersects( const QgsRectangle &rectangle ) const;
+
+    /**
+     * Calls a \a visitor function for all features with a bounding box which intersects the specified \a rectangle.
+     *
+     * The visitor is called with the feature ID and its bounding box. If the visitor returns FALSE then
+     * the search is aborted and no further features are visited.
+     */
+    void intersects( const QgsRectangle &rectangle, const std::function<bool( QgsFeatureId id, const QgsRectangle &bounds )> &visitor ) const;
+
+    /**
+     * Returns the IDs of the \a neighbors features closest to the specified \a point, in order of
+     * increasing distance from the point to their bounding boxes.
+     *
+     * If \a maxDistance is greater than 0, only features with a bounding box within this distance of the
+     * point are returned.
+     */
+    QList<QgsFeatureId> nearestNeighbor( const QgsPointXY &point, int neighbors = 1, double maxDistance = 0 ) const;
+
+    /**
+     * Calls a \a visitor function for features in order of increasing distance from the
+     * specified \a point to their bounding boxes.
+     *
+     * The visitor is called with the feature ID and the distance from the point to the feature's
+     * bounding box. If the visitor returns FALSE then the search is aborted and no further features are visited.
+     *
+     * If \a maxDistance is greater than 0, only features with a bounding box within this distance of the
+     * point are visited.
+     */
+    void nearestNeighbor( const QgsPointXY &point, const std::function<bool( QgsFeatureId id, double distance )> &visitor, double maxDistance = 0 ) const;
+
+    /**
+     * Returns the size of the index, i.e. the number of features contained within the index.
+     */
+    qgssize size() const;
+
+  private:
+
+    //! Implicitly shared data pointer
+    QgsSpatialIndexPackedRTreePrivate *d = nullptr;
+
+    friend class TestQgsSpatialIndexPackedRTree;
+};
+
+#endif // QGSSPATIALINDEXPACKEDRTREE_H
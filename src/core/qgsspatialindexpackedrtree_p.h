@@ -0,0 +1,117 @@
+/***************************************************************************
+                             qgsspatialindexpackedrtree_p.h
+                             ------------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALINDEXPACKEDRTREE_PRIVATE_H
+#define QGSSPATIALINDEXPACKEDRTREE_PRIVATE_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgsfeatureid.h"
+#include "qgsrectangle.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturesource.h"
+#include "qgsfeedback.h"
+#include <QAtomicInt>
+#include <QPair>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Packed Hilbert R-tree storage.
+ *
+ * The tree is stored in two flat arrays. The first size() entries are the leaf items, sorted
+ * by the Hilbert value of their centers. They are followed by the nodes of each successive
+ * level, up to the single root node stored last. For leaf items mIndices stores the feature
+ * id, for nodes it stores the position of the node's first child.
+ */
+class QgsPackedHilbertRTree
+{
+  public:
+
+    static constexpr int NODE_SIZE = 16;
+
+    explicit QgsPackedHilbertRTree( QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr );
+
+    explicit QgsPackedHilbertRTree( const QVector< QPair< QgsFeatureId, QgsRectangle > > &entries );
+
+    std::size_t size() const { return mNumItems; }
+
+    void intersects( double xMin, double yMin, double xMax, double yMax, const std::function<bool( QgsFeatureId, const QgsRectangle & )> &visitor ) const;
+
+    void nearestNeighbor( double x, double y, double maxDistance, const std::function<bool( QgsFeatureId, double )> &visitor ) const;
+
+    //! Returns the Hilbert curve index of a point in the 2^16 x 2^16 grid
+    static quint32 hilbert( quint32 x, quint32 y );
+
+  private:
+
+    void load( const std::vector< double > &boxes, const std::vector< qint64 > &ids );
+
+    void build();
+
+    std::size_t levelEnd( std::size_t nodeIndex ) const;
+
+    QgsRectangle boxAt( std::size_t pos ) const
+    {
+      return QgsRectangle( mBoxes[4 * pos], mBoxes[4 * pos + 1], mBoxes[4 * pos + 2], mBoxes[4 * pos + 3], false );
+    }
+
+    std::size_t mNumItems = 0;
+    std::vector< double > mBoxes;
+    std::vector< qint64 > mIndices;
+    std::vector< std::size_t > mLevelBounds;
+
+    friend class TestQgsSpatialIndexPackedRTree;
+};
+
+class QgsSpatialIndexPackedRTreePrivate
+{
+  public:
+
+    explicit QgsSpatialIndexPackedRTreePrivate( QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr )
+      : index( std::make_unique< QgsPackedHilbertRTree >( fi, feedback ) )
+    {}
+
+    explicit QgsSpatialIndexPackedRTreePrivate( const QVector< QPair< QgsFeatureId, QgsRectangle > > &entries )
+      : index( std::make_unique< QgsPackedHilbertRTree >( entries ) )
+    {}
+
+    explicit QgsSpatialIndexPackedRTreePrivate( const QgsFeatureSource &source, QgsFeedback *feedback = nullptr )
+    {
+      QgsFeatureIterator it = source.getFeatures( QgsFeatureRequest().setNoAttributes() );
+      index = std::make_unique< QgsPackedHilbertRTree >( it, feedback );
+    }
+
+    QAtomicInt ref = 1;
+    std::unique_ptr< QgsPackedHilbertRTree > index;
+};
+
+/// @endcond
+
+#endif // QGSSPATIALINDEXPACKEDRTREE_PRIVATE_H
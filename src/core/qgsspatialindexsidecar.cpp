@@ -0,0 +1,243 @@
+/***************************************************************************
+                             qgsspatialindexsidecar.cpp
+                             --------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsspatialindexsidecar.h"
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsapplication.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeedback.h"
+#include "qgsgeometry.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSaveFile>
+
+///@cond PRIVATE
+static const quint32 SIDECAR_MAGIC = 0x49534751; // "QGSI"
+static const quint32 SIDECAR_VERSION = 2;
+
+static QString sidecarFolder()
+{
+  return QgsApplication::qgisSettingsDirPath() + QStringLiteral( "spatial_index_cache" );
+}
+///@endcond
+
+QString QgsSpatialIndexSidecar::sidecarPath( const QString &sourcePath, const QString &layerName, const QString &suffix )
+{
+  const QString absolutePath = QFileInfo( sourcePath ).absoluteFilePath();
+  const QByteArray hash = QCryptographicHash::hash( QStringLiteral( "%1|%2" ).arg( absolutePath, layerName ).toUtf8(), QCryptographicHash::Sha1 ).toHex();
+  return QDir( sidecarFolder() ).filePath( QStringLiteral( "%1.%2" ).arg( QString::fromLatin1( hash ), suffix ) );
+}
+
+QString QgsSpatialIndexSidecar::sourceState( const QString &sourcePath )
+{
+  const QFileInfo fi( sourcePath );
+  if ( !fi.exists() )
+    return QString();
+
+  QString state = QStringLiteral( "%1:%2" ).arg( fi.size() ).arg( fi.lastModified().toMSecsSinceEpoch() );
+  const QFileInfo wal( sourcePath + QStringLiteral( "-wal" ) );
+  if ( wal.exists() )
+    state += QStringLiteral( "|%1:%2" ).arg( wal.size() ).arg( wal.lastModified().toMSecsSinceEpoch() );
+  return state;
+}
+
+void QgsSpatialIndexSidecar::writeHeader( QDataStream &stream, quint32 magic, quint32 version, const QString &sourcePath, const QString &layerName )
+{
+  stream << magic << version << QFileInfo( sourcePath ).absoluteFilePath() << layerName << sourceState( sourcePath );
+}
+
+bool QgsSpatialIndexSidecar::readHeader( QDataStream &stream, quint32 magic, quint32 version, const QString &sourcePath, const QString &layerName )
+{
+  const QString state = sourceState( sourcePath );
+  if ( state.isEmpty() )
+    return false;
+
+  quint32 storedMagic = 0;
+  quint32 storedVersion = 0;
+  QString path;
+  QString layer;
+  QString storedState;
+  stream >> storedMagic >> storedVersion;
+  if ( stream.status() != QDataStream::Ok || storedMagic != magic || storedVersion != version )
+    return false;
+
+  stream >> path >> layer >> storedState;
+  if ( stream.status() != QDataStream::Ok
+       || path != QFileInfo( sourcePath ).absoluteFilePath()
+       || layer != layerName
+       || storedState != state )
+    return false;
+
+  // the modification time of sidecars tracks their last use, as their validity is checked against the stored source state
+  if ( QFileDevice *file = qobject_cast< QFileDevice * >( stream.device() ) )
+    file->setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+  return true;
+}
+
+bool QgsSpatialIndexSidecar::openForWriting( QSaveFile &file, QString *error )
+{
+  const QString folder = QFileInfo( file.fileName() ).absolutePath();
+  if ( !QDir().mkpath( folder ) )
+  {
+    if ( error )
+      *error = QObject::tr( "Could not create folder %1" ).arg( folder );
+    return false;
+  }
+
+  evictLeastRecentlyUsed();
+
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    if ( error )
+      *error = QObject::tr( "Could not open %1 for writing: %2" ).arg( file.fileName(), file.errorString() );
+    return false;
+  }
+  return true;
+}
+
+void QgsSpatialIndexSidecar::evictLeastRecentlyUsed( qint64 maximumSize )
+{
+  // sidecars are named by a SHA1 hash and a suffix, anything else (such as files still being written) is left alone
+  static const QRegularExpression sidecarName( QStringLiteral( "^[0-9a-f]{40}\\.\\w+$" ) );
+
+  const QFileInfoList files = QDir( sidecarFolder() ).entryInfoList( QDir::Files, QDir::Time );
+  qint64 totalSize = 0;
+  for ( const QFileInfo &file : files )
+  {
+    if ( !sidecarName.match( file.fileName() ).hasMatch() )
+      continue;
+
+    // the most recently used sidecars come first, so only the older ones are removed once the budget is used up
+    totalSize += file.size();
+    if ( totalSize > maximumSize )
+      QFile::remove( file.absoluteFilePath() );
+  }
+}
+
+bool QgsSpatialIndexSidecar::isValid( const QString &sourcePath, const QString &layerName )
+{
+  QFile file( sidecarPath( sourcePath, layerName ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream in( &file );
+  in.setByteOrder( QDataStream::LittleEndian );
+  return readHeader( in, SIDECAR_MAGIC, SIDECAR_VERSION, sourcePath, layerName );
+}
+
+bool QgsSpatialIndexSidecar::write( const QString &sourcePath, const QString &layerName, const QVector<QPair<QgsFeatureId, QgsRectangle> > &entries, QString *error )
+{
+  if ( !QFileInfo::exists( sourcePath ) )
+  {
+    if ( error )
+      *error = QObject::tr( "Source file %1 does not exist" ).arg( sourcePath );
+    return false;
+  }
+
+  const QString path = sidecarPath( sourcePath, layerName );
+  QSaveFile file( path );
+  if ( !openForWriting( file, error ) )
+    return false;
+
+  QDataStream out( &file );
+  out.setByteOrder( QDataStream::LittleEndian );
+  writeHeader( out, SIDECAR_MAGIC, SIDECAR_VERSION, sourcePath, layerName );
+  out << static_cast< qint64 >( entries.size() );
+  for ( const QPair<QgsFeatureId, QgsRectangle> &entry : entries )
+  {
+    out << static_cast< qint64 >( entry.first )
+        << entry.second.xMinimum() << entry.second.yMinimum()
+        << entry.second.xMaximum() << entry.second.yMaximum();
+  }
+
+  if ( out.status() != QDataStream::Ok || !file.commit() )
+  {
+    if ( error )
+      *error = QObject::tr( "Could not write spatial index to %1: %2" ).arg( path, file.errorString() );
+    return false;
+  }
+  return true;
+}
+
+bool QgsSpatialIndexSidecar::write( const QString &sourcePath, const QString &layerName, QgsFeatureIterator &iterator, QgsFeedback *feedback, QString *error )
+{
+  QVector<QPair<QgsFeatureId, QgsRectangle> > entries;
+  QgsFeature f;
+  while ( iterator.nextFeature( f ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      if ( error )
+        *error = QObject::tr( "Canceled" );
+      return false;
+    }
+
+    if ( !f.hasGeometry() )
+      continue;
+
+    entries.append( qMakePair( f.id(), f.geometry().boundingBox() ) );
+  }
+
+  return write( sourcePath, layerName, entries, error );
+}
+
+std::unique_ptr<QgsSpatialIndexPackedRTree> QgsSpatialIndexSidecar::load( const QString &sourcePath, const QString &layerName )
+{
+  QFile file( sidecarPath( sourcePath, layerName ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return nullptr;
+
+  QDataStream in( &file );
+  in.setByteOrder( QDataStream::LittleEndian );
+  if ( !readHeader( in, SIDECAR_MAGIC, SIDECAR_VERSION, sourcePath, layerName ) )
+    return nullptr;
+
+  qint64 count = 0;
+  in >> count;
+
+  // each entry is stored as a 64 bit id followed by four doubles
+  if ( in.status() != QDataStream::Ok || count < 0 || count * 40 > file.size() - file.pos() )
+    return nullptr;
+
+  QVector<QPair<QgsFeatureId, QgsRectangle> > entries;
+  entries.reserve( static_cast< int >( count ) );
+  for ( qint64 i = 0; i < count; ++i )
+  {
+    qint64 id = 0;
+    double xMin = 0;
+    double yMin = 0;
+    double xMax = 0;
+    double yMax = 0;
+    in >> id >> xMin >> yMin >> xMax >> yMax;
+    entries.append( qMakePair( static_cast< QgsFeatureId >( id ), QgsRectangle( xMin, yMin, xMax, yMax, false ) ) );
+  }
+  if ( in.status() != QDataStream::Ok )
+    return nullptr;
+
+  return std::make_unique< QgsSpatialIndexPackedRTree >( entries );
+}
+
+bool QgsSpatialIndexSidecar::remove( const QString &sourcePath, const QString &layerName )
+{
+  const QString path = sidecarPath( sourcePath, layerName );
+  return !QFile::exists( path ) || QFile::remove( path );
+}
@@ -0,0 +1,161 @@
+/***************************************************************************
+                             qgsspatialindexsidecar.h
+                             ------------------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALINDEXSIDECAR_H
+#define QGSSPATIALINDEXSIDECAR_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+#include "qgsrectangle.h"
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+class QgsFeatureIterator;
+class QgsFeedback;
+class QgsSpatialIndexPackedRTree;
+class QDataStream;
+class QSaveFile;
+
+/**
+ * \ingroup core
+ * \class QgsSpatialIndexSidecar
+ * \brief Persists spatial indexes for file based data sources which lack a native spatial index.
+ *
+ * Formats such as GeoJSON, GML, KML or delimited text files have no spatial index of their own,
+ * so every extent filtered request requires a full scan of the file. QgsSpatialIndexSidecar
+ * stores a compact on-disk index of feature IDs and bounding boxes for these sources, which can
+ * be loaded into a QgsSpatialIndexPackedRTree when the source is next opened.
+ *
+ * Sidecar files are stored in the "spatial_index_cache" folder of the active user profile, and
+ * are keyed by the source's file path and layer name. The state of the source file is recorded
+ * when the sidecar is written (see sourceState()), and the sidecar is ignored if the source
+ * file has changed since.
+ *
+ * Other caches of data derived from file based sources share the same folder, keys and
+ * invalidation, by using their own file suffix with sidecarPath() and writing their sidecars
+ * with writeHeader() and readHeader().
+ *
+ * The total size of the folder is bounded, by removing the least recently used sidecars
+ * whenever a new sidecar is written (see evictLeastRecentlyUsed()).
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.20
+ */
+class CORE_EXPORT QgsSpatialIndexSidecar
+{
+  public:
+
+    //! Default maximum total size of the sidecars in the cache folder, in bytes
+    static constexpr qint64 DEFAULT_MAXIMUM_CACHE_SIZE = 1024LL * 1024 * 1024;
+
+    /**
+     * Returns the path of the sidecar file for the specified \a sourcePath and \a layerName.
+     *
+     * The file \a suffix distinguishes the sidecars of different kinds of cached data for the same source.
+     */
+    static QString sidecarPath( const QString &sourcePath, const QString &layerName = QString(), const QString &suffix = QStringLiteral( "qsi" ) );
+
+    /**
+     * Returns a fingerprint of the current state of the file at \a sourcePath, which changes whenever
+     * the file is edited, or an empty string if the file does not exist.
+     *
+     * The fingerprint covers the size and last modification time of the file and of its SQLite
+     * write-ahead log, since edits to GeoPackages and other SQLite databases in WAL mode only
+     * modify the "-wal" file until it is checkpointed.
+     */
+    static QString sourceState( const QString &sourcePath );
+
+    /**
+     * Writes the header of a sidecar to \a stream, identifying the sidecar format by \a magic and
+     * \a version, and the source by \a sourcePath, \a layerName and its current sourceState().
+     *
+     * \see readHeader()
+     */
+    static void writeHeader( QDataStream &stream, quint32 magic, quint32 version, const QString &sourcePath, const QString &layerName );
+
+    /**
+     * Reads the header of a sidecar from \a stream, and returns TRUE if it was written by writeHeader()
+     * with the same \a magic, \a version, \a sourcePath and \a layerName, and the source is unchanged since.
+     *
+     * Valid sidecars read from a file are marked as recently used, so that they are the last to be evicted.
+     *
+     * \see writeHeader()
+     */
+    static bool readHeader( QDataStream &stream, quint32 magic, quint32 version, const QString &sourcePath, const QString &layerName );
+
+    /**
+     * Creates the folder of the sidecar \a file and opens the file for writing.
+     *
+     * The least recently used sidecars are evicted first, to keep the cache folder within
+     * DEFAULT_MAXIMUM_CACHE_SIZE.
+     *
+     * Returns FALSE if the file could not be opened, in which case \a error will be
+     * set to a descriptive error message.
+     */
+    static bool openForWriting( QSaveFile &file, QString *error = nullptr );
+
+    /**
+     * Removes the least recently used sidecars from the cache folder, until the sidecars left
+     * take no more than \a maximumSize bytes.
+     */
+    static void evictLeastRecentlyUsed( qint64 maximumSize = DEFAULT_MAXIMUM_CACHE_SIZE );
+
+    /**
+     * Returns TRUE if a sidecar index exists for the specified \a sourcePath and \a layerName,
+     * and it is up to date with respect to the source file.
+     */
+    static bool isValid( const QString &sourcePath, const QString &layerName = QString() );
+
+    /**
+     * Writes a sidecar index for the specified \a sourcePath and \a layerName, containing the
+     * feature IDs and bounding boxes from \a entries.
+     *
+     * Returns FALSE if the sidecar could not be written, in which case \a error will be
+     * set to a descriptive error message.
+     */
+    static bool write( const QString &sourcePath, const QString &layerName, const QVector< QPair< QgsFeatureId, QgsRectangle > > &entries, QString *error = nullptr );
+
+    /**
+     * Writes a sidecar index for the specified \a sourcePath and \a layerName, containing the
+     * bounding boxes of all features returned by the \a iterator.
+     *
+     * The optional \a feedback argument can be used to cancel the operation, in which case no
+     * sidecar will be written.
+     *
+     * Returns FALSE if the sidecar could not be written, in which case \a error will be
+     * set to a descriptive error message.
+     */
+    static bool write( const QString &sourcePath, const QString &layerName, QgsFeatureIterator &iterator, QgsFeedback *feedback = nullptr, QString *error = nullptr );
+
+    /**
+     * Loads the sidecar index for the specified \a sourcePath and \a layerName.
+     *
+     * Returns NULLPTR if no sidecar exists, or it is out of date with respect to the source file.
+     */
+    static std::unique_ptr< QgsSpatialIndexPackedRTree > load( const QString &sourcePath, const QString &layerName = QString() );
+
+    /**
+     * Removes the sidecar index for the specified \a sourcePath and \a layerName, if one exists.
+     */
+    static bool remove( const QString &sourcePath, const QString &layerName = QString() );
+};
+
+#endif // QGSSPATIALINDEXSIDECAR_H
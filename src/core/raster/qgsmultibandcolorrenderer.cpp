@@ -27,6 +27,90 @@
 #include <QImage>
 #include <QSet>
 
+#include <limits>
+#include <vector>
+
+///@cond PRIVATE
+
+//! Marks lookup table entries for values outside the displayable range of a contrast enhancement
+static const int NOT_DISPLAYABLE = std::numeric_limits<int>::min();
+
+/**
+ * Renders RGB blocks of integer data by looking up the stretched value of each band in
+ * precomputed tables, reading the typed input data and writing the output colors in a single pass.
+ */
+template <typename T>
+static void renderRgbUsingLookupTables( QgsRasterBlock *redBlock, QgsRasterBlock *greenBlock, QgsRasterBlock *blueBlock, QgsRasterBlock *alphaBlock,
+                                        const int *redTable, const int *greenTable, const int *blueTable, int tableOffset,
+                                        double opacity, QRgb noDataColor, QRgb *output, qgssize count )
+{
+  const T *redData = reinterpret_cast< const T * >( redBlock->bits() );
+  const T *greenData = reinterpret_cast< const T * >( greenBlock->bits() );
+  const T *blueData = reinterpret_cast< const T * >( blueBlock->bits() );
+  const bool checkNoData = redBlock->hasNoData() || greenBlock->hasNoData() || blueBlock->hasNoData();
+  const bool opaque = !alphaBlock && qgsDoubleNear( opacity, 1.0 );
+
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    if ( checkNoData && ( redBlock->isNoData( i ) || greenBlock->isNoData( i ) || blueBlock->isNoData( i ) ) )
+    {
+      output[i] = noDataColor;
+      continue;
+    }
+
+    const int red = redTable[ static_cast< int >( redData[i] ) + tableOffset ];
+    const int green = greenTable[ static_cast< int >( greenData[i] ) + tableOffset ];
+    const int blue = blueTable[ static_cast< int >( blueData[i] ) + tableOffset ];
+    if ( red == NOT_DISPLAYABLE || green == NOT_DISPLAYABLE || blue == NOT_DISPLAYABLE )
+    {
+      output[i] = noDataColor;
+      continue;
+    }
+
+    if ( opaque )
+    {
+      output[i] = qRgba( red, green, blue, 255 );
+      continue;
+    }
+
+    double currentOpacity = opacity;
+    if ( alphaBlock )
+    {
+      currentOpacity *= alphaBlock->value( i ) / 255.0;
+    }
+
+    if ( qgsDoubleNear( currentOpacity, 1.0 ) )
+    {
+      output[i] = qRgba( red, green, blue, 255 );
+    }
+    else
+    {
+      output[i] = qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * 255 );
+    }
+  }
+}
+
+/**
+ * Fills a lookup \a table for all values between \a minimum and \a maximum with the
+ * result of the contrast enhancement \a ce, or the unmodified value if \a ce is NULLPTR.
+ */
+static void buildContrastLookupTable( std::vector< int > &table, QgsContrastEnhancement *ce, int minimum, int maximum )
+{
+  table.resize( static_cast< std::size_t >( maximum - minimum + 1 ) );
+  for ( int value = minimum; value <= maximum; ++value )
+  {
+    int &entry = table[ static_cast< std::size_t >( value - minimum ) ];
+    if ( !ce )
+      entry = value;
+    else if ( !ce->isValueInDisplayableRange( value ) )
+      entry = NOT_DISPLAYABLE;
+    else
+      entry = ce->enhanceContrast( value );
+  }
+}
+
+///@endcond
+
 QgsMultiBandColorRenderer::QgsMultiBandColorRenderer( QgsRasterInterface *input, int redBand, int greenBand, int blueBand,
     QgsContrastEnhancement *redEnhancement,
     QgsContrastEnhancement *greenEnhancement,
@@ -241,6 +325,13 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
   }
 
   const QRgb myDefaultColor = renderColorForNodataPixel();
+  const qgssize count = ( qgssize )width * height;
+
+  if ( renderUsingLookupTables( redBlock, greenBlock, blueBlock, alphaBlock, myDefaultColor, outputBlockColorData, count ) )
+  {
+    qDeleteAll( bandBlocks );
+    return outputBlock.release();
+  }
 
   if ( fastDraw )
   {
@@ -263,7 +354,6 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
       fastDraw = false;
   }
 
-  qgssize count = ( qgssize )width * height;
   for ( qgssize i = 0; i < count; i++ )
   {
     if ( fastDraw ) //fast rendering if no transparency, stretching, color inversion, etc.
@@ -336,8 +426,8 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
 
     //apply default color if red, green or blue not in displayable range
     if ( ( mRedContrastEnhancement && !mRedContrastEnhancement->isValueInDisplayableRange( redVal ) )
-         || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( redVal ) )
-         || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( redVal ) ) )
+         || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( greenVal ) )
+         || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( blueVal ) ) )
     {
       outputBlock->setColor( i, myDefaultColor );
       continue;
@@ -388,6 +478,72 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
   return outputBlock.release();
 }
 
+bool QgsMultiBandColorRenderer::renderUsingLookupTables( QgsRasterBlock *redBlock, QgsRasterBlock *greenBlock, QgsRasterBlock *blueBlock, QgsRasterBlock *alphaBlock,
+    QRgb noDataColor, QRgb *output, qgssize count )
+{
+  if ( !redBlock || !greenBlock || !blueBlock || !output )
+    return false;
+
+  const Qgis::DataType dataType = redBlock->dataType();
+  if ( greenBlock->dataType() != dataType || blueBlock->dataType() != dataType )
+    return false;
+
+  // per-value transparency is defined on the stretched values, so it can't be folded into the tables
+  if ( mRasterTransparency && !mRasterTransparency->transparentThreeValuePixelList().isEmpty() )
+    return false;
+
+  int minimum = 0;
+  int maximum = 0;
+  switch ( dataType )
+  {
+    case Qgis::Byte:
+      minimum = std::numeric_limits< quint8 >::min();
+      maximum = std::numeric_limits< quint8 >::max();
+      break;
+    case Qgis::UInt16:
+      minimum = std::numeric_limits< quint16 >::min();
+      maximum = std::numeric_limits< quint16 >::max();
+      break;
+    case Qgis::Int16:
+      minimum = std::numeric_limits< qint16 >::min();
+      maximum = std::numeric_limits< qint16 >::max();
+      break;
+    default:
+      return false;
+  }
+
+  // building the tables costs one evaluation per possible value and band, which only pays
+  // off if the block holds at least as many pixels
+  if ( count < static_cast< qgssize >( maximum - minimum + 1 ) )
+    return false;
+
+  std::vector< int > redTable;
+  std::vector< int > greenTable;
+  std::vector< int > blueTable;
+  buildContrastLookupTable( redTable, mRedContrastEnhancement, minimum, maximum );
+  buildContrastLookupTable( greenTable, mGreenContrastEnhancement, minimum, maximum );
+  buildContrastLookupTable( blueTable, mBlueContrastEnhancement, minimum, maximum );
+
+  // match the truncation applied by QgsRasterTransparency::alphaValue()
+  const double opacity = mRasterTransparency ? static_cast< int >( mOpacity * 255 ) / 255.0 : mOpacity;
+
+  switch ( dataType )
+  {
+    case Qgis::Byte:
+      renderRgbUsingLookupTables< quint8 >( redBlock, greenBlock, blueBlock, alphaBlock, redTable.data(), greenTable.data(), blueTable.data(), -minimum, opacity, noDataColor, output, count );
+      break;
+    case Qgis::UInt16:
+      renderRgbUsingLookupTables< quint16 >( redBlock, greenBlock, blueBlock, alphaBlock, redTable.data(), greenTable.data(), blueTable.data(), -minimum, opacity, noDataColor, output, count );
+      break;
+    case Qgis::Int16:
+      renderRgbUsingLookupTables< qint16 >( redBlock, greenBlock, blueBlock, alphaBlock, redTable.data(), greenTable.data(), blueTable.data(), -minimum, opacity, noDataColor, output, count );
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
 void QgsMultiBandColorRenderer::writeXml( QDomDocument &doc, QDomElement &parentElem ) const
 {
   if ( parentElem.isNull() )
@@ -136,6 +136,14 @@ class CORE_EXPORT QgsMultiBandColorRenderer: public QgsRasterRenderer
     QgsContrastEnhancement *mGreenContrastEnhancement = nullptr;
     QgsContrastEnhancement *mBlueContrastEnhancement = nullptr;
 
+    /**
+     * Renders the red, green and blue blocks to \a output in a single pass using per band lookup
+     * tables of the stretched values. Returns FALSE if the blocks can't be rendered this way (e.g.
+     * for floating point data types), in which case nothing is written to \a output.
+     */
+    bool renderUsingLookupTables( QgsRasterBlock *redBlock, QgsRasterBlock *greenBlock, QgsRasterBlock *blueBlock, QgsRasterBlock *alphaBlock,
+                                  QRgb noDataColor, QRgb *output, qgssize count );
+
 };
 
 #endif // QGSMULTIBANDCOLORRENDERER_H
@@ -21,6 +21,7 @@
 #include "qgis_core.h"
 #include "qgis_sip.h"
 #include <limits>
+#include <type_traits>
 #include <QImage>
 #include "qgis.h"
 #include "qgserror.h"
@@ -29,6 +30,124 @@
 
 class QgsRectangle;
 
+#ifndef SIP_RUN
+
+/**
+ * \ingroup core
+ * \brief A typed view of the data of a numeric QgsRasterBlock.
+ *
+ * Views give direct access to the values of a block as their native type \a T, together with the
+ * block's no data value or no data bitmap. Unlike QgsRasterBlock::value() and QgsRasterBlock::valueAndNoData()
+ * there is no switch on the data type and no conversion to double for every pixel, so loops over
+ * the values of a view compile to type specialized code which can be vectorized.
+ *
+ * Views are created with QgsRasterBlock::view() or QgsRasterBlock::visitView(), and are only valid
+ * as long as the block they were created from exists and is not reset. A view of a const block
+ * has a const value type, and views of non const blocks allow values to be changed, without
+ * updating the no data bitmap of the block.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.20
+ */
+template <typename T>
+class QgsRasterBlockView
+{
+  public:
+
+    //! Value type of the view, without const qualification
+    typedef typename std::remove_const< T >::type ValueType;
+
+    //! Constructor for an invalid view
+    QgsRasterBlockView() = default;
+
+    /**
+     * Constructor for a view of the \a data of a block with the specified \a width and \a height.
+     *
+     * If \a hasNoDataValue is TRUE, pixels equal to \a noDataValue are no data. Otherwise, if \a noDataBitmap
+     * is set, the pixels with a bit set in the bitmap are no data, with \a noDataBitmapWidth bytes per row.
+     */
+    QgsRasterBlockView( T *data, int width, int height, bool hasNoDataValue, double noDataValue, const char *noDataBitmap, int noDataBitmapWidth )
+      : mData( data )
+      , mWidth( width )
+      , mHeight( height )
+      , mHasNoDataValue( hasNoDataValue )
+      , mNoDataValue( noDataValue )
+      , mNoDataBitmap( hasNoDataValue ? nullptr : noDataBitmap )
+      , mNoDataBitmapWidth( noDataBitmapWidth )
+    {}
+
+    //! Returns TRUE if the view is valid, i.e. the block has data of type \a T
+    bool isValid() const { return mData; }
+
+    //! Returns the width (number of columns) of the block
+    int width() const { return mWidth; }
+
+    //! Returns the height (number of rows) of the block
+    int height() const { return mHeight; }
+
+    //! Returns the number of values in the block
+    qgssize count() const { return static_cast< qgssize >( mWidth ) * mHeight; }
+
+    //! Returns a pointer to the values of the block, in row major order
+    T *data() const { return mData; }
+
+    //! Returns a pointer to the values of the specified \a row
+    T *row( int row ) const { return mData + static_cast< qgssize >( row ) * mWidth; }
+
+    //! Returns the value at the specified \a index
+    T &operator[]( qgssize index ) const { return mData[index]; }
+
+    //! Returns TRUE if the block has a no data value or a no data bitmap
+    bool hasNoData() const { return mHasNoDataValue || mNoDataBitmap; }
+
+    //! Returns TRUE if the block has a no data value
+    bool hasNoDataValue() const { return mHasNoDataValue; }
+
+    //! Returns the no data value of the block, only valid if hasNoDataValue() is TRUE
+    double noDataValue() const { return mNoDataValue; }
+
+    //! Returns TRUE if \a value is the no data value of the block, with the same test as QgsRasterBlock::isNoData()
+    bool isNoDataValue( ValueType value ) const
+    {
+      const double doubleValue = static_cast< double >( value );
+      if ( std::is_floating_point< ValueType >::value && std::isnan( doubleValue ) )
+        return true;
+      return qgsDoubleNear( doubleValue, mNoDataValue );
+    }
+
+    //! Returns TRUE if the value at \a row and \a column is no data
+    bool isNoData( int row, int column ) const
+    {
+      if ( mHasNoDataValue )
+        return isNoDataValue( mData[static_cast< qgssize >( row ) * mWidth + column] );
+      if ( !mNoDataBitmap )
+        return false;
+      return mNoDataBitmap[static_cast< qgssize >( row ) * mNoDataBitmapWidth + column / 8] & ( 0x80 >> ( column % 8 ) );
+    }
+
+    //! Returns TRUE if the value at \a index is no data
+    bool isNoData( qgssize index ) const
+    {
+      if ( mHasNoDataValue )
+        return isNoDataValue( mData[index] );
+      if ( !mNoDataBitmap )
+        return false;
+      return isNoData( static_cast< int >( index / mWidth ), static_cast< int >( index % mWidth ) );
+    }
+
+  private:
+
+    T *mData = nullptr;
+    int mWidth = 0;
+    int mHeight = 0;
+    bool mHasNoDataValue = false;
+    double mNoDataValue = 0;
+    const char *mNoDataBitmap = nullptr;
+    int mNoDataBitmapWidth = 0;
+};
+
+#endif
+
 /**
  * \ingroup core
  * \brief Raster data container.
@@ -251,6 +370,133 @@ class CORE_EXPORT QgsRasterBlock
       return static_cast< const quint8 * >( mData );
     }
 
+#ifndef SIP_RUN
+
+    /**
+     * Returns a read only view of the block data as values of type \a T.
+     *
+     * The view is invalid if the data type of the block does not correspond to \a T,
+     * e.g. view<float>() is only valid for Qgis::Float32 blocks.
+     *
+     * \see visitView()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    template <typename T>
+    QgsRasterBlockView< const T > view() const
+    {
+      if ( !mData || !isDataTypeOf< T >( mDataType ) )
+        return QgsRasterBlockView< const T >();
+      return QgsRasterBlockView< const T >( static_cast< const T * >( mData ), mWidth, mHeight, mHasNoDataValue, mNoDataValue, mNoDataBitmap, mNoDataBitmapWidth );
+    }
+
+    /**
+     * Returns a view of the block data as values of type \a T, which can be used to modify the values.
+     *
+     * The view is invalid if the data type of the block does not correspond to \a T.
+     * Changing values through the view does not update the no data bitmap of the block.
+     *
+     * \see visitView()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    template <typename T>
+    QgsRasterBlockView< T > view()
+    {
+      if ( !mData || !isDataTypeOf< T >( mDataType ) )
+        return QgsRasterBlockView< T >();
+      return QgsRasterBlockView< T >( static_cast< T * >( mData ), mWidth, mHeight, mHasNoDataValue, mNoDataValue, mNoDataBitmap, mNoDataBitmapWidth );
+    }
+
+    /**
+     * Calls \a function with a read only view of the block data of its native type, e.g. a QgsRasterBlockView< const qint16 >
+     * for a Qgis::Int16 block. \a function is usually a generic lambda, which is then compiled for every data type.
+     *
+     * Returns FALSE if the block is not numeric or has no data, in which case \a function is not called.
+     *
+     * \see view()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    template <typename Function>
+    bool visitView( Function &&function ) const
+    {
+      if ( !mData )
+        return false;
+
+      switch ( mDataType )
+      {
+        case Qgis::Byte:
+          function( view< quint8 >() );
+          return true;
+        case Qgis::UInt16:
+          function( view< quint16 >() );
+          return true;
+        case Qgis::Int16:
+          function( view< qint16 >() );
+          return true;
+        case Qgis::UInt32:
+          function( view< quint32 >() );
+          return true;
+        case Qgis::Int32:
+          function( view< qint32 >() );
+          return true;
+        case Qgis::Float32:
+          function( view< float >() );
+          return true;
+        case Qgis::Float64:
+          function( view< double >() );
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    /**
+     * Calls \a function with a view of the block data of its native type, which can be used to modify the values.
+     *
+     * Returns FALSE if the block is not numeric or has no data, in which case \a function is not called.
+     *
+     * \see view()
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    template <typename Function>
+    bool visitView( Function &&function )
+    {
+      if ( !mData )
+        return false;
+
+      switch ( mDataType )
+      {
+        case Qgis::Byte:
+          function( view< quint8 >() );
+          return true;
+        case Qgis::UInt16:
+          function( view< quint16 >() );
+          return true;
+        case Qgis::Int16:
+          function( view< qint16 >() );
+          return true;
+        case Qgis::UInt32:
+          function( view< quint32 >() );
+          return true;
+        case Qgis::Int32:
+          function( view< qint32 >() );
+          return true;
+        case Qgis::Float32:
+          function( view< float >() );
+          return true;
+        case Qgis::Float64:
+          function( view< double >() );
+          return true;
+        default:
+          return false;
+      }
+    }
+
+#endif
+
     /**
      * \brief Read a single color
      *  \param row row index
@@ -653,6 +899,33 @@ class CORE_EXPORT QgsRasterBlock
     static QImage::Format imageFormat( Qgis::DataType dataType );
     static Qgis::DataType dataType( QImage::Format format );
 
+#ifndef SIP_RUN
+    //! Returns TRUE if values of a block of the specified \a dataType are stored as \a T
+    template <typename T>
+    static bool isDataTypeOf( Qgis::DataType dataType )
+    {
+      switch ( dataType )
+      {
+        case Qgis::Byte:
+          return std::is_same< T, quint8 >::value;
+        case Qgis::UInt16:
+          return std::is_same< T, quint16 >::value;
+        case Qgis::Int16:
+          return std::is_same< T, qint16 >::value;
+        case Qgis::UInt32:
+          return std::is_same< T, quint32 >::value;
+        case Qgis::Int32:
+          return std::is_same< T, qint32 >::value;
+        case Qgis::Float32:
+          return std::is_same< T, float >::value;
+        case Qgis::Float64:
+          return std::is_same< T, double >::value;
+        default:
+          return false;
+      }
+    }
+#endif
+
     /**
      * Test if value is nodata comparing to noDataValue
      * \param value tested value
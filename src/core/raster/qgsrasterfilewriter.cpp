@@ -27,17 +27,182 @@
 #include "qgsreadwritelocker.h"
 
 #include <QCoreApplication>
+#include <QFile>
 #include <QProgressDialog>
 #include <QTextStream>
 #include <QMessageBox>
+#include <QMutex>
+#include <QQueue>
 #include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
 #include <cmath>
+#include <functional>
+#include <memory>
 
 #include <gdal.h>
 #include <cpl_string.h>
 #include <mutex>
 
+///@cond PRIVATE
+
+// raster writing is commonly run from tasks which already occupy threads from the global pool
+Q_GLOBAL_STATIC( QThreadPool, sRasterWriterPool )
+
+//! Maximum total size of the data of all raster parts in progress, i.e. read ahead or being written
+static const qgssize MAX_PARTS_IN_PROGRESS_BYTES = static_cast< qgssize >( QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH ) * QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT * 64;
+
+struct RasterPart
+{
+  int cols = 0;
+  int rows = 0;
+  int left = 0;
+  int top = 0;
+  QgsRectangle extent;
+};
+
+//! Returns the parts of the raster read by \a iter, in the order they are read
+static QVector< RasterPart > rasterParts( QgsRasterIterator *iter, int nCols, int nRows, const QgsRectangle &extent )
+{
+  QVector< RasterPart > parts;
+  iter->startRasterRead( 1, nCols, nRows, extent );
+  RasterPart part;
+  while ( iter->next( 1, part.cols, part.rows, part.left, part.top, part.extent ) )
+  {
+    parts << part;
+  }
+  iter->stopRasterRead( 1 );
+  return parts;
+}
+
+/**
+ * Reduces the maximum tile height of \a iter, so that parts of \a bytesPerPixel bytes per pixel read by
+ * \a threadCount threads stay within MAX_PARTS_IN_PROGRESS_BYTES together.
+ *
+ * Only suitable when the parts are written into a single output, as the part size is not reflected in the output.
+ */
+static void fitPartsInMemoryBudget( QgsRasterIterator *iter, qgssize bytesPerPixel, int threadCount )
+{
+  // one part per thread is read ahead, and one more is being written
+  const qgssize partsInProgress = static_cast< qgssize >( std::max( threadCount, 1 ) ) + 1;
+  const qgssize rowBytes = std::max< qgssize >( bytesPerPixel, 1 ) * std::max( iter->maximumTileWidth(), 1 );
+  const qgssize maxRows = std::max< qgssize >( MAX_PARTS_IN_PROGRESS_BYTES / partsInProgress / rowBytes, 1 );
+  iter->setMaximumTileHeight( static_cast< int >( std::min< qgssize >( iter->maximumTileHeight(), maxRows ) ) );
+}
+
+//! GDAL progress function which cancels the COG conversion when the QgsRasterBlockFeedback passed as \a data is canceled
+static int CPL_STDCALL cogProgress( double complete, const char *message, void *data )
+{
+  Q_UNUSED( complete )
+  Q_UNUSED( message )
+  QgsRasterBlockFeedback *feedback = static_cast< QgsRasterBlockFeedback * >( data );
+  return !feedback || !feedback->isCanceled();
+}
+
+/**
+ * Reads all \a parts using the \a read function and passes them to the \a write function in order.
+ *
+ * If \a threadCount is greater than 1, parts are read in parallel through clones of \a pipe,
+ * with at most \a threadCount parts being read ahead of the part being written. The number of parts
+ * read ahead is reduced so that all parts in progress, of \a bytesPerPixel bytes per pixel, stay within
+ * MAX_PARTS_IN_PROGRESS_BYTES. The \a write function is always called from the calling thread.
+ *
+ * Returns FALSE if \a write returned FALSE for a part, in which case no further parts are written.
+ */
+template <typename T>
+static bool processRasterParts( const QgsRasterPipe *pipe, const QVector< RasterPart > &parts, int threadCount, qgssize bytesPerPixel,
+                                const std::function< std::shared_ptr< T >( QgsRasterInterface *, const RasterPart & ) > &read,
+                                const std::function< bool( const RasterPart &, const std::shared_ptr< T > & ) > &write )
+{
+  qgssize largestPartBytes = 1;
+  for ( const RasterPart &part : parts )
+    largestPartBytes = std::max( largestPartBytes, std::max< qgssize >( bytesPerPixel, 1 ) * part.cols * part.rows );
+  // the part being written is in progress as well as the parts read ahead
+  const qgssize partsWithinBudget = MAX_PARTS_IN_PROGRESS_BYTES / largestPartBytes;
+  threadCount = static_cast< int >( std::min< qgssize >( std::max( threadCount, 1 ), std::max< qgssize >( partsWithinBudget, 2 ) - 1 ) );
+
+  std::vector< std::unique_ptr< QgsRasterPipe > > pipes;
+  if ( pipe && threadCount > 1 && parts.size() > 1 )
+  {
+    threadCount = std::min( threadCount, parts.size() );
+    for ( int i = 0; i < threadCount; ++i )
+    {
+      std::unique_ptr< QgsRasterPipe > clone = std::make_unique< QgsRasterPipe >( *pipe );
+      if ( !clone->last() || !clone->provider() || !clone->provider()->isValid() )
+      {
+        pipes.clear();
+        break;
+      }
+      pipes.emplace_back( std::move( clone ) );
+    }
+  }
+
+  if ( pipes.empty() )
+  {
+    QgsRasterInterface *input = pipe ? pipe->last() : nullptr;
+    for ( const RasterPart &part : parts )
+    {
+      if ( !write( part, read( input, part ) ) )
+        return false;
+    }
+    return true;
+  }
+
+  // every read in progress takes a pipe from this list, and there are never more reads in
+  // progress than pipes
+  QMutex freePipesMutex;
+  std::vector< QgsRasterPipe * > freePipes;
+  for ( const std::unique_ptr< QgsRasterPipe > &clone : pipes )
+    freePipes.emplace_back( clone.get() );
+
+  auto readWithFreePipe = [&read, &freePipes, &freePipesMutex]( const RasterPart & part ) -> std::shared_ptr< T >
+  {
+    QgsRasterPipe *workerPipe = nullptr;
+    {
+      QMutexLocker locker( &freePipesMutex );
+      workerPipe = freePipes.back();
+      freePipes.pop_back();
+    }
+    std::shared_ptr< T > result = read( workerPipe->last(), part );
+    {
+      QMutexLocker locker( &freePipesMutex );
+      freePipes.emplace_back( workerPipe );
+    }
+    return result;
+  };
+
+  QQueue< QFuture< std::shared_ptr< T > > > pending;
+  int nextPart = 0;
+  bool result = true;
+  for ( int i = 0; i < parts.size(); ++i )
+  {
+    while ( nextPart < parts.size() && pending.size() < static_cast< int >( pipes.size() ) )
+    {
+      const RasterPart part = parts.at( nextPart++ );
+      pending.enqueue( QtConcurrent::run( sRasterWriterPool(), [&readWithFreePipe, part]
+      {
+        return readWithFreePipe( part );
+      } ) );
+    }
+
+    QFuture< std::shared_ptr< T > > future = pending.dequeue();
+    if ( !write( parts.at( i ), future.result() ) )
+    {
+      result = false;
+      break;
+    }
+  }
+
+  for ( QFuture< std::shared_ptr< T > > &future : pending )
+    future.waitForFinished();
+
+  return result;
+}
+
+///@endcond
+
 QgsRasterDataProvider *QgsRasterFileWriter::createOneBandRaster( Qgis::DataType dataType, int width, int height, const QgsRectangle &extent, const QgsCoordinateReferenceSystem &crs )
 {
   if ( mTiledMode )
@@ -91,6 +256,12 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeRaster( const QgsRast
   {
     return SourceProviderError;
   }
+
+  if ( mCogMode )
+  {
+    return writeCogRaster( pipe, nCols, nRows, outputExtent, crs, transformContext, feedback );
+  }
+
   mPipe = pipe;
 
   //const QgsRasterInterface* iface = iter->input();
@@ -394,11 +565,6 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
   return error;
 }
 
-static int qgsDivRoundUp( int a, int b )
-{
-  return a / b + ( ( ( a % b ) != 0 ) ? 1 : 0 );
-}
-
 QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const QgsRasterPipe *pipe,
     QgsRasterIterator *iter,
     int nCols, int nRows,
@@ -410,8 +576,6 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
     QgsRasterDataProvider *destProvider,
     QgsRasterBlockFeedback *feedback )
 {
-  Q_UNUSED( pipe )
-  Q_UNUSED( destHasNoDataValueList )
   QgsDebugMsgLevel( QStringLiteral( "Entered" ), 4 );
 
   const QgsRasterInterface *iface = iter->input();
@@ -419,104 +583,85 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
   int nBands = iface->bandCount();
   QgsDebugMsgLevel( QStringLiteral( "nBands = %1" ).arg( nBands ), 4 );
 
-  //Get output map units per pixel
-  int iterLeft = 0;
-  int iterTop = 0;
-  int iterCols = 0;
-  int iterRows = 0;
-
-  std::vector< std::unique_ptr<QgsRasterBlock> > blockList;
-  std::vector< std::unique_ptr<QgsRasterBlock> > destBlockList;
-
-  blockList.resize( nBands );
-  destBlockList.resize( nBands );
-
+  // It may happen that internal data type (dataType) is wider than destDataType
+  QVector< bool > convertBand;
+  convertBand.reserve( nBands );
   for ( int i = 1; i <= nBands; ++i )
   {
-    iter->startRasterRead( i, nCols, nRows, outputExtent );
+    convertBand << !( srcProvider && srcProvider->dataType( i ) == destDataType );
     if ( destProvider && destHasNoDataValueList.value( i - 1 ) ) // no tiles
     {
       destProvider->setNoDataValue( i, destNoDataValueList.value( i - 1 ) );
     }
   }
 
-  int nParts = 0;
-  int fileIndex = 0;
-  if ( feedback )
+  // the blocks of a part are held in both their source and destination data types while they are converted
+  qgssize bytesPerPixel = 0;
+  for ( int i = 1; i <= nBands; ++i )
   {
-    int nPartsX = qgsDivRoundUp( nCols, iter->maximumTileWidth() );
-    int nPartsY = qgsDivRoundUp( nRows, iter->maximumTileHeight() );
-    nParts = nPartsX * nPartsY;
+    bytesPerPixel += static_cast< qgssize >( QgsRasterBlock::typeSize( iface->dataType( i ) ) );
+    if ( convertBand.at( i - 1 ) )
+      bytesPerPixel += static_cast< qgssize >( QgsRasterBlock::typeSize( destDataType ) );
   }
 
-  // hmm why is there a for(;;) here ..
-  // not good coding practice IMHO, it might be better to use [ for() and break ] or  [ while (test) ]
-  Q_FOREVER
+  const int threadCount = mMaxThreads > 0 ? mMaxThreads : QThread::idealThreadCount();
+  if ( !mTiledMode )
+    fitPartsInMemoryBudget( iter, bytesPerPixel, threadCount );
+
+  const QVector< RasterPart > parts = rasterParts( iter, nCols, nRows, outputExtent );
+  const int nParts = parts.size();
+  int fileIndex = 0;
+  WriterError error = NoError;
+
+  typedef std::vector< std::unique_ptr< QgsRasterBlock > > BlockList;
+
+  auto readPart = [nBands, &convertBand, destDataType, feedback]( QgsRasterInterface * input, const RasterPart & part ) -> std::shared_ptr< BlockList >
   {
+    std::shared_ptr< BlockList > destBlockList = std::make_shared< BlockList >();
+    if ( feedback && feedback->isCanceled() )
+      return destBlockList;
+
+    destBlockList->reserve( nBands );
     for ( int i = 1; i <= nBands; ++i )
     {
-      QgsRasterBlock *block = nullptr;
-      if ( !iter->readNextRasterPart( i, iterCols, iterRows, &block, iterLeft, iterTop ) )
+      std::unique_ptr< QgsRasterBlock > block( input->block( i, part.extent, part.cols, part.rows ) );
+      // TODO: verify if NoDataConflict happened, to do that we need the whole pipe or nuller interface
+      if ( convertBand.at( i - 1 ) )
       {
-        // No more parts, create VRT and return
-        if ( mTiledMode )
-        {
-          QString vrtFilePath( mOutputUrl + '/' + vrtFileName() );
-          writeVRT( vrtFilePath );
-          if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
-          {
-            buildPyramids( vrtFilePath );
-          }
-        }
-        else
-        {
-          if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
-          {
-            buildPyramids( mOutputUrl, destProvider );
-          }
-        }
-
-        QgsDebugMsgLevel( QStringLiteral( "Done" ), 4 );
-        return NoError; //reached last tile, bail out
+        // TODO: this conversion should go to QgsRasterDataProvider::write with additional input data type param
+        block->convert( destDataType );
       }
-      blockList[i - 1].reset( block );
-      // TODO: verify if NoDataConflict happened, to do that we need the whole pipe or nuller interface
+      destBlockList->emplace_back( std::move( block ) );
     }
+    return destBlockList;
+  };
 
+  auto writePart = [&]( const RasterPart & part, const std::shared_ptr< BlockList > &destBlockList ) -> bool
+  {
     if ( feedback && fileIndex < ( nParts - 1 ) )
     {
       feedback->setProgress( 100.0 * fileIndex / static_cast< double >( nParts ) );
       if ( feedback->isCanceled() )
       {
-        break;
+        return false;
       }
     }
 
-    // It may happen that internal data type (dataType) is wider than destDataType
-    for ( int i = 1; i <= nBands; ++i )
-    {
-      if ( srcProvider && srcProvider->dataType( i ) == destDataType )
-      {
-        // nothing
-      }
-      else
-      {
-        // TODO: this conversion should go to QgsRasterDataProvider::write with additional input data type param
-        blockList[i - 1]->convert( destDataType );
-      }
-      destBlockList[i - 1] = std::move( blockList[i - 1] );
-    }
+    // the part was not read as writing has been canceled
+    if ( static_cast< int >( destBlockList->size() ) != nBands )
+      return false;
 
     if ( mTiledMode ) //write to file
     {
       std::unique_ptr< QgsRasterDataProvider > partDestProvider( createPartProvider( outputExtent,
-          nCols, iterCols, iterRows,
-          iterLeft, iterTop, mOutputUrl,
+          nCols, part.cols, part.rows,
+          part.left, part.top, mOutputUrl,
           fileIndex, nBands, destDataType, crs ) );
 
       if ( !partDestProvider || !partDestProvider->isValid() )
       {
-        return DestProviderError;
+        error = DestProviderError;
+        return false;
       }
 
       //write data to output file. todo: loop over the data list
@@ -526,14 +671,15 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
         {
           partDestProvider->setNoDataValue( i, destNoDataValueList.value( i - 1 ) );
         }
-        if ( destBlockList[ i - 1 ]->isEmpty() )
+        if ( ( *destBlockList )[ i - 1 ]->isEmpty() )
           continue;
 
-        if ( !partDestProvider->write( destBlockList[i - 1]->bits( 0 ), i, iterCols, iterRows, 0, 0 ) )
+        if ( !partDestProvider->write( ( *destBlockList )[i - 1]->bits( 0 ), i, part.cols, part.rows, 0, 0 ) )
         {
-          return WriteError;
+          error = WriteError;
+          return false;
         }
-        addToVRT( partFileName( fileIndex ), i, iterCols, iterRows, iterLeft, iterTop );
+        addToVRT( partFileName( fileIndex ), i, part.cols, part.rows, part.left, part.top );
       }
 
     }
@@ -542,20 +688,150 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
       //loop over data
       for ( int i = 1; i <= nBands; ++i )
       {
-        if ( destBlockList[ i - 1 ]->isEmpty() )
+        if ( ( *destBlockList )[ i - 1 ]->isEmpty() )
           continue;
 
-        if ( !destProvider->write( destBlockList[i - 1]->bits( 0 ), i, iterCols, iterRows, iterLeft, iterTop ) )
+        if ( !destProvider->write( ( *destBlockList )[i - 1]->bits( 0 ), i, part.cols, part.rows, part.left, part.top ) )
         {
-          return WriteError;
+          error = WriteError;
+          return false;
         }
       }
     }
     ++fileIndex;
+    return true;
+  };
+
+  // blocks are read and converted in parallel through clones of the pipe, and written in order from this thread
+  if ( !processRasterParts< BlockList >( pipe, parts, threadCount, bytesPerPixel, readPart, writePart ) )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Done" ), 4 );
+    return error != NoError ? error : WriteCanceled;
+  }
+
+  // No more parts, create VRT and return
+  if ( mTiledMode )
+  {
+    QString vrtFilePath( mOutputUrl + '/' + vrtFileName() );
+    writeVRT( vrtFilePath );
+    if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
+    {
+      buildPyramids( vrtFilePath );
+    }
+  }
+  else
+  {
+    if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
+    {
+      buildPyramids( mOutputUrl, destProvider );
+    }
   }
 
   QgsDebugMsgLevel( QStringLiteral( "Done" ), 4 );
-  return ( feedback && feedback->isCanceled() ) ? WriteCanceled : NoError;
+  return NoError;
+}
+
+QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeCogRaster( const QgsRasterPipe *pipe, int nCols, int nRows, const QgsRectangle &outputExtent,
+    const QgsCoordinateReferenceSystem &crs, const QgsCoordinateTransformContext &transformContext, QgsRasterBlockFeedback *feedback )
+{
+  GDALDriverH cogDriver = GDALGetDriverByName( "COG" );
+  if ( !cogDriver )
+  {
+    QgsDebugMsg( QStringLiteral( "GDAL COG driver not available" ) );
+    return CreateDatasourceError;
+  }
+
+  const QString tempUrl = mOutputUrl + QStringLiteral( ".tmp.tif" );
+  auto removeTempFiles = [&tempUrl]
+  {
+    QFile::remove( tempUrl );
+    QFile::remove( tempUrl + QStringLiteral( ".ovr" ) );
+    QFile::remove( tempUrl + QStringLiteral( ".aux.xml" ) );
+  };
+  removeTempFiles();
+
+  // the intermediate file is only read once, by the COG driver, so it is not compressed
+  QgsRasterFileWriter tempWriter( tempUrl );
+  tempWriter.setOutputProviderKey( QStringLiteral( "gdal" ) );
+  tempWriter.setOutputFormat( QStringLiteral( "GTiff" ) );
+  tempWriter.setCreateOptions( QStringList() << QStringLiteral( "TILED=YES" ) << QStringLiteral( "BIGTIFF=IF_SAFER" ) );
+  tempWriter.setMaxTileWidth( mMaxTileWidth );
+  tempWriter.setMaxTileHeight( mMaxTileHeight );
+  tempWriter.setMaxThreads( mMaxThreads );
+  WriterError error = tempWriter.writeRaster( pipe, nCols, nRows, outputExtent, crs, transformContext, feedback );
+  if ( error != NoError )
+  {
+    removeTempFiles();
+    return error;
+  }
+
+  // build the overviews with the provider, so that they are reused by the COG driver
+  {
+    std::unique_ptr< QgsRasterDataProvider > tempProvider( qobject_cast< QgsRasterDataProvider * >(
+          QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), tempUrl, QgsDataProvider::ProviderOptions() ) ) );
+    if ( !tempProvider || !tempProvider->isValid() )
+    {
+      removeTempFiles();
+      return DestProviderError;
+    }
+
+    QList< QgsRasterPyramid > pyramidList = tempProvider->buildPyramidList( mPyramidsList );
+    for ( QgsRasterPyramid &pyramid : pyramidList )
+    {
+      pyramid.setBuild( true );
+    }
+    if ( !pyramidList.isEmpty() )
+    {
+      const QString result = tempProvider->buildPyramids( pyramidList, mPyramidsResampling, QgsRaster::PyramidsInternal, mPyramidsConfigOptions, feedback );
+      if ( feedback && feedback->isCanceled() )
+      {
+        tempProvider.reset();
+        removeTempFiles();
+        return WriteCanceled;
+      }
+      // if the overviews couldn't be built here, the COG driver will build them
+      if ( !result.isEmpty() )
+        QgsDebugMsg( QStringLiteral( "Could not build COG overviews: %1" ).arg( result ) );
+    }
+  }
+
+  gdal::dataset_unique_ptr tempDataset( GDALOpen( tempUrl.toUtf8().constData(), GA_ReadOnly ) );
+  if ( !tempDataset )
+  {
+    removeTempFiles();
+    return DestProviderError;
+  }
+
+  char **options = nullptr;
+  for ( const QString &option : std::as_const( mCreateOptions ) )
+  {
+    const int separator = option.indexOf( '=' );
+    if ( separator > 0 )
+      options = CSLSetNameValue( options, option.left( separator ).toUtf8().constData(), option.mid( separator + 1 ).toUtf8().constData() );
+  }
+  if ( !CSLFetchNameValue( options, "NUM_THREADS" ) )
+    options = CSLSetNameValue( options, "NUM_THREADS", "ALL_CPUS" );
+  if ( !CSLFetchNameValue( options, "RESAMPLING" ) )
+    options = CSLSetNameValue( options, "RESAMPLING", mPyramidsResampling.toUtf8().constData() );
+
+  QFile::remove( mOutputUrl );
+  GDALDatasetH cogDataset = GDALCreateCopy( cogDriver, mOutputUrl.toUtf8().constData(), tempDataset.get(), FALSE, options, cogProgress, feedback );
+  CSLDestroy( options );
+  tempDataset.reset();
+  removeTempFiles();
+
+  if ( !cogDataset )
+  {
+    QFile::remove( mOutputUrl );
+    if ( feedback && feedback->isCanceled() )
+      return WriteCanceled;
+
+    QgsDebugMsg( QStringLiteral( "Could not create COG: %1" ).arg( QString::fromUtf8( CPLGetLastErrorMsg() ) ) );
+    return CreateDatasourceError;
+  }
+  GDALClose( cogDataset );
+
+  return NoError;
 }
 
 QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRasterIterator *iter, int nCols, int nRows, const QgsRectangle &outputExtent,
@@ -581,12 +857,6 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
   iter->setMaximumTileWidth( mMaxTileWidth );
   iter->setMaximumTileHeight( mMaxTileHeight );
 
-  const size_t nMaxPixels = static_cast<size_t>( mMaxTileWidth ) * mMaxTileHeight;
-  std::vector<unsigned char> redData( nMaxPixels );
-  std::vector<unsigned char> greenData( nMaxPixels );
-  std::vector<unsigned char> blueData( nMaxPixels );
-  std::vector<unsigned char> alphaData( nMaxPixels );
-  int iterLeft = 0, iterTop = 0, iterCols = 0, iterRows = 0;
   int fileIndex = 0;
 
   //create destProvider for whole dataset here
@@ -639,35 +909,43 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
     }
   }
 
-  iter->startRasterRead( 1, nCols, nRows, outputExtent, feedback );
+  // each part holds the rendered ARGB32 block and the four channels split from it
+  const qgssize bytesPerPixel = 8;
+  const int threadCount = mMaxThreads > 0 ? mMaxThreads : QThread::idealThreadCount();
+  if ( !mTiledMode )
+    fitPartsInMemoryBudget( iter, bytesPerPixel, threadCount );
 
-  int nParts = 0;
-  if ( feedback )
+  const QVector< RasterPart > parts = rasterParts( iter, nCols, nRows, outputExtent );
+  const int nParts = parts.size();
+  WriterError error = NoError;
+
+  struct ChannelData
   {
-    int nPartsX = qgsDivRoundUp( nCols, iter->maximumTileWidth() );
-    int nPartsY = qgsDivRoundUp( nRows, iter->maximumTileHeight() );
-    nParts = nPartsX * nPartsY;
-  }
+    std::vector<unsigned char> redData;
+    std::vector<unsigned char> greenData;
+    std::vector<unsigned char> blueData;
+    std::vector<unsigned char> alphaData;
+  };
 
-  std::unique_ptr< QgsRasterBlock > inputBlock;
-  while ( iter->readNextRasterPart( 1, iterCols, iterRows, inputBlock, iterLeft, iterTop ) )
+  auto readPart = [isPremultiplied, feedback]( QgsRasterInterface * input, const RasterPart & part ) -> std::shared_ptr< ChannelData >
   {
-    if ( !inputBlock || inputBlock->isEmpty() )
-    {
-      continue;
-    }
+    // parts are read from several threads at once, so the feedback is only checked between parts
+    if ( feedback && feedback->isCanceled() )
+      return nullptr;
 
-    if ( feedback && fileIndex < ( nParts - 1 ) )
+    std::unique_ptr< QgsRasterBlock > inputBlock( input->block( 1, part.extent, part.cols, part.rows ) );
+    if ( !inputBlock || inputBlock->isEmpty() )
     {
-      feedback->setProgress( 100.0 * fileIndex / static_cast< double >( nParts ) );
-      if ( feedback->isCanceled() )
-      {
-        break;
-      }
+      return nullptr;
     }
 
     //fill into red/green/blue/alpha channels
-    qgssize nPixels = static_cast< qgssize >( iterCols ) * iterRows;
+    qgssize nPixels = static_cast< qgssize >( part.cols ) * part.rows;
+    std::shared_ptr< ChannelData > data = std::make_shared< ChannelData >();
+    data->redData.resize( nPixels );
+    data->greenData.resize( nPixels );
+    data->blueData.resize( nPixels );
+    data->alphaData.resize( nPixels );
     for ( qgssize i = 0; i < nPixels; ++i )
     {
       QRgb c = inputBlock->color( i );
@@ -675,51 +953,80 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
       {
         c = qUnpremultiply( c );
       }
-      redData[i] = static_cast<unsigned char>( qRed( c ) );
-      greenData[i] = static_cast<unsigned char>( qGreen( c ) );
-      blueData[i] = static_cast<unsigned char>( qBlue( c ) );
-      alphaData[i] = static_cast<unsigned char>( qAlpha( c ) );
+      data->redData[i] = static_cast<unsigned char>( qRed( c ) );
+      data->greenData[i] = static_cast<unsigned char>( qGreen( c ) );
+      data->blueData[i] = static_cast<unsigned char>( qBlue( c ) );
+      data->alphaData[i] = static_cast<unsigned char>( qAlpha( c ) );
+    }
+    return data;
+  };
+
+  auto writePart = [&]( const RasterPart & part, const std::shared_ptr< ChannelData > &data ) -> bool
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      return false;
+    }
+
+    if ( !data )
+    {
+      return true;
+    }
+
+    if ( feedback && fileIndex < ( nParts - 1 ) )
+    {
+      feedback->setProgress( 100.0 * fileIndex / static_cast< double >( nParts ) );
     }
 
     //create output file
     if ( mTiledMode )
     {
       std::unique_ptr< QgsRasterDataProvider > partDestProvider( createPartProvider( outputExtent,
-          nCols, iterCols, iterRows,
-          iterLeft, iterTop, mOutputUrl, fileIndex,
+          nCols, part.cols, part.rows,
+          part.left, part.top, mOutputUrl, fileIndex,
           4, Qgis::Byte, crs ) );
 
       if ( !partDestProvider || partDestProvider->isValid() )
       {
-        return DestProviderError;
+        error = DestProviderError;
+        return false;
       }
 
       //write data to output file
-      if ( !partDestProvider->write( &redData[0], 1, iterCols, iterRows, 0, 0 ) ||
-           !partDestProvider->write( &greenData[0], 2, iterCols, iterRows, 0, 0 ) ||
-           !partDestProvider->write( &blueData[0], 3, iterCols, iterRows, 0, 0 ) ||
-           !partDestProvider->write( &alphaData[0], 4, iterCols, iterRows, 0, 0 ) )
+      if ( !partDestProvider->write( &data->redData[0], 1, part.cols, part.rows, 0, 0 ) ||
+           !partDestProvider->write( &data->greenData[0], 2, part.cols, part.rows, 0, 0 ) ||
+           !partDestProvider->write( &data->blueData[0], 3, part.cols, part.rows, 0, 0 ) ||
+           !partDestProvider->write( &data->alphaData[0], 4, part.cols, part.rows, 0, 0 ) )
       {
-        return WriteError;
+        error = WriteError;
+        return false;
       }
 
-      addToVRT( partFileName( fileIndex ), 1, iterCols, iterRows, iterLeft, iterTop );
-      addToVRT( partFileName( fileIndex ), 2, iterCols, iterRows, iterLeft, iterTop );
-      addToVRT( partFileName( fileIndex ), 3, iterCols, iterRows, iterLeft, iterTop );
-      addToVRT( partFileName( fileIndex ), 4, iterCols, iterRows, iterLeft, iterTop );
+      addToVRT( partFileName( fileIndex ), 1, part.cols, part.rows, part.left, part.top );
+      addToVRT( partFileName( fileIndex ), 2, part.cols, part.rows, part.left, part.top );
+      addToVRT( partFileName( fileIndex ), 3, part.cols, part.rows, part.left, part.top );
+      addToVRT( partFileName( fileIndex ), 4, part.cols, part.rows, part.left, part.top );
     }
     else if ( destProvider )
     {
-      if ( !destProvider->write( &redData[0], 1, iterCols, iterRows, iterLeft, iterTop ) ||
-           !destProvider->write( &greenData[0], 2, iterCols, iterRows, iterLeft, iterTop ) ||
-           !destProvider->write( &blueData[0], 3, iterCols, iterRows, iterLeft, iterTop ) ||
-           !destProvider->write( &alphaData[0], 4, iterCols, iterRows, iterLeft, iterTop ) )
+      if ( !destProvider->write( &data->redData[0], 1, part.cols, part.rows, part.left, part.top ) ||
+           !destProvider->write( &data->greenData[0], 2, part.cols, part.rows, part.left, part.top ) ||
+           !destProvider->write( &data->blueData[0], 3, part.cols, part.rows, part.left, part.top ) ||
+           !destProvider->write( &data->alphaData[0], 4, part.cols, part.rows, part.left, part.top ) )
       {
-        return WriteError;
+        error = WriteError;
+        return false;
       }
     }
 
     ++fileIndex;
+    return true;
+  };
+
+  // rendering and splitting into channels runs in parallel through clones of the pipe, and parts are written in order from this thread
+  if ( !processRasterParts< ChannelData >( mPipe, parts, threadCount, bytesPerPixel, readPart, writePart ) && error != NoError )
+  {
+    return error;
   }
   destProvider.reset();
 
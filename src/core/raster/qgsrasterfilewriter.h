@@ -164,6 +164,53 @@ class CORE_EXPORT QgsRasterFileWriter
     void setPyramidsConfigOptions( const QStringList &list ) { mPyramidsConfigOptions = list; }
     QStringList pyramidsConfigOptions() const { return mPyramidsConfigOptions; }
 
+    /**
+     * Sets the maximum number of \a threads used to read and process raster blocks.
+     *
+     * Blocks are read in parallel through clones of the raster pipe, and written to the
+     * output in order from the calling thread. A value of 1 disables parallel block processing,
+     * while a value of 0 or less uses the number of processor cores.
+     *
+     * \see maxThreads()
+     * \since QGIS 3.20
+     */
+    void setMaxThreads( int threads ) { mMaxThreads = threads; }
+
+    /**
+     * Returns the maximum number of threads used to read and process raster blocks.
+     *
+     * \see setMaxThreads()
+     * \since QGIS 3.20
+     */
+    int maxThreads() const { return mMaxThreads; }
+
+    /**
+     * Sets whether the raster is written as a Cloud Optimized GeoTIFF (COG).
+     *
+     * In COG mode the raster is first written to an intermediate tiled GeoTIFF next to the output
+     * file, and internal overviews are built for it using pyramidsList() and pyramidsResampling().
+     * It is then converted to the output file by the GDAL COG driver, and removed.
+     *
+     * The createOptions() are passed to the COG driver, e.g. "COMPRESS=DEFLATE" to choose the
+     * compression or "BLOCKSIZE=256" to choose the tile size. Tiles are compressed in parallel
+     * unless a "NUM_THREADS" option is set.
+     *
+     * The outputFormat(), tiledMode() and buildPyramidsFlag() are ignored in COG mode.
+     *
+     * \note Requires GDAL 3.1 or later.
+     * \see cogMode()
+     * \since QGIS 3.20
+     */
+    void setCogMode( bool enabled ) { mCogMode = enabled; }
+
+    /**
+     * Returns TRUE if the raster is written as a Cloud Optimized GeoTIFF (COG).
+     *
+     * \see setCogMode()
+     * \since QGIS 3.20
+     */
+    bool cogMode() const { return mCogMode; }
+
     //! Creates a filter for an GDAL driver key
     static QString filterForDriver( const QString &driverName );
 
@@ -249,6 +296,11 @@ class CORE_EXPORT QgsRasterFileWriter
                                   const QgsCoordinateReferenceSystem &crs,
                                   QgsRasterBlockFeedback *feedback = nullptr );
 
+    //! Writes the raster to an intermediate GeoTIFF with overviews, and converts it to a COG
+    WriterError writeCogRaster( const QgsRasterPipe *pipe, int nCols, int nRows, const QgsRectangle &outputExtent,
+                                const QgsCoordinateReferenceSystem &crs, const QgsCoordinateTransformContext &transformContext,
+                                QgsRasterBlockFeedback *feedback = nullptr );
+
     /**
      * \brief Initialize vrt member variables
      *  \param xSize width of vrt
@@ -312,6 +364,12 @@ class CORE_EXPORT QgsRasterFileWriter
     QgsRaster::RasterPyramidsFormat mPyramidsFormat = QgsRaster::PyramidsGTiff;
     QStringList mPyramidsConfigOptions;
 
+    //! Maximum number of threads used to read raster blocks, or 0 or less to use the number of processor cores
+    int mMaxThreads = 0;
+
+    //! TRUE: write a Cloud Optimized GeoTIFF
+    bool mCogMode = false;
+
     QDomDocument mVRTDocument;
     QList<QDomElement> mVRTBands;
 
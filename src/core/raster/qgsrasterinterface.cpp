@@ -15,12 +15,17 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <algorithm>
 #include <limits>
+#include <memory>
 #include <typeinfo>
+#include <vector>
 
 #include <QByteArray>
 #include <QTime>
 #include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
 #include "qgslogger.h"
 #include "qgsrasterbandstats.h"
@@ -28,6 +33,348 @@
 #include "qgsrasterinterface.h"
 #include "qgsrectangle.h"
 
+///@cond PRIVATE
+
+// band statistics and histograms are accumulated in a dedicated pool, as they are commonly
+// calculated from tasks which already occupy threads from the global pool
+Q_GLOBAL_STATIC( QThreadPool, sStatisticsPool )
+
+// upper limit for the total number of histogram bins accumulated in parallel
+static const qgssize MAX_PARALLEL_HISTOGRAM_BINS = 1 << 24;
+
+template <typename T, typename Visitor>
+static void visitTypedValues( const T *data, const QgsRasterBlock *block, qgssize count, const Visitor &visitor )
+{
+  if ( block->hasNoDataValue() )
+  {
+    const double noDataValue = block->noDataValue();
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      const double value = static_cast< double >( data[i] );
+      if ( !QgsRasterBlock::isNoDataValue( value, noDataValue ) )
+        visitor( value );
+    }
+  }
+  else if ( block->hasNoData() )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      if ( !block->isNoData( i ) )
+        visitor( static_cast< double >( data[i] ) );
+    }
+  }
+  else
+  {
+    for ( qgssize i = 0; i < count; ++i )
+      visitor( static_cast< double >( data[i] ) );
+  }
+}
+
+/**
+ * Calls \a visitor for every value in \a block which isn't nodata, using a typed loop
+ * over the block data for the common data types.
+ */
+template <typename Visitor>
+static void visitBlockValues( QgsRasterBlock *block, const Visitor &visitor )
+{
+  const qgssize count = static_cast< qgssize >( block->width() ) * block->height();
+  const char *data = block->bits();
+  switch ( block->dataType() )
+  {
+    case Qgis::Byte:
+      visitTypedValues( reinterpret_cast< const quint8 * >( data ), block, count, visitor );
+      break;
+    case Qgis::UInt16:
+      visitTypedValues( reinterpret_cast< const quint16 * >( data ), block, count, visitor );
+      break;
+    case Qgis::Int16:
+      visitTypedValues( reinterpret_cast< const qint16 * >( data ), block, count, visitor );
+      break;
+    case Qgis::UInt32:
+      visitTypedValues( reinterpret_cast< const quint32 * >( data ), block, count, visitor );
+      break;
+    case Qgis::Int32:
+      visitTypedValues( reinterpret_cast< const qint32 * >( data ), block, count, visitor );
+      break;
+    case Qgis::Float32:
+      visitTypedValues( reinterpret_cast< const float * >( data ), block, count, visitor );
+      break;
+    case Qgis::Float64:
+      visitTypedValues( reinterpret_cast< const double * >( data ), block, count, visitor );
+      break;
+    default:
+    {
+      bool isNoData = false;
+      for ( qgssize i = 0; i < count; ++i )
+      {
+        const double value = block->valueAndNoData( i, isNoData );
+        if ( !isNoData )
+          visitor( value );
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * Mergeable accumulator for band statistics.
+ *
+ * Infinite values are counted and summed, but excluded from the minimum, maximum and sum of squares.
+ */
+struct StatisticsAccumulator
+{
+  qgssize count = 0;
+  double sum = 0;
+  qgssize finiteCount = 0;
+  double finiteMean = 0;
+  double sumOfSquares = 0;
+  double minimum = std::numeric_limits<double>::max();
+  double maximum = std::numeric_limits<double>::lowest();
+
+  void addBlock( QgsRasterBlock *block )
+  {
+    StatisticsAccumulator blockStats;
+    double finiteSum = 0;
+    visitBlockValues( block, [&]( double value )
+    {
+      blockStats.sum += value;
+      blockStats.count++;
+      if ( !std::isfinite( value ) )
+        return;
+
+      blockStats.finiteCount++;
+      finiteSum += value;
+      if ( value < blockStats.minimum )
+        blockStats.minimum = value;
+      if ( value > blockStats.maximum )
+        blockStats.maximum = value;
+    } );
+
+    if ( blockStats.finiteCount > 0 )
+    {
+      // second pass about the block mean, which is more robust against rounding errors than a single pass
+      const double mean = finiteSum / blockStats.finiteCount;
+      double sumOfSquares = 0;
+      visitBlockValues( block, [mean, &sumOfSquares]( double value )
+      {
+        if ( std::isfinite( value ) )
+          sumOfSquares += ( value - mean ) * ( value - mean );
+      } );
+      blockStats.finiteMean = mean;
+      blockStats.sumOfSquares = sumOfSquares;
+    }
+
+    merge( blockStats );
+  }
+
+  void merge( const StatisticsAccumulator &other )
+  {
+    count += other.count;
+    sum += other.sum;
+    if ( other.finiteCount == 0 )
+      return;
+
+    // Chan et al. pairwise update of the sum of squared differences from the mean
+    const double total = static_cast< double >( finiteCount + other.finiteCount );
+    const double delta = other.finiteMean - finiteMean;
+    sumOfSquares += other.sumOfSquares + delta * delta * ( static_cast< double >( finiteCount ) * other.finiteCount / total );
+    finiteMean += delta * other.finiteCount / total;
+    finiteCount += other.finiteCount;
+    minimum = std::min( minimum, other.minimum );
+    maximum = std::max( maximum, other.maximum );
+  }
+};
+
+/**
+ * Mergeable accumulator for histograms.
+ *
+ * Values of 8 and 16 bit integer blocks are counted per value, and only assigned to bins
+ * by finalize() once all blocks have been accumulated.
+ */
+struct HistogramAccumulator
+{
+  int binCount = 0;
+  double minimum = 0;
+  double binSize = 1;
+  bool includeOutOfRange = false;
+
+  std::vector< qgssize > bins;
+  qgssize nonNullCount = 0;
+
+  std::vector< qgssize > valueCounts;
+  int valueOffset = 0;
+
+  HistogramAccumulator( int histogramBinCount, double histogramMinimum, double histogramBinSize, bool histogramIncludeOutOfRange )
+    : binCount( histogramBinCount )
+    , minimum( histogramMinimum )
+    , binSize( histogramBinSize )
+    , includeOutOfRange( histogramIncludeOutOfRange )
+    , bins( static_cast< std::size_t >( histogramBinCount ), 0 )
+  {}
+
+  void addValue( double value, qgssize count = 1 )
+  {
+    int binIndex = static_cast <int>( std::floor( ( value - minimum ) / binSize ) );
+
+    if ( ( binIndex < 0 || binIndex > ( binCount - 1 ) ) && !includeOutOfRange )
+      return;
+
+    if ( binIndex < 0 ) binIndex = 0;
+    if ( binIndex > ( binCount - 1 ) ) binIndex = binCount - 1;
+
+    bins[binIndex] += count;
+    nonNullCount += count;
+  }
+
+  void addBlock( QgsRasterBlock *block )
+  {
+    switch ( block->dataType() )
+    {
+      case Qgis::Byte:
+        countValues( block, 0, 256 );
+        return;
+      case Qgis::UInt16:
+        countValues( block, 0, 65536 );
+        return;
+      case Qgis::Int16:
+        countValues( block, 32768, 65536 );
+        return;
+      default:
+        break;
+    }
+
+    visitBlockValues( block, [this]( double value ) { addValue( value ); } );
+  }
+
+  void countValues( QgsRasterBlock *block, int offset, int size )
+  {
+    if ( valueCounts.empty() )
+    {
+      valueCounts.assign( size, 0 );
+      valueOffset = offset;
+    }
+    qgssize *counts = valueCounts.data();
+    visitBlockValues( block, [counts, offset]( double value ) { counts[ static_cast< int >( value ) + offset ]++; } );
+  }
+
+  void merge( const HistogramAccumulator &other )
+  {
+    for ( int i = 0; i < binCount; ++i )
+      bins[i] += other.bins[i];
+    nonNullCount += other.nonNullCount;
+
+    if ( valueCounts.empty() )
+    {
+      valueCounts = other.valueCounts;
+      valueOffset = other.valueOffset;
+    }
+    else
+    {
+      for ( std::size_t i = 0; i < other.valueCounts.size(); ++i )
+        valueCounts[i] += other.valueCounts[i];
+    }
+  }
+
+  void finalize()
+  {
+    for ( std::size_t i = 0; i < valueCounts.size(); ++i )
+    {
+      if ( valueCounts[i] > 0 )
+        addValue( static_cast< double >( static_cast< int >( i ) - valueOffset ), valueCounts[i] );
+    }
+    valueCounts.clear();
+  }
+};
+
+/**
+ * Reads the blocks of \a extent from \a interface on the calling thread, and accumulates them
+ * in parallel into up to \a maxWorkers copies of \a accumulator, which are merged into
+ * \a accumulator on completion. Returns FALSE if the operation was canceled.
+ */
+template <typename Accumulator>
+static bool accumulateBlocks( QgsRasterInterface *interface, int bandNo, const QgsRectangle &extent, int width, int height,
+                              Accumulator &accumulator, int maxWorkers, QgsRasterBlockFeedback *feedback )
+{
+  int xBlockSize = interface->xBlockSize();
+  int yBlockSize = interface->yBlockSize();
+  if ( xBlockSize == 0 ) // should not happen, but happens
+  {
+    xBlockSize = 500;
+  }
+  if ( yBlockSize == 0 ) // should not happen, but happens
+  {
+    yBlockSize = 500;
+  }
+
+  const int nXBlocks = ( width + xBlockSize - 1 ) / xBlockSize;
+  const int nYBlocks = ( height + yBlockSize - 1 ) / yBlockSize;
+  const int blockCount = nXBlocks * nYBlocks;
+
+  const double xRes = extent.width() / width;
+  const double yRes = extent.height() / height;
+
+  // blocks are always read on this thread, as interfaces are not safe to use concurrently.
+  // Each worker accumulates every n-th block, so at most one block per worker is held in memory.
+  const int workerCount = std::max( 1, std::min( { maxWorkers, sStatisticsPool()->maxThreadCount(), blockCount } ) );
+  std::vector< Accumulator > accumulators( workerCount, accumulator );
+  std::vector< QFuture< void > > pending( workerCount );
+
+  bool canceled = false;
+  for ( int blockIndex = 0; blockIndex < blockCount; ++blockIndex )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      canceled = true;
+      break;
+    }
+
+    const int yBlock = blockIndex / nXBlocks;
+    const int xBlock = blockIndex % nXBlocks;
+    const int blockWidth = std::min( xBlockSize, width - xBlock * xBlockSize );
+    const int blockHeight = std::min( yBlockSize, height - yBlock * yBlockSize );
+
+    const double xmin = extent.xMinimum() + xBlock * xBlockSize * xRes;
+    const double xmax = xmin + blockWidth * xRes;
+    const double ymin = extent.yMaximum() - yBlock * yBlockSize * yRes;
+    const double ymax = ymin - blockHeight * yRes;
+
+    std::shared_ptr< QgsRasterBlock > blk( interface->block( bandNo, QgsRectangle( xmin, ymin, xmax, ymax ), blockWidth, blockHeight, feedback ) );
+    if ( feedback )
+      feedback->setProgress( 100.0 * ( blockIndex + 1 ) / blockCount );
+
+    if ( !blk || blk->isEmpty() || !QgsRasterBlock::typeIsNumeric( blk->dataType() ) )
+      continue;
+
+    const int worker = blockIndex % workerCount;
+    Accumulator *workerAccumulator = &accumulators[ worker ];
+    if ( workerCount == 1 )
+    {
+      workerAccumulator->addBlock( blk.get() );
+      continue;
+    }
+
+    pending[ worker ].waitForFinished();
+    pending[ worker ] = QtConcurrent::run( sStatisticsPool(), [workerAccumulator, blk]
+    {
+      workerAccumulator->addBlock( blk.get() );
+    } );
+  }
+
+  for ( QFuture< void > &future : pending )
+    future.waitForFinished();
+
+  if ( canceled )
+    return false;
+
+  // merge in worker order, so that results don't depend on thread scheduling
+  accumulator = accumulators[0];
+  for ( int worker = 1; worker < workerCount; ++worker )
+    accumulator.merge( accumulators[ worker ] );
+  return true;
+}
+
+///@endcond
+
 QgsRasterInterface::QgsRasterInterface( QgsRasterInterface *input )
   : mInput( input )
 {
@@ -135,103 +482,27 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int bandNo,
     }
   }
 
-  QgsRectangle myExtent = myRasterBandStats.extent;
-  int myWidth = myRasterBandStats.width;
-  int myHeight = myRasterBandStats.height;
-
-  //int myDataType = dataType( bandNo );
-
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
-
-  double myXRes = myExtent.width() / myWidth;
-  double myYRes = myExtent.height() / myHeight;
-  // TODO: progress signals
+  StatisticsAccumulator accumulator;
+  if ( !accumulateBlocks( this, bandNo, myRasterBandStats.extent, myRasterBandStats.width, myRasterBandStats.height,
+                          accumulator, std::numeric_limits<int>::max(), feedback ) )
+    return myRasterBandStats;
 
-  // used by single pass stdev
-  double myMean = 0;
-  double mySumOfSquares = 0;
-
-  bool myFirstIterationFlag = true;
-  bool isNoData = false;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
+  myRasterBandStats.sum = accumulator.sum;
+  myRasterBandStats.elementCount = accumulator.count;
+  if ( accumulator.finiteCount > 0 )
   {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      if ( feedback && feedback->isCanceled() )
-        return myRasterBandStats;
-
-      QgsDebugMsgLevel( QStringLiteral( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ), 4 );
-      int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
-
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
-
-      std::unique_ptr< QgsRasterBlock > blk( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
-
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        double myValue = blk->valueAndNoData( i, isNoData );
-        if ( isNoData )
-          continue; // NULL
-
-        myRasterBandStats.sum += myValue;
-        myRasterBandStats.elementCount++;
-
-        if ( !std::isfinite( myValue ) ) continue; // inf
-
-        if ( myFirstIterationFlag )
-        {
-          myFirstIterationFlag = false;
-          myRasterBandStats.minimumValue = myValue;
-          myRasterBandStats.maximumValue = myValue;
-        }
-        else
-        {
-          if ( myValue < myRasterBandStats.minimumValue )
-          {
-            myRasterBandStats.minimumValue = myValue;
-          }
-          if ( myValue > myRasterBandStats.maximumValue )
-          {
-            myRasterBandStats.maximumValue = myValue;
-          }
-        }
-
-        // Single pass stdev
-        double myDelta = myValue - myMean;
-        myMean += myDelta / myRasterBandStats.elementCount;
-        mySumOfSquares += myDelta * ( myValue - myMean );
-      }
-    }
+    myRasterBandStats.minimumValue = accumulator.minimum;
+    myRasterBandStats.maximumValue = accumulator.maximum;
   }
-
   myRasterBandStats.range = myRasterBandStats.maximumValue - myRasterBandStats.minimumValue;
   myRasterBandStats.mean = myRasterBandStats.sum / myRasterBandStats.elementCount;
 
-  myRasterBandStats.sumOfSquares = mySumOfSquares; // OK with single pass?
+  myRasterBandStats.sumOfSquares = accumulator.sumOfSquares;
 
   // stdDev may differ  from GDAL stats, because GDAL is using naive single pass
   // algorithm which is more error prone (because of rounding errors)
   // Divide result by sample size - 1 and get square root to get stdev
-  myRasterBandStats.stdDev = std::sqrt( mySumOfSquares / ( myRasterBandStats.elementCount - 1 ) );
+  myRasterBandStats.stdDev = std::sqrt( myRasterBandStats.sumOfSquares / ( myRasterBandStats.elementCount - 1 ) );
 
   QgsDebugMsgLevel( QStringLiteral( "************ STATS **************" ), 4 );
   QgsDebugMsgLevel( QStringLiteral( "MIN %1" ).arg( myRasterBandStats.minimumValue ), 4 );
@@ -425,28 +696,8 @@ QgsRasterHistogram QgsRasterInterface::histogram( int bandNo,
   }
 
   int myBinCount = myHistogram.binCount;
-  int myWidth = myHistogram.width;
-  int myHeight = myHistogram.height;
-  QgsRectangle myExtent = myHistogram.extent;
   myHistogram.histogramVector.resize( myBinCount );
 
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
-
-  double myXRes = myExtent.width() / myWidth;
-  double myYRes = myExtent.height() / myHeight;
-
   double myMinimum = myHistogram.minimum;
   double myMaximum = myHistogram.maximum;
 
@@ -460,50 +711,19 @@ QgsRasterHistogram QgsRasterInterface::histogram( int bandNo,
 
   double myBinSize = ( myMaximum - myMinimum ) / myBinCount;
 
-  // TODO: progress signals
-  bool isNoData = false;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
-  {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      if ( feedback && feedback->isCanceled() )
-        return myHistogram;
+  // each worker holds its own bins, so limit the number of workers for large bin counts
+  const int maxWorkers = static_cast< int >( std::max< qgssize >( 1, MAX_PARALLEL_HISTOGRAM_BINS / std::max( myBinCount, 1 ) ) );
+  HistogramAccumulator accumulator( myBinCount, myMinimum, myBinSize, includeOutOfRange );
+  if ( !accumulateBlocks( this, bandNo, myHistogram.extent, myHistogram.width, myHistogram.height,
+                          accumulator, maxWorkers, feedback ) )
+    return myHistogram;
 
-      int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
-
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
-
-      std::unique_ptr< QgsRasterBlock > blk( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
-
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        double myValue = blk->valueAndNoData( i, isNoData );
-        if ( isNoData )
-        {
-          continue; // NULL
-        }
-
-        int myBinIndex = static_cast <int>( std::floor( ( myValue - myMinimum ) /  myBinSize ) );
-
-        if ( ( myBinIndex < 0 || myBinIndex > ( myBinCount - 1 ) ) && !includeOutOfRange )
-        {
-          continue;
-        }
-        if ( myBinIndex < 0 ) myBinIndex = 0;
-        if ( myBinIndex > ( myBinCount - 1 ) ) myBinIndex = myBinCount - 1;
-
-        myHistogram.histogramVector[myBinIndex] += 1;
-        myHistogram.nonNullCount++;
-      }
-    }
+  accumulator.finalize();
+  for ( int myBin = 0; myBin < myBinCount; myBin++ )
+  {
+    myHistogram.histogramVector[myBin] = static_cast< int >( accumulator.bins[myBin] );
   }
+  myHistogram.nonNullCount = static_cast< int >( accumulator.nonNullCount );
 
   myHistogram.valid = true;
   mHistograms.append( myHistogram );
@@ -15,6 +15,8 @@
  *                                                                         *
  ***************************************************************************/
 #include <algorithm>
+#include <list>
+#include <memory>
 
 #include "qgsrasterdataprovider.h"
 #include "qgslogger.h"
@@ -22,6 +24,9 @@
 #include "qgscoordinatetransform.h"
 #include "qgsexception.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+
 Q_NOWARN_DEPRECATED_PUSH // because of deprecated members
 QgsRasterProjector::QgsRasterProjector()
   : QgsRasterInterface( nullptr )
@@ -65,6 +70,147 @@ Qgis::DataType QgsRasterProjector::dataType( int bandNo ) const
 
 /// @cond PRIVATE
 
+/**
+ * Retrieves the full extent of the source raster and its maximum resolution, if known.
+ * A resolution of 0 means there is no resolution limit.
+ */
+static void sourceLimits( QgsRasterInterface *input, QgsRectangle &extent, double &maxXRes, double &maxYRes )
+{
+  if ( !input )
+    return;
+
+  QgsRasterDataProvider *provider = dynamic_cast<QgsRasterDataProvider *>( input->sourceInput() );
+  if ( !provider )
+    return;
+
+  // If provider-side resampling is possible, we will get a much better looking
+  // result by not requesting at the maximum resolution and then doing nearest
+  // resampling here. A real fix would be to do resampling during reprojection
+  // however.
+  if ( !( provider->providerCapabilities() & QgsRasterDataProvider::ProviderHintCanPerformProviderResampling ) &&
+       ( provider->capabilities() & QgsRasterDataProvider::Size ) )
+  {
+    maxXRes = provider->extent().width() / provider->xSize();
+    maxYRes = provider->extent().height() / provider->ySize();
+  }
+  extent = provider->extent();
+}
+
+/**
+ * Source pixel lookup for every pixel of a destination block, as calculated by ProjectorData.
+ */
+struct ProjectorGrid
+{
+  QgsRectangle srcExtent;
+  int srcRows = 0;
+  int srcCols = 0;
+  //! Source pixel index for each destination pixel, or -1 if outside of the source
+  std::vector< qint64 > srcIndices;
+};
+
+/**
+ * Everything which the source pixel lookup for a destination block depends on.
+ */
+struct ProjectorGridKey
+{
+  QgsRectangle extent;
+  int width = 0;
+  int height = 0;
+  QgsCoordinateReferenceSystem srcCrs;
+  QgsCoordinateReferenceSystem destCrs;
+  QgsCoordinateTransformContext transformContext;
+  int srcDatumTransform = -1;
+  int destDatumTransform = -1;
+  QgsRasterProjector::Precision precision = QgsRasterProjector::Approximate;
+  QgsRectangle sourceExtent;
+  double maxSrcXRes = 0;
+  double maxSrcYRes = 0;
+
+  bool operator==( const ProjectorGridKey &other ) const
+  {
+    return width == other.width
+           && height == other.height
+           && precision == other.precision
+           && srcDatumTransform == other.srcDatumTransform
+           && destDatumTransform == other.destDatumTransform
+           && maxSrcXRes == other.maxSrcXRes
+           && maxSrcYRes == other.maxSrcYRes
+           && extent == other.extent
+           && sourceExtent == other.sourceExtent
+           && srcCrs == other.srcCrs
+           && destCrs == other.destCrs
+           && transformContext == other.transformContext;
+  }
+};
+
+//! Maximum total number of destination pixels of the cached grids
+static const qgssize MAX_CACHED_GRID_PIXELS = 1 << 23;
+
+/**
+ * Least recently used cache of projector grids, shared by all projectors. Repeated renders of the
+ * same view (e.g. on map redraws or for every band of a multiband renderer) request blocks with
+ * identical extents and sizes, so the grid only has to be calculated once.
+ */
+class ProjectorGridCache
+{
+  public:
+
+    std::shared_ptr< const ProjectorGrid > grid( const ProjectorGridKey &key )
+    {
+      QMutexLocker locker( &mMutex );
+      for ( auto it = mEntries.begin(); it != mEntries.end(); ++it )
+      {
+        if ( it->first == key )
+        {
+          mEntries.splice( mEntries.begin(), mEntries, it );
+          return mEntries.front().second;
+        }
+      }
+      return nullptr;
+    }
+
+    void insert( const ProjectorGridKey &key, const std::shared_ptr< const ProjectorGrid > &grid )
+    {
+      const qgssize pixels = grid->srcIndices.size();
+      if ( pixels > MAX_CACHED_GRID_PIXELS )
+        return;
+
+      QMutexLocker locker( &mMutex );
+      mEntries.emplace_front( key, grid );
+      mPixels += pixels;
+      while ( mPixels > MAX_CACHED_GRID_PIXELS )
+      {
+        mPixels -= mEntries.back().second->srcIndices.size();
+        mEntries.pop_back();
+      }
+    }
+
+  private:
+
+    QMutex mMutex;
+    std::list< std::pair< ProjectorGridKey, std::shared_ptr< const ProjectorGrid > > > mEntries;
+    qgssize mPixels = 0;
+};
+
+Q_GLOBAL_STATIC( ProjectorGridCache, sProjectorGridCache )
+
+/**
+ * Copies the source pixels of a block to the destination pixels using the \a indices of a projector grid.
+ * Destination pixels with a negative index are left untouched.
+ */
+template <typename T>
+static void gatherPixels( const char *src, char *dest, const qint64 *indices, qgssize count )
+{
+  const T *srcValues = reinterpret_cast< const T * >( src );
+  T *destValues = reinterpret_cast< T * >( dest );
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    const qint64 index = indices[i];
+    if ( index >= 0 )
+      destValues[i] = srcValues[index];
+  }
+}
+
 void QgsRasterProjector::setCrs( const QgsCoordinateReferenceSystem &srcCRS,
                                  const QgsCoordinateReferenceSystem &destCRS,
                                  int srcDatumTransform,
@@ -114,28 +260,7 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   QgsDebugMsgLevel( QStringLiteral( "Entered" ), 4 );
 
   // Get max source resolution and extent if possible
-  if ( input )
-  {
-    QgsRasterDataProvider *provider = dynamic_cast<QgsRasterDataProvider *>( input->sourceInput() );
-    if ( provider )
-    {
-      // If provider-side resampling is possible, we will get a much better looking
-      // result by not requesting at the maximum resolution and then doing nearest
-      // resampling here. A real fix would be to do resampling during reprojection
-      // however.
-      if ( !( provider->providerCapabilities() & QgsRasterDataProvider::ProviderHintCanPerformProviderResampling ) &&
-           ( provider->capabilities() & QgsRasterDataProvider::Size ) )
-      {
-        mMaxSrcXRes = provider->extent().width() / provider->xSize();
-        mMaxSrcYRes = provider->extent().height() / provider->ySize();
-      }
-      // Get source extent
-      if ( mExtent.isEmpty() )
-      {
-        mExtent = provider->extent();
-      }
-    }
-  }
+  sourceLimits( input, mExtent, mMaxSrcXRes, mMaxSrcYRes );
 
   mDestXRes = mDestExtent.width() / ( mDestCols );
   mDestYRes = mDestExtent.height() / ( mDestRows );
@@ -219,10 +344,8 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
 #endif
 
   // init helper points
-  pHelperTop = new QgsPointXY[mDestCols];
-  pHelperBottom = new QgsPointXY[mDestCols];
-  calcHelper( 0, pHelperTop );
-  calcHelper( 1, pHelperBottom );
+  calcHelper( 0, mHelperTopX, mHelperTopY );
+  calcHelper( 1, mHelperBottomX, mHelperBottomY );
   mHelperTopRow = 0;
 
   // Calculate source dimensions
@@ -232,13 +355,6 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   mSrcXRes = mSrcExtent.width() / mSrcCols;
 }
 
-ProjectorData::~ProjectorData()
-{
-  delete[] pHelperTop;
-  delete[] pHelperBottom;
-}
-
-
 void ProjectorData::calcSrcExtent()
 {
   /* Run around the mCPMatrix and find source extent */
@@ -417,8 +533,10 @@ inline int ProjectorData::matrixCol( int destCol )
   return static_cast< int >( std::floor( ( destCol + 0.5 ) / mDestColsPerMatrixCol ) );
 }
 
-void ProjectorData::calcHelper( int matrixRow, QgsPointXY *points )
+void ProjectorData::calcHelper( int matrixRow, std::vector< double > &x, std::vector< double > &y )
 {
+  x.resize( mDestCols );
+  y.resize( mDestCols );
   // TODO?: should we also precalc dest cell center coordinates for x and y?
   for ( int myDestCol = 0; myDestCol < mDestCols; myDestCol++ )
   {
@@ -438,19 +556,17 @@ void ProjectorData::calcHelper( int matrixRow, QgsPointXY *points )
     double s = mySrcPoint0.x() + ( mySrcPoint1.x() - mySrcPoint0.x() ) * xfrac;
     double t = mySrcPoint0.y() + ( mySrcPoint1.y() - mySrcPoint0.y() ) * xfrac;
 
-    points[myDestCol].setX( s );
-    points[myDestCol].setY( t );
+    x[myDestCol] = s;
+    y[myDestCol] = t;
   }
 }
 
 void ProjectorData::nextHelper()
 {
-  // We just switch pHelperTop and pHelperBottom, memory is not lost
-  QgsPointXY *tmp = nullptr;
-  tmp = pHelperTop;
-  pHelperTop = pHelperBottom;
-  pHelperBottom = tmp;
-  calcHelper( mHelperTopRow + 2, pHelperBottom );
+  // We just switch the top and bottom helpers, memory is not lost
+  mHelperTopX.swap( mHelperBottomX );
+  mHelperTopY.swap( mHelperBottomY );
+  calcHelper( mHelperTopRow + 2, mHelperBottomX, mHelperBottomY );
   mHelperTopRow++;
 }
 
@@ -466,6 +582,132 @@ bool ProjectorData::srcRowCol( int destRow, int destCol, int *srcRow, int *srcCo
   }
 }
 
+bool ProjectorData::srcIndices( std::vector< qint64 > &indices, QgsRasterBlockFeedback *feedback )
+{
+  indices.resize( static_cast< qgssize >( mDestRows ) * mDestCols );
+
+  // Source coordinates are calculated for a whole destination row at a time, as
+  // contiguous x and y arrays, so that the interpolation and the conversion to
+  // source pixel indexes are simple loops without branches over the columns
+  std::vector< double > x( mDestCols );
+  std::vector< double > y( mDestCols );
+  std::vector< double > z;
+  std::vector< double > destX;
+  if ( !mApproximate )
+  {
+    z.resize( mDestCols );
+    destX.resize( mDestCols );
+    for ( int destCol = 0; destCol < mDestCols; ++destCol )
+    {
+      destX[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+    }
+  }
+
+  for ( int destRow = 0; destRow < mDestRows; ++destRow )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return false;
+
+    const double destY = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
+    qint64 *rowIndices = indices.data() + static_cast< qgssize >( destRow ) * mDestCols;
+
+    if ( mApproximate )
+    {
+      const int myMatrixRow = matrixRow( destRow );
+      while ( myMatrixRow > mHelperTopRow )
+      {
+        nextHelper();
+      }
+
+      // See the schema in javax.media.jai.WarpGrid doc (but up side down)
+      double myDestXMin, myDestYMin, myDestXMax, myDestYMax;
+      destPointOnCPMatrix( myMatrixRow + 1, 0, &myDestXMin, &myDestYMin );
+      destPointOnCPMatrix( myMatrixRow, 1, &myDestXMax, &myDestYMax );
+      const double yfrac = ( destY - myDestYMin ) / ( myDestYMax - myDestYMin );
+
+      const double *topX = mHelperTopX.data();
+      const double *topY = mHelperTopY.data();
+      const double *bottomX = mHelperBottomX.data();
+      const double *bottomY = mHelperBottomY.data();
+      double *srcX = x.data();
+      double *srcY = y.data();
+      for ( int destCol = 0; destCol < mDestCols; ++destCol )
+      {
+        srcX[destCol] = bottomX[destCol] + ( topX[destCol] - bottomX[destCol] ) * yfrac;
+        srcY[destCol] = bottomY[destCol] + ( topY[destCol] - bottomY[destCol] ) * yfrac;
+      }
+    }
+    else
+    {
+      std::copy( destX.begin(), destX.end(), x.begin() );
+      std::fill( y.begin(), y.end(), destY );
+      std::fill( z.begin(), z.end(), 0.0 );
+
+      if ( mInverseCt.isValid() )
+      {
+        try
+        {
+          mInverseCt.transformCoords( mDestCols, x.data(), y.data(), z.data() );
+        }
+        catch ( QgsCsException & )
+        {
+          // some of the points could not be transformed, transform them one by one so that only
+          // the failed ones are excluded
+          for ( int destCol = 0; destCol < mDestCols; ++destCol )
+          {
+            double pointX = destX[destCol];
+            double pointY = destY;
+            double pointZ = 0;
+            try
+            {
+              mInverseCt.transformInPlace( pointX, pointY, pointZ );
+            }
+            catch ( QgsCsException & )
+            {
+              pointX = std::numeric_limits< double >::quiet_NaN();
+              pointY = std::numeric_limits< double >::quiet_NaN();
+            }
+            x[destCol] = pointX;
+            y[destCol] = pointY;
+          }
+        }
+      }
+    }
+
+    srcIndicesForPoints( x.data(), y.data(), mDestCols, rowIndices );
+  }
+  return true;
+}
+
+void ProjectorData::srcIndicesForPoints( const double *x, const double *y, int count, qint64 *indices ) const
+{
+  const double extentXMin = mExtent.xMinimum();
+  const double extentXMax = mExtent.xMaximum();
+  const double extentYMin = mExtent.yMinimum();
+  const double extentYMax = mExtent.yMaximum();
+  const double srcXMin = mSrcExtent.xMinimum();
+  const double srcYMax = mSrcExtent.yMaximum();
+  const double srcXRes = mSrcXRes;
+  const double srcYRes = mSrcYRes;
+  const double srcRows = mSrcRows;
+  const double srcCols = mSrcCols;
+  const qint64 srcColCount = mSrcCols;
+
+  // Same as the checks in preciseSrcRowCol() / approximateSrcRowCol(), but the limits are
+  // tested on the floating point row and column, so NaN coordinates of points which failed
+  // to transform are excluded too
+  for ( int i = 0; i < count; ++i )
+  {
+    const double srcX = x[i];
+    const double srcY = y[i];
+    const double srcRow = std::floor( ( srcYMax - srcY ) / srcYRes );
+    const double srcCol = std::floor( ( srcX - srcXMin ) / srcXRes );
+    const bool inside = srcX >= extentXMin && srcX <= extentXMax && srcY >= extentYMin && srcY <= extentYMax
+                        && srcRow >= 0 && srcRow < srcRows && srcCol >= 0 && srcCol < srcCols;
+    indices[i] = inside ? static_cast< qint64 >( srcRow ) * srcColCount + static_cast< qint64 >( srcCol ) : -1;
+  }
+}
+
 bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
 {
 #if 0 // too slow, even if we only run it on debug builds!
@@ -527,7 +769,7 @@ bool ProjectorData::approximateSrcRowCol( int destRow, int destCol, int *srcRow,
   int myMatrixRow = matrixRow( destRow );
   int myMatrixCol = matrixCol( destCol );
 
-  if ( myMatrixRow > mHelperTopRow )
+  while ( myMatrixRow > mHelperTopRow )
   {
     // TODO: make it more robust (for random, not sequential reading)
     nextHelper();
@@ -544,17 +786,10 @@ bool ProjectorData::approximateSrcRowCol( int destRow, int destCol, int *srcRow,
 
   double yfrac = ( myDestY - myDestYMin ) / ( myDestYMax - myDestYMin );
 
-  QgsPointXY &myTop = pHelperTop[destCol];
-  QgsPointXY &myBot = pHelperBottom[destCol];
-
-  // Warning: this is very SLOW compared to the following code!:
-  //double mySrcX = myBot.x() + (myTop.x() - myBot.x()) * yfrac;
-  //double mySrcY = myBot.y() + (myTop.y() - myBot.y()) * yfrac;
-
-  double tx = myTop.x();
-  double ty = myTop.y();
-  double bx = myBot.x();
-  double by = myBot.y();
+  double tx = mHelperTopX[destCol];
+  double ty = mHelperTopY[destCol];
+  double bx = mHelperBottomX[destCol];
+  double by = mHelperBottomY[destCol];
   double mySrcX = bx + ( tx - bx ) * yfrac;
   double mySrcY = by + ( ty - by ) * yfrac;
 
@@ -797,30 +1032,56 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
       QgsCoordinateTransform( mDestCRS, mSrcCRS, mDestDatumTransform, mSrcDatumTransform ) : QgsCoordinateTransform( mDestCRS, mSrcCRS, mTransformContext ) ;
   Q_NOWARN_DEPRECATED_POP
 
-  ProjectorData pd( extent, width, height, mInput, inverseCt, mPrecision, feedback );
+  ProjectorGridKey key;
+  key.extent = extent;
+  key.width = width;
+  key.height = height;
+  key.srcCrs = mSrcCRS;
+  key.destCrs = mDestCRS;
+  key.transformContext = mTransformContext;
+  Q_NOWARN_DEPRECATED_PUSH
+  key.srcDatumTransform = mSrcDatumTransform;
+  key.destDatumTransform = mDestDatumTransform;
+  Q_NOWARN_DEPRECATED_POP
+  key.precision = mPrecision;
+  sourceLimits( mInput, key.sourceExtent, key.maxSrcXRes, key.maxSrcYRes );
 
-  if ( feedback && feedback->isCanceled() )
-    return new QgsRasterBlock();
+  std::shared_ptr< const ProjectorGrid > grid = sProjectorGridCache()->grid( key );
+  if ( !grid )
+  {
+    ProjectorData pd( extent, width, height, mInput, inverseCt, mPrecision, feedback );
 
-  QgsDebugMsgLevel( QStringLiteral( "srcExtent:\n%1" ).arg( pd.srcExtent().toString() ), 4 );
-  QgsDebugMsgLevel( QStringLiteral( "srcCols = %1 srcRows = %2" ).arg( pd.srcCols() ).arg( pd.srcRows() ), 4 );
+    if ( feedback && feedback->isCanceled() )
+      return new QgsRasterBlock();
 
-  // If we zoom out too much, projector srcRows / srcCols maybe 0, which can cause problems in providers
-  if ( pd.srcRows() <= 0 || pd.srcCols() <= 0 )
-  {
-    QgsDebugMsgLevel( QStringLiteral( "Zero srcRows or srcCols" ), 4 );
-    return new QgsRasterBlock();
+    QgsDebugMsgLevel( QStringLiteral( "srcExtent:\n%1" ).arg( pd.srcExtent().toString() ), 4 );
+    QgsDebugMsgLevel( QStringLiteral( "srcCols = %1 srcRows = %2" ).arg( pd.srcCols() ).arg( pd.srcRows() ), 4 );
+
+    // If we zoom out too much, projector srcRows / srcCols maybe 0, which can cause problems in providers
+    if ( pd.srcRows() <= 0 || pd.srcCols() <= 0 )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Zero srcRows or srcCols" ), 4 );
+      return new QgsRasterBlock();
+    }
+
+    std::shared_ptr< ProjectorGrid > newGrid = std::make_shared< ProjectorGrid >();
+    newGrid->srcExtent = pd.srcExtent();
+    newGrid->srcRows = pd.srcRows();
+    newGrid->srcCols = pd.srcCols();
+    if ( !pd.srcIndices( newGrid->srcIndices, feedback ) )
+      return new QgsRasterBlock();
+
+    sProjectorGridCache()->insert( key, newGrid );
+    grid = newGrid;
   }
 
-  std::unique_ptr< QgsRasterBlock > inputBlock( mInput->block( bandNo, pd.srcExtent(), pd.srcCols(), pd.srcRows(), feedback ) );
+  std::unique_ptr< QgsRasterBlock > inputBlock( mInput->block( bandNo, grid->srcExtent, grid->srcCols, grid->srcRows, feedback ) );
   if ( !inputBlock || inputBlock->isEmpty() )
   {
     QgsDebugMsg( QStringLiteral( "No raster data!" ) );
     return new QgsRasterBlock();
   }
 
-  qgssize pixelSize = static_cast<qgssize>( QgsRasterBlock::typeSize( mInput->dataType( bandNo ) ) );
-
   std::unique_ptr< QgsRasterBlock > outputBlock( new QgsRasterBlock( inputBlock->dataType(), width, height ) );
   if ( inputBlock->hasNoDataValue() )
   {
@@ -835,54 +1096,80 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
   // set output to no data, it should be fast
   outputBlock->setIsNoData();
 
-  // No data: because isNoData()/setIsNoData() is slow with respect to simple memcpy,
+  // No data: because isNoData()/setIsNoData() is slow with respect to simple copies,
   // we use if only if necessary:
-  // 1) no data value exists (numerical) -> memcpy, not necessary isNoData()/setIsNoData()
+  // 1) no data value exists (numerical) -> copy, not necessary isNoData()/setIsNoData()
   // 2) no data value does not exist but it may contain no data (numerical no data bitmap)
-  //    -> must use isNoData()/setIsNoData()
-  // 3) no data are not used (no no data value, no no data bitmap) -> simple memcpy
-  // 4) image - simple memcpy
+  //    -> copy, then clear the no data bitmap for the copied pixels with setIsData()
+  // 3) no data are not used (no no data value, no no data bitmap) -> simple copy
+  // 4) image - simple copy
 
   // To copy no data values stored in bitmaps we have to use isNoData()/setIsNoData(),
-  // we cannot fill output block with no data because we use memcpy for data, not setValue().
+  // we cannot fill output block with no data because we copy data, not setValue().
   bool doNoData = !QgsRasterBlock::typeIsNumeric( inputBlock->dataType() ) && inputBlock->hasNoData() && !inputBlock->hasNoDataValue();
 
-  outputBlock->setIsNoData();
+  const qint64 *srcIndices = grid->srcIndices.data();
+  const qgssize count = static_cast< qgssize >( width ) * height;
+  const int pixelSize = QgsRasterBlock::typeSize( inputBlock->dataType() );
+  const char *srcBits = inputBlock->bits();
+  char *destBits = outputBlock->bits();
+  if ( !srcBits || !destBits )
+  {
+    QgsDebugMsg( QStringLiteral( "Cannot get block data" ) );
+    return outputBlock.release();
+  }
 
-  int srcRow, srcCol;
-  for ( int i = 0; i < height; ++i )
+  if ( doNoData )
   {
-    if ( feedback && feedback->isCanceled() )
-      break;
-    for ( int j = 0; j < width; ++j )
+    for ( qgssize i = 0; i < count; ++i )
     {
-      bool inside = pd.srcRowCol( i, j, &srcRow, &srcCol );
-      if ( !inside ) continue; // we have everything set to no data
+      const qint64 srcIndex = srcIndices[i];
+      if ( srcIndex < 0 )
+        continue; // we have everything set to no data
 
-      qgssize srcIndex = static_cast< qgssize >( srcRow * pd.srcCols() + srcCol );
-
-      // isNoData() may be slow so we check doNoData first
-      if ( doNoData && inputBlock->isNoData( srcRow, srcCol ) )
+      if ( inputBlock->isNoData( static_cast< qgssize >( srcIndex ) ) )
       {
-        outputBlock->setIsNoData( i, j );
+        outputBlock->setIsNoData( i );
         continue;
       }
 
-      qgssize destIndex = static_cast< qgssize >( i * width + j );
-      char *srcBits = inputBlock->bits( srcIndex );
-      char *destBits = outputBlock->bits( destIndex );
-      if ( !srcBits )
-      {
-        // QgsDebugMsg( QStringLiteral( "Cannot get input block data: row = %1 col = %2" ).arg( i ).arg( j ) );
-        continue;
-      }
-      if ( !destBits )
+      memcpy( destBits + i * pixelSize, srcBits + srcIndex * pixelSize, pixelSize );
+      outputBlock->setIsData( i );
+    }
+    return outputBlock.release();
+  }
+
+  switch ( pixelSize )
+  {
+    case 1:
+      gatherPixels< quint8 >( srcBits, destBits, srcIndices, count );
+      break;
+    case 2:
+      gatherPixels< quint16 >( srcBits, destBits, srcIndices, count );
+      break;
+    case 4:
+      gatherPixels< quint32 >( srcBits, destBits, srcIndices, count );
+      break;
+    case 8:
+      gatherPixels< quint64 >( srcBits, destBits, srcIndices, count );
+      break;
+    default:
+      for ( qgssize i = 0; i < count; ++i )
       {
-        // QgsDebugMsg( QStringLiteral( "Cannot set output block data: srcRow = %1 srcCol = %2" ).arg( srcRow ).arg( srcCol ) );
-        continue;
+        const qint64 srcIndex = srcIndices[i];
+        if ( srcIndex >= 0 )
+          memcpy( destBits + i * pixelSize, srcBits + srcIndex * pixelSize, pixelSize );
       }
-      memcpy( destBits, srcBits, pixelSize );
-      outputBlock->setIsData( i, j );
+      break;
+  }
+
+  // without a no data value, the output no data bitmap has to be cleared for the copied pixels
+  if ( !outputBlock->hasNoDataValue() )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      if ( srcIndices[i] >= 0 )
+        outputBlock->setIsData( i );
     }
   }
 
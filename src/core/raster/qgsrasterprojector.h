@@ -34,6 +34,7 @@
 #include "qgsrasterinterface.h"
 
 #include <cmath>
+#include <vector>
 
 class QgsPointXY;
 
@@ -132,7 +133,7 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 
 /**
  * Internal class for reprojection of rasters - either exact or approximate.
- * QgsRasterProjector creates it and then keeps calling srcRowCol() to get source pixel position
+ * QgsRasterProjector creates it and then calls srcIndices() to get source pixel position
  * for every destination pixel position.
  */
 class ProjectorData
@@ -140,7 +141,6 @@ class ProjectorData
   public:
     //! Initialize reprojector and calculate matrix
     ProjectorData( const QgsRectangle &extent, int width, int height, QgsRasterInterface *input, const QgsCoordinateTransform &inverseCt, QgsRasterProjector::Precision precision, QgsRasterBlockFeedback *feedback = nullptr );
-    ~ProjectorData();
 
     ProjectorData( const ProjectorData &other ) = delete;
     ProjectorData &operator=( const ProjectorData &other ) = delete;
@@ -152,6 +152,13 @@ class ProjectorData
      */
     bool srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
 
+    /**
+     * Calculates the index of the source pixel for every destination pixel, in row major order,
+     * with -1 for destination pixels outside of the source.
+     * Returns FALSE if the calculation was canceled via \a feedback.
+     */
+    bool srcIndices( std::vector< qint64 > &indices, QgsRasterBlockFeedback *feedback = nullptr );
+
     QgsRectangle srcExtent() const { return mSrcExtent; }
     int srcRows() const { return mSrcRows; }
     int srcCols() const { return mSrcCols; }
@@ -207,7 +214,13 @@ class ProjectorData
     bool checkRows( const QgsCoordinateTransform &ct );
 
     //! Calculate array of src helper points
-    void calcHelper( int matrixRow, QgsPointXY *points );
+    void calcHelper( int matrixRow, std::vector< double > &x, std::vector< double > &y );
+
+    /**
+     * Sets \a indices to the source pixel indexes for \a count source coordinates, or -1 for
+     * coordinates outside of the source.
+     */
+    void srcIndicesForPoints( const double *x, const double *y, int count, qint64 *indices ) const;
 
     //! Calc / switch helper
     void nextHelper();
@@ -270,13 +283,13 @@ class ProjectorData
     /* Same size as mCPMatrix */
     QList< QList<bool> > mCPLegalMatrix;
 
-    //! Array of source points for each destination column on top of current CPMatrix grid row
-    /* Warning: using QList is slow on access */
-    QgsPointXY *pHelperTop = nullptr;
+    //! Source x and y coordinates for each destination column on top of current CPMatrix grid row
+    std::vector< double > mHelperTopX;
+    std::vector< double > mHelperTopY;
 
-    //! Array of source points for each destination column on bottom of current CPMatrix grid row
-    /* Warning: using QList is slow on access */
-    QgsPointXY *pHelperBottom = nullptr;
+    //! Source x and y coordinates for each destination column on bottom of current CPMatrix grid row
+    std::vector< double > mHelperBottomX;
+    std::vector< double > mHelperBottomY;
 
     //! Current mHelperTop matrix row
     int mHelperTopRow;
@@ -28,6 +28,77 @@
 #include <QDomElement>
 #include <QImage>
 
+#include <limits>
+#include <vector>
+
+///@cond PRIVATE
+
+/**
+ * Shades all values of an integer block by looking up their colors in a table which is
+ * filled once for the whole value range of the data type, instead of evaluating the shader
+ * function for every pixel.
+ */
+template <typename T>
+static void shadeUsingLookupTable( QgsRasterBlock *inputBlock, const QgsRasterShaderFunction *fcn, bool hasTransparency, double opacity,
+                                   const QgsRasterTransparency *transparency, const QgsRasterBlock *alphaBlock,
+                                   QRgb noDataColor, QRgb *output, qgssize count )
+{
+  const int minimum = std::numeric_limits< T >::min();
+  const int maximum = std::numeric_limits< T >::max();
+
+  std::vector< QRgb > colors( static_cast< std::size_t >( maximum - minimum + 1 ) );
+  std::vector< bool > shaded( colors.size() );
+  for ( int value = minimum; value <= maximum; ++value )
+  {
+    int red, green, blue, alpha;
+    if ( !fcn->shade( value, &red, &green, &blue, &alpha ) )
+      continue;
+
+    if ( alpha < 255 )
+    {
+      // Working with premultiplied colors, so multiply values by alpha
+      red *= ( alpha / 255.0 );
+      blue *= ( alpha / 255.0 );
+      green *= ( alpha / 255.0 );
+    }
+    colors[ value - minimum ] = qRgba( red, green, blue, alpha );
+    shaded[ value - minimum ] = true;
+  }
+
+  const T *data = reinterpret_cast< const T * >( inputBlock->bits() );
+  const bool checkNoData = inputBlock->hasNoData();
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    const int index = static_cast< int >( data[i] ) - minimum;
+    if ( ( checkNoData && inputBlock->isNoData( i ) ) || !shaded[ index ] )
+    {
+      output[i] = noDataColor;
+      continue;
+    }
+
+    const QRgb color = colors[ index ];
+    if ( !hasTransparency )
+    {
+      output[i] = color;
+      continue;
+    }
+
+    double currentOpacity = opacity;
+    if ( transparency )
+    {
+      currentOpacity = transparency->alphaValue( data[i], opacity * 255 ) / 255.0;
+    }
+    if ( alphaBlock )
+    {
+      currentOpacity *= alphaBlock->value( i ) / 255.0;
+    }
+
+    output[i] = qRgba( currentOpacity * qRed( color ), currentOpacity * qGreen( color ), currentOpacity * qBlue( color ), currentOpacity * qAlpha( color ) );
+  }
+}
+
+///@endcond
+
 QgsSingleBandPseudoColorRenderer::QgsSingleBandPseudoColorRenderer( QgsRasterInterface *input, int band, QgsRasterShader *shader )
   : QgsRasterRenderer( input, QStringLiteral( "singlebandpseudocolor" ) )
   , mShader( shader )
@@ -236,6 +307,36 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
   const QgsRasterShaderFunction *fcn = mShader->rasterShaderFunction();
 
   qgssize count = ( qgssize )width * height;
+
+  // for integer data the colors of all possible values can be computed upfront, which is
+  // cheaper than shading each pixel whenever the block is at least as large as the value range
+  const QgsRasterBlock *alphaBandBlock = mAlphaBand > 0 ? alphaBlock.get() : nullptr;
+  switch ( inputBlock->dataType() )
+  {
+    case Qgis::Byte:
+      shadeUsingLookupTable< quint8 >( inputBlock.get(), fcn, hasTransparency, mOpacity, mRasterTransparency, alphaBandBlock, myDefaultColor, outputBlockData, count );
+      return outputBlock.release();
+
+    case Qgis::UInt16:
+      if ( count >= static_cast< qgssize >( std::numeric_limits< quint16 >::max() ) + 1 )
+      {
+        shadeUsingLookupTable< quint16 >( inputBlock.get(), fcn, hasTransparency, mOpacity, mRasterTransparency, alphaBandBlock, myDefaultColor, outputBlockData, count );
+        return outputBlock.release();
+      }
+      break;
+
+    case Qgis::Int16:
+      if ( count >= static_cast< qgssize >( std::numeric_limits< quint16 >::max() ) + 1 )
+      {
+        shadeUsingLookupTable< qint16 >( inputBlock.get(), fcn, hasTransparency, mOpacity, mRasterTransparency, alphaBandBlock, myDefaultColor, outputBlockData, count );
+        return outputBlock.release();
+      }
+      break;
+
+    default:
+      break;
+  }
+
   bool isNoData = false;
   for ( qgssize i = 0; i < count; i++ )
   {
@@ -17,6 +17,7 @@
 #include "qgsmarkersymbollayer.h"
 #include "qgssymbollayerutils.h"
 #include "qgspainteffect.h"
+#include "qgspainterswapper.h"
 
 QgsMarkerSymbol *QgsMarkerSymbol::createSimple( const QVariantMap &properties )
 {
@@ -419,6 +420,16 @@ void QgsMarkerSymbol::renderPoint( QPointF point, const QgsFeature *f, QgsRender
   symbolContext.setGeometryPartCount( symbolRenderContext()->geometryPartCount() );
   symbolContext.setGeometryPartNum( symbolRenderContext()->geometryPartNum() );
 
+  if ( context.testFlag( QgsRenderContext::CacheMarkerSprites ) && renderPointUsingSprite( point, f, symbolContext, layerIdx ) )
+    return;
+
+  renderPointLayers( point, symbolContext, layerIdx );
+}
+
+void QgsMarkerSymbol::renderPointLayers( QPointF point, QgsSymbolRenderContext &symbolContext, int layerIdx )
+{
+  QgsRenderContext &context = symbolContext.renderContext();
+
   if ( layerIdx != -1 )
   {
     QgsSymbolLayer *symbolLayer = mLayers.value( layerIdx );
@@ -454,6 +465,130 @@ void QgsMarkerSymbol::renderPoint( QPointF point, const QgsFeature *f, QgsRender
   }
 }
 
+///@cond PRIVATE
+//! Maximum number of distinct sprites cached per render, before falling back to direct rendering
+static const int MAX_MARKER_SPRITES = 1000;
+//! Maximum width or height of a cached sprite, in painter units
+static const double MAX_MARKER_SPRITE_SIZE = 512;
+///@endcond
+
+QString QgsMarkerSymbol::spriteKey( const QgsSymbolRenderContext &symbolContext, int layerIdx ) const
+{
+  const QgsRenderContext &context = symbolContext.renderContext();
+  if ( !context.painter() || context.testFlag( QgsRenderContext::ForceVectorOutput )
+       || !context.painter()->device() || context.painter()->device()->devType() != QInternal::Image )
+    return QString();
+
+  QStringList parts;
+  parts << QString::number( layerIdx )
+        << ( symbolContext.selected() ? QStringLiteral( "1" ) : QStringLiteral( "0" ) )
+        << QString::number( symbolContext.opacity(), 'g', 6 )
+        << QString::number( context.scaleFactor(), 'g', 10 )
+        << QString::number( context.mapToPixel().mapUnitsPerPixel(), 'g', 10 )
+        << QString::number( context.mapToPixel().mapRotation(), 'f', 1 );
+
+  for ( int i = 0; i < mLayers.count(); ++i )
+  {
+    if ( layerIdx != -1 && i != layerIdx )
+      continue;
+
+    const QgsSymbolLayer *layer = mLayers.at( i );
+    if ( !layer->enabled() || !context.isSymbolLayerEnabled( layer ) )
+    {
+      parts << QStringLiteral( "-" );
+      continue;
+    }
+
+    if ( layer->type() != Qgis::SymbolType::Marker )
+      return QString();
+
+    // marker line symbol layers rotate the markers they draw along the line, by changing the angle
+    // and line angle of the marker layers between points
+    const QgsMarkerSymbolLayer *markerLayer = static_cast< const QgsMarkerSymbolLayer * >( layer );
+    parts << QString::number( std::round( markerLayer->angle() + markerLayer->lineAngle() ) );
+
+    // data defined properties of sub symbols aren't reflected in the key
+    if ( const QgsSymbol *subSymbol = layer->subSymbol() )
+    {
+      if ( subSymbol->hasDataDefinedProperties() )
+        return QString();
+    }
+
+    // key on the evaluated values of data defined properties, so that features sharing
+    // the same appearance share a sprite
+    const QgsPropertyCollection &properties = layer->dataDefinedProperties();
+    if ( properties.hasActiveProperties() )
+    {
+      QList< int > keys = qgis::setToList( properties.propertyKeys() );
+      std::sort( keys.begin(), keys.end() );
+      for ( int key : std::as_const( keys ) )
+      {
+        if ( !properties.isActive( key ) )
+          continue;
+
+        const QVariant value = properties.value( key, context.expressionContext() );
+        // rotations are bucketed to whole degrees
+        const QString valueString = key == QgsSymbolLayer::PropertyAngle && value.isValid()
+                                    ? QString::number( std::round( value.toDouble() ) )
+                                    : value.toString();
+        parts << QStringLiteral( "%1=%2" ).arg( key ).arg( valueString );
+      }
+    }
+
+    if ( const QgsSvgMarkerSymbolLayer *svgLayer = dynamic_cast< const QgsSvgMarkerSymbolLayer * >( layer ) )
+    {
+      const QMap< QString, QgsProperty > parameters = svgLayer->parameters();
+      for ( auto it = parameters.constBegin(); it != parameters.constEnd(); ++it )
+        parts << QStringLiteral( "%1=%2" ).arg( it.key(), it.value().value( context.expressionContext() ).toString() );
+    }
+  }
+
+  return parts.join( '|' );
+}
+
+bool QgsMarkerSymbol::renderPointUsingSprite( QPointF point, const QgsFeature *f, QgsSymbolRenderContext &symbolContext, int layerIdx )
+{
+  const QString key = spriteKey( symbolContext, layerIdx );
+  if ( key.isEmpty() )
+    return false;
+
+  QgsRenderContext &context = symbolContext.renderContext();
+  auto it = mSprites.constFind( key );
+  if ( it == mSprites.constEnd() )
+  {
+    if ( mSprites.size() >= MAX_MARKER_SPRITES )
+      return false;
+
+    QRectF spriteBounds = bounds( QPointF( 0, 0 ), context, f ? *f : QgsFeature() );
+    if ( spriteBounds.isNull() )
+      return false;
+
+    // symbol layer bounds are approximate, so leave some room for antialiasing and strokes
+    const double margin = std::max( 2.0, 0.1 * std::max( spriteBounds.width(), spriteBounds.height() ) );
+    spriteBounds.adjust( -margin, -margin, margin, margin );
+    if ( spriteBounds.width() > MAX_MARKER_SPRITE_SIZE || spriteBounds.height() > MAX_MARKER_SPRITE_SIZE )
+      return false;
+
+    const qreal devicePixelRatio = context.painter()->device()->devicePixelRatioF();
+    QImage image( static_cast< int >( std::ceil( spriteBounds.width() * devicePixelRatio ) ),
+                  static_cast< int >( std::ceil( spriteBounds.height() * devicePixelRatio ) ),
+                  QImage::Format_ARGB32_Premultiplied );
+    image.setDevicePixelRatio( devicePixelRatio );
+    image.fill( Qt::transparent );
+    {
+      QPainter spritePainter( &image );
+      spritePainter.setRenderHints( context.painter()->renderHints() );
+      QgsPainterSwapper swapper( context, &spritePainter );
+      renderPointLayers( -spriteBounds.topLeft(), symbolContext, layerIdx );
+    }
+
+    it = mSprites.insert( key, Sprite{ image, spriteBounds.topLeft() } );
+  }
+
+  context.painter()->drawImage( point + it->offset, it->image );
+  return true;
+}
+
 QRectF QgsMarkerSymbol::bounds( QPointF point, QgsRenderContext &context, const QgsFeature &feature ) const
 {
   QgsSymbolRenderContext symbolContext( context, QgsUnitTypes::RenderUnknownUnit, mOpacity, false, mRenderHints, &feature, feature.fields() );
@@ -487,3 +622,9 @@ QgsMarkerSymbol *QgsMarkerSymbol::clone() const
   return cloneSymbol;
 }
 
+void QgsMarkerSymbol::renderStopped()
+{
+  // cached sprites are only valid for a single render
+  mSprites.clear();
+}
+
@@ -19,6 +19,9 @@
 #include "qgis_core.h"
 #include "qgssymbol.h"
 
+#include <QHash>
+#include <QImage>
+
 class QgsMarkerSymbolLayer;
 
 /**
@@ -228,6 +231,37 @@ class CORE_EXPORT QgsMarkerSymbol : public QgsSymbol
 
     void renderPointUsingLayer( QgsMarkerSymbolLayer *layer, QPointF point, QgsSymbolRenderContext &context );
 
+#ifndef SIP_RUN
+
+    void renderStopped() override;
+
+    /**
+     * Renders the symbol layers (or only the layer at \a layerIdx, if not -1) at the specified \a point.
+     */
+    void renderPointLayers( QPointF point, QgsSymbolRenderContext &symbolContext, int layerIdx );
+
+    /**
+     * Renders the symbol at \a point by drawing a cached raster sprite, rasterizing it first
+     * if no matching sprite exists yet.
+     *
+     * Returns FALSE if the sprite cache cannot be used for this symbol or context, in which
+     * case the symbol must be rendered directly.
+     */
+    bool renderPointUsingSprite( QPointF point, const QgsFeature *f, QgsSymbolRenderContext &symbolContext, int layerIdx );
+
+    //! Returns the sprite cache key for the current symbol appearance, or an empty string if the sprite cache cannot be used
+    QString spriteKey( const QgsSymbolRenderContext &symbolContext, int layerIdx ) const;
+
+    struct Sprite
+    {
+      QImage image;
+      QPointF offset;
+    };
+
+    //! Rasterized sprites, valid between startRender() and stopRender()
+    QHash< QString, Sprite > mSprites;
+#endif
+
 };
 
 
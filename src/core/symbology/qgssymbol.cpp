@@ -80,6 +80,54 @@ QgsSymbol::QgsSymbol( Qgis::SymbolType type, const QgsSymbolLayerList &layers )
 }
 Q_NOWARN_DEPRECATED_POP
 
+///@cond PRIVATE
+
+/**
+ * Returns the painter coordinate tolerance below which vertices are dropped when the
+ * QgsRenderContext::CullSubPixelFeatures flag is set.
+ */
+static double subPixelVertexTolerance( const QgsRenderContext &context )
+{
+  if ( context.vectorSimplifyMethod().simplifyHints() & QgsVectorSimplifyMethod::GeometrySimplification )
+    return std::max( 1.0, static_cast< double >( context.vectorSimplifyMethod().threshold() ) );
+  return 1.0;
+}
+
+/**
+ * Removes vertices from the painter coordinate polygon \a pts which are closer than \a tolerance
+ * to the previously retained vertex. The first and last vertices are always kept, and
+ * the polygon is left untouched if fewer than \a minimumPoints vertices would remain.
+ */
+static void removeSubPixelVertices( QPolygonF &pts, double tolerance, int minimumPoints )
+{
+  const int count = pts.size();
+  if ( count <= minimumPoints )
+    return;
+
+  const double toleranceSquared = tolerance * tolerance;
+  QPolygonF reduced;
+  reduced.reserve( count );
+  reduced << pts.at( 0 );
+  QPointF last = pts.at( 0 );
+  for ( int i = 1; i < count - 1; ++i )
+  {
+    const QPointF &pt = pts.at( i );
+    const double dx = pt.x() - last.x();
+    const double dy = pt.y() - last.y();
+    if ( dx * dx + dy * dy >= toleranceSquared )
+    {
+      reduced << pt;
+      last = pt;
+    }
+  }
+  reduced << pts.at( count - 1 );
+
+  if ( reduced.size() >= minimumPoints )
+    pts = reduced;
+}
+
+///@endcond
+
 QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
   const unsigned int nPoints = curve.numPoints();
@@ -138,6 +186,9 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
     mtp.transformInPlace( ptr->rx(), ptr->ry() );
   }
 
+  if ( context.testFlag( QgsRenderContext::CullSubPixelFeatures ) )
+    removeSubPixelVertices( pts, subPixelVertexTolerance( context ), 2 );
+
   return pts;
 }
 
@@ -209,6 +260,9 @@ QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve
   if ( !poly.empty() && !poly.isClosed() )
     poly << poly.at( 0 );
 
+  if ( context.testFlag( QgsRenderContext::CullSubPixelFeatures ) )
+    removeSubPixelVertices( poly, subPixelVertexTolerance( context ), 4 );
+
   return poly;
 }
 
@@ -533,6 +587,8 @@ void QgsSymbol::stopRender( QgsRenderContext &context )
 
   mSymbolRenderContext.reset( nullptr );
 
+  renderStopped();
+
   Q_NOWARN_DEPRECATED_PUSH
   mLayer = nullptr;
   Q_NOWARN_DEPRECATED_POP
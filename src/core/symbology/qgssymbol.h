@@ -673,6 +673,15 @@ class CORE_EXPORT QgsSymbol
      */
     void renderVertexMarker( QPointF pt, QgsRenderContext &context, int currentVertexMarkerType, double currentVertexMarkerSize );
 
+    /**
+     * Called at the end of stopRender(), after all symbol layers have stopped rendering.
+     *
+     * Subclasses can reimplement this to discard any state cached for the render.
+     *
+     * \since QGIS 3.20
+     */
+    virtual void renderStopped() SIP_SKIP {}
+
     Qgis::SymbolType mType;
     QgsSymbolLayerList mLayers;
 
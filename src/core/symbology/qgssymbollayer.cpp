@@ -136,6 +136,12 @@ QgsSymbol *QgsSymbolLayer::subSymbol()
   return nullptr;
 }
 
+const QgsSymbol *QgsSymbolLayer::subSymbol() const
+{
+  // the non-const accessor only returns the layer's sub symbol, without modifying the layer
+  return const_cast< QgsSymbolLayer * >( this )->subSymbol();
+}
+
 bool QgsSymbolLayer::setSubSymbol( QgsSymbol *symbol )
 {
   delete symbol;
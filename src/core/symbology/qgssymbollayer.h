@@ -358,6 +358,14 @@ class CORE_EXPORT QgsSymbolLayer
      */
     virtual QgsSymbol *subSymbol();
 
+    /**
+     * Returns the symbol's sub symbol, if present.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.20
+     */
+    const QgsSymbol *subSymbol() const SIP_SKIP;
+
     //! Sets layer's subsymbol. takes ownership of the passed symbol
     virtual bool setSubSymbol( QgsSymbol *symbol SIP_TRANSFER );
 
@@ -680,10 +688,18 @@ class CORE_EXPORT QgsMarkerSymbolLayer : public QgsSymbolLayer
      * \param lineAngle Angle in degrees clockwise from north, valid values are between 0 and 360
      * \see setAngle()
      * \see angle()
+     * \see lineAngle()
      * \since QGIS 2.9
      */
     void setLineAngle( double lineAngle ) { mLineAngle = lineAngle; }
 
+    /**
+     * Returns the line angle modification for the symbol's angle, in degrees clockwise from north.
+     * \see setLineAngle()
+     * \since QGIS 3.20
+     */
+    double lineAngle() const { return mLineAngle; }
+
     /**
      * Sets the symbol size.
      * \param size symbol size. Units are specified by sizeUnit().
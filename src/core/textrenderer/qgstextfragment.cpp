@@ -14,7 +14,7 @@
  ***************************************************************************/
 
 #include "qgstextfragment.h"
-#include <QFontMetricsF>
+#include "qgstextlayoutcache.h"
 #include <QTextFragment>
 
 QgsTextFragment::QgsTextFragment( const QString &text, const QgsTextCharacterFormat &format )
@@ -48,15 +48,13 @@ double QgsTextFragment::horizontalAdvance( const QFont &font, bool fontHasBeenUp
 {
   if ( fontHasBeenUpdatedForFragment )
   {
-    QFontMetricsF fm( font );
-    return fm.horizontalAdvance( mText );
+    return QgsTextLayoutCache::horizontalAdvance( font, mText );
   }
   else
   {
     QFont updatedFont = font;
     mCharFormat.updateFontForFormat( updatedFont, scaleFactor );
-    QFontMetricsF fm( updatedFont );
-    return fm.horizontalAdvance( mText );
+    return QgsTextLayoutCache::horizontalAdvance( updatedFont, mText );
   }
 }
 
@@ -0,0 +1,109 @@
+/***************************************************************************
+  qgstextlayoutcache.cpp
+  ----------------------
+   begin                : October 2021
+   copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstextlayoutcache.h"
+
+#include <QCache>
+#include <QFontMetricsF>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+
+///@cond PRIVATE
+class QgsTextLayoutCacheStorage
+{
+  public:
+
+    QgsTextLayoutCacheStorage()
+      : advances( 20000 )
+      , paths( 5000 )
+    {}
+
+    QMutex mutex;
+    QCache< QString, double > advances;
+    QCache< QString, QPainterPath > paths;
+};
+
+Q_GLOBAL_STATIC( QgsTextLayoutCacheStorage, sTextLayoutCache )
+
+static QString cacheKey( const QFont &font, const QString &text )
+{
+  return QgsTextLayoutCache::fontKey( font ) + QChar( 0x1f ) + text;
+}
+///@endcond
+
+QString QgsTextLayoutCache::fontKey( const QFont &font )
+{
+  // QFont::toString() omits several properties which affect shaping, so append them explicitly
+  return font.toString()
+         + '|' + QString::number( static_cast< int >( font.letterSpacingType() ) )
+         + '|' + QString::number( font.letterSpacing(), 'g', 17 )
+         + '|' + QString::number( font.wordSpacing(), 'g', 17 )
+         + '|' + QString::number( static_cast< int >( font.capitalization() ) )
+         + '|' + QString::number( font.stretch() )
+         + '|' + QString::number( font.kerning() ? 1 : 0 )
+         + '|' + QString::number( static_cast< int >( font.hintingPreference() ) );
+}
+
+double QgsTextLayoutCache::horizontalAdvance( const QFont &font, const QString &text )
+{
+  if ( text.isEmpty() )
+    return 0;
+
+  const QString key = cacheKey( font, text );
+  QgsTextLayoutCacheStorage *storage = sTextLayoutCache();
+  {
+    QMutexLocker locker( &storage->mutex );
+    if ( const double *advance = storage->advances.object( key ) )
+      return *advance;
+  }
+
+  // shape outside of the lock, so that concurrent label providers are not serialized
+  const QFontMetricsF fm( font );
+  const double advance = fm.horizontalAdvance( text );
+
+  QMutexLocker locker( &storage->mutex );
+  storage->advances.insert( key, new double( advance ) );
+  return advance;
+}
+
+QPainterPath QgsTextLayoutCache::textPath( const QFont &font, const QString &text )
+{
+  if ( text.isEmpty() )
+    return QPainterPath();
+
+  const QString key = cacheKey( font, text );
+  QgsTextLayoutCacheStorage *storage = sTextLayoutCache();
+  {
+    QMutexLocker locker( &storage->mutex );
+    if ( const QPainterPath *path = storage->paths.object( key ) )
+      return *path;
+  }
+
+  QPainterPath path;
+  path.addText( 0, 0, font, text );
+
+  QMutexLocker locker( &storage->mutex );
+  // cost paths by element count, so that long strings don't starve the cache
+  storage->paths.insert( key, new QPainterPath( path ), std::max( 1, path.elementCount() / 100 ) );
+  return path;
+}
+
+void QgsTextLayoutCache::clear()
+{
+  QgsTextLayoutCacheStorage *storage = sTextLayoutCache();
+  QMutexLocker locker( &storage->mutex );
+  storage->advances.clear();
+  storage->paths.clear();
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+  qgstextlayoutcache.h
+  --------------------
+   begin                : October 2021
+   copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSTEXTLAYOUTCACHE_H
+#define QGSTEXTLAYOUTCACHE_H
+
+#include "qgis_core.h"
+
+#include <QFont>
+#include <QPainterPath>
+#include <QString>
+
+#define SIP_NO_FILE
+
+/**
+ * \class QgsTextLayoutCache
+ * \ingroup core
+ * \brief A thread-safe cache of shaped text metrics and glyph outlines.
+ *
+ * Label placement measures the same strings many times while sizing candidates, and the
+ * text renderer then shapes those strings again when drawing buffers, masks and the
+ * text itself. QgsTextLayoutCache stores the advance width and the glyph outline path for
+ * each combination of font and text, so that text is shaped only once and the result is
+ * shared between sizing and drawing.
+ *
+ * Entries are keyed by every font property which affects shaping (family, style, size,
+ * weight, letter and word spacing, capitalization, stretch, kerning and hinting), so cached
+ * results are identical to those returned by QFontMetricsF and QPainterPath::addText().
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.20
+ */
+class CORE_EXPORT QgsTextLayoutCache
+{
+  public:
+
+    /**
+     * Returns the horizontal advance of \a text when rendered with the specified \a font,
+     * as would be returned by QFontMetricsF::horizontalAdvance().
+     */
+    static double horizontalAdvance( const QFont &font, const QString &text );
+
+    /**
+     * Returns the outline path of \a text when rendered with the specified \a font, with
+     * the text baseline starting at the origin.
+     *
+     * The result is identical to calling QPainterPath::addText() with an origin of (0, 0).
+     * Callers should translate the returned path to the desired position.
+     */
+    static QPainterPath textPath( const QFont &font, const QString &text );
+
+    /**
+     * Clears all cached metrics and glyph outlines.
+     */
+    static void clear();
+
+    /**
+     * Returns a key uniquely identifying the shaping properties of \a font.
+     */
+    static QString fontKey( const QFont &font );
+};
+
+#endif // QGSTEXTLAYOUTCACHE_H
@@ -18,6 +18,7 @@
 #include "qgstextformat.h"
 #include "qgstextdocument.h"
 #include "qgstextfragment.h"
+#include "qgstextlayoutcache.h"
 #include "qgspallabeling.h"
 #include "qgspainteffect.h"
 #include "qgspainterswapper.h"
@@ -311,7 +312,7 @@ double QgsTextRenderer::drawBuffer( QgsRenderContext &context, const QgsTextRend
         if ( component.extraWordSpacing || component.extraLetterSpacing )
           applyExtraSpacingForLineJustification( fragmentFont, component.extraWordSpacing, component.extraLetterSpacing );
 
-        path.addText( xOffset, 0, fragmentFont, fragment.text() );
+        path.addPath( QgsTextLayoutCache::textPath( fragmentFont, fragment.text() ).translated( xOffset, 0 ) );
 
         xOffset += fragment.horizontalAdvance( fragmentFont, true, scaleFactor );
       }
@@ -335,8 +336,8 @@ double QgsTextRenderer::drawBuffer( QgsRenderContext &context, const QgsTextRend
         const QStringList parts = QgsPalLabeling::splitToGraphemes( fragment.text() );
         for ( const QString &part : parts )
         {
-          double partXOffset = ( labelWidth - ( fragmentMetrics.horizontalAdvance( part ) - letterSpacing ) ) / 2;
-          path.addText( partXOffset, partYOffset, fragmentFont, part );
+          double partXOffset = ( labelWidth - ( QgsTextLayoutCache::horizontalAdvance( fragmentFont, part ) - letterSpacing ) ) / 2;
+          path.addPath( QgsTextLayoutCache::textPath( fragmentFont, part ).translated( partXOffset, partYOffset ) );
           partYOffset += fragmentMetrics.ascent() + letterSpacing;
         }
       }
@@ -446,7 +447,7 @@ void QgsTextRenderer::drawMask( QgsRenderContext &context, const QgsTextRenderer
     QFont fragmentFont = font;
     fragment.characterFormat().updateFontForFormat( fragmentFont, scaleFactor );
 
-    path.addText( xOffset, 0, fragmentFont, fragment.text() );
+    path.addPath( QgsTextLayoutCache::textPath( fragmentFont, fragment.text() ).translated( xOffset, 0 ) );
 
     xOffset += fragment.horizontalAdvance( fragmentFont, true );
   }
@@ -1555,7 +1556,7 @@ void QgsTextRenderer::drawTextInternalHorizontal( QgsRenderContext &context, con
         if ( extraWordSpace || extraLetterSpace )
           applyExtraSpacingForLineJustification( fragmentFont, extraWordSpace * fontScale, extraLetterSpace * fontScale );
 
-        path.addText( xOffset, 0, fragmentFont, fragment.text() );
+        path.addPath( QgsTextLayoutCache::textPath( fragmentFont, fragment.text() ).translated( xOffset, 0 ) );
 
         QColor textColor = fragment.characterFormat().textColor().isValid() ? fragment.characterFormat().textColor() : format.color();
         textColor.setAlphaF( fragment.characterFormat().textColor().isValid() ? textColor.alphaF() * format.opacity() : format.opacity() );
@@ -1787,8 +1788,8 @@ void QgsTextRenderer::drawTextInternalVertical( QgsRenderContext &context, const
         double partYOffset = 0.0;
         for ( const auto &part : parts )
         {
-          double partXOffset = ( labelWidth - ( fragmentMetrics.horizontalAdvance( part ) / fontScale - letterSpacing ) ) / 2;
-          path.addText( partXOffset * fontScale, partYOffset * fontScale, fragmentFont, part );
+          double partXOffset = ( labelWidth - ( QgsTextLayoutCache::horizontalAdvance( fragmentFont, part ) / fontScale - letterSpacing ) ) / 2;
+          path.addPath( QgsTextLayoutCache::textPath( fragmentFont, part ).translated( partXOffset * fontScale, partYOffset * fontScale ) );
           partYOffset += fragmentMetrics.ascent() / fontScale + letterSpacing;
         }
 
@@ -1851,7 +1852,7 @@ void QgsTextRenderer::drawTextInternalVertical( QgsRenderContext &context, const
             double partYOffset = 0.0;
             for ( const QString &part : parts )
             {
-              double partXOffset = ( labelWidth - ( fragmentMetrics.horizontalAdvance( part ) / fontScale - letterSpacing ) ) / 2;
+              double partXOffset = ( labelWidth - ( QgsTextLayoutCache::horizontalAdvance( fragmentFont, part ) / fontScale - letterSpacing ) ) / 2;
               context.painter()->scale( 1 / fontScale, 1 / fontScale );
               context.painter()->drawText( partXOffset * fontScale, ( fragmentYOffset + partYOffset ) * fontScale, part );
               context.painter()->scale( fontScale, fontScale );
@@ -29,6 +29,7 @@
 #include "qgsvectorlayer.h"
 #include "qgsvectorlayerdiagramprovider.h"
 #include "qgsvectorlayerfeatureiterator.h"
+#include "qgsvectorlayerjoininfo.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgsvectorlayerlabelprovider.h"
 #include "qgspainteffect.h"
@@ -39,11 +40,289 @@
 #include "qgsexpressioncontextutils.h"
 #include "qgsrenderedfeaturehandlerinterface.h"
 #include "qgsvectorlayertemporalproperties.h"
+#include "qgsvectorlayerutils.h"
 #include "qgsmapclippingutils.h"
 #include "qgsfeaturerenderergenerator.h"
+#include "qgspointaggregationpyramid.h"
+#include "qgsproviderregistry.h"
+#include "qgsvectordataprovider.h"
+#include "qgsmarkersymbol.h"
+#include "qgsfillsymbollayer.h"
+#include "qgslinesymbollayer.h"
 
 #include <QPicture>
 #include <QTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+///@cond PRIVATE
+
+//! Maximum number of tiles a layer is split into for parallel rendering
+static const int MAX_RENDER_TILES = 8;
+//! Minimum height of a render tile, in pixels
+static const int MIN_RENDER_TILE_HEIGHT = 128;
+//! Features within this many pixels of a tile are fetched, so that symbols which extend past their feature's bounds are not cut off
+static const int RENDER_TILE_MARGIN = 128;
+//! Maximum number of features drawn for each layer by draft renders
+static const int DRAFT_FEATURE_LIMIT = 5000;
+//! Minimum simplification threshold used by draft renders, in pixels
+static const float DRAFT_SIMPLIFY_THRESHOLD = 4.0f;
+
+/**
+ * Returns a rough estimate of the memory used by a cached copy of the feature \a f, in bytes.
+ */
+static qint64 estimatedFeatureMemory( const QgsFeature &f )
+{
+  qint64 size = sizeof( QgsFeature ) + f.geometry().wkbSize();
+  const QgsAttributes attributes = f.attributes();
+  size += attributes.size() * static_cast< qint64 >( sizeof( QVariant ) );
+  for ( const QVariant &attribute : attributes )
+  {
+    if ( attribute.type() == QVariant::String )
+      size += attribute.toString().size() * static_cast< qint64 >( sizeof( QChar ) );
+    else if ( attribute.type() == QVariant::ByteArray )
+      size += attribute.toByteArray().size();
+  }
+  return size;
+}
+
+// tile jobs get their own pool, as the layer jobs waiting for them may already occupy every thread of the global pool
+Q_GLOBAL_STATIC( QThreadPool, sRenderTilePool )
+
+/**
+ * Returns the color of the dot drawn for a sub-pixel feature with the specified \a symbol, or an invalid
+ * color if the symbol is not drawn in a single plain color (e.g. outline only fills, patterns, geometry
+ * generators or data defined colors), in which case the feature must be rendered normally.
+ *
+ * If \a singleColor is specified, it will be set to TRUE if every part of the symbol is drawn in the returned color.
+ */
+static QColor subPixelFeatureColor( const QgsSymbol *symbol, bool *singleColor = nullptr )
+{
+  QColor color;
+  bool uniform = true;
+  const QgsSymbolLayerList layers = symbol->symbolLayers();
+  for ( const QgsSymbolLayer *layer : layers )
+  {
+    if ( !layer->enabled() )
+      continue;
+
+    if ( layer->dataDefinedProperties().hasActiveProperties() || ( layer->paintEffect() && layer->paintEffect()->enabled() ) )
+      return QColor();
+
+    if ( const QgsSimpleFillSymbolLayer *fill = dynamic_cast< const QgsSimpleFillSymbolLayer * >( layer ) )
+    {
+      if ( fill->brushStyle() != Qt::SolidPattern )
+        return QColor();
+      if ( fill->strokeStyle() != Qt::NoPen && fill->strokeColor() != fill->color() )
+        uniform = false;
+    }
+    else if ( const QgsSimpleLineSymbolLayer *line = dynamic_cast< const QgsSimpleLineSymbolLayer * >( layer ) )
+    {
+      if ( line->penStyle() == Qt::NoPen )
+        return QColor();
+    }
+    else
+    {
+      return QColor();
+    }
+
+    // the first layer is the largest part of such a small feature
+    if ( !color.isValid() )
+      color = layer->color();
+    else if ( layer->color() != color )
+      uniform = false;
+  }
+
+  if ( singleColor )
+    *singleColor = color.isValid() && uniform;
+  return color;
+}
+
+/**
+ * Colors of the map pixels drawn in a single opaque color by the features rendered so far, used to skip
+ * features which would not change the rendered map.
+ *
+ * Pixels which are not covered by a known color are stored as 0, which can never be an opaque color.
+ * The map is divided in cells, so that the uncovered parts of the map can be skipped cheaply when
+ * the pixels beneath larger features are cleared.
+ */
+struct QgsVectorLayerRenderer::SubPixelCoverage
+{
+  static constexpr int CELL_SIZE = 64;
+
+  SubPixelCoverage( int width, int height )
+    : width( width )
+    , height( height )
+    , cellColumns( ( width + CELL_SIZE - 1 ) / CELL_SIZE )
+    , pixels( width * height, 0 )
+    , coveredCells( cellColumns * ( ( height + CELL_SIZE - 1 ) / CELL_SIZE ), false )
+  {}
+
+  QRgb color( int x, int y ) const
+  {
+    return pixels.at( y * width + x );
+  }
+
+  void setColor( int x, int y, QRgb color )
+  {
+    pixels[ y * width + x ] = color;
+    if ( color )
+      coveredCells[( y / CELL_SIZE ) * cellColumns + x / CELL_SIZE ] = true;
+  }
+
+  //! Returns TRUE if every map pixel within \a rect is covered by \a color
+  bool isCovered( const QRect &rect, QRgb color ) const
+  {
+    const QRect r = rect.intersected( QRect( 0, 0, width, height ) );
+    if ( r.isEmpty() )
+      return false;
+
+    for ( int cellY = r.top() / CELL_SIZE; cellY <= r.bottom() / CELL_SIZE; ++cellY )
+    {
+      for ( int cellX = r.left() / CELL_SIZE; cellX <= r.right() / CELL_SIZE; ++cellX )
+      {
+        if ( !coveredCells.at( cellY * cellColumns + cellX ) )
+          return false;
+      }
+    }
+    for ( int y = r.top(); y <= r.bottom(); ++y )
+    {
+      const QRgb *row = pixels.constData() + y * width;
+      for ( int x = r.left(); x <= r.right(); ++x )
+      {
+        if ( row[x] != color )
+          return false;
+      }
+    }
+    return true;
+  }
+
+  //! Forgets the colors of the map pixels within \a rect, which are about to be drawn over
+  void invalidate( const QRect &rect )
+  {
+    const QRect r = rect.intersected( QRect( 0, 0, width, height ) );
+    if ( r.isEmpty() )
+      return;
+
+    for ( int cellY = r.top() / CELL_SIZE; cellY <= r.bottom() / CELL_SIZE; ++cellY )
+    {
+      for ( int cellX = r.left() / CELL_SIZE; cellX <= r.right() / CELL_SIZE; ++cellX )
+      {
+        const int cell = cellY * cellColumns + cellX;
+        if ( !coveredCells.at( cell ) )
+          continue;
+
+        const QRect cellRect( cellX * CELL_SIZE, cellY * CELL_SIZE, CELL_SIZE, CELL_SIZE );
+        const QRect clear = cellRect.intersected( r );
+        for ( int y = clear.top(); y <= clear.bottom(); ++y )
+          std::fill( pixels.begin() + y * width + clear.left(), pixels.begin() + y * width + clear.right() + 1, 0 );
+        // a cell which is cleared entirely can be skipped from now on
+        if ( r.contains( cellRect.intersected( QRect( 0, 0, width, height ) ) ) )
+          coveredCells[ cell ] = false;
+      }
+    }
+  }
+
+  int width = 0;
+  int height = 0;
+  int cellColumns = 0;
+  QVector< QRgb > pixels;
+  QVector< bool > coveredCells;
+};
+
+struct QgsVectorLayerRenderer::RenderTile
+{
+  //! Area of the map covered by the tile, in logical pixels
+  QRect pixelRect;
+  std::unique_ptr< QgsRenderContext > context;
+  std::unique_ptr< QgsVectorLayerRenderer > renderer;
+  QImage image;
+};
+
+/**
+ * Iterates over features stored in a QgsMapRendererCache. Filter expressions, ordering and limits
+ * are handled by QgsAbstractFeatureIterator, as for any other source.
+ */
+class QgsRendererCacheFeatureIterator : public QgsAbstractFeatureIterator
+{
+  public:
+
+    /**
+     * Iterates over the cached \a features which match the \a request, followed by the features of
+     * the optional \a remainingFeatures iterator, which continues the read of a partially cached extent.
+     */
+    QgsRendererCacheFeatureIterator( std::shared_ptr< const QgsMapRendererCache::CachedFeatures > features, const QgsFeatureRequest &request,
+                                     const QgsFeatureIterator &remainingFeatures = QgsFeatureIterator() )
+      : QgsAbstractFeatureIterator( request )
+      , mFeatures( std::move( features ) )
+      , mRemainingFeatures( remainingFeatures )
+      , mHasRemainingFeatures( !remainingFeatures.isClosed() )
+    {}
+
+    bool rewind() override
+    {
+      // the features read by the remaining iterator are not kept, so they can't be iterated again
+      if ( mHasRemainingFeatures )
+        return false;
+
+      mIndex = 0;
+      return true;
+    }
+
+    bool close() override
+    {
+      mRemainingFeatures.close();
+      mClosed = true;
+      return true;
+    }
+
+  protected:
+
+    bool fetchFeature( QgsFeature &f ) override
+    {
+      f.setValid( false );
+      if ( mClosed )
+        return false;
+
+      const QgsRectangle filterRect = mRequest.filterRect();
+      while ( mIndex < mFeatures->features.size() )
+      {
+        const QgsFeature &feature = mFeatures->features.at( mIndex++ );
+        if ( !filterRect.isNull() && ( !feature.hasGeometry() || !feature.geometry().boundingBoxIntersects( filterRect ) ) )
+          continue;
+
+        f = feature;
+        f.setValid( true );
+        return true;
+      }
+
+      QgsFeature feature;
+      while ( mRemainingFeatures.nextFeature( feature ) )
+      {
+        if ( !filterRect.isNull() && ( !feature.hasGeometry() || !feature.geometry().boundingBoxIntersects( filterRect ) ) )
+          continue;
+
+        f = feature;
+        f.setValid( true );
+        return true;
+      }
+      if ( mHasRemainingFeatures && !mRemainingFeatures.isValid() )
+        mValid = false;
+
+      close();
+      return false;
+    }
+
+  private:
+
+    std::shared_ptr< const QgsMapRendererCache::CachedFeatures > mFeatures;
+    QgsFeatureIterator mRemainingFeatures;
+    bool mHasRemainingFeatures = false;
+    int mIndex = 0;
+};
+
+///@endcond
 
 QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context )
   : QgsMapLayerRenderer( layer->id(), &context )
@@ -92,8 +371,34 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
 
   mGeometryType = layer->geometryType();
 
+  // point layers read from a file may have a precomputed aggregation pyramid, which is used
+  // in place of the individual features at small scales
+  if ( mGeometryType == QgsWkbTypes::PointGeometry && layer->dataProvider() && !layer->editBuffer() && layer->subsetString().isEmpty() )
+  {
+    const QString sourcePath = QgsProviderRegistry::instance()->decodeUri( layer->providerType(), layer->source() ).value( QStringLiteral( "path" ) ).toString();
+    if ( !sourcePath.isEmpty() )
+      mPointAggregationPyramid = QgsPointAggregationPyramid::cachedPyramid( layer->source(), sourcePath );
+  }
+
   mFeatureBlendMode = layer->featureBlendMode();
 
+  // features of layers being edited are not cached, as edits do not always emit dataChanged(), nor are the
+  // features of automatically refreshed layers, which are expected to change between renders
+  mCacheFeatures = context.testFlag( QgsRenderContext::CacheVectorFeatures ) && !layer->editBuffer()
+                   && !layer->autoRefreshEnabled();
+  // the same goes for the layers joined to this one, whose attributes are part of the cached features
+  const QList< QgsVectorLayerJoinInfo > joins = layer->vectorJoins();
+  for ( const QgsVectorLayerJoinInfo &join : joins )
+  {
+    if ( QgsVectorLayer *joinLayer = join.joinLayer() )
+    {
+      if ( joinLayer->editBuffer() || joinLayer->autoRefreshEnabled() )
+        mCacheFeatures = false;
+      mCacheDependentLayers << joinLayer;
+    }
+  }
+  mSubsetString = layer->subsetString();
+
   if ( context.isTemporal() )
   {
     QgsVectorLayerTemporalContext temporalContext;
@@ -115,6 +420,16 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
     mSimplifyGeometry = layer->simplifyDrawingCanbeApplied( *renderContext(), QgsVectorSimplifyMethod::GeometrySimplification );
   }
 
+  // draft renders are replaced by a full render soon after, so they simplify far more aggressively than
+  // the layer settings ask for, regardless of whether the provider can simplify itself
+  if ( context.testFlag( QgsRenderContext::RenderDraftPreview ) && mGeometryType != QgsWkbTypes::PointGeometry )
+  {
+    mSimplifyMethod.setSimplifyHints( mSimplifyMethod.simplifyHints() | QgsVectorSimplifyMethod::GeometrySimplification );
+    mSimplifyMethod.setThreshold( std::max( mSimplifyMethod.threshold(), DRAFT_SIMPLIFY_THRESHOLD ) );
+    mSimplifyMethod.setForceLocalOptimization( true );
+    mSimplifyGeometry = true;
+  }
+
   mVertexMarkerOnlyForSelection = QgsSettingsRegistryCore::settingsDigitizingMarkerOnlyForSelected.value();
 
   QString markerTypeString = QgsSettingsRegistryCore::settingsDigitizingMarkerStyle.value();
@@ -140,6 +455,9 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
     // set editing vertex markers style (main renderer only)
     mRenderer->setVertexMarkerAppearance( mVertexMarkerStyle, mVertexMarkerSize );
   }
+  // must be done before the layer scope is added, as the tile contexts are copied from this context
+  prepareTiles( layer, context );
+
   renderContext()->expressionContext() << QgsExpressionContextUtils::layerScope( layer );
 
   for ( const std::unique_ptr< QgsFeatureRenderer > &renderer : mRenderers )
@@ -157,6 +475,20 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
   prepareLabeling( layer, mAttrNames );
   prepareDiagrams( layer, mAttrNames );
 
+  if ( mCacheFeatures )
+  {
+    // the values of expression fields may depend on other layers, variables or the current time, so they can't be kept
+    const bool allAttributes = mAttrNames.contains( QgsFeatureRequest::ALL_ATTRIBUTES );
+    for ( int i = 0; i < mFields.count(); ++i )
+    {
+      if ( mFields.fieldOrigin( i ) == QgsFields::OriginExpression && ( allAttributes || mAttrNames.contains( mFields.at( i ).name() ) ) )
+      {
+        mCacheFeatures = false;
+        break;
+      }
+    }
+  }
+
   mClippingRegions = QgsMapClippingUtils::collectClippingRegionsForLayer( context, layer );
 
   for ( const std::unique_ptr< QgsFeatureRenderer > &renderer : mRenderers )
@@ -188,6 +520,11 @@ void QgsVectorLayerRenderer::setLayerRenderingTimeHint( int time )
   mRenderTimeHint = time;
 }
 
+void QgsVectorLayerRenderer::setMapRendererCache( QgsMapRendererCache *cache )
+{
+  mRendererCache = cache;
+}
+
 QgsFeedback *QgsVectorLayerRenderer::feedback() const
 {
   return mInterruptionChecker.get();
@@ -221,6 +558,22 @@ bool QgsVectorLayerRenderer::render()
     mElapsedTimer.start();
   }
 
+  if ( !mTiles.empty() )
+  {
+    QgsRenderContext &context = *renderContext();
+    // the render job may still have switched to a non raster destination or applied selective masking to this layer
+    // after the tiles were prepared. Mask painters and disabled symbol layers are set on the context after the tile contexts
+    // were copied from it, and the disabled symbol layers refer to the symbols of this renderer rather than the tiles' clones
+    if ( context.painter() && context.painter()->device() && context.painter()->device()->devType() == QInternal::Image
+         && !context.maskPainter() && context.disabledSymbolLayers().isEmpty() )
+    {
+      const bool res = renderTiles();
+      mReadyToCompose = true;
+      return res && !context.renderingStopped();
+    }
+    mTiles.clear();
+  }
+
   bool res = true;
   for ( const std::unique_ptr< QgsFeatureRenderer > &renderer : mRenderers )
   {
@@ -267,6 +620,22 @@ bool QgsVectorLayerRenderer::renderInternal( QgsFeatureRenderer *renderer )
 
   renderer->startRender( context, mFields );
 
+  // sub-pixel culling bypasses symbol rendering, so it can't be used when rendered feature handlers need to see every feature,
+  // or with renderers which don't draw each feature's symbol directly (e.g. inverted polygons or merged features)
+  const QString rendererType = renderer->type();
+  mCullSubPixelFeatures = context.testFlag( QgsRenderContext::CullSubPixelFeatures )
+                          && ( rendererType == QLatin1String( "singleSymbol" ) || rendererType == QLatin1String( "categorizedSymbol" )
+                               || rendererType == QLatin1String( "graduatedSymbol" ) || rendererType == QLatin1String( "RuleRenderer" ) )
+                          && ( mGeometryType == QgsWkbTypes::LineGeometry || mGeometryType == QgsWkbTypes::PolygonGeometry )
+                          && !context.hasRenderedFeatureHandlers()
+                          && context.painter()
+                          && context.mapToPixel().mapWidth() > 0 && context.mapToPixel().mapHeight() > 0;
+  // the colors of covered pixels are only known if features are painted over each other with plain alpha blending
+  mSubPixelCoverage.reset();
+  if ( mCullSubPixelFeatures && !usingEffect
+       && ( !context.useAdvancedEffects() || mFeatureBlendMode == QPainter::CompositionMode_SourceOver ) )
+    mSubPixelCoverage = std::make_unique< SubPixelCoverage >( context.mapToPixel().mapWidth(), context.mapToPixel().mapHeight() );
+
   QString rendererFilter = renderer->filter( mFields );
 
   QgsRectangle requestExtent = context.extent();
@@ -317,6 +686,12 @@ bool QgsVectorLayerRenderer::renderInternal( QgsFeatureRenderer *renderer )
     featureRequest.setFlags( featureRequest.flags() | QgsFeatureRequest::EmbeddedSymbols );
   }
 
+  if ( context.testFlag( QgsRenderContext::RenderDraftPreview ) )
+  {
+    // only a subset of the features is drawn, the full render which follows fills in the rest
+    featureRequest.setLimit( DRAFT_FEATURE_LIMIT );
+  }
+
   // enable the simplification of the geometries (Using the current map2pixel context) before send it to renderer engine.
   if ( mSimplifyGeometry )
   {
@@ -392,7 +767,31 @@ bool QgsVectorLayerRenderer::renderInternal( QgsFeatureRenderer *renderer )
     context.setVectorSimplifyMethod( vectorMethod );
   }
 
-  QgsFeatureIterator fit = mSource->getFeatures( featureRequest );
+  if ( mPointAggregationPyramid && drawPointAggregation( renderer, featureRequest ) )
+  {
+    if ( usingEffect )
+    {
+      renderer->paintEffect()->end( context );
+    }
+
+    mInterruptionChecker.reset();
+    return true;
+  }
+
+  std::shared_ptr< const QgsMapRendererCache::CachedFeatures > cached;
+  QgsFeatureIterator remainingFeatures;
+  if ( mCacheFeatures && mRendererCache && !( featureRequest.flags() & QgsFeatureRequest::EmbeddedSymbols ) )
+    cached = cachedFeatures( featureRequest, remainingFeatures );
+  if ( cached && context.vectorSimplifyMethod().simplifyHints() != QgsVectorSimplifyMethod::NoSimplification )
+  {
+    // cached features are stored unsimplified, so they must be simplified while drawing instead
+    QgsVectorSimplifyMethod vectorMethod = context.vectorSimplifyMethod();
+    vectorMethod.setForceLocalOptimization( true );
+    context.setVectorSimplifyMethod( vectorMethod );
+  }
+
+  QgsFeatureIterator fit = cached ? QgsFeatureIterator( new QgsRendererCacheFeatureIterator( cached, featureRequest, remainingFeatures ) )
+                           : mSource->getFeatures( featureRequest );
   // Attach an interruption checker so that iterators that have potentially
   // slow fetchFeature() implementations, such as in the WFS provider, can
   // check it, instead of relying on just the mContext.renderingStopped() check
@@ -460,7 +859,9 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureRenderer *renderer, QgsFeat
       bool drawMarker = isMainRenderer && ( mDrawVertexMarkers && context.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
 
       // render feature
-      bool rendered = renderer->renderFeature( fet, context, -1, sel, drawMarker );
+      bool rendered = false;
+      if ( !mCullSubPixelFeatures || drawMarker || !drawSubPixelFeature( fet, renderer, sel, rendered ) )
+        rendered = renderer->renderFeature( fet, context, -1, sel, drawMarker );
 
       // labeling - register feature
       if ( rendered )
@@ -520,6 +921,492 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureRenderer *renderer, QgsFeat
   stopRenderer( renderer, nullptr );
 }
 
+bool QgsVectorLayerRenderer::featurePixelBounds( const QgsFeature &feature, QRectF &bounds ) const
+{
+  const QgsRenderContext &context = *renderContext();
+
+  QgsRectangle mapBounds = feature.geometry().boundingBox();
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+  if ( ct.isValid() && !ct.isShortCircuited() )
+    mapBounds = ct.transformBoundingBox( mapBounds );
+
+  // map rotation means all four corners must be considered
+  const QgsMapToPixel &mtp = context.mapToPixel();
+  const QgsPointXY corners[4] =
+  {
+    mtp.transform( mapBounds.xMinimum(), mapBounds.yMinimum() ),
+    mtp.transform( mapBounds.xMaximum(), mapBounds.yMinimum() ),
+    mtp.transform( mapBounds.xMaximum(), mapBounds.yMaximum() ),
+    mtp.transform( mapBounds.xMinimum(), mapBounds.yMaximum() )
+  };
+  double xMin = std::numeric_limits< double >::max();
+  double yMin = std::numeric_limits< double >::max();
+  double xMax = std::numeric_limits< double >::lowest();
+  double yMax = std::numeric_limits< double >::lowest();
+  for ( const QgsPointXY &corner : corners )
+  {
+    xMin = std::min( xMin, corner.x() );
+    yMin = std::min( yMin, corner.y() );
+    xMax = std::max( xMax, corner.x() );
+    yMax = std::max( yMax, corner.y() );
+  }
+
+  if ( !std::isfinite( xMin ) || !std::isfinite( yMin ) || !std::isfinite( xMax ) || !std::isfinite( yMax ) )
+    return false;
+
+  bounds = QRectF( QPointF( xMin, yMin ), QPointF( xMax, yMax ) );
+  return true;
+}
+
+bool QgsVectorLayerRenderer::drawSubPixelFeature( const QgsFeature &feature, QgsFeatureRenderer *renderer, bool selected, bool &rendered )
+{
+  // features up to this size (in pixels) are skipped when every pixel they would draw is already covered by their color
+  constexpr double MAX_OVERDRAWN_FEATURE_SIZE = 16;
+
+  QgsRenderContext &context = *renderContext();
+  const QgsMapToPixel &mtp = context.mapToPixel();
+
+  QRectF bounds;
+  if ( !featurePixelBounds( feature, bounds ) )
+  {
+    // no idea where the feature will be drawn
+    if ( mSubPixelCoverage )
+      mSubPixelCoverage->invalidate( QRect( 0, 0, mtp.mapWidth(), mtp.mapHeight() ) );
+    return false;
+  }
+
+  const QgsSymbolList symbols = renderer->symbolsForFeature( feature, context );
+  if ( symbols.isEmpty() )
+  {
+    // the renderer would not have drawn this feature either
+    rendered = false;
+    return true;
+  }
+
+  // features drawn with several symbols (e.g. matching several rules) are always rendered normally
+  if ( symbols.size() == 1 )
+  {
+    QgsSymbol *symbol = symbols.at( 0 );
+    bool singleColor = false;
+    const QColor symbolColor = subPixelFeatureColor( symbol, &singleColor );
+
+    if ( symbolColor.isValid() && bounds.width() < 1 && bounds.height() < 1 )
+    {
+      rendered = true;
+
+      const int pixelX = static_cast< int >( std::floor( bounds.center().x() ) );
+      const int pixelY = static_cast< int >( std::floor( bounds.center().y() ) );
+      if ( pixelX < 0 || pixelY < 0 || pixelX >= mtp.mapWidth() || pixelY >= mtp.mapHeight() )
+        return true;
+
+      const QColor color = selected ? context.selectionColor() : symbolColor;
+      QColor dotColor = color;
+      dotColor.setAlphaF( color.alphaF() * symbol->opacity() );
+
+      // an earlier feature already covers this pixel with the same color, so another dot would make no visible difference
+      if ( mSubPixelCoverage && mSubPixelCoverage->color( pixelX, pixelY ) == dotColor.rgba() )
+        return true;
+
+      context.painter()->fillRect( QRectF( pixelX, pixelY, 1, 1 ), dotColor );
+      if ( mSubPixelCoverage )
+        mSubPixelCoverage->setColor( pixelX, pixelY, dotColor.alpha() == 255 ? dotColor.rgba() : 0 );
+      return true;
+    }
+
+    if ( mSubPixelCoverage && !selected && singleColor && symbolColor.alpha() == 255 && symbol->opacity() == 1
+         && bounds.width() <= MAX_OVERDRAWN_FEATURE_SIZE && bounds.height() <= MAX_OVERDRAWN_FEATURE_SIZE )
+    {
+      // an antialiased feature may touch every pixel within its symbol bleed, plus one
+      const double bleed = QgsSymbolLayerUtils::estimateMaxSymbolBleed( symbol, context ) + 1;
+      const QRectF drawnBounds = bounds.adjusted( -bleed, -bleed, bleed, bleed );
+      const QRect drawnPixels( QPoint( static_cast< int >( std::floor( drawnBounds.left() ) ), static_cast< int >( std::floor( drawnBounds.top() ) ) ),
+                               QPoint( static_cast< int >( std::floor( drawnBounds.right() ) ), static_cast< int >( std::floor( drawnBounds.bottom() ) ) ) );
+      if ( mSubPixelCoverage->isCovered( drawnPixels, symbolColor.rgba() ) )
+      {
+        // the feature is fully overdrawn by earlier features of the same color
+        rendered = true;
+        return true;
+      }
+    }
+  }
+
+  if ( mSubPixelCoverage )
+  {
+    // the feature will be rendered normally, so the colors of the pixels it draws over are no longer known
+    double bleed = 0;
+    for ( QgsSymbol *symbol : symbols )
+      bleed = std::max( bleed, QgsSymbolLayerUtils::estimateMaxSymbolBleed( symbol, context ) );
+    bleed += 1;
+    const QRectF drawnBounds = bounds.adjusted( -bleed, -bleed, bleed, bleed ).intersected( QRectF( 0, 0, mtp.mapWidth(), mtp.mapHeight() ) );
+    if ( !drawnBounds.isEmpty() )
+      mSubPixelCoverage->invalidate( QRect( QPoint( static_cast< int >( std::floor( drawnBounds.left() ) ), static_cast< int >( std::floor( drawnBounds.top() ) ) ),
+                                            QPoint( static_cast< int >( std::floor( drawnBounds.right() ) ), static_cast< int >( std::floor( drawnBounds.bottom() ) ) ) ) );
+  }
+  return false;
+}
+
+void QgsVectorLayerRenderer::prepareTiles( QgsVectorLayer *layer, QgsRenderContext &context )
+{
+  if ( !context.testFlag( QgsRenderContext::RenderVectorLayersInTiles )
+       || mGeometryType == QgsWkbTypes::NullGeometry || mGeometryType == QgsWkbTypes::UnknownGeometry
+       || mRenderers.empty() || context.hasRenderedFeatureHandlers()
+       || !QgsMapClippingUtils::collectClippingRegionsForLayer( context, layer ).empty() )
+    return;
+
+  // tiles are drawn into transparent images and composited afterwards, so features would no longer blend with the layers beneath
+  if ( layer->featureBlendMode() != QPainter::CompositionMode_SourceOver )
+    return;
+
+  // separate tile images can only be composited onto a raster destination. Layers without a painter yet are given an image by the render job
+  if ( context.painter() && context.painter()->device() && context.painter()->device()->devType() != QInternal::Image )
+    return;
+
+  // layers which mask other layers are also drawn into a mask painter, which the tiles don't support
+  if ( !QgsVectorLayerUtils::symbolLayerMasks( layer ).isEmpty() || !QgsVectorLayerUtils::labelMasks( layer ).isEmpty() )
+    return;
+
+  for ( const std::unique_ptr< QgsFeatureRenderer > &renderer : mRenderers )
+  {
+    // renderers which aggregate or displace features depend on all features at once, and effects such as
+    // blurs and shadows would show seams at the tile edges
+    const QString type = renderer->type();
+    if ( ( type != QLatin1String( "singleSymbol" ) && type != QLatin1String( "categorizedSymbol" )
+           && type != QLatin1String( "graduatedSymbol" ) && type != QLatin1String( "RuleRenderer" ) )
+         || ( renderer->paintEffect() && renderer->paintEffect()->enabled() ) )
+      return;
+  }
+
+  const QgsMapToPixel &mtp = context.mapToPixel();
+  const int width = mtp.mapWidth();
+  const int height = mtp.mapHeight();
+  const int tileCount = std::min( std::min( QThread::idealThreadCount(), MAX_RENDER_TILES ), height / MIN_RENDER_TILE_HEIGHT );
+  if ( tileCount < 2 || width <= 0 )
+    return;
+
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+  std::vector< std::unique_ptr< RenderTile > > tiles;
+  try
+  {
+    for ( int i = 0; i < tileCount; ++i )
+    {
+      const int top = height * i / tileCount;
+      const int bottom = height * ( i + 1 ) / tileCount;
+
+      // map rotation means all four corners must be considered
+      const QgsPointXY corners[4] =
+      {
+        mtp.toMapCoordinates( 0.0, static_cast< double >( top - RENDER_TILE_MARGIN ) ),
+        mtp.toMapCoordinates( static_cast< double >( width ), static_cast< double >( top - RENDER_TILE_MARGIN ) ),
+        mtp.toMapCoordinates( static_cast< double >( width ), static_cast< double >( bottom + RENDER_TILE_MARGIN ) ),
+        mtp.toMapCoordinates( 0.0, static_cast< double >( bottom + RENDER_TILE_MARGIN ) )
+      };
+      QgsRectangle mapExtent( corners[0], corners[1] );
+      mapExtent.combineExtentWith( corners[2] );
+      mapExtent.combineExtentWith( corners[3] );
+
+      QgsRectangle layerExtent = mapExtent;
+      if ( ct.isValid() && !ct.isShortCircuited() )
+        layerExtent = ct.transformBoundingBox( mapExtent, QgsCoordinateTransform::ReverseTransform );
+      layerExtent = layerExtent.intersect( context.extent() );
+      if ( layerExtent.isEmpty() )
+        continue; // nothing from the layer can be visible in this tile
+
+      std::unique_ptr< RenderTile > tile = std::make_unique< RenderTile >();
+      tile->pixelRect = QRect( 0, top, width, bottom - top );
+      tile->context = std::make_unique< QgsRenderContext >( context );
+      tile->context->setFlag( QgsRenderContext::RenderVectorLayersInTiles, false );
+      tile->context->setExtent( layerExtent );
+      tile->context->setMapExtent( mapExtent );
+      tile->context->setPainter( nullptr );
+      // labels and diagrams are registered by this renderer, so that features shared by several tiles are only labeled once
+      tile->context->setLabelingEngine( nullptr );
+      tile->renderer = std::make_unique< QgsVectorLayerRenderer >( layer, *tile->context );
+      tiles.emplace_back( std::move( tile ) );
+    }
+  }
+  catch ( QgsCsException & )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Could not transform tile extents, rendering layer %1 in one piece" ).arg( layer->id() ), 2 );
+    return;
+  }
+
+  mTiles = std::move( tiles );
+}
+
+bool QgsVectorLayerRenderer::renderTiles()
+{
+  QgsRenderContext &context = *renderContext();
+  QPainter *painter = context.painter();
+  const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
+
+  // QPainter only allows one painter per device, so every tile is drawn into an image of its own
+  QList< QFuture< bool > > futures;
+  for ( const std::unique_ptr< RenderTile > &tile : mTiles )
+  {
+    RenderTile *t = tile.get();
+    t->image = QImage( t->pixelRect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied );
+    t->image.setDevicePixelRatio( devicePixelRatio );
+    t->image.fill( Qt::transparent );
+    futures << QtConcurrent::run( sRenderTilePool(), [t]
+    {
+      QPainter tilePainter( &t->image );
+      t->context->setPainterFlagsUsingContext( &tilePainter );
+      tilePainter.translate( 0, -t->pixelRect.top() );
+      t->context->setPainter( &tilePainter );
+      const bool res = t->renderer->render();
+      t->context->setPainter( nullptr );
+      return res;
+    } );
+  }
+
+  // tile contexts are copies, so cancellation of the layer job has to be forwarded to them. Jobs cancel layers
+  // through their feedback object, so it's created before checking whether the render was already stopped
+  mInterruptionChecker = std::make_unique< QgsVectorLayerRendererInterruptionChecker >( context );
+  auto stopTiles = [this]
+  {
+    for ( const std::unique_ptr< RenderTile > &tile : mTiles )
+      tile->context->setRenderingStopped( true );
+  };
+  QObject::connect( mInterruptionChecker.get(), &QgsFeedback::canceled, mInterruptionChecker.get(), stopTiles, Qt::DirectConnection );
+  if ( context.renderingStopped() )
+    stopTiles();
+
+  if ( mLabelProvider || mDiagramProvider )
+    registerLabelFeatures();
+
+  bool res = true;
+  for ( QFuture< bool > &future : futures )
+  {
+    future.waitForFinished();
+    res = future.result() && res;
+  }
+  mInterruptionChecker.reset();
+
+  // tiles do not overlap, so compositing them in any order preserves symbol levels and feature blending within each tile
+  QgsScopedQPainterState painterState( painter );
+  painter->setCompositionMode( QPainter::CompositionMode_SourceOver );
+  for ( const std::unique_ptr< RenderTile > &tile : mTiles )
+  {
+    painter->drawImage( QPointF( 0, tile->pixelRect.top() ), tile->image );
+    tile->image = QImage();
+    mErrors.append( tile->renderer->errors() );
+  }
+
+  return res;
+}
+
+void QgsVectorLayerRenderer::registerLabelFeatures()
+{
+  QgsRenderContext &context = *renderContext();
+  if ( !context.labelingEngine() )
+    return;
+
+  mRenderer->startRender( context, mFields );
+
+  QgsFeatureRequest featureRequest = QgsFeatureRequest()
+                                     .setFilterRect( context.extent() )
+                                     .setSubsetOfAttributes( mAttrNames, mFields )
+                                     .setExpressionContext( context.expressionContext() );
+  if ( const QgsFeatureFilterProvider *featureFilterProvider = context.featureFilterProvider() )
+  {
+    featureFilterProvider->filterFeatures( mLayer, featureRequest );
+  }
+  const QString rendererFilter = mRenderer->filter( mFields );
+  if ( !rendererFilter.isEmpty() && rendererFilter != QLatin1String( "TRUE" ) )
+  {
+    featureRequest.combineFilterExpression( rendererFilter );
+  }
+  if ( !mTemporalFilter.isEmpty() )
+  {
+    featureRequest.combineFilterExpression( mTemporalFilter );
+  }
+  if ( mRenderer->usesEmbeddedSymbols() )
+  {
+    featureRequest.setFlags( featureRequest.flags() | QgsFeatureRequest::EmbeddedSymbols );
+  }
+
+  QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+  context.expressionContext().appendScope( symbolScope );
+
+  QgsFeatureIterator fit = mSource->getFeatures( featureRequest );
+  fit.setInterruptionChecker( mInterruptionChecker.get() );
+  QgsFeature fet;
+  while ( fit.nextFeature( fet ) )
+  {
+    try
+    {
+      if ( context.renderingStopped() )
+        break;
+
+      if ( !fet.hasGeometry() || fet.geometry().isEmpty() )
+        continue;
+
+      context.expressionContext().setFeature( fet );
+      if ( !mRenderer->willRenderFeature( fet, context ) )
+        continue;
+
+      QgsGeometry obstacleGeometry;
+      QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, context );
+      QgsSymbol *symbol = nullptr;
+      if ( !symbols.isEmpty() && fet.geometry().type() == QgsWkbTypes::PointGeometry )
+      {
+        obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( fet, context, symbols );
+      }
+
+      if ( !symbols.isEmpty() )
+      {
+        symbol = symbols.at( 0 );
+        QgsExpressionContextUtils::updateSymbolScope( symbol, symbolScope );
+      }
+
+      if ( mLabelProvider )
+      {
+        mLabelProvider->registerFeature( fet, context, obstacleGeometry, symbol );
+      }
+      if ( mDiagramProvider )
+      {
+        mDiagramProvider->registerFeature( fet, context, obstacleGeometry );
+      }
+    }
+    catch ( const QgsCsException &cse )
+    {
+      Q_UNUSED( cse )
+      QgsDebugMsg( QStringLiteral( "Failed to transform a point while labeling a feature with ID '%1'. Ignoring this feature. %2" )
+                   .arg( fet.id() ).arg( cse.what() ) );
+    }
+  }
+
+  delete context.expressionContext().popScope();
+
+  mRenderer->stopRender( context );
+}
+
+std::shared_ptr< const QgsMapRendererCache::CachedFeatures > QgsVectorLayerRenderer::cachedFeatures( const QgsFeatureRequest &request, QgsFeatureIterator &remainingFeatures )
+{
+  if ( request.filterRect().isNull() )
+    return nullptr;
+
+  std::shared_ptr< const QgsMapRendererCache::CachedFeatures > cached = mRendererCache->cacheFeatures( layerId() );
+  if ( cached && cached->subsetString == mSubsetString && cached->fields == mFields )
+  {
+    if ( !cached->exceedsMemoryBudget )
+    {
+      if ( cached->attributes.contains( mAttrNames ) && cached->extent.contains( request.filterRect() ) )
+        return cached;
+    }
+    else if ( request.filterRect().contains( cached->extent ) && mAttrNames.contains( cached->attributes ) )
+    {
+      // a request covering at least as much as one which already exceeded the memory budget would exceed it too
+      return nullptr;
+    }
+  }
+
+  // only the extent and attributes are applied when fetching, so that the same features can be reused
+  // by later renders with other filters, styles or scales
+  std::shared_ptr< QgsMapRendererCache::CachedFeatures > fetched = std::make_shared< QgsMapRendererCache::CachedFeatures >();
+  fetched->extent = request.filterRect();
+  fetched->attributes = mAttrNames;
+  fetched->subsetString = mSubsetString;
+  fetched->fields = mFields;
+
+  QgsFeatureIterator it = mSource->getFeatures( QgsFeatureRequest()
+                          .setFilterRect( request.filterRect() )
+                          .setSubsetOfAttributes( mAttrNames, mFields ) );
+  it.setInterruptionChecker( mInterruptionChecker.get() );
+  const qint64 maximumMemory = mRendererCache->maximumFeatureMemory();
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    if ( renderContext()->renderingStopped() )
+      return nullptr;
+
+    fetched->features.append( f );
+    fetched->memoryUsage += estimatedFeatureMemory( f );
+    if ( fetched->memoryUsage > maximumMemory )
+    {
+      // the features don't fit in the cache's memory budget, so remember that instead of reading them again on
+      // every render, and render the features read so far followed by the rest of the source
+      std::shared_ptr< QgsMapRendererCache::CachedFeatures > exceeded = std::make_shared< QgsMapRendererCache::CachedFeatures >();
+      exceeded->extent = fetched->extent;
+      exceeded->attributes = fetched->attributes;
+      exceeded->subsetString = fetched->subsetString;
+      exceeded->fields = fetched->fields;
+      exceeded->exceedsMemoryBudget = true;
+      mRendererCache->setCacheFeatures( layerId(), exceeded, mLayer, mCacheDependentLayers );
+
+      remainingFeatures = it;
+      return fetched;
+    }
+  }
+  if ( !it.isValid() )
+    return nullptr;
+
+  if ( !mRendererCache->setCacheFeatures( layerId(), fetched, mLayer, mCacheDependentLayers ) )
+    return nullptr;
+  return fetched;
+}
+
+bool QgsVectorLayerRenderer::drawPointAggregation( QgsFeatureRenderer *renderer, const QgsFeatureRequest &request )
+{
+  QgsRenderContext &context = *renderContext();
+
+  // bins only carry a location and a count, so they can only stand in for the features when every
+  // feature would be drawn with the same static symbol and nothing else needs the individual features
+  if ( renderer->type() != QLatin1String( "singleSymbol" ) || renderer != mRenderer
+       || !mSelectedFeatureIds.isEmpty() || mLabelProvider || mDiagramProvider || mDrawVertexMarkers
+       || !mClippingRegions.empty() || context.hasRenderedFeatureHandlers()
+       || request.filterType() != QgsFeatureRequest::FilterNone || !request.orderBy().isEmpty()
+       || !context.painter() || context.mapToPixel().mapWidth() <= 0 )
+    return false;
+
+  QgsMarkerSymbol *symbol = dynamic_cast< QgsMarkerSymbol * >( static_cast< QgsSingleSymbolRenderer * >( renderer )->symbol() );
+  if ( !symbol || symbol->hasDataDefinedProperties() )
+    return false;
+
+  // the coarsest level which still resolves individual pixels
+  const double layerUnitsPerPixel = context.extent().width() / context.mapToPixel().mapWidth();
+  QVector< QgsPointAggregationPyramid::Bin > bins;
+  if ( !mPointAggregationPyramid->bins( request.filterRect(), layerUnitsPerPixel, bins ) )
+    return false;
+
+  QgsDebugMsgLevel( QStringLiteral( "Drawing %1 aggregated bins for layer %2" ).arg( bins.size() ).arg( layerId() ), 2 );
+
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+  const QgsMapToPixel &mtp = context.mapToPixel();
+  int count = 0;
+  for ( const QgsPointAggregationPyramid::Bin &bin : std::as_const( bins ) )
+  {
+    if ( ( ++count % 1000 ) == 0 && context.renderingStopped() )
+      break;
+
+    double x = bin.x;
+    double y = bin.y;
+    double z = 0;
+    if ( ct.isValid() )
+    {
+      try
+      {
+        ct.transformInPlace( x, y, z );
+      }
+      catch ( QgsCsException & )
+      {
+        continue;
+      }
+    }
+    mtp.transformInPlace( x, y );
+    if ( !std::isfinite( x ) || !std::isfinite( y ) )
+      continue;
+
+    symbol->renderPoint( QPointF( x, y ), nullptr, context );
+  }
+
+  if ( !mBlockRenderUpdates || mElapsedTimer.elapsed() > MAX_TIME_TO_USE_CACHED_PREVIEW_IMAGE )
+    mReadyToCompose = true;
+
+  stopRenderer( renderer, nullptr );
+  return true;
+}
+
 void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureRenderer *renderer, QgsFeatureIterator &fit )
 {
   const bool isMainRenderer = renderer == mRenderer;
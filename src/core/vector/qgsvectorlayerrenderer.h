@@ -27,12 +27,16 @@ class QgsDiagramLayerSettings;
 class QgsFeatureIterator;
 class QgsSingleSymbolRenderer;
 class QgsMapClippingRegion;
+class QgsPointAggregationPyramid;
+class QgsFeatureRequest;
+class QgsMapRendererCache;
 
 #define SIP_NO_FILE
 
 #include <QList>
 #include <QPainter>
 #include <QElapsedTimer>
+#include <memory>
 
 typedef QList<int> QgsAttributeList;
 
@@ -44,6 +48,7 @@ typedef QList<int> QgsAttributeList;
 #include "qgsfeatureid.h"
 
 #include "qgsmaplayerrenderer.h"
+#include "qgsmaprenderercache.h"
 
 class QgsVectorLayerLabelProvider;
 class QgsVectorLayerDiagramProvider;
@@ -91,6 +96,7 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     bool render() override;
 
     void setLayerRenderingTimeHint( int time ) override;
+    void setMapRendererCache( QgsMapRendererCache *cache ) override;
 
   private:
 
@@ -115,6 +121,65 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsFeatureRenderer *renderer, QgsSingleSymbolRenderer *selRenderer );
 
+    /**
+     * Calculates the \a bounds of \a feature in map pixels. Returns FALSE if the bounds could not be calculated.
+     */
+    bool featurePixelBounds( const QgsFeature &feature, QRectF &bounds ) const;
+
+    /**
+     * Draws \a feature as a single dot if it covers less than a pixel in the rendered map,
+     * or skips it if every pixel it would draw is already covered by its color, when the
+     * QgsRenderContext::CullSubPixelFeatures flag is set.
+     *
+     * Returns TRUE if the feature was handled (either drawn as a dot, or skipped because
+     * it would make no visible difference), or FALSE if it must be rendered normally. The
+     * \a rendered argument is set to TRUE if the feature has a symbol and counts as rendered.
+     */
+    bool drawSubPixelFeature( const QgsFeature &feature, QgsFeatureRenderer *renderer, bool selected, bool &rendered );
+
+    /**
+     * Draws the aggregated bins of the layer's point aggregation pyramid in place of the individual
+     * point features, if the \a renderer and the current map scale allow it.
+     *
+     * Returns FALSE if the individual features must be rendered instead.
+     */
+    bool drawPointAggregation( QgsFeatureRenderer *renderer, const QgsFeatureRequest &request );
+
+    /**
+     * Prepares a child renderer for each horizontal tile of the map, when the
+     * QgsRenderContext::RenderVectorLayersInTiles flag is set and the layer can be safely split.
+     *
+     * All conditions which are known when the renderer is created are checked before any child
+     * renderer is built. Must be called in the main thread, as the child renderers take a snapshot
+     * of the layer, so they can't be built later from render().
+     */
+    void prepareTiles( QgsVectorLayer *layer, QgsRenderContext &context );
+
+    /**
+     * Renders the prepared tiles in parallel and composites them onto the layer's painter, while
+     * features are registered with the labeling engine in the calling thread.
+     */
+    bool renderTiles();
+
+    /**
+     * Registers all features which would be rendered with the labeling and diagram providers,
+     * without drawing them.
+     */
+    void registerLabelFeatures();
+
+    /**
+     * Returns the features cached in the map renderer cache which cover the filter extent and
+     * attributes of the \a request, fetching them from the layer's source and storing them in
+     * the cache if required.
+     *
+     * If the features exceed the memory budget of the cache while fetching, the features fetched
+     * so far are returned without being stored, and \a remainingFeatures is set to the iterator
+     * which continues the read.
+     *
+     * Returns NULLPTR if the features could not be cached, in which case they must be read
+     * from the source directly.
+     */
+    std::shared_ptr< const QgsMapRendererCache::CachedFeatures > cachedFeatures( const QgsFeatureRequest &request, QgsFeatureIterator &remainingFeatures );
 
     bool renderInternal( QgsFeatureRenderer *renderer );
   protected:
@@ -175,6 +240,27 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     bool mApplyLabelClipGeometries = false;
     bool mForceRasterRender = false;
 
+    //! Aggregation pyramid for point layers with a pyramid sidecar, may be NULLPTR
+    std::shared_ptr< const QgsPointAggregationPyramid > mPointAggregationPyramid;
+
+    //! TRUE if sub-pixel features should be collapsed to single dots
+    bool mCullSubPixelFeatures = false;
+    struct SubPixelCoverage;
+    //! Colors of the map pixels covered by previously drawn features, NULLPTR if unknown
+    std::unique_ptr< SubPixelCoverage > mSubPixelCoverage;
+
+    struct RenderTile;
+    //! Child renderers for parallel tiled rendering, empty if the layer is rendered in one piece
+    std::vector< std::unique_ptr< RenderTile > > mTiles;
+
+    //! Cache of the map render job, may be NULLPTR
+    QgsMapRendererCache *mRendererCache = nullptr;
+    //! TRUE if features should be kept in the map renderer cache
+    bool mCacheFeatures = false;
+    QString mSubsetString;
+    //! Layers from which the cached features take attributes, such as joined layers
+    QList< QgsMapLayer * > mCacheDependentLayers;
+
     int mRenderTimeHint = 0;
     bool mBlockRenderUpdates = false;
     QElapsedTimer mElapsedTimer;
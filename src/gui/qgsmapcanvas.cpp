@@ -267,6 +267,12 @@ QgsMapCanvas::~QgsMapCanvas()
     delete mJob;
   }
 
+  if ( mDraftJob )
+  {
+    whileBlocking( mDraftJob )->cancel();
+    delete mDraftJob;
+  }
+
   QList< QgsMapRendererQImageJob * >::const_iterator previewJob = mPreviewJobs.constBegin();
   for ( ; previewJob != mPreviewJobs.constEnd(); ++previewJob )
   {
@@ -618,6 +624,9 @@ void QgsMapCanvas::refreshMap()
   allLayers.insert( 0, QgsProject::instance()->mainAnnotationLayer() );
   renderSettings.setLayers( allLayers );
 
+  if ( mUseProgressiveRendering )
+    startDraftJob( renderSettings );
+
   // create the renderer job
   Q_ASSERT( !mJob );
   mJobCanceled = false;
@@ -682,6 +691,10 @@ void QgsMapCanvas::rendererJobFinished()
 
   mMapUpdateTimer.stop();
 
+  // the full render supersedes any draft
+  stopDraftJob();
+  mShowingDraft = false;
+
   // TODO: would be better to show the errors in message bar
   const auto constErrors = mJob->errors();
   for ( const QgsMapRendererJob::Error &error : constErrors )
@@ -763,6 +776,25 @@ void QgsMapCanvas::rendererJobFinished()
   }
 }
 
+void QgsMapCanvas::draftJobFinished()
+{
+  QgsMapRendererQImageJob *job = mDraftJob;
+  mDraftJob = nullptr;
+  if ( !job )
+    return;
+
+  // only show the draft if the full render is still running
+  if ( mJob )
+  {
+    const QImage img = job->renderedImage();
+    mMap->setContent( img, imageRect( img, mSettings ) );
+    mShowingDraft = true;
+  }
+
+  // now we are in a slot called from the job - do not delete it immediately
+  job->deleteLater();
+}
+
 void QgsMapCanvas::previewJobFinished()
 {
   QgsMapRendererQImageJob *job = qobject_cast<QgsMapRendererQImageJob *>( sender() );
@@ -811,6 +843,16 @@ void QgsMapCanvas::setPreviewJobsEnabled( bool enabled )
   mUsePreviewJobs = enabled;
 }
 
+bool QgsMapCanvas::progressiveRenderingEnabled() const
+{
+  return mUseProgressiveRendering;
+}
+
+void QgsMapCanvas::setProgressiveRenderingEnabled( bool enabled )
+{
+  mUseProgressiveRendering = enabled;
+}
+
 void QgsMapCanvas::setCustomDropHandlers( const QVector<QPointer<QgsCustomDropHandler> > &handlers )
 {
   mDropHandlers = handlers;
@@ -1010,7 +1052,7 @@ bool QgsMapCanvas::allowInteraction( QgsMapCanvasInteractionBlocker::Interaction
 
 void QgsMapCanvas::mapUpdateTimeout()
 {
-  if ( mJob )
+  if ( mJob && !mShowingDraft )
   {
     const QImage &img = mJob->renderedImage();
     mMap->setContent( img, imageRect( img, mSettings ) );
@@ -1029,6 +1071,8 @@ void QgsMapCanvas::stopRendering()
     mJob = nullptr;
     emit mapRefreshCanceled();
   }
+  stopDraftJob();
+  mShowingDraft = false;
   stopPreviewJobs();
 }
 
@@ -2980,6 +3024,46 @@ void QgsMapCanvas::stopPreviewJobs()
   mPreviewJobs.clear();
 }
 
+void QgsMapCanvas::startDraftJob( const QgsMapSettings &settings )
+{
+  // a draft is only worth it if some layer is slow to render, e.g. a large table in a remote database
+  bool hasSlowLayer = false;
+  const QList<QgsMapLayer *> layers = settings.layers();
+  for ( QgsMapLayer *layer : layers )
+  {
+    if ( layer && layer->type() == QgsMapLayerType::VectorLayer && mLastLayerRenderTime.value( layer->id(), MINIMUM_LAYER_DRAFT_TIME_MS ) >= MINIMUM_LAYER_DRAFT_TIME_MS )
+    {
+      hasSlowLayer = true;
+      break;
+    }
+  }
+  if ( !hasSlowLayer )
+    return;
+
+  QgsMapSettings draftSettings = settings;
+  draftSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  draftSettings.setFlag( QgsMapSettings::RenderDraftPreview, true );
+
+  // no cache: draft renders must never be reused in place of full quality renders
+  if ( mUseParallelRendering )
+    mDraftJob = new QgsMapRendererParallelJob( draftSettings );
+  else
+    mDraftJob = new QgsMapRendererSequentialJob( draftSettings );
+  connect( mDraftJob, &QgsMapRendererJob::finished, this, &QgsMapCanvas::draftJobFinished );
+  mDraftJob->start();
+}
+
+void QgsMapCanvas::stopDraftJob()
+{
+  if ( mDraftJob )
+  {
+    disconnect( mDraftJob, &QgsMapRendererJob::finished, this, &QgsMapCanvas::draftJobFinished );
+    connect( mDraftJob, &QgsMapRendererQImageJob::finished, mDraftJob, &QgsMapRendererQImageJob::deleteLater );
+    mDraftJob->cancelWithoutBlocking();
+    mDraftJob = nullptr;
+  }
+}
+
 void QgsMapCanvas::schedulePreviewJob( int number )
 {
   mPreviewTimer.setSingleShot( true );
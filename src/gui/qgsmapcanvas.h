@@ -769,6 +769,30 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
      */
     void setPreviewJobsEnabled( bool enabled );
 
+    /**
+     * Returns TRUE if progressive rendering is enabled for the canvas.
+     *
+     * When enabled, refreshes which involve slow layers (or layers which have not been rendered
+     * before) start with a fast, low quality draft render (see QgsMapSettings::RenderDraftPreview),
+     * which is shown until the full quality render completes.
+     *
+     * \see setProgressiveRenderingEnabled()
+     * \since QGIS 3.20
+     */
+    bool progressiveRenderingEnabled() const;
+
+    /**
+     * Sets whether progressive rendering is \a enabled for the canvas.
+     *
+     * When enabled, refreshes which involve slow layers (or layers which have not been rendered
+     * before) start with a fast, low quality draft render (see QgsMapSettings::RenderDraftPreview),
+     * which is shown until the full quality render completes.
+     *
+     * \see progressiveRenderingEnabled()
+     * \since QGIS 3.20
+     */
+    void setProgressiveRenderingEnabled( bool enabled );
+
     /**
      * Sets a list of custom drop \a handlers to use when drop events occur on the canvas.
      * \note Not available in Python bindings
@@ -971,6 +995,9 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
     //! called when a preview job has been finished
     void previewJobFinished();
 
+    //! called when the draft render job of a progressive refresh has finished
+    void draftJobFinished();
+
     void mapUpdateTimeout();
 
     void refreshMap();
@@ -1344,6 +1371,14 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
 
     bool mUsePreviewJobs = false;
 
+    bool mUseProgressiveRendering = false;
+
+    //! Draft render job of a progressive refresh, running alongside mJob
+    QgsMapRendererQImageJob *mDraftJob = nullptr;
+
+    //! TRUE if the canvas currently shows the draft render, which partial updates of mJob must not replace
+    bool mShowingDraft = false;
+
     QHash< QString, int > mLastLayerRenderTime;
 
     QVector<QPointer<QgsCustomDropHandler >> mDropHandlers;
@@ -1403,6 +1438,13 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
 
     void startPreviewJobs();
     void stopPreviewJobs();
+
+    /**
+     * Starts a draft render for the specified \a settings, if any of their layers
+     * was slow to render last time.
+     */
+    void startDraftJob( const QgsMapSettings &settings );
+    void stopDraftJob();
     void schedulePreviewJob( int number );
 
     /**
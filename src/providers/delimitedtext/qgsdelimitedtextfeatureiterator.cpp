@@ -22,6 +22,7 @@
 #include "qgsmessagelog.h"
 #include "qgsproject.h"
 #include "qgsspatialindex.h"
+#include "qgsspatialindexpackedrtree.h"
 #include "qgsexception.h"
 #include "qgsexpressioncontextutils.h"
 
@@ -85,7 +86,7 @@ QgsDelimitedTextFeatureIterator::QgsDelimitedTextFeatureIterator( QgsDelimitedTe
 
     else if ( mSource->mUseSpatialIndex )
     {
-      mFeatureIds = mSource->mSpatialIndex->intersects( mFilterRect );
+      mFeatureIds = mSource->mSidecarIndex ? mSource->mSidecarIndex->intersects( mFilterRect ) : mSource->mSpatialIndex->intersects( mFilterRect );
       // Sort for efficient sequential retrieval
       std::sort( mFeatureIds.begin(), mFeatureIds.end() );
       QgsDebugMsgLevel( QStringLiteral( "Layer has spatial index - selected %1 features from index" ).arg( mFeatureIds.size() ), 4 );
@@ -394,6 +395,15 @@ bool QgsDelimitedTextFeatureIterator::nextFeatureInternal( QgsFeature &feature )
 
 bool QgsDelimitedTextFeatureIterator::setNextFeatureId( qint64 fid )
 {
+  // records with a known offset can be read without scanning the file up to them
+  const QVector< QPair< QgsFeatureId, qint64 > > &offsets = mSource->mRecordOffsets;
+  const auto offset = std::lower_bound( offsets.constBegin(), offsets.constEnd(), fid, []( const QPair< QgsFeatureId, qint64 > &entry, qint64 id )
+  {
+    return entry.first < id;
+  } );
+  if ( offset != offsets.constEnd() && offset->first == fid )
+    return mSource->mFile->setNextRecordId( ( long ) fid, offset->second );
+
   return mSource->mFile->setNextRecordId( ( long ) fid );
 }
 
@@ -532,6 +542,8 @@ QgsDelimitedTextFeatureSource::QgsDelimitedTextFeatureSource( const QgsDelimited
   , mExtent( p->mExtent )
   , mUseSpatialIndex( p->mUseSpatialIndex )
   , mSpatialIndex( p->mSpatialIndex ? new QgsSpatialIndex( *p->mSpatialIndex ) : nullptr )
+  , mSidecarIndex( p->mSidecarIndex ? new QgsSpatialIndexPackedRTree( *p->mSidecarIndex ) : nullptr )
+  , mRecordOffsets( p->mRecordOffsets )
   , mUseSubsetIndex( p->mUseSubsetIndex )
   , mSubsetIndex( p->mSubsetIndex )
   , mFile( nullptr )
@@ -36,6 +36,8 @@ class QgsDelimitedTextFeatureSource final: public QgsAbstractFeatureSource
     QgsRectangle mExtent;
     bool mUseSpatialIndex;
     std::unique_ptr< QgsSpatialIndex > mSpatialIndex;
+    std::unique_ptr< QgsSpatialIndexPackedRTree > mSidecarIndex;
+    QVector< QPair< QgsFeatureId, qint64 > > mRecordOffsets;
     bool mUseSubsetIndex;
     QList<quintptr> mSubsetIndex;
     std::unique_ptr< QgsDelimitedTextFile > mFile;
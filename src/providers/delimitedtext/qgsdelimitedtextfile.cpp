@@ -44,6 +44,7 @@ QgsDelimitedTextFile::QgsDelimitedTextFile( const QString &url )
   // For tests
   QString bufferSizeStr( getenv( "QGIS_DELIMITED_TEXT_FILE_BUFFER_SIZE" ) );
   mMaxBufferSize = bufferSizeStr.isEmpty() ? 10 * 1024 * 1024 : bufferSizeStr.toInt();
+  mReadSize = mMaxBufferSize;
 }
 
 
@@ -74,6 +75,9 @@ void QgsDelimitedTextFile::close()
   mRecordNumber = -1;
   mMaxRecordNumber = -1;
   mHoldCurrentRecord = false;
+  mNextLineOffset = -1;
+  mRecordOffset = -1;
+  mEncoder.reset();
 }
 
 bool QgsDelimitedTextFile::open()
@@ -502,6 +506,33 @@ bool QgsDelimitedTextFile::setNextRecordId( long nextRecordId )
   return setNextLineNumber( nextRecordId );
 }
 
+bool QgsDelimitedTextFile::setNextRecordId( long nextRecordId, qint64 offset )
+{
+  // Records a short way ahead are quicker to reach by reading on than by seeking
+  static const qint64 MAX_READ_AHEAD_BYTES = 64 * 1024;
+
+  if ( ! mFile ) reset();
+
+  mHoldCurrentRecord = nextRecordId == mRecordLineNumber;
+  if ( mHoldCurrentRecord ) return true;
+
+  // Seeking needs the end of line character, which is only known once the first line has been read
+  if ( ! mStream || offset < 0 || nextRecordId <= 1 || mLineNumber <= 0 || mFirstEOLChar.isNull()
+       || ( nextRecordId > mLineNumber && mNextLineOffset >= 0 && offset >= mNextLineOffset && offset - mNextLineOffset < MAX_READ_AHEAD_BYTES ) )
+    return setNextLineNumber( nextRecordId );
+
+  if ( ! mStream->seek( offset ) ) return false;
+  mLineNumber = nextRecordId - 1;
+  mRecordNumber = -1;
+  mRecordLineNumber = -1;
+  // Only read a small part of the file, as the next wanted record may be far away
+  mReadSize = std::min( mMaxBufferSize, static_cast< int >( MAX_READ_AHEAD_BYTES ) );
+  mBuffer = mStream->read( mReadSize );
+  mPosInBuffer = 0;
+  mNextLineOffset = offset;
+  return true;
+}
+
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextRecord( QStringList &record )
 {
 
@@ -524,6 +555,7 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextRecord( QStringList &reco
 
     mCurrentRecord.clear();
     mRecordLineNumber = mLineNumber;
+    mRecordOffset = mLineOffset;
     if ( mRecordNumber >= 0 )
     {
       mRecordNumber++;
@@ -550,6 +582,9 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   mRecordLineNumber = -1;
   mBuffer = QString();
   mPosInBuffer = 0;
+  mReadSize = mMaxBufferSize;
+  mNextLineOffset = -1;
+  mRecordOffset = -1;
 
   // Skip header lines
   for ( int i = mSkipLines; i-- > 0; )
@@ -579,7 +614,10 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
   if ( mLineNumber == 0 )
   {
     mPosInBuffer = 0;
+    mReadSize = mMaxBufferSize;
     mBuffer = mStream->read( mMaxBufferSize );
+    // the stream position accounts for any byte order mark skipped by the read
+    mNextLineOffset = mTrackRecordOffsets ? mStream->pos() - encodedSize( mBuffer ) : -1;
   }
 
   while ( !mBuffer.isEmpty() )
@@ -639,27 +677,37 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
 
       // Extract the current line from the buffer
       buffer = mBuffer.mid( mPosInBuffer, eolPos - mPosInBuffer );
+      mLineOffset = mNextLineOffset;
+      if ( mNextLineOffset >= 0 )
+        mNextLineOffset += encodedSize( mBuffer.mid( mPosInBuffer, nextPos - mPosInBuffer ) );
       // Update current position in buffer to be the one next to the end of
       // line character(s)
       mPosInBuffer = nextPos;
     }
     else
     {
-      if ( mPosInBuffer == 0 )
+      if ( mPosInBuffer == 0 && ( mBuffer.size() >= mMaxBufferSize || mStream->atEnd() ) )
       {
         // If our current position was the beginning of the buffer and we
         // didn't find any end of line character, then return the whole buffer
         // (to avoid unbounded line sizes)
         // and set the buffer to null so that we don't iterate any more.
         buffer = mBuffer;
+        mLineOffset = mNextLineOffset;
+        if ( mNextLineOffset >= 0 )
+          mNextLineOffset += encodedSize( mBuffer );
         mBuffer = QString();
       }
       else
       {
-        // Read more bytes from file to have up to mMaxBufferSize characters
-        // in our buffer (after having subset it from mPosInBuffer)
+        // Read more bytes from file to have up to mReadSize characters
+        // in our buffer (after having subset it from mPosInBuffer).
+        // After seeking to a record lines longer than the reduced read
+        // size grow it back up to mMaxBufferSize
         mBuffer = mBuffer.mid( mPosInBuffer );
-        mBuffer += mStream->read( mMaxBufferSize - mBuffer.size() );
+        while ( mReadSize < mMaxBufferSize && mBuffer.size() >= mReadSize )
+          mReadSize = std::min( mReadSize * 2, mMaxBufferSize );
+        mBuffer += mStream->read( mReadSize - mBuffer.size() );
         mPosInBuffer = 0;
         continue;
       }
@@ -681,6 +729,7 @@ bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
     mRecordNumber = -1;
     mStream->seek( 0 );
     mLineNumber = 0;
+    mNextLineOffset = -1;
   }
   QString buffer;
   while ( mLineNumber < nextLineNumber - 1 )
@@ -691,6 +740,16 @@ bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 
 }
 
+int QgsDelimitedTextFile::encodedSize( const QString &string )
+{
+  if ( ! mEncoder )
+  {
+    QTextCodec *codec = mStream && mStream->codec() ? mStream->codec() : QTextCodec::codecForName( "UTF-8" );
+    mEncoder.reset( codec->makeEncoder( QTextCodec::IgnoreHeader ) );
+  }
+  return mEncoder->fromUnicode( string ).size();
+}
+
 void QgsDelimitedTextFile::appendField( QStringList &record, QString field, bool quoted )
 {
   if ( mMaxFields > 0 && record.size() >= mMaxFields ) return;
@@ -22,12 +22,14 @@
 #include <QRegularExpression>
 #include <QUrl>
 #include <QObject>
+#include <memory>
 
 class QgsFeature;
 class QgsField;
 class QFile;
 class QFileSystemWatcher;
 class QTextStream;
+class QTextEncoder;
 
 
 /**
@@ -292,6 +294,29 @@ class QgsDelimitedTextFile : public QObject
      */
     bool setNextRecordId( long nextRecordId );
 
+    /**
+     * Set the index of the next record to return, using the byte \a offset of the record
+     * in the file (see recordOffset()) to seek to records which are not just ahead of
+     * the current position, instead of reading every line before them.
+     *  \param  nextRecordId The id to set the next record to
+     *  \returns valid  True if the next record can be located
+     */
+    bool setNextRecordId( long nextRecordId, qint64 offset );
+
+    /**
+     * Sets whether the byte offsets of records are tracked while reading the file, from the
+     * next reset() onwards.
+     * \see recordOffset()
+     */
+    void setTrackRecordOffsets( bool track ) { mTrackRecordOffsets = track; }
+
+    /**
+     * Returns the byte offset in the file of the start of the last record read, or -1
+     * if record offsets are not tracked.
+     * \see setTrackRecordOffsets()
+     */
+    qint64 recordOffset() const { return mRecordOffset; }
+
     /**
      * Number record number of records visited. After scanning the file
      *  serves as a record count.
@@ -391,6 +416,9 @@ class QgsDelimitedTextFile : public QObject
      */
     bool setNextLineNumber( long nextLineNumber );
 
+    //! Returns the number of bytes used to encode \a string in the file
+    int encodedSize( const QString &string );
+
     /**
      * Utility routine to add a field to a record, accounting for trimming
      *  and discarding, and maximum field count
@@ -432,6 +460,14 @@ class QgsDelimitedTextFile : public QObject
     QString mBuffer;
     int mPosInBuffer = 0;
     int mMaxBufferSize = 0;
+    // Number of characters read at once, which is reduced after seeking to a record
+    int mReadSize = 0;
+    bool mTrackRecordOffsets = false;
+    // Byte offsets in the file of the character at mPosInBuffer, of the last line and of the last record read, -1 if unknown
+    qint64 mNextLineOffset = -1;
+    qint64 mLineOffset = -1;
+    qint64 mRecordOffset = -1;
+    std::unique_ptr< QTextEncoder > mEncoder;
     QChar mFirstEOLChar = 0; // '\r' if EOL is "\r" or "\r\n", or `\n' if EOL is "\n"
     QStringList mCurrentRecord;
     bool mHoldCurrentRecord = false;
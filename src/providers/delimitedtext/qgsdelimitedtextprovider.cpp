@@ -18,9 +18,11 @@
 #include "qgsdelimitedtextprovider.h"
 
 #include <QtGlobal>
+#include <QCryptographicHash>
 #include <QFile>
 #include <QFileInfo>
 #include <QDataStream>
+#include <QSaveFile>
 #include <QTextStream>
 #include <QStringList>
 #include <QSettings>
@@ -40,6 +42,8 @@
 #include "qgsmessageoutput.h"
 #include "qgsrectangle.h"
 #include "qgsspatialindex.h"
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsspatialindexsidecar.h"
 #include "qgis.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsproviderregistry.h"
@@ -59,6 +63,109 @@ static const int SUBSET_ID_THRESHOLD_FACTOR = 10;
 QRegularExpression QgsDelimitedTextProvider::sWktPrefixRegexp( QStringLiteral( "^\\s*(?:\\d+\\s+|SRID\\=\\d+\\;)" ), QRegularExpression::CaseInsensitiveOption );
 QRegularExpression QgsDelimitedTextProvider::sCrdDmsRegexp( QStringLiteral( "^\\s*(?:([-+nsew])\\s*)?(\\d{1,3})(?:[^0-9.]+([0-5]?\\d))?[^0-9.]+([0-5]?\\d(?:\\.\\d+)?)[^0-9.]*([-+nsew])?\\s*$" ), QRegularExpression::CaseInsensitiveOption );
 
+///@cond PRIVATE
+
+/**
+ * Returns the key of the spatial index sidecar for a layer with the URI \a query. Layers over the same
+ * file get different sidecars if they read features differently, as their feature ids or geometries
+ * may not match.
+ */
+static QString spatialIndexSidecarKey( const QUrlQuery &query )
+{
+  static const QStringList sParameters
+  {
+    QStringLiteral( "encoding" ), QStringLiteral( "type" ), QStringLiteral( "delimiterType" ), QStringLiteral( "delimiter" ),
+    QStringLiteral( "quote" ), QStringLiteral( "escape" ), QStringLiteral( "skipLines" ), QStringLiteral( "useHeader" ),
+    QStringLiteral( "skipEmptyFields" ), QStringLiteral( "trimFields" ), QStringLiteral( "maxFields" ),
+    QStringLiteral( "geomType" ), QStringLiteral( "wktField" ), QStringLiteral( "xField" ), QStringLiteral( "yField" ),
+    QStringLiteral( "zField" ), QStringLiteral( "mField" ), QStringLiteral( "xyDms" ), QStringLiteral( "decimalPoint" ),
+    QStringLiteral( "crs" )
+  };
+
+  QStringList values;
+  for ( const QString &parameter : sParameters )
+  {
+    if ( query.hasQueryItem( parameter ) )
+      values << parameter + '=' + query.queryItemValue( parameter, QUrl::FullyDecoded );
+  }
+  return QStringLiteral( "delimitedtext:%1" ).arg( QString::fromLatin1( QCryptographicHash::hash( values.join( '&' ).toUtf8(), QCryptographicHash::Sha1 ).toHex() ) );
+}
+
+static const quint32 RECORD_OFFSETS_MAGIC = 0x4f544451; // "QDTO"
+static const quint32 RECORD_OFFSETS_VERSION = 1;
+
+/**
+ * Returns the path of the sidecar holding the byte offsets of the records of \a sourcePath, stored next to
+ * its spatial index sidecar with the same \a key.
+ */
+static QString recordOffsetsPath( const QString &sourcePath, const QString &key )
+{
+  return QgsSpatialIndexSidecar::sidecarPath( sourcePath, key, QStringLiteral( "qdo" ) );
+}
+
+/**
+ * Writes the byte \a offsets of the records of \a sourcePath, sorted by record id, to a sidecar.
+ */
+static bool writeRecordOffsets( const QString &sourcePath, const QString &key, const QVector< QPair< QgsFeatureId, qint64 > > &offsets, QString *error )
+{
+  const QString path = recordOffsetsPath( sourcePath, key );
+  QSaveFile file( path );
+  if ( !QgsSpatialIndexSidecar::openForWriting( file, error ) )
+    return false;
+
+  QDataStream out( &file );
+  out.setByteOrder( QDataStream::LittleEndian );
+  QgsSpatialIndexSidecar::writeHeader( out, RECORD_OFFSETS_MAGIC, RECORD_OFFSETS_VERSION, sourcePath, key );
+  out << static_cast< qint64 >( offsets.size() );
+  for ( const QPair< QgsFeatureId, qint64 > &offset : offsets )
+    out << static_cast< qint64 >( offset.first ) << offset.second;
+
+  if ( out.status() != QDataStream::Ok || !file.commit() )
+  {
+    if ( error )
+      *error = QObject::tr( "Could not write record offsets to %1: %2" ).arg( path, file.errorString() );
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Reads the byte offsets of the records of \a sourcePath written by writeRecordOffsets(), or returns
+ * an empty list if there are none for the current state of the file.
+ */
+static QVector< QPair< QgsFeatureId, qint64 > > readRecordOffsets( const QString &sourcePath, const QString &key )
+{
+  QFile file( recordOffsetsPath( sourcePath, key ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return QVector< QPair< QgsFeatureId, qint64 > >();
+
+  QDataStream in( &file );
+  in.setByteOrder( QDataStream::LittleEndian );
+  if ( !QgsSpatialIndexSidecar::readHeader( in, RECORD_OFFSETS_MAGIC, RECORD_OFFSETS_VERSION, sourcePath, key ) )
+    return QVector< QPair< QgsFeatureId, qint64 > >();
+
+  qint64 count = 0;
+  in >> count;
+  // each entry is stored as a 64 bit id followed by a 64 bit offset
+  if ( in.status() != QDataStream::Ok || count < 0 || count * 16 > file.size() - file.pos() )
+    return QVector< QPair< QgsFeatureId, qint64 > >();
+
+  QVector< QPair< QgsFeatureId, qint64 > > offsets;
+  offsets.reserve( static_cast< int >( count ) );
+  for ( qint64 i = 0; i < count; ++i )
+  {
+    qint64 id = 0;
+    qint64 offset = 0;
+    in >> id >> offset;
+    offsets.append( qMakePair( static_cast< QgsFeatureId >( id ), offset ) );
+  }
+  if ( in.status() != QDataStream::Ok )
+    return QVector< QPair< QgsFeatureId, qint64 > >();
+  return offsets;
+}
+
+///@endcond
+
 QgsDelimitedTextProvider::QgsDelimitedTextProvider( const QString &uri, const ProviderOptions &options, QgsDataProvider::ReadFlags flags )
   : QgsVectorDataProvider( uri, options, flags )
 {
@@ -157,6 +264,8 @@ QgsDelimitedTextProvider::QgsDelimitedTextProvider( const QString &uri, const Pr
 
   if ( query.hasQueryItem( QStringLiteral( "quiet" ) ) ) mShowInvalidLines = false;
 
+  mSidecarKey = spatialIndexSidecarKey( query );
+
   // Do an initial scan of the file to determine field names, types,
   // geometry type (for Wkt), extents, etc.  Parameter value subset.isEmpty()
   // avoid redundant building indexes if we will be building a subset string,
@@ -270,8 +379,9 @@ void QgsDelimitedTextProvider::resetIndexes() const
   mUseSpatialIndex = false;
 
   mSubsetIndex.clear();
-  if ( mBuildSpatialIndex && mGeomRep != GeomNone )
-    mSpatialIndex = std::make_unique< QgsSpatialIndex >();
+  mSpatialIndex.reset();
+  mSidecarIndex.reset();
+  mRecordOffsets.clear();
 }
 
 bool QgsDelimitedTextProvider::createSpatialIndex()
@@ -292,7 +402,7 @@ bool QgsDelimitedTextProvider::createSpatialIndex()
 
 QgsFeatureSource::SpatialIndexPresence QgsDelimitedTextProvider::hasSpatialIndex() const
 {
-  return mSpatialIndex ? QgsFeatureSource::SpatialIndexPresent : QgsFeatureSource::SpatialIndexNotPresent;
+  return mSpatialIndex || mSidecarIndex ? QgsFeatureSource::SpatialIndexPresent : QgsFeatureSource::SpatialIndexNotPresent;
 }
 
 // Really want to merge scanFile and rescan into single code.  Currently the reason
@@ -320,7 +430,23 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   // Initiallize indexes
 
   resetIndexes();
-  bool buildSpatialIndex = buildIndexes && nullptr != mSpatialIndex;
+  bool buildSpatialIndex = buildIndexes && mBuildSpatialIndex && mGeomRep != GeomNone;
+
+  // The full file spatial index is persisted to a sidecar file, so that it only
+  // needs to be built once for each version of the file. If a valid sidecar exists
+  // we can use it directly and skip collecting bounding boxes during the scan.
+  // The byte offsets of the records are persisted next to it, so that the records
+  // found in the index can be read without scanning the file up to them.
+
+  QVector< QPair< QgsFeatureId, QgsRectangle > > sidecarEntries;
+  QVector< QPair< QgsFeatureId, qint64 > > recordOffsets;
+  if ( buildSpatialIndex )
+  {
+    mSidecarIndex = QgsSpatialIndexSidecar::load( mFile->fileName(), mSidecarKey );
+    if ( mSidecarIndex )
+      mRecordOffsets = readRecordOffsets( mFile->fileName(), mSidecarKey );
+  }
+  const bool buildSidecar = buildSpatialIndex && !mSidecarIndex;
 
   // No point building a subset index if there is no geometry, as all
   // records will be included.
@@ -413,6 +539,12 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
   bool foundFirstGeometry = false;
 
+  if ( buildSidecar )
+  {
+    mFile->setTrackRecordOffsets( true );
+    mFile->reset();
+  }
+
   while ( true )
   {
     QgsDelimitedTextFile::Status status = mFile->nextRecord( parts );
@@ -475,12 +607,10 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
                 QgsRectangle bbox( geom.boundingBox() );
                 mExtent.combineExtentWith( bbox );
               }
-              if ( buildSpatialIndex )
+              if ( buildSidecar )
               {
-                QgsFeature f;
-                f.setId( mFile->recordId() );
-                f.setGeometry( geom );
-                mSpatialIndex->addFeature( f );
+                sidecarEntries.append( qMakePair( static_cast< QgsFeatureId >( mFile->recordId() ), geom.boundingBox() ) );
+                recordOffsets.append( qMakePair( static_cast< QgsFeatureId >( mFile->recordId() ), mFile->recordOffset() ) );
               }
             }
             else
@@ -542,12 +672,10 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
             foundFirstGeometry = true;
           }
           mNumberFeatures++;
-          if ( buildSpatialIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
+          if ( buildSidecar && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
           {
-            QgsFeature f;
-            f.setId( mFile->recordId() );
-            f.setGeometry( QgsGeometry::fromPointXY( pt ) );
-            mSpatialIndex->addFeature( f );
+            sidecarEntries.append( qMakePair( static_cast< QgsFeatureId >( mFile->recordId() ), QgsRectangle( pt.x(), pt.y(), pt.x(), pt.y(), false ) ) );
+            recordOffsets.append( qMakePair( static_cast< QgsFeatureId >( mFile->recordId() ), mFile->recordOffset() ) );
           }
         }
         else
@@ -814,6 +942,17 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
       mSubsetIndex = QList<quintptr>();
   }
 
+  if ( buildSidecar )
+  {
+    mFile->setTrackRecordOffsets( false );
+    QString error;
+    if ( !QgsSpatialIndexSidecar::write( mFile->fileName(), mSidecarKey, sidecarEntries, &error )
+         || !writeRecordOffsets( mFile->fileName(), mSidecarKey, recordOffsets, &error ) )
+      QgsDebugMsgLevel( QStringLiteral( "Could not persist spatial index: %1" ).arg( error ), 2 );
+    mSidecarIndex = std::make_unique< QgsSpatialIndexPackedRTree >( sidecarEntries );
+    mRecordOffsets = recordOffsets;
+  }
+
   mUseSpatialIndex = buildSpatialIndex;
 
   mValid = mGeometryType != QgsWkbTypes::UnknownGeometry;
@@ -831,7 +970,16 @@ void QgsDelimitedTextProvider::rescanFile() const
   mRescanRequired = false;
   resetIndexes();
 
-  bool buildSpatialIndex = nullptr != mSpatialIndex;
+  bool buildSpatialIndex = mBuildSpatialIndex && mGeomRep != GeomNone;
+  // The sidecar only indexes the whole file, so any subset needs its own in-memory index
+  if ( buildSpatialIndex && !mSubsetExpression )
+  {
+    mSidecarIndex = QgsSpatialIndexSidecar::load( mFile->fileName(), mSidecarKey );
+    if ( mSidecarIndex )
+      mRecordOffsets = readRecordOffsets( mFile->fileName(), mSidecarKey );
+  }
+  if ( buildSpatialIndex && !mSidecarIndex )
+    mSpatialIndex = std::make_unique< QgsSpatialIndex >();
   bool buildSubsetIndex = mBuildSubsetIndex && ( mSubsetExpression || mGeomRep != GeomNone );
 
   // In case file has been rewritten check that it is still valid
@@ -905,7 +1053,7 @@ void QgsDelimitedTextProvider::rescanFile() const
         QgsRectangle bbox( f.geometry().boundingBox() );
         mExtent.combineExtentWith( bbox );
       }
-      if ( buildSpatialIndex )
+      if ( mSpatialIndex )
         mSpatialIndex->addFeature( f );
     }
     if ( buildSubsetIndex )
@@ -38,6 +38,7 @@ class QTextStream;
 class QgsDelimitedTextFeatureIterator;
 class QgsExpression;
 class QgsSpatialIndex;
+class QgsSpatialIndexPackedRTree;
 
 /**
  * \class QgsDelimitedTextProvider
@@ -229,6 +230,12 @@ class QgsDelimitedTextProvider final: public QgsVectorDataProvider
     mutable bool mUseSpatialIndex;
     mutable bool mCachedUseSpatialIndex;
     mutable std::unique_ptr< QgsSpatialIndex > mSpatialIndex;
+    // Index loaded from (or written to) the persisted spatial index sidecar for the unfiltered file
+    mutable std::unique_ptr< QgsSpatialIndexPackedRTree > mSidecarIndex;
+    // Byte offsets of the records of the file, sorted by record id, persisted next to the sidecar index
+    mutable QVector< QPair< QgsFeatureId, qint64 > > mRecordOffsets;
+    // Key of the sidecar, derived from the URI parameters which affect feature ids and geometries
+    QString mSidecarKey;
 
     friend class QgsDelimitedTextFeatureIterator;
     friend class QgsDelimitedTextFeatureSource;
@@ -0,0 +1,146 @@
+/***************************************************************************
+                         testqgskde.cpp
+                         --------------
+    begin                : October 2021
+    copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgskde.h"
+#include "qgsvectorlayer.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterblock.h"
+#include "qgsfeedback.h"
+#include <QTemporaryDir>
+
+class TestQgsKde: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase(); // will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+    void tiles();
+    void feedback();
+
+};
+
+void TestQgsKde::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsKde::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsKde::tiles()
+{
+  // the surface is calculated in tiles of 1024 pixels, so the footprint of the point at x=1020 spans two tiles
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( double x : { 0.0, 1020.0, 1500.0 } )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x, 0 ) ) );
+    features << f;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.source = layer.dataProvider();
+  parameters.radius = 10;
+  parameters.pixelSize = 1;
+  parameters.shape = QgsKernelDensityEstimation::KernelQuartic;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputRaw;
+
+  QTemporaryDir dir;
+  const QString outputFile = dir.filePath( QStringLiteral( "kde.tif" ) );
+  QgsKernelDensityEstimation kde( parameters, outputFile, QStringLiteral( "GTiff" ) );
+  QCOMPARE( kde.run(), QgsKernelDensityEstimation::Success );
+
+  QgsRasterLayer output( outputFile, QStringLiteral( "kde" ), QStringLiteral( "gdal" ) );
+  QVERIFY( output.isValid() );
+  QCOMPARE( output.width(), 1521 );
+  QCOMPARE( output.height(), 21 );
+
+  std::unique_ptr< QgsRasterBlock > block( output.dataProvider()->block( 1, output.extent(), output.width(), output.height() ) );
+  QVERIFY( block );
+
+  // every footprint is identical, regardless of the tiles it covers
+  for ( int row = 0; row < 21; ++row )
+  {
+    for ( int col = 0; col < 21; ++col )
+    {
+      const double value = block->value( row, col );
+      QCOMPARE( block->value( row, 1020 + col ), value );
+      QCOMPARE( block->value( row, 1500 + col ), value );
+    }
+  }
+  QGSCOMPARENEAR( block->value( 10, 10 ), 0.990025, 0.000001 );
+
+  // pixels outside all footprints are nodata
+  QVERIFY( block->isNoData( 10, 500 ) );
+  QCOMPARE( block->value( 10, 500 ), -9999.0 );
+}
+
+void TestQgsKde::feedback()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( double x : { 0.0, 3000.0 } )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x, 0 ) ) );
+    features << f;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.source = layer.dataProvider();
+  parameters.radius = 10;
+  parameters.pixelSize = 1;
+  parameters.shape = QgsKernelDensityEstimation::KernelQuartic;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputRaw;
+
+  QTemporaryDir dir;
+  QgsKernelDensityEstimation kde( parameters, dir.filePath( QStringLiteral( "kde.tif" ) ), QStringLiteral( "GTiff" ) );
+  QCOMPARE( kde.prepare(), QgsKernelDensityEstimation::Success );
+  for ( const QgsFeature &f : std::as_const( features ) )
+    QCOMPARE( kde.addFeature( f ), QgsKernelDensityEstimation::Success );
+
+  // progress is reported as the tiles are written
+  QgsFeedback feedback;
+  QCOMPARE( kde.finalise( &feedback ), QgsKernelDensityEstimation::Success );
+  QCOMPARE( feedback.progress(), 100.0 );
+
+  // and the calculation can be canceled
+  QgsKernelDensityEstimation canceledKde( parameters, dir.filePath( QStringLiteral( "canceled.tif" ) ), QStringLiteral( "GTiff" ) );
+  QCOMPARE( canceledKde.prepare(), QgsKernelDensityEstimation::Success );
+  for ( const QgsFeature &f : std::as_const( features ) )
+    QCOMPARE( canceledKde.addFeature( f ), QgsKernelDensityEstimation::Success );
+  QgsFeedback canceledFeedback;
+  canceledFeedback.cancel();
+  QCOMPARE( canceledKde.finalise( &canceledFeedback ), QgsKernelDensityEstimation::Canceled );
+}
+
+QGSTEST_MAIN( TestQgsKde )
+#include "testqgskde.moc"
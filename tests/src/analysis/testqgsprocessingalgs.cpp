@@ -61,6 +61,8 @@
 #include "qgsmarkersymbol.h"
 #include "qgsfillsymbol.h"
 
+#include <atomic>
+
 class TestQgsProcessingAlgs: public QObject
 {
     Q_OBJECT
@@ -113,8 +115,11 @@ class TestQgsProcessingAlgs: public QObject
 
     void rasterLogicOp_data();
     void rasterLogicOp();
+    void processRasterBlocks();
     void cellStatistics_data();
     void cellStatistics();
+    void polygonCellScanner_data();
+    void polygonCellScanner();
     void percentileFunctions_data();
     void percentileFunctions();
     void percentileRaster_data();
@@ -2482,6 +2487,80 @@ void TestQgsProcessingAlgs::rasterLogicOp()
   }
 }
 
+void TestQgsProcessingAlgs::processRasterBlocks()
+{
+  // wide enough to be processed as several blocks
+  const int nCols = 4100;
+  const int nRows = 3;
+  const QgsRectangle extent( 0, 0, nCols, nRows );
+  const QgsCoordinateReferenceSystem crs( QStringLiteral( "EPSG:3857" ) );
+  double tform[] = { extent.xMinimum(), 1.0, 0.0, extent.yMaximum(), 0.0, -1.0 };
+
+  QTemporaryFile inputFile;
+  inputFile.open();
+  inputFile.close();
+  std::unique_ptr< QgsRasterDataProvider > input( QgsRasterDataProvider::create( QStringLiteral( "gdal" ), inputFile.fileName(), QStringLiteral( "GTiff" ), 1, Qgis::Float32, nCols, nRows, tform, crs ) );
+  QVERIFY( input->isValid() );
+  QgsRasterBlock inputBlock( Qgis::Float32, nCols, nRows );
+  for ( int row = 0; row < nRows; row++ )
+  {
+    for ( int col = 0; col < nCols; col++ )
+      inputBlock.setValue( row, col, row * nCols + col );
+  }
+  QVERIFY( input->writeBlock( &inputBlock, 1 ) );
+  QVERIFY( input->setEditable( false ) );
+
+  QTemporaryFile outputFile;
+  outputFile.open();
+  outputFile.close();
+  std::unique_ptr< QgsRasterDataProvider > output( QgsRasterDataProvider::create( QStringLiteral( "gdal" ), outputFile.fileName(), QStringLiteral( "GTiff" ), 1, Qgis::Float64, nCols, nRows, tform, crs ) );
+  QVERIFY( output->isValid() );
+
+  QgsRasterAnalysisUtils::RasterBlockInput blockInput;
+  blockInput.interface = input.get();
+  blockInput.band = 1;
+
+  std::atomic< int > kernelCalls( 0 );
+  QgsFeedback feedback;
+  QgsRasterAnalysisUtils::processRasterBlocks( { blockInput, blockInput }, output.get(), nCols, nRows, extent, &feedback,
+      [&kernelCalls]( std::vector< std::unique_ptr< QgsRasterBlock > > &inputBlocks, QgsRasterBlock * outputBlock )
+  {
+    kernelCalls++;
+    for ( int row = 0; row < outputBlock->height(); row++ )
+    {
+      for ( int col = 0; col < outputBlock->width(); col++ )
+        outputBlock->setValue( row, col, inputBlocks.at( 0 )->value( row, col ) + inputBlocks.at( 1 )->value( row, col ) );
+    }
+  } );
+  QVERIFY( kernelCalls > 1 );
+  QCOMPARE( feedback.progress(), 100.0 );
+
+  std::unique_ptr< QgsRasterBlock > block( output->block( 1, extent, nCols, nRows ) );
+  for ( int row = 0; row < nRows; row++ )
+  {
+    for ( int col = 0; col < nCols; col++ )
+      QCOMPARE( block->value( row, col ), 2.0 * ( row * nCols + col ) );
+  }
+
+  // exceptions raised by the kernel are passed to the caller
+  bool caught = false;
+  try
+  {
+    QgsRasterAnalysisUtils::processRasterBlocks( { blockInput }, output.get(), nCols, nRows, extent, &feedback,
+        []( std::vector< std::unique_ptr< QgsRasterBlock > > &, QgsRasterBlock * )
+    {
+      throw QgsProcessingException( QStringLiteral( "kernel error" ) );
+    } );
+  }
+  catch ( QgsProcessingException &e )
+  {
+    caught = true;
+    QCOMPARE( e.what(), QStringLiteral( "kernel error" ) );
+  }
+  QVERIFY( caught );
+  QVERIFY( !output->isEditable() );
+}
+
 void TestQgsProcessingAlgs::cellStatistics_data()
 {
   QTest::addColumn<QStringList>( "inputRasters" );
@@ -2794,6 +2873,57 @@ void TestQgsProcessingAlgs::cellStatistics()
   }
 }
 
+void TestQgsProcessingAlgs::polygonCellScanner_data()
+{
+  QTest::addColumn<QString>( "wkt" );
+
+  QTest::newRow( "square with hole" ) << QStringLiteral( "Polygon((1 1, 9 1, 9 9, 1 9, 1 1),(3 3, 3 7, 7 7, 7 3, 3 3))" );
+  QTest::newRow( "hole with same orientation" ) << QStringLiteral( "Polygon((1 1, 9 1, 9 9, 1 9, 1 1),(3 3, 7 3, 7 7, 3 7, 3 3))" );
+  QTest::newRow( "outside window" ) << QStringLiteral( "Polygon((-3 5.2, 5.1 -2, 13 6.3, 4.4 14, -3 5.2),(4.1 4.2, 6.3 4.5, 5.2 7.7, 4.1 4.2))" );
+  QTest::newRow( "multipolygon" ) << QStringLiteral( "MultiPolygon(((0.2 0.2, 2.7 0.4, 1.1 3.3, 0.2 0.2)),((5.5 5.5, 9.9 6.1, 7.3 9.4, 5.5 5.5)))" );
+  QTest::newRow( "curved" ) << QStringLiteral( "CurvePolygon(CircularString(2 5, 5 8, 8 5, 5 2, 2 5))" );
+}
+
+void TestQgsProcessingAlgs::polygonCellScanner()
+{
+  QFETCH( QString, wkt );
+
+  const QgsGeometry polygon = QgsGeometry::fromWkt( wkt );
+  QVERIFY( !polygon.isNull() );
+  QgsGeometry straightPolygon = polygon;
+  straightPolygon.convertToStraightSegment();
+
+  // a window of 14 x 12 cells, with non square cells
+  const QgsRectangle window( 0, 0, 9.8, 9.6 );
+  const double cellSizeX = 0.7;
+  const double cellSizeY = 0.8;
+  const int nCellsX = 14;
+  const int nCellsY = 12;
+
+  QgsRasterAnalysisUtils::PolygonCellScanner centerScanner( polygon, window, cellSizeX, cellSizeY, nCellsX );
+  QgsRasterAnalysisUtils::PolygonCellScanner coverageScanner( polygon, window, cellSizeX, cellSizeY, nCellsX );
+  std::vector< std::pair< int, int > > spans;
+  std::vector< double > coverage;
+  for ( int row = 0; row < nCellsY; ++row )
+  {
+    centerScanner.cellCentersInRow( row, spans );
+    coverageScanner.coverageForRow( row, coverage );
+    QCOMPARE( static_cast< int >( coverage.size() ), nCellsX );
+    for ( int col = 0; col < nCellsX; ++col )
+    {
+      const QgsRectangle cell( window.xMinimum() + col * cellSizeX, window.yMaximum() - ( row + 1 ) * cellSizeY,
+                               window.xMinimum() + ( col + 1 ) * cellSizeX, window.yMaximum() - row * cellSizeY );
+
+      const bool inSpans = std::any_of( spans.begin(), spans.end(), [col]( const std::pair< int, int > &span ) { return col >= span.first && col < span.second; } );
+      const QgsGeometry center = QgsGeometry::fromPointXY( cell.center() );
+      QCOMPARE( inSpans, straightPolygon.contains( center ) );
+
+      const double expectedCoverage = QgsGeometry::fromRect( cell ).intersection( straightPolygon ).area() / ( cellSizeX * cellSizeY );
+      QGSCOMPARENEAR( coverage[col], expectedCoverage, 1e-6 );
+    }
+  }
+}
+
 Q_DECLARE_METATYPE( QgsRasterAnalysisUtils::CellValuePercentileMethods )
 void TestQgsProcessingAlgs::percentileFunctions_data()
 {
@@ -42,6 +42,7 @@ class TestQgsZonalStatistics : public QObject
     void testReprojection();
     void testNoData();
     void testSmallPolygons();
+    void testMultipleZones();
     void testShortName();
 
   private:
@@ -344,6 +345,64 @@ void TestQgsZonalStatistics::testSmallPolygons()
   QGSCOMPARENEAR( f.attribute( "nmean" ).toDouble(), 864.285638, 0.001 );
 }
 
+void TestQgsZonalStatistics::testMultipleZones()
+{
+  QString myDataPath( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  QString myTestDataPath = myDataPath + "/zonalstatistics/";
+
+  std::unique_ptr< QgsRasterLayer > rasterLayer = std::make_unique< QgsRasterLayer >( myTestDataPath + "raster.tif", QStringLiteral( "raster" ), QStringLiteral( "gdal" ) );
+  QVERIFY( rasterLayer->isValid() );
+  const QgsRectangle extent = rasterLayer->extent();
+  const double cellSizeX = std::fabs( rasterLayer->rasterUnitsPerPixelX() );
+  const double cellSizeY = std::fabs( rasterLayer->rasterUnitsPerPixelY() );
+
+  // overlapping zones of varying size covering the raster, plus a small zone, a zone outside the raster and an empty geometry
+  QVector< QgsGeometry > zones;
+  for ( int i = 0; i < 5; ++i )
+  {
+    for ( int j = 0; j < 4; ++j )
+    {
+      const double x = extent.xMinimum() + extent.width() * i / 5.0;
+      const double y = extent.yMinimum() + extent.height() * j / 4.0;
+      zones << QgsGeometry::fromPolygonXY( QgsPolygonXY() << ( QgsPolylineXY()
+                                           << QgsPointXY( x - extent.width() * 0.05, y )
+                                           << QgsPointXY( x + extent.width() * 0.3, y + extent.height() * 0.1 )
+                                           << QgsPointXY( x + extent.width() * 0.1, y + extent.height() * 0.35 )
+                                           << QgsPointXY( x - extent.width() * 0.05, y ) ) );
+    }
+  }
+  const QgsPointXY center = extent.center();
+  zones << QgsGeometry::fromRect( QgsRectangle( center.x(), center.y(), center.x() + cellSizeX * 0.3, center.y() + cellSizeY * 0.4 ) );
+  zones << QgsGeometry::fromRect( QgsRectangle( extent.xMaximum() + 10, extent.yMaximum() + 10, extent.xMaximum() + 20, extent.yMaximum() + 20 ) );
+  zones << QgsGeometry();
+
+  const QList< QMap<QgsZonalStatistics::Statistic, QVariant> > results = QgsZonalStatistics::calculateStatistics( rasterLayer->dataProvider(), zones, cellSizeX, cellSizeY, 1, QgsZonalStatistics::All );
+  QCOMPARE( results.size(), zones.size() );
+  for ( int i = 0; i < zones.size(); ++i )
+  {
+    const QMap<QgsZonalStatistics::Statistic, QVariant> expected = QgsZonalStatistics::calculateStatistics( rasterLayer->dataProvider(), zones.at( i ), cellSizeX, cellSizeY, 1, QgsZonalStatistics::All );
+    QCOMPARE( results.at( i ).keys(), expected.keys() );
+    for ( auto it = expected.constBegin(); it != expected.constEnd(); ++it )
+    {
+      QGSCOMPARENEAR( results.at( i ).value( it.key() ).toDouble(), it.value().toDouble(), 1e-9 );
+    }
+  }
+  QVERIFY( !results.at( 0 ).isEmpty() );
+  QVERIFY( results.at( zones.size() - 2 ).isEmpty() );
+  QVERIFY( results.at( zones.size() - 1 ).isEmpty() );
+
+  // sparse zones in opposite corners of the raster are calculated separately
+  QVector< QgsGeometry > sparseZones;
+  sparseZones << QgsGeometry::fromRect( QgsRectangle( extent.xMinimum(), extent.yMaximum() - cellSizeY * 3, extent.xMinimum() + cellSizeX * 3, extent.yMaximum() ) );
+  sparseZones << QgsGeometry::fromRect( QgsRectangle( extent.xMaximum() - cellSizeX * 3, extent.yMinimum(), extent.xMaximum(), extent.yMinimum() + cellSizeY * 3 ) );
+  const QList< QMap<QgsZonalStatistics::Statistic, QVariant> > sparseResults = QgsZonalStatistics::calculateStatistics( rasterLayer->dataProvider(), sparseZones, cellSizeX, cellSizeY, 1, QgsZonalStatistics::All );
+  QCOMPARE( sparseResults.size(), 2 );
+  for ( int i = 0; i < sparseZones.size(); ++i )
+  {
+    QCOMPARE( sparseResults.at( i ), QgsZonalStatistics::calculateStatistics( rasterLayer->dataProvider(), sparseZones.at( i ), cellSizeX, cellSizeY, 1, QgsZonalStatistics::All ) );
+  }
+}
+
 void TestQgsZonalStatistics::testShortName()
 {
   QCOMPARE( QgsZonalStatistics::shortName( QgsZonalStatistics::Count ), QStringLiteral( "count" ) );
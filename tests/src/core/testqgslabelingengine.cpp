@@ -34,6 +34,8 @@
 #include "qgslabelingresults.h"
 #include "qgscallout.h"
 #include "qgslinesymbol.h"
+#include "qgsmaprenderercache.h"
+#include "qgstextlayoutcache.h"
 
 class TestQgsLabelingEngine : public QObject
 {
@@ -96,6 +98,9 @@ class TestQgsLabelingEngine : public QObject
     void testLineAnchorHorizontalConstraints();
     void testLineAnchorClipping();
     void testShowAllLabelsWhenALabelHasNoCandidates();
+    void testParallelLabeling();
+    void testIncrementalLabeling();
+    void testTextLayoutCache();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -3684,5 +3689,229 @@ void TestQgsLabelingEngine::testShowAllLabelsWhenALabelHasNoCandidates()
   QVERIFY( imageCheck( QStringLiteral( "show_all_labels_when_no_candidates" ), img, 20 ) );
 }
 
+void TestQgsLabelingEngine::testParallelLabeling()
+{
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "'label'" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl->setRenderer( new QgsNullSymbolRenderer() );
+
+  // a dense cluster of features with conflicting labels, and a few isolated features
+  QgsFeatureList features;
+  int id = 1;
+  for ( int i = 0; i < 10; ++i )
+  {
+    for ( int j = 0; j < 10; ++j )
+    {
+      QgsFeature f;
+      f.setAttributes( QgsAttributes() << id++ );
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 1000 + i * 15, 1000 + j * 10 ) ) );
+      features << f;
+    }
+  }
+  for ( int i = 0; i < 4; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << id++ );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 500 + i * 400, 1800 ) ) );
+    features << f;
+  }
+  QVERIFY( vl->dataProvider()->addFeatures( features ) );
+  vl->updateExtents();
+  vl->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+  vl->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( vl->crs() );
+  mapSettings.setOutputSize( QSize( 600, 600 ) );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 2500, 2500 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto runLabeling = [&mapSettings]( bool parallel ) -> QList< QgsLabelPosition >
+  {
+    QgsLabelingEngineSettings engineSettings;
+    engineSettings.setFlag( QgsLabelingEngineSettings::UsePartialCandidates, false );
+    engineSettings.setFlag( QgsLabelingEngineSettings::DrawLabelRectOnly, true );
+    engineSettings.setFlag( QgsLabelingEngineSettings::ParallelLabeling, parallel );
+    QgsMapSettings settings = mapSettings;
+    settings.setLabelingEngineSettings( engineSettings );
+
+    QgsMapRendererSequentialJob job( settings );
+    job.start();
+    job.waitForFinished();
+
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QList< QgsLabelPosition > labels = results->labelsWithinRect( settings.extent() );
+    std::sort( labels.begin(), labels.end(), []( const QgsLabelPosition & a, const QgsLabelPosition & b ) { return a.featureId < b.featureId; } );
+    return labels;
+  };
+
+  const QList< QgsLabelPosition > serialLabels = runLabeling( false );
+  const QList< QgsLabelPosition > parallelLabels = runLabeling( true );
+  QVERIFY( !parallelLabels.isEmpty() );
+
+  // results must not depend on thread scheduling
+  const QList< QgsLabelPosition > parallelLabels2 = runLabeling( true );
+  QCOMPARE( parallelLabels2.size(), parallelLabels.size() );
+  for ( int i = 0; i < parallelLabels.size(); ++i )
+  {
+    QCOMPARE( parallelLabels2.at( i ).featureId, parallelLabels.at( i ).featureId );
+    QCOMPARE( parallelLabels2.at( i ).labelRect, parallelLabels.at( i ).labelRect );
+  }
+
+  // placed labels must not overlap
+  for ( int i = 0; i < parallelLabels.size(); ++i )
+  {
+    for ( int j = i + 1; j < parallelLabels.size(); ++j )
+      QVERIFY( !parallelLabels.at( i ).labelRect.buffered( -0.01 ).intersects( parallelLabels.at( j ).labelRect.buffered( -0.01 ) ) );
+  }
+
+  // isolated features get the same labels as with serial labeling
+  for ( QgsFeatureId fid = 101; fid <= 104; ++fid )
+  {
+    auto findLabel = [fid]( const QList< QgsLabelPosition > &labels ) -> QgsRectangle
+    {
+      for ( const QgsLabelPosition &label : labels )
+      {
+        if ( label.featureId == fid )
+          return label.labelRect;
+      }
+      return QgsRectangle();
+    };
+    QVERIFY( !findLabel( serialLabels ).isNull() );
+    QCOMPARE( findLabel( parallelLabels ), findLabel( serialLabels ) );
+  }
+}
+
+void TestQgsLabelingEngine::testIncrementalLabeling()
+{
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "\"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl->setRenderer( new QgsNullSymbolRenderer() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 5; ++i )
+  {
+    for ( int j = 0; j < 5; ++j )
+    {
+      QgsFeature f;
+      f.setAttributes( QgsAttributes() << i * 5 + j + 1 );
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 400 + i * 400, 400 + j * 400 ) ) );
+      features << f;
+    }
+  }
+  QVERIFY( vl->dataProvider()->addFeatures( features ) );
+  vl->updateExtents();
+  vl->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+  vl->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( vl->crs() );
+  mapSettings.setOutputSize( QSize( 600, 600 ) );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 2400, 2400 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  QgsLabelingEngineSettings engineSettings;
+  engineSettings.setFlag( QgsLabelingEngineSettings::UsePartialCandidates, false );
+  engineSettings.setFlag( QgsLabelingEngineSettings::DrawLabelRectOnly, true );
+  engineSettings.setFlag( QgsLabelingEngineSettings::IncrementalLabeling, true );
+  mapSettings.setLabelingEngineSettings( engineSettings );
+
+  QgsMapRendererCache cache;
+  auto render = [&cache]( const QgsMapSettings & settings ) -> std::unique_ptr< QgsLabelingResults >
+  {
+    QgsMapRendererSequentialJob job( settings );
+    job.setCache( &cache );
+    job.start();
+    job.waitForFinished();
+    return std::unique_ptr< QgsLabelingResults >( job.takeLabelingResults() );
+  };
+
+  std::unique_ptr< QgsLabelingResults > results = render( mapSettings );
+  QgsRectangle previousExtent;
+  QgsCoordinateReferenceSystem crs;
+  QgsMapToPixel mtp;
+  QCOMPARE( cache.cacheLabelPositions( QgsMapRendererJob::LABEL_PREVIEW_CACHE_ID, previousExtent, mtp, crs ).size(), 25 );
+  QCOMPARE( crs, vl->crs() );
+
+  QCOMPARE( previousExtent, mapSettings.visibleExtent() );
+
+  // the label for the feature in the center of the map
+  QgsLabelPosition previous;
+  const QList< QgsLabelPosition > previousLabels = results->labelsWithinRect( mapSettings.visibleExtent() );
+  for ( const QgsLabelPosition &label : previousLabels )
+  {
+    if ( label.featureId == 13 )
+      previous = label;
+  }
+  QCOMPARE( previous.featureId, 13 );
+
+  // pan the map slightly, the label in the center must be kept at exactly the same position
+  mapSettings.setExtent( QgsRectangle( 60, 40, 2460, 2440 ) );
+  results = render( mapSettings );
+  const QList< QgsLabelPosition > labels = results->labelsWithinRect( mapSettings.visibleExtent() );
+  bool found = false;
+  for ( const QgsLabelPosition &label : labels )
+  {
+    if ( label.featureId != previous.featureId )
+      continue;
+
+    found = true;
+    QCOMPARE( label.labelRect, previous.labelRect );
+    QCOMPARE( label.rotation, previous.rotation );
+    // reused positions aren't user pinned labels
+    QVERIFY( !label.isPinned );
+  }
+  QVERIFY( found );
+
+  // changing the layer invalidates the stored positions
+  vl->triggerRepaint();
+  QVERIFY( cache.cacheLabelPositions( QgsMapRendererJob::LABEL_PREVIEW_CACHE_ID, previousExtent, mtp, crs ).isEmpty() );
+}
+
+void TestQgsLabelingEngine::testTextLayoutCache()
+{
+  QgsTextLayoutCache::clear();
+
+  QFont font = QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ) );
+  font.setPixelSize( 20 );
+  const QString text = QStringLiteral( "Label text" );
+
+  const QFontMetricsF fm( font );
+  QGSCOMPARENEAR( QgsTextLayoutCache::horizontalAdvance( font, text ), fm.horizontalAdvance( text ), 0.0001 );
+  // cached result must be identical
+  QGSCOMPARENEAR( QgsTextLayoutCache::horizontalAdvance( font, text ), fm.horizontalAdvance( text ), 0.0001 );
+  QCOMPARE( QgsTextLayoutCache::horizontalAdvance( font, QString() ), 0.0 );
+
+  QPainterPath expected;
+  expected.addText( 0, 0, font, text );
+  QCOMPARE( QgsTextLayoutCache::textPath( font, text ), expected );
+  QCOMPARE( QgsTextLayoutCache::textPath( font, text ), expected );
+  QVERIFY( QgsTextLayoutCache::textPath( font, QString() ).isEmpty() );
+
+  // properties not covered by QFont::toString() must still give distinct entries
+  QFont spacedFont = font;
+  spacedFont.setLetterSpacing( QFont::AbsoluteSpacing, 10 );
+  QVERIFY( QgsTextLayoutCache::fontKey( font ) != QgsTextLayoutCache::fontKey( spacedFont ) );
+  const QFontMetricsF spacedFm( spacedFont );
+  QGSCOMPARENEAR( QgsTextLayoutCache::horizontalAdvance( spacedFont, text ), spacedFm.horizontalAdvance( text ), 0.0001 );
+  QVERIFY( QgsTextLayoutCache::horizontalAdvance( spacedFont, text ) > QgsTextLayoutCache::horizontalAdvance( font, text ) );
+
+  QFont capsFont = font;
+  capsFont.setCapitalization( QFont::AllUppercase );
+  QVERIFY( QgsTextLayoutCache::fontKey( font ) != QgsTextLayoutCache::fontKey( capsFont ) );
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
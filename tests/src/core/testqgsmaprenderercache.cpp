@@ -19,6 +19,12 @@
 #include "qgsmaprenderercache.h"
 #include "qgsmaptopixel.h"
 #include "qgsrectangle.h"
+#include "qgsvectorlayer.h"
+#include "qgsmapsettings.h"
+#include "qgsmaprenderersequentialjob.h"
+#include "qgssinglesymbolrenderer.h"
+#include "qgsfillsymbol.h"
+#include "qgscategorizedsymbolrenderer.h"
 
 class TestQgsMapRendererCache: public QObject
 {
@@ -34,6 +40,9 @@ class TestQgsMapRendererCache: public QObject
     void cleanup(); // will be called after every testfunction.
 
     void testCache();
+    void testCacheFeatures();
+    void testCacheFeaturesMemory();
+    void testRenderCachedFeatures();
 };
 
 
@@ -154,6 +163,172 @@ void TestQgsMapRendererCache::testCache()
   QVERIFY( !cache.hasAnyCacheImage( imgRedKey ) );
 }
 
+void TestQgsMapRendererCache::testCacheFeatures()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+
+  QgsMapRendererCache cache;
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+
+  std::shared_ptr< QgsMapRendererCache::CachedFeatures > features = std::make_shared< QgsMapRendererCache::CachedFeatures >();
+  features->extent = QgsRectangle( 0, 0, 10, 10 );
+  features->features << QgsFeature( 1 ) << QgsFeature( 2 );
+  cache.setCacheFeatures( layer->id(), features, layer.get() );
+  QVERIFY( cache.cacheFeatures( layer->id() ) );
+  QCOMPARE( cache.cacheFeatures( layer->id() )->features.size(), 2 );
+  QVERIFY( cache.cacheFeatures( layer->id() )->extent == QgsRectangle( 0, 0, 10, 10 ) );
+
+  // cached features survive repaints, which are triggered by style changes
+  layer->triggerRepaint();
+  QVERIFY( cache.cacheFeatures( layer->id() ) );
+
+  // but not changes to the layer's data
+  emit layer->dataChanged();
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+
+  // nor deferred repaints, which are triggered when the layer is automatically refreshed
+  cache.setCacheFeatures( layer->id(), features, layer.get() );
+  layer->triggerRepaint( true );
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+
+  cache.setCacheFeatures( layer->id(), features, layer.get() );
+  QVERIFY( cache.cacheFeatures( layer->id() ) );
+  cache.clear();
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+
+  // features taking attributes from other layers are discarded when those layers are edited or repainted
+  std::unique_ptr< QgsVectorLayer > joinLayer = std::make_unique< QgsVectorLayer >( QStringLiteral( "None" ), QStringLiteral( "join" ), QStringLiteral( "memory" ) );
+  cache.setCacheFeatures( layer->id(), features, layer.get(), QList< QgsMapLayer * >() << joinLayer.get() );
+  QVERIFY( cache.cacheFeatures( layer->id() ) );
+  joinLayer->triggerRepaint();
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+  cache.setCacheFeatures( layer->id(), features, layer.get(), QList< QgsMapLayer * >() << joinLayer.get() );
+  emit joinLayer->dataChanged();
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+  cache.setCacheFeatures( layer->id(), features, layer.get(), QList< QgsMapLayer * >() << joinLayer.get() );
+  joinLayer.reset();
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+
+  // or deletion of the layer
+  const QString layerId = layer->id();
+  cache.setCacheFeatures( layerId, features, layer.get() );
+  layer.reset();
+  QVERIFY( !cache.cacheFeatures( layerId ) );
+}
+
+void TestQgsMapRendererCache::testCacheFeaturesMemory()
+{
+  std::unique_ptr< QgsVectorLayer > layer1 = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points1" ), QStringLiteral( "memory" ) );
+  std::unique_ptr< QgsVectorLayer > layer2 = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points2" ), QStringLiteral( "memory" ) );
+  std::unique_ptr< QgsVectorLayer > layer3 = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points3" ), QStringLiteral( "memory" ) );
+
+  QgsMapRendererCache cache;
+  cache.setMaximumFeatureMemory( 1000 );
+  QCOMPARE( cache.maximumFeatureMemory(), 1000LL );
+
+  std::shared_ptr< QgsMapRendererCache::CachedFeatures > features = std::make_shared< QgsMapRendererCache::CachedFeatures >();
+  features->memoryUsage = 400;
+
+  // features which exceed the whole budget are not kept
+  std::shared_ptr< QgsMapRendererCache::CachedFeatures > tooLarge = std::make_shared< QgsMapRendererCache::CachedFeatures >();
+  tooLarge->memoryUsage = 1001;
+  QVERIFY( !cache.setCacheFeatures( layer1->id(), tooLarge, layer1.get() ) );
+  QVERIFY( !cache.cacheFeatures( layer1->id() ) );
+
+  QVERIFY( cache.setCacheFeatures( layer1->id(), features, layer1.get() ) );
+  QVERIFY( cache.setCacheFeatures( layer2->id(), features, layer2.get() ) );
+  QVERIFY( cache.cacheFeatures( layer1->id() ) );
+
+  // the least recently used features of other layers are discarded to make room
+  QVERIFY( cache.setCacheFeatures( layer3->id(), features, layer3.get() ) );
+  QVERIFY( cache.cacheFeatures( layer1->id() ) );
+  QVERIFY( !cache.cacheFeatures( layer2->id() ) );
+  QVERIFY( cache.cacheFeatures( layer3->id() ) );
+}
+
+void TestQgsMapRendererCache::testRenderCachedFeatures()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=EPSG:3857" ), QStringLiteral( "polys" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeature f1;
+  f1.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon((10 10, 40 10, 40 40, 10 40, 10 10))" ) ) );
+  QgsFeature f2;
+  f2.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon((60 60, 90 60, 90 90, 60 90, 60 60))" ) ) );
+  QVERIFY( layer->dataProvider()->addFeatures( QgsFeatureList() << f1 << f2 ) );
+  layer->setRenderer( new QgsSingleSymbolRenderer( QgsFillSymbol::createSimple( QVariantMap( {{ QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) }, { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) }} ) ) ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( layer->crs() );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  mapSettings.setOutputSize( QSize( 100, 100 ) );
+  mapSettings.setBackgroundColor( QColor( 255, 255, 255 ) );
+  mapSettings.setFlag( QgsMapSettings::CacheVectorFeatures, true );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << layer.get() );
+
+  QgsMapRendererCache cache;
+  auto render = [&mapSettings, &cache]
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.setCache( &cache );
+    job.start();
+    job.waitForFinished();
+    return job.renderedImage();
+  };
+
+  QImage img = render();
+  QCOMPARE( img.pixelColor( 25, 75 ), QColor( 255, 0, 0 ) );
+  QVERIFY( cache.cacheFeatures( layer->id() ) );
+  QCOMPARE( cache.cacheFeatures( layer->id() )->features.size(), 2 );
+
+  // restyling reuses the cached features
+  const std::shared_ptr< const QgsMapRendererCache::CachedFeatures > cached = cache.cacheFeatures( layer->id() );
+  layer->setRenderer( new QgsSingleSymbolRenderer( QgsFillSymbol::createSimple( QVariantMap( {{ QStringLiteral( "color" ), QStringLiteral( "0,0,255" ) }, { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) }} ) ) ) );
+  layer->triggerRepaint();
+  img = render();
+  QCOMPARE( img.pixelColor( 25, 75 ), QColor( 0, 0, 255 ) );
+  QCOMPARE( img.pixelColor( 75, 25 ), QColor( 0, 0, 255 ) );
+  QVERIFY( cache.cacheFeatures( layer->id() ) == cached );
+
+  // zooming in reuses them too
+  mapSettings.setExtent( QgsRectangle( 50, 50, 100, 100 ) );
+  img = render();
+  QCOMPARE( img.pixelColor( 50, 50 ), QColor( 0, 0, 255 ) );
+  QVERIFY( cache.cacheFeatures( layer->id() ) == cached );
+
+  // changing the data discards them
+  QgsFeature f3;
+  f3.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon((10 60, 40 60, 40 90, 10 90, 10 60))" ) ) );
+  QVERIFY( layer->dataProvider()->addFeatures( QgsFeatureList() << f3 ) );
+  emit layer->dataChanged();
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  img = render();
+  QCOMPARE( cache.cacheFeatures( layer->id() )->features.size(), 3 );
+
+  // features which exceed the memory budget are rendered in full, and the cache remembers not to read them for caching again
+  cache.setMaximumFeatureMemory( 1 );
+  emit layer->dataChanged();
+  img = render();
+  QCOMPARE( img.pixelColor( 25, 75 ), QColor( 0, 0, 255 ) );
+  QCOMPARE( img.pixelColor( 75, 25 ), QColor( 0, 0, 255 ) );
+  QCOMPARE( img.pixelColor( 25, 25 ), QColor( 0, 0, 255 ) );
+  QVERIFY( cache.cacheFeatures( layer->id() ) );
+  QVERIFY( cache.cacheFeatures( layer->id() )->exceedsMemoryBudget );
+  QVERIFY( cache.cacheFeatures( layer->id() )->features.isEmpty() );
+  const std::shared_ptr< const QgsMapRendererCache::CachedFeatures > exceeded = cache.cacheFeatures( layer->id() );
+  img = render();
+  QCOMPARE( img.pixelColor( 25, 25 ), QColor( 0, 0, 255 ) );
+  QVERIFY( cache.cacheFeatures( layer->id() ) == exceeded );
+
+  // features with expression fields are never cached, as their values may change without the layer's data changing
+  cache.setMaximumFeatureMemory( 256 * 1024 * 1024 );
+  emit layer->dataChanged();
+  layer->addExpressionField( QStringLiteral( "@map_scale" ), QgsField( QStringLiteral( "scale" ), QVariant::Double ) );
+  layer->setRenderer( new QgsCategorizedSymbolRenderer( QStringLiteral( "scale" ) ) );
+  img = render();
+  QVERIFY( !cache.cacheFeatures( layer->id() ) );
+}
 
 QGSTEST_MAIN( TestQgsMapRendererCache )
 #include "testqgsmaprenderercache.moc"
@@ -45,6 +45,13 @@
 #include "qgssinglesymbolrenderer.h"
 #include "qgsrasterlayertemporalproperties.h"
 #include "qgslinesymbol.h"
+#include "qgsfillsymbol.h"
+#include "qgsmarkersymbol.h"
+#include "qgsmarkersymbollayer.h"
+#include "qgslinesymbollayer.h"
+#include "qgsmaprendererparalleljob.h"
+#include "qgscategorizedsymbolrenderer.h"
+#include "qgsrulebasedrenderer.h"
 
 //qgs unit test utility class
 #include "qgsmultirenderchecker.h"
@@ -91,6 +98,12 @@ class TestQgsMapRendererJob : public QObject
 
     void temporalRender();
 
+    void cullSubPixelFeatures();
+    void cacheMarkerSprites();
+    void cacheMarkerSpritesOnLines();
+    void renderVectorLayersInTiles();
+    void renderDraftPreview();
+
   private:
     bool imageCheck( const QString &type, const QImage &image, int mismatchCount = 0 );
 
@@ -947,6 +960,318 @@ void TestQgsMapRendererJob::temporalRender()
 
 }
 
+void TestQgsMapRendererJob::cullSubPixelFeatures()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=EPSG:3857" ), QStringLiteral( "polys" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+
+  QgsFeature tiny;
+  tiny.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon((10 10, 10.5 10, 10.5 10.5, 10 10.5, 10 10))" ) ) );
+  QgsFeature tiny2;
+  tiny2.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon((11 11, 11.5 11, 11.5 11.5, 11 11.5, 11 11))" ) ) );
+  QgsFeature large;
+  large.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon((500 500, 900 500, 900 900, 500 900, 500 500))" ) ) );
+  QVERIFY( layer->dataProvider()->addFeatures( QgsFeatureList() << tiny << tiny2 << large ) );
+
+  QgsFillSymbol *fill = QgsFillSymbol::createSimple( QVariantMap( {{ QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) }, { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) }} ) );
+  layer->setRenderer( new QgsSingleSymbolRenderer( fill ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( layer->crs() );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+  mapSettings.setOutputSize( QSize( 100, 100 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setBackgroundColor( QColor( 255, 255, 255 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing, true );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << layer.get() );
+
+  // without culling, the tiny polygons are barely visible antialiased specks
+  QgsMapRendererSequentialJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  QImage img = job.renderedImage();
+  QVERIFY( img.pixelColor( 1, 98 ) != QColor( 255, 0, 0 ) );
+  QCOMPARE( img.pixelColor( 70, 30 ), QColor( 255, 0, 0 ) );
+
+  // with culling, both tiny polygons fall in the same pixel and collapse to a single solid dot
+  mapSettings.setFlag( QgsMapSettings::CullSubPixelFeatures, true );
+  QgsMapRendererSequentialJob job2( mapSettings );
+  job2.start();
+  job2.waitForFinished();
+  img = job2.renderedImage();
+  QCOMPARE( img.pixelColor( 1, 98 ), QColor( 255, 0, 0 ) );
+  QCOMPARE( img.pixelColor( 2, 97 ), QColor( 255, 255, 255 ) );
+  // larger features are rendered as usual
+  QCOMPARE( img.pixelColor( 70, 30 ), QColor( 255, 0, 0 ) );
+  QCOMPARE( img.pixelColor( 30, 30 ), QColor( 255, 255, 255 ) );
+
+  // symbols which aren't drawn in a plain color, such as outline only fills, are always rendered normally
+  QgsFillSymbol *outline = QgsFillSymbol::createSimple( QVariantMap( {{ QStringLiteral( "color" ), QStringLiteral( "0,0,255" ) }, { QStringLiteral( "style" ), QStringLiteral( "no" ) }, { QStringLiteral( "outline_color" ), QStringLiteral( "255,0,0" ) }} ) );
+  layer->setRenderer( new QgsSingleSymbolRenderer( outline ) );
+  QgsMapRendererSequentialJob job3( mapSettings );
+  job3.start();
+  job3.waitForFinished();
+  img = job3.renderedImage();
+  QVERIFY( img.pixelColor( 1, 98 ) != QColor( 0, 0, 255 ) );
+
+  // a later dot of a different color is drawn over an earlier one
+  QgsRuleBasedRenderer::Rule *root = new QgsRuleBasedRenderer::Rule( nullptr );
+  QgsFillSymbol *redFill = QgsFillSymbol::createSimple( QVariantMap( {{ QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) }, { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) }} ) );
+  root->appendChild( new QgsRuleBasedRenderer::Rule( redFill, 0, 0, QStringLiteral( "$id = 1" ) ) );
+  QgsFillSymbol *blueFill = QgsFillSymbol::createSimple( QVariantMap( {{ QStringLiteral( "color" ), QStringLiteral( "0,0,255" ) }, { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) }} ) );
+  root->appendChild( new QgsRuleBasedRenderer::Rule( blueFill, 0, 0, QStringLiteral( "$id <> 1" ) ) );
+  layer->setRenderer( new QgsRuleBasedRenderer( root ) );
+  QgsMapRendererSequentialJob job4( mapSettings );
+  job4.start();
+  job4.waitForFinished();
+  img = job4.renderedImage();
+  QCOMPARE( img.pixelColor( 1, 98 ), QColor( 0, 0, 255 ) );
+  QCOMPARE( img.pixelColor( 70, 30 ), QColor( 0, 0, 255 ) );
+
+  // features matching several rules are drawn with every symbol, so they are rendered normally
+  root = new QgsRuleBasedRenderer::Rule( nullptr );
+  root->appendChild( new QgsRuleBasedRenderer::Rule( redFill->clone() ) );
+  root->appendChild( new QgsRuleBasedRenderer::Rule( blueFill->clone() ) );
+  layer->setRenderer( new QgsRuleBasedRenderer( root ) );
+  QgsMapRendererSequentialJob job5( mapSettings );
+  job5.start();
+  job5.waitForFinished();
+  img = job5.renderedImage();
+  QVERIFY( img.pixelColor( 1, 98 ) != QColor( 255, 0, 0 ) );
+  QVERIFY( img.pixelColor( 1, 98 ) != QColor( 0, 0, 255 ) );
+  QCOMPARE( img.pixelColor( 70, 30 ), QColor( 0, 0, 255 ) );
+}
+
+void TestQgsMapRendererJob::cacheMarkerSprites()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857&field=size:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 20; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << ( i % 2 ? 4.0 : 8.0 ) );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 50 + ( i % 5 ) * 200, 100 + ( i / 5 ) * 250 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsMarkerSymbol *marker = QgsMarkerSymbol::createSimple( QVariantMap( {{ QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) }, { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) }} ) );
+  marker->symbolLayer( 0 )->setDataDefinedProperty( QgsSymbolLayer::PropertySize, QgsProperty::fromField( QStringLiteral( "size" ) ) );
+  layer->setRenderer( new QgsSingleSymbolRenderer( marker ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( layer->crs() );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+  mapSettings.setOutputSize( QSize( 200, 200 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setBackgroundColor( QColor( 255, 255, 255 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << layer.get() );
+
+  auto render = [&mapSettings]
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+    return job.renderedImage();
+  };
+  auto countMarkerPixels = []( const QImage & image )
+  {
+    int count = 0;
+    for ( int y = 0; y < image.height(); ++y )
+      for ( int x = 0; x < image.width(); ++x )
+        if ( image.pixelColor( x, y ) != QColor( 255, 255, 255 ) )
+          count++;
+    return count;
+  };
+
+  const QImage direct = render();
+  mapSettings.setFlag( QgsMapSettings::CacheMarkerSprites, true );
+  const QImage cached = render();
+
+  // markers must be drawn at the same places and with the evaluated data defined sizes
+  QCOMPARE( cached.pixelColor( 10, 180 ), QColor( 255, 0, 0 ) );
+  QCOMPARE( cached.pixelColor( 50, 180 ), direct.pixelColor( 50, 180 ) );
+  const int directCount = countMarkerPixels( direct );
+  const int cachedCount = countMarkerPixels( cached );
+  QVERIFY( directCount > 0 );
+  QVERIFY( std::abs( directCount - cachedCount ) < directCount / 10 );
+}
+
+void TestQgsMapRendererJob::cacheMarkerSpritesOnLines()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "LineString?crs=EPSG:3857" ), QStringLiteral( "lines" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+
+  // horizontal, vertical and diagonal lines, each with markers rotated to follow the line
+  QgsFeatureList features;
+  for ( const QString &wkt : { QStringLiteral( "LineString(100 900, 900 900)" ),
+                               QStringLiteral( "LineString(100 100, 100 700)" ),
+                               QStringLiteral( "LineString(300 100, 900 700)" ) } )
+  {
+    QgsFeature f( layer->fields() );
+    f.setGeometry( QgsGeometry::fromWkt( wkt ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsMarkerSymbol *marker = QgsMarkerSymbol::createSimple( QVariantMap( {{ QStringLiteral( "name" ), QStringLiteral( "triangle" ) },
+    { QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) },
+    { QStringLiteral( "outline_style" ), QStringLiteral( "no" ) },
+    { QStringLiteral( "size" ), QStringLiteral( "4" ) }} ) );
+  QgsMarkerLineSymbolLayer *markerLine = new QgsMarkerLineSymbolLayer( true, 8 );
+  markerLine->setSubSymbol( marker );
+  layer->setRenderer( new QgsSingleSymbolRenderer( new QgsLineSymbol( QgsSymbolLayerList() << markerLine ) ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( layer->crs() );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+  mapSettings.setOutputSize( QSize( 200, 200 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setBackgroundColor( QColor( 255, 255, 255 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << layer.get() );
+
+  auto render = [&mapSettings]
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+    return job.renderedImage();
+  };
+
+  const QImage direct = render();
+  mapSettings.setFlag( QgsMapSettings::CacheMarkerSprites, true );
+  const QImage cached = render();
+
+  // markers on the vertical line point along it, so they are symmetric about the line at column 20. Reusing the
+  // sprite of the horizontal line drawn first would point them sideways, with most of their pixels on one side
+  auto sideCounts = []( const QImage & image, int &left, int &right )
+  {
+    left = 0;
+    right = 0;
+    for ( int y = 60; y <= 180; ++y )
+      for ( int x = 0; x < 40; ++x )
+        if ( image.pixelColor( x, y ) != QColor( 255, 255, 255 ) )
+          ( x < 20 ? left : right )++;
+  };
+  int left = 0;
+  int right = 0;
+  sideCounts( direct, left, right );
+  QVERIFY( left + right > 0 );
+  QVERIFY( std::abs( left - right ) < ( left + right ) / 4 );
+  sideCounts( cached, left, right );
+  QVERIFY( left + right > 0 );
+  QVERIFY2( std::abs( left - right ) < ( left + right ) / 4, QStringLiteral( "%1 marker pixels left of the line, %2 right" ).arg( left ).arg( right ).toLocal8Bit().constData() );
+}
+
+void TestQgsMapRendererJob::renderVectorLayersInTiles()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=EPSG:3857&field=class:integer" ), QStringLiteral( "polys" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+
+  // overlapping polygons spanning the tile boundaries, drawn with symbol levels
+  QgsFeatureList features;
+  for ( int i = 0; i < 10; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << i % 2 );
+    f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon((%1 %2, %3 %2, %3 %4, %1 %4, %1 %2))" ).arg( 30 + i * 80 ).arg( 60 + i * 40 ).arg( 330 + i * 60 ).arg( 700 + i * 25 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsFillSymbol *fill = QgsFillSymbol::createSimple( QVariantMap( {{ QStringLiteral( "color" ), QStringLiteral( "255,0,0,150" ) }, { QStringLiteral( "outline_color" ), QStringLiteral( "0,0,255" ) }, { QStringLiteral( "outline_width" ), QStringLiteral( "2" ) }} ) );
+  fill->symbolLayer( 0 )->setRenderingPass( 1 );
+  QgsSymbol *fill2 = fill->clone();
+  fill2->setColor( QColor( 0, 255, 0, 150 ) );
+  fill2->symbolLayer( 0 )->setRenderingPass( 0 );
+  QgsCategorizedSymbolRenderer *renderer = new QgsCategorizedSymbolRenderer( QStringLiteral( "class" ), QgsCategoryList() << QgsRendererCategory( 0, fill, QStringLiteral( "0" ) ) << QgsRendererCategory( 1, fill2, QStringLiteral( "1" ) ) );
+  renderer->setUsingSymbolLevels( true );
+  layer->setRenderer( renderer );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( layer->crs() );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+  mapSettings.setOutputSize( QSize( 400, 400 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setBackgroundColor( QColor( 255, 255, 255 ) );
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing, true );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << layer.get() );
+
+  auto render = [&mapSettings]
+  {
+    QgsMapRendererParallelJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+    return job.renderedImage();
+  };
+
+  const QImage direct = render();
+  mapSettings.setFlag( QgsMapSettings::RenderVectorLayersInTiles, true );
+  const QImage tiled = render();
+
+  // tiles do not overlap and each draws every feature touching it, so the result must be identical
+  QCOMPARE( tiled.size(), direct.size() );
+  int mismatches = 0;
+  for ( int y = 0; y < direct.height(); ++y )
+    for ( int x = 0; x < direct.width(); ++x )
+      if ( tiled.pixel( x, y ) != direct.pixel( x, y ) )
+        mismatches++;
+  QCOMPARE( mismatches, 0 );
+
+  // feature blending must still apply between the features of the layer, so layers using it are rendered in one piece
+  layer->setFeatureBlendMode( QPainter::CompositionMode_Multiply );
+  mapSettings.setFlag( QgsMapSettings::RenderVectorLayersInTiles, false );
+  const QImage directBlended = render();
+  mapSettings.setFlag( QgsMapSettings::RenderVectorLayersInTiles, true );
+  const QImage tiledBlended = render();
+  QCOMPARE( tiledBlended, directBlended );
+}
+
+void TestQgsMapRendererJob::renderDraftPreview()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 6000; ++i )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i % 100, i / 60 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( layer->crs() );
+  mapSettings.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  mapSettings.setOutputSize( QSize( 100, 100 ) );
+  mapSettings.setLayers( QList< QgsMapLayer * >() << layer.get() );
+
+  auto renderedCount = [&mapSettings]
+  {
+    QList< QgsFeature > rendered;
+    QList< QgsGeometry > geometries;
+    TestHandler handler( rendered, geometries );
+    QgsMapSettings settings = mapSettings;
+    settings.addRenderedFeatureHandler( &handler );
+    QgsMapRendererSequentialJob job( settings );
+    job.start();
+    job.waitForFinished();
+    return rendered.size();
+  };
+
+  QCOMPARE( renderedCount(), 6000 );
+
+  // draft renders only draw a subset of the features
+  mapSettings.setFlag( QgsMapSettings::RenderDraftPreview, true );
+  QCOMPARE( renderedCount(), 5000 );
+}
+
 bool TestQgsMapRendererJob::imageCheck( const QString &testName, const QImage &image, int mismatchCount )
 {
   mReport += "<h2>" + testName + "</h2>\n";
@@ -25,6 +25,7 @@
 #include "qgsfield.h"
 #include "qgsgeometry.h"
 #include "qgsogrutils.h"
+#include "qgswkbgeometryview.h"
 #include "qgsapplication.h"
 #include "qgspoint.h"
 #include "qgsogrproxytextcodec.h"
@@ -46,6 +47,7 @@ class TestQgsOgrUtils: public QObject
     void ogrGeometryToQgsGeometry();
     void ogrGeometryToQgsGeometry2_data();
     void ogrGeometryToQgsGeometry2();
+    void ogrGeometryToWkbGeometryView();
     void readOgrFeatureGeometry();
     void getOgrFeatureAttribute();
     void readOgrFeatureAttributes();
@@ -228,6 +230,36 @@ void TestQgsOgrUtils::ogrGeometryToQgsGeometry2()
   QCOMPARE( geom.asWkt( 3 ), wkt );
 }
 
+void TestQgsOgrUtils::ogrGeometryToWkbGeometryView()
+{
+  QVERIFY( QgsOgrUtils::ogrGeometryToWkbGeometryView( nullptr ).isNull() );
+
+  OGRGeometryH ogrGeom = nullptr;
+  QByteArray wkt( "GEOMETRYCOLLECTION (POINT (1 2),LINESTRING (3 4,5 -6))" );
+  char *wktChar = wkt.data();
+  OGR_G_CreateFromWkt( &wktChar, nullptr, &ogrGeom );
+  QgsWkbGeometryView view = QgsOgrUtils::ogrGeometryToWkbGeometryView( ogrGeom );
+  OGR_G_DestroyGeometry( ogrGeom );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::GeometryCollection );
+  // the bounding box of straight geometries is read from the WKB, without parsing the geometry
+  QCOMPARE( view.boundingBox(), QgsRectangle( 1, -6, 5, 4 ) );
+  QVERIFY( view.boundingBoxIntersects( QgsRectangle( 4, 0, 10, 10 ) ) );
+  QVERIFY( !view.boundingBoxIntersects( QgsRectangle( 6, 0, 10, 10 ) ) );
+  QVERIFY( !view.isMaterialized() );
+  QCOMPARE( view.geometry().asWkt(), QStringLiteral( "GeometryCollection (Point (1 2),LineString (3 4, 5 -6))" ) );
+
+  // TINs are mapped to multipolygons
+  ogrGeom = nullptr;
+  wkt = QByteArray( "TIN (((0 0,0 1,1 1,0 0)))" );
+  wktChar = wkt.data();
+  OGR_G_CreateFromWkt( &wktChar, nullptr, &ogrGeom );
+  view = QgsOgrUtils::ogrGeometryToWkbGeometryView( ogrGeom );
+  OGR_G_DestroyGeometry( ogrGeom );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::MultiPolygon );
+  QCOMPARE( view.boundingBox(), QgsRectangle( 0, 0, 1, 1 ) );
+  QCOMPARE( view.geometry().asWkt(), QStringLiteral( "MultiPolygon (((0 0, 0 1, 1 1, 0 0)))" ) );
+}
+
 void TestQgsOgrUtils::readOgrFeatureGeometry()
 {
   QgsFeature f;
@@ -0,0 +1,222 @@
+/***************************************************************************
+     testqgspointaggregationpyramid.cpp
+     ----------------------------------
+    Date                 : October 2021
+    Copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <qgsapplication.h>
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgspointaggregationpyramid.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+class TestQgsPointAggregationPyramid : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
+    }
+
+    void testBuild()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point" ), QString(), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      // 100 x 100 grid of points, with a second point stacked on each point of the first row
+      for ( int row = 0; row < 100; ++row )
+      {
+        for ( int col = 0; col < 100; ++col )
+        {
+          QgsFeature f;
+          f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( col + 0.5, row + 0.5 ) ) );
+          features << f;
+        }
+      }
+      for ( int col = 0; col < 100; ++col )
+      {
+        QgsFeature f;
+        f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "MultiPoint((%1 0.5))" ).arg( col + 0.5 ) ) );
+        features << f;
+      }
+      QVERIFY( vl->dataProvider()->addFeatures( features ) );
+
+      QgsFeatureIterator it = vl->dataProvider()->getFeatures();
+      std::unique_ptr< QgsPointAggregationPyramid > pyramid = QgsPointAggregationPyramid::build( it, QgsRectangle( 0, 0, 100, 100 ) );
+      QVERIFY( pyramid );
+      QCOMPARE( pyramid->pointCount(), 10100LL );
+      QCOMPARE( pyramid->cellSize( 0 ), 100.0 );
+      QCOMPARE( pyramid->cellSize( 1 ), 50.0 );
+
+      // level 0 has a single cell holding all points
+      QVector< QgsPointAggregationPyramid::Bin > bins;
+      QVERIFY( pyramid->bins( QgsRectangle( 0, 0, 100, 100 ), 100, bins ) );
+      QCOMPARE( bins.size(), 1 );
+      QCOMPARE( bins.at( 0 ).count, 10100LL );
+      QGSCOMPARENEAR( bins.at( 0 ).x, 50.0, 0.000001 );
+
+      // 10 unit cells must use level 4 (6.25 unit cells), with one cell per 6.25 x 6.25 block
+      QVERIFY( pyramid->bins( QgsRectangle( 0, 0, 100, 100 ), 10, bins ) );
+      QCOMPARE( bins.size(), 256 );
+      qint64 total = 0;
+      for ( const QgsPointAggregationPyramid::Bin &bin : std::as_const( bins ) )
+        total += bin.count;
+      QCOMPARE( total, 10100LL );
+
+      // queries are limited to the requested rectangle
+      QVERIFY( pyramid->bins( QgsRectangle( 0, 0, 6, 6 ), 10, bins ) );
+      QCOMPARE( bins.size(), 1 );
+      QCOMPARE( bins.at( 0 ).count, 36LL + 6 );
+      QGSCOMPARENEAR( bins.at( 0 ).x, 3.0, 0.000001 );
+
+      // levels stop once cells hold at most two points on average, at 0.78 unit cells
+      QCOMPARE( pyramid->levelCount(), 8 );
+
+      // cells finer than the finest level can't be satisfied
+      QVERIFY( !pyramid->bins( QgsRectangle( 0, 0, 100, 100 ), 0.01, bins ) );
+    }
+
+    void testDepthFollowsDensity()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point" ), QString(), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      // 10 x 10 grid of points with unit spacing in one corner of a huge extent
+      for ( int row = 0; row < 10; ++row )
+      {
+        for ( int col = 0; col < 10; ++col )
+        {
+          QgsFeature f;
+          f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( col + 0.5, row + 0.5 ) ) );
+          features << f;
+        }
+      }
+      QgsFeature f;
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 1000000, 1000000 ) ) );
+      features << f;
+      QVERIFY( vl->dataProvider()->addFeatures( features ) );
+
+      QgsFeatureIterator it = vl->dataProvider()->getFeatures();
+      std::unique_ptr< QgsPointAggregationPyramid > pyramid = QgsPointAggregationPyramid::build( it, QgsRectangle( 0, 0, 1000000, 1000000 ) );
+      QVERIFY( pyramid );
+      QCOMPARE( pyramid->pointCount(), 101LL );
+
+      // the pyramid must go deep enough to separate the grid points, far beyond a 1024 x 1024 grid
+      QCOMPARE( pyramid->levelCount(), 21 );
+      QVERIFY( pyramid->cellSize( pyramid->levelCount() - 1 ) < 1 );
+
+      // 2 unit cells use level 19 (1.9 unit cells), aggregating the grid into 5 x 5 cells
+      QVector< QgsPointAggregationPyramid::Bin > bins;
+      QVERIFY( pyramid->bins( QgsRectangle( 0, 0, 20, 20 ), 2, bins ) );
+      QCOMPARE( bins.size(), 25 );
+      qint64 total = 0;
+      for ( const QgsPointAggregationPyramid::Bin &bin : std::as_const( bins ) )
+        total += bin.count;
+      QCOMPARE( total, 100LL );
+
+      QVERIFY( !pyramid->bins( QgsRectangle( 0, 0, 20, 20 ), 0.5, bins ) );
+    }
+
+    void testStackedPoints()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point" ), QString(), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      // points stacked three high can always be aggregated, so every level is kept
+      for ( int i = 0; i < 10; ++i )
+      {
+        QgsFeature f;
+        f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "MultiPoint((%1 %1),(%1 %1),(%1 %1))" ).arg( i ) ) );
+        features << f;
+      }
+      QVERIFY( vl->dataProvider()->addFeatures( features ) );
+
+      QgsFeatureIterator it = vl->dataProvider()->getFeatures();
+      std::unique_ptr< QgsPointAggregationPyramid > pyramid = QgsPointAggregationPyramid::build( it, QgsRectangle( 0, 0, 9, 9 ) );
+      QVERIFY( pyramid );
+      QCOMPARE( pyramid->pointCount(), 30LL );
+      QCOMPARE( pyramid->levelCount(), QgsPointAggregationPyramid::MAX_LEVEL + 1 );
+
+      QVector< QgsPointAggregationPyramid::Bin > bins;
+      QVERIFY( pyramid->bins( QgsRectangle( 0, 0, 9, 9 ), 0.001, bins ) );
+      QCOMPARE( bins.size(), 10 );
+      QCOMPARE( bins.at( 0 ).count, 3LL );
+    }
+
+    void testSidecar()
+    {
+      QTemporaryDir dir;
+      const QString sourcePath = dir.filePath( QStringLiteral( "source.csv" ) );
+      QFile source( sourcePath );
+      QVERIFY( source.open( QIODevice::WriteOnly ) );
+      source.write( "xxxx" );
+      source.close();
+      const QString layerSource = QStringLiteral( "file://%1?xField=x&yField=y" ).arg( sourcePath );
+
+      QVERIFY( !QgsPointAggregationPyramid::load( layerSource, sourcePath ) );
+      QVERIFY( !QgsPointAggregationPyramid::cachedPyramid( layerSource, sourcePath ) );
+
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point" ), QString(), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      for ( int i = 0; i < 10; ++i )
+      {
+        QgsFeature f;
+        f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+        features << f;
+      }
+      QVERIFY( vl->dataProvider()->addFeatures( features ) );
+      QgsFeatureIterator it = vl->dataProvider()->getFeatures();
+      std::unique_ptr< QgsPointAggregationPyramid > pyramid = QgsPointAggregationPyramid::build( it, QgsRectangle( 0, 0, 9, 9 ) );
+      QVERIFY( pyramid );
+
+      QVERIFY( QgsPointAggregationPyramid::write( layerSource, sourcePath, *pyramid ) );
+      std::unique_ptr< QgsPointAggregationPyramid > loaded = QgsPointAggregationPyramid::load( layerSource, sourcePath );
+      QVERIFY( loaded );
+      QCOMPARE( loaded->pointCount(), 10LL );
+      QCOMPARE( loaded->extent(), QgsRectangle( 0, 0, 9, 9 ) );
+      QVector< QgsPointAggregationPyramid::Bin > bins;
+      QVERIFY( loaded->bins( QgsRectangle( 0, 0, 9, 9 ), 9, bins ) );
+      QCOMPARE( bins.size(), 1 );
+      QCOMPARE( bins.at( 0 ).count, 10LL );
+
+      std::shared_ptr< const QgsPointAggregationPyramid > cached = QgsPointAggregationPyramid::cachedPyramid( layerSource, sourcePath );
+      QVERIFY( cached );
+      QCOMPARE( QgsPointAggregationPyramid::cachedPyramid( layerSource, sourcePath ).get(), cached.get() );
+
+      // pyramids are specific to a layer source
+      QVERIFY( !QgsPointAggregationPyramid::load( layerSource + QStringLiteral( "&other" ), sourcePath ) );
+
+      // modifying the source must invalidate the sidecar
+      QVERIFY( source.open( QIODevice::Append ) );
+      source.write( "yy" );
+      source.close();
+      QVERIFY( !QgsPointAggregationPyramid::load( layerSource, sourcePath ) );
+      QVERIFY( !QgsPointAggregationPyramid::cachedPyramid( layerSource, sourcePath ) );
+
+      QVERIFY( QgsPointAggregationPyramid::remove( layerSource, sourcePath ) );
+      QVERIFY( !QFile::exists( QgsPointAggregationPyramid::sidecarPath( layerSource, sourcePath ) ) );
+    }
+};
+
+QGSTEST_MAIN( TestQgsPointAggregationPyramid )
+
+#include "testqgspointaggregationpyramid.moc"
@@ -39,6 +39,7 @@ class TestQgsRasterBlock : public QObject
 
     void testBasic();
     void testWrite();
+    void testView();
 
   private:
 
@@ -242,6 +243,79 @@ void TestQgsRasterBlock::testWrite()
   delete block;
 }
 
+void TestQgsRasterBlock::testView()
+{
+  QgsRasterDataProvider *provider = mpRasterLayer->dataProvider();
+  std::unique_ptr< QgsRasterBlock > block( provider->block( 1, mpRasterLayer->extent(), mpRasterLayer->width(), mpRasterLayer->height() ) );
+  const QgsRasterBlock *constBlock = block.get();
+
+  // views of a different type are invalid
+  QVERIFY( !constBlock->view< qint16 >().isValid() );
+  QVERIFY( !constBlock->view< float >().isValid() );
+  QVERIFY( !QgsRasterBlock().view< quint8 >().isValid() );
+
+  const QgsRasterBlockView< const quint8 > view = constBlock->view< quint8 >();
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.width(), 10 );
+  QCOMPARE( view.height(), 10 );
+  QCOMPARE( view.count(), static_cast< qgssize >( 100 ) );
+  QVERIFY( view.hasNoDataValue() );
+  QCOMPARE( view.noDataValue(), 255. );
+  QCOMPARE( view[0], static_cast< quint8 >( 2 ) );
+  QCOMPARE( view[1], static_cast< quint8 >( 5 ) );
+  QCOMPARE( view.row( 1 )[0], static_cast< quint8 >( 27 ) );
+  for ( qgssize i = 0; i < view.count(); ++i )
+  {
+    QCOMPARE( view.isNoData( i ), block->isNoData( i ) );
+    QCOMPARE( static_cast< double >( view[i] ), block->value( i ) );
+  }
+  QVERIFY( view.isNoData( 0, 2 ) );
+  QVERIFY( !view.isNoData( 0, 1 ) );
+
+  // visitView calls the function with a view of the native type
+  int visitCount = 0;
+  bool isByteView = false;
+  double visitedValue = 0;
+  const bool visited = constBlock->visitView( [&]( auto typedView )
+  {
+    visitCount++;
+    isByteView = std::is_same< typename decltype( typedView )::ValueType, quint8 >::value;
+    visitedValue = typedView[10];
+  } );
+  QVERIFY( visited );
+  QVERIFY( isByteView );
+  QCOMPARE( visitedValue, 27.0 );
+  QCOMPARE( visitCount, 1 );
+
+  // values can be changed through views of non const blocks
+  const bool written = block->visitView( []( auto typedView )
+  {
+    typedView[10] = 42;
+  } );
+  QVERIFY( written );
+  QCOMPARE( block->value( 10 ), 42. );
+
+  // no data bitmap
+  QgsRasterBlock bitmapBlock( Qgis::Float32, 10, 2 );
+  bitmapBlock.setIsNoData();
+  bitmapBlock.setValue( 1, 9, 1.5 );
+  bitmapBlock.setIsData( 1, 9 );
+  const QgsRasterBlockView< const float > floatView = std::as_const( bitmapBlock ).view< float >();
+  QVERIFY( floatView.isValid() );
+  QVERIFY( !floatView.hasNoDataValue() );
+  QVERIFY( floatView.hasNoData() );
+  QVERIFY( floatView.isNoData( 0, 0 ) );
+  QVERIFY( floatView.isNoData( 1, 8 ) );
+  QVERIFY( !floatView.isNoData( 1, 9 ) );
+  QVERIFY( !floatView.isNoData( static_cast< qgssize >( 19 ) ) );
+  QCOMPARE( floatView[19], 1.5f );
+
+  // non numeric blocks can't be viewed
+  QgsRasterBlock imageBlock( Qgis::ARGB32, 2, 2 );
+  const bool imageVisited = imageBlock.visitView( []( auto ) {} );
+  QVERIFY( !imageVisited );
+}
+
 QGSTEST_MAIN( TestQgsRasterBlock )
 
 #include "testqgsrasterblock.moc"
@@ -25,6 +25,7 @@
 #include <QTemporaryFile>
 
 #include "cpl_conv.h"
+#include "gdal.h"
 
 //qgis includes...
 #include <qgsrasterchecker.h>
@@ -33,6 +34,7 @@
 #include <qgsrasterfilewriter.h>
 #include <qgsrasternuller.h>
 #include "qgsrasterprojector.h"
+#include "qgsogrutils.h"
 #include <qgsapplication.h>
 
 /**
@@ -52,6 +54,8 @@ class TestQgsRasterFileWriter: public QObject
     void testCreateOneBandRaster();
     void testCreateMultiBandRaster();
     void testVrtCreation();
+    void testParallelWrite();
+    void testCogWrite();
   private:
     bool writeTest( const QString &rasterName );
     void log( const QString &msg );
@@ -325,6 +329,78 @@ void TestQgsRasterFileWriter::testVrtCreation()
   QGSCOMPARENEAR( yminVrt, yminOriginal, srcRasterLayer->rasterUnitsPerPixelY() / 4 );
 }
 
+void TestQgsRasterFileWriter::testParallelWrite()
+{
+  const QString srcFileName = mTestDataDir + QStringLiteral( "landsat.tif" );
+  std::unique_ptr< QgsRasterLayer > srcRasterLayer = std::make_unique< QgsRasterLayer >( srcFileName, QStringLiteral( "landsat" ) );
+  QVERIFY( srcRasterLayer->isValid() );
+
+  QTemporaryDir dir;
+  for ( int threads : { 1, 4 } )
+  {
+    const QString outputFileName = dir.filePath( QStringLiteral( "parallel_%1.tif" ).arg( threads ) );
+    QgsRasterFileWriter fileWriter( outputFileName );
+    // use small tiles, so that many parts are read ahead of the part being written
+    fileWriter.setMaxTileWidth( 37 );
+    fileWriter.setMaxTileHeight( 23 );
+    fileWriter.setMaxThreads( threads );
+    QCOMPARE( fileWriter.maxThreads(), threads );
+
+    QgsRasterPipe pipe;
+    QVERIFY( pipe.set( srcRasterLayer->dataProvider()->clone() ) );
+    QgsRasterDataProvider *provider = srcRasterLayer->dataProvider();
+    QCOMPARE( fileWriter.writeRaster( &pipe, provider->xSize(), provider->ySize(), provider->extent(), provider->crs(), provider->transformContext() ), QgsRasterFileWriter::NoError );
+
+    QgsRasterChecker checker;
+    const bool ok = checker.runTest( QStringLiteral( "gdal" ), outputFileName, QStringLiteral( "gdal" ), srcFileName );
+    mReport += checker.report();
+    QVERIFY( ok );
+  }
+}
+
+void TestQgsRasterFileWriter::testCogWrite()
+{
+  if ( !GDALGetDriverByName( "COG" ) )
+    QSKIP( "GDAL COG driver not available" );
+
+  const QString srcFileName = mTestDataDir + QStringLiteral( "landsat.tif" );
+  std::unique_ptr< QgsRasterLayer > srcRasterLayer = std::make_unique< QgsRasterLayer >( srcFileName, QStringLiteral( "landsat" ) );
+  QVERIFY( srcRasterLayer->isValid() );
+
+  QTemporaryDir dir;
+  const QString outputFileName = dir.filePath( QStringLiteral( "cog.tif" ) );
+  QgsRasterFileWriter fileWriter( outputFileName );
+  fileWriter.setCogMode( true );
+  QVERIFY( fileWriter.cogMode() );
+  fileWriter.setCreateOptions( QStringList() << QStringLiteral( "COMPRESS=DEFLATE" ) << QStringLiteral( "BLOCKSIZE=64" ) );
+  fileWriter.setPyramidsList( QList< int >() << 2 << 4 );
+
+  QgsRasterPipe pipe;
+  QVERIFY( pipe.set( srcRasterLayer->dataProvider()->clone() ) );
+  QgsRasterDataProvider *provider = srcRasterLayer->dataProvider();
+  QCOMPARE( fileWriter.writeRaster( &pipe, provider->xSize(), provider->ySize(), provider->extent(), provider->crs(), provider->transformContext() ), QgsRasterFileWriter::NoError );
+
+  // the intermediate file must be removed
+  QVERIFY( !QFile::exists( outputFileName + QStringLiteral( ".tmp.tif" ) ) );
+
+  QgsRasterChecker checker;
+  const bool ok = checker.runTest( QStringLiteral( "gdal" ), outputFileName, QStringLiteral( "gdal" ), srcFileName );
+  mReport += checker.report();
+  QVERIFY( ok );
+
+  gdal::dataset_unique_ptr dataset( GDALOpen( outputFileName.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( dataset );
+  QCOMPARE( QString( GDALGetMetadataItem( dataset.get(), "LAYOUT", "IMAGE_STRUCTURE" ) ), QStringLiteral( "COG" ) );
+  QCOMPARE( QString( GDALGetMetadataItem( dataset.get(), "COMPRESSION", "IMAGE_STRUCTURE" ) ), QStringLiteral( "DEFLATE" ) );
+  GDALRasterBandH band = GDALGetRasterBand( dataset.get(), 1 );
+  int blockXSize = 0;
+  int blockYSize = 0;
+  GDALGetBlockSize( band, &blockXSize, &blockYSize );
+  QCOMPARE( blockXSize, 64 );
+  QCOMPARE( blockYSize, 64 );
+  QCOMPARE( GDALGetOverviewCount( band ), 2 );
+}
+
 void TestQgsRasterFileWriter::log( const QString &msg )
 {
   mReport += msg + "<br>";
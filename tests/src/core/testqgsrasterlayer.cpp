@@ -38,6 +38,7 @@
 #include <qgssinglebandgrayrenderer.h>
 #include <qgssinglebandpseudocolorrenderer.h>
 #include <qgsmultibandcolorrenderer.h>
+#include <qgscontrastenhancement.h>
 #include <qgscolorramp.h>
 #include <qgscptcityarchive.h>
 #include "qgscolorrampshader.h"
@@ -46,6 +47,7 @@
 #include "qgsrastertransparency.h"
 #include "qgspalettedrasterrenderer.h"
 #include "qgsrasterlayertemporalproperties.h"
+#include "qgsrasterprojector.h"
 
 //qgis unit test includes
 #include <qgsrenderchecker.h>
@@ -81,13 +83,19 @@ class TestQgsRasterLayer : public QObject
     void landsatBasic875Qml();
     void checkDimensions();
     void checkStats();
+    void checkBlockStatistics();
+    void approximateDefaultHistogram();
+    void checkReprojectedBlock();
     void checkScaleOffset();
     void buildExternalOverviews();
+    void buildNativeOverviews_data();
+    void buildNativeOverviews();
     void registry();
     void transparency();
     void multiBandColorRenderer();
     void multiBandColorRendererNoData();
     void multiBandColorRendererNoDataColor();
+    void multiBandColorRendererLookupTables();
     void palettedRendererNoData();
     void palettedRendererNoDataColor();
     void singleBandGrayRendererNoData();
@@ -440,6 +448,147 @@ void TestQgsRasterLayer::checkStats()
   QGSCOMPARENEAR( myStatistics.stdDev, 0.707107, 0.00001 );
 }
 
+void TestQgsRasterLayer::checkBlockStatistics()
+{
+  // sub extents are not handled by GDAL, so these use the generic block based calculation
+  for ( QgsRasterLayer *layer : { mpLandsatRasterLayer, mpFloat32RasterLayer } )
+  {
+    QgsRasterDataProvider *provider = layer->dataProvider();
+    QgsRectangle extent = provider->extent();
+    const double xRes = extent.width() / provider->xSize();
+    const double yRes = extent.height() / provider->ySize();
+    extent.setXMinimum( extent.xMinimum() + ( provider->xSize() / 4 ) * xRes );
+    extent.setYMaximum( extent.yMaximum() - ( provider->ySize() / 4 ) * yRes );
+
+    const QgsRasterBandStats stats = provider->bandStatistics( 1, QgsRasterBandStats::All, extent );
+    const QgsRasterHistogram histogram = provider->histogram( 1, 100, stats.minimumValue, stats.maximumValue, extent );
+    QVERIFY( histogram.valid );
+
+    // compare against values calculated from a single block of the same extent
+    std::unique_ptr< QgsRasterBlock > block( provider->block( 1, extent, stats.width, stats.height ) );
+    qgssize count = 0;
+    double sum = 0;
+    double minimum = std::numeric_limits<double>::max();
+    double maximum = std::numeric_limits<double>::lowest();
+    std::vector< double > values;
+    for ( qgssize i = 0; i < static_cast< qgssize >( stats.width ) * stats.height; ++i )
+    {
+      bool isNoData = false;
+      const double value = block->valueAndNoData( i, isNoData );
+      if ( isNoData )
+        continue;
+      count++;
+      sum += value;
+      minimum = std::min( minimum, value );
+      maximum = std::max( maximum, value );
+      values.emplace_back( value );
+    }
+    QVERIFY( count > 0 );
+    const double mean = sum / count;
+    double sumOfSquares = 0;
+    for ( double value : values )
+      sumOfSquares += ( value - mean ) * ( value - mean );
+
+    QCOMPARE( stats.elementCount, count );
+    QCOMPARE( stats.minimumValue, minimum );
+    QCOMPARE( stats.maximumValue, maximum );
+    QGSCOMPARENEAR( stats.mean, mean, 0.000001 );
+    QGSCOMPARENEAR( stats.stdDev, std::sqrt( sumOfSquares / ( count - 1 ) ), 0.000001 );
+
+    const double interval = ( maximum - minimum ) / 100;
+    const double histogramMinimum = minimum - 0.1 * interval;
+    const double binSize = ( maximum + 0.1 * interval - histogramMinimum ) / 100;
+    QVector< int > bins( 100 );
+    for ( double value : values )
+    {
+      const int bin = static_cast< int >( std::floor( ( value - histogramMinimum ) / binSize ) );
+      if ( bin >= 0 && bin < 100 )
+        bins[bin]++;
+    }
+    QCOMPARE( histogram.histogramVector, bins );
+    QCOMPARE( histogram.nonNullCount, static_cast< int >( count ) );
+  }
+}
+
+void TestQgsRasterLayer::approximateDefaultHistogram()
+{
+  const QString tempPath = QDir::tempPath() + '/';
+  QFile::remove( tempPath + "landsat_histogram.tif.aux.xml" );
+  QFile::remove( tempPath + "landsat_histogram.tif" );
+  QVERIFY( QFile::copy( mTestDataDir + "landsat.tif", tempPath + "landsat_histogram.tif" ) );
+
+  // store a default histogram which does not match the data, as an approximate histogram might not
+  // (histogram() with 10 bins from 0 to 250 uses bins from -12.5 to 262.5)
+  GDALDatasetH dataset = GDALOpen( QString( tempPath + "landsat_histogram.tif" ).toLocal8Bit().constData(), GA_ReadOnly );
+  QVERIFY( dataset );
+  std::vector< GUIntBig > approximate( 10, 1 );
+  QCOMPARE( GDALSetDefaultHistogramEx( GDALGetRasterBand( dataset, 1 ), -12.5, 262.5, 10, approximate.data() ), CE_None );
+  GDALClose( dataset );
+
+  std::unique_ptr< QgsRasterLayer > layer = std::make_unique< QgsRasterLayer >( tempPath + "landsat_histogram.tif", QStringLiteral( "landsat" ) );
+  QVERIFY( layer->isValid() );
+  const QVector< int > approximateBins( 10, 1 );
+
+  // the stored histogram is only reused for approximate requests
+  const QgsRasterHistogram sampled = layer->dataProvider()->histogram( 1, 10, 0, 250, QgsRectangle(), 100 );
+  QVERIFY( sampled.valid );
+  QCOMPARE( sampled.histogramVector, approximateBins );
+
+  const QgsRasterHistogram exact = layer->dataProvider()->histogram( 1, 10, 0, 250 );
+  QVERIFY( exact.valid );
+  QVERIFY( exact.histogramVector != approximateBins );
+  layer.reset();
+
+  // exact histograms calculated by QGIS are reused for exact requests
+  layer = std::make_unique< QgsRasterLayer >( tempPath + "landsat_histogram.tif", QStringLiteral( "landsat" ) );
+  QVERIFY( layer->dataProvider()->hasHistogram( 1, 10, 0, 250 ) );
+  QCOMPARE( layer->dataProvider()->histogram( 1, 10, 0, 250 ).histogramVector, exact.histogramVector );
+}
+
+void TestQgsRasterLayer::checkReprojectedBlock()
+{
+  QgsRasterDataProvider *provider = mpLandsatRasterLayer->dataProvider();
+  const QgsCoordinateReferenceSystem destCrs( QStringLiteral( "EPSG:4326" ) );
+  const QgsCoordinateTransform ct( provider->crs(), destCrs, QgsProject::instance()->transformContext() );
+  const QgsRectangle extent = ct.transformBoundingBox( provider->extent() );
+  const int width = 150;
+  const int height = 130;
+
+  QgsRasterProjector projector;
+  projector.setInput( provider );
+  projector.setCrs( provider->crs(), destCrs, QgsProject::instance()->transformContext() );
+
+  projector.setPrecision( QgsRasterProjector::Approximate );
+  std::unique_ptr< QgsRasterBlock > approximate( projector.block( 1, extent, width, height ) );
+  QVERIFY( approximate && approximate->isValid() );
+  // a repeated request reuses the cached reprojection grid, and must give the same result
+  std::unique_ptr< QgsRasterBlock > cached( projector.block( 1, extent, width, height ) );
+  QCOMPARE( cached->data(), approximate->data() );
+
+  projector.setPrecision( QgsRasterProjector::Exact );
+  std::unique_ptr< QgsRasterBlock > exact( projector.block( 1, extent, width, height ) );
+  QVERIFY( exact && exact->isValid() );
+
+  // the approximation is within a destination pixel of the exact reprojection, so the results should
+  // only differ along the edges between source pixels
+  int dataCount = 0;
+  int matchCount = 0;
+  for ( int row = 0; row < height; ++row )
+  {
+    for ( int col = 0; col < width; ++col )
+    {
+      if ( exact->isNoData( row, col ) )
+        continue;
+
+      dataCount++;
+      if ( !approximate->isNoData( row, col ) && approximate->value( row, col ) == exact->value( row, col ) )
+        matchCount++;
+    }
+  }
+  QVERIFY( dataCount > width * height / 2 );
+  QVERIFY( matchCount > dataCount * 0.9 );
+}
+
 // test scale_factor and offset - uses netcdf file which may not be supported
 // see https://github.com/qgis/QGIS/issues/17186
 void TestQgsRasterLayer::checkScaleOffset()
@@ -609,6 +758,80 @@ void TestQgsRasterLayer::buildExternalOverviews()
 }
 
 
+void TestQgsRasterLayer::buildNativeOverviews_data()
+{
+  QTest::addColumn<QString>( "resampling" );
+  // maximum difference to the overviews built by GDAL for each level
+  QTest::addColumn<QList<double>>( "tolerances" );
+
+  QTest::newRow( "nearest" ) << QStringLiteral( "NEAREST" ) << ( QList<double>() << 0 << 0 << 0 );
+  // average levels are cascaded by both, so rounding differences of the byte values can add up from level to level
+  QTest::newRow( "average" ) << QStringLiteral( "AVERAGE" ) << ( QList<double>() << 1 << 2 << 3 );
+}
+
+void TestQgsRasterLayer::buildNativeOverviews()
+{
+  QFETCH( QString, resampling );
+  QFETCH( QList<double>, tolerances );
+
+  // nearest and average overviews are built natively, compare them to the overviews built by GDAL
+  const QString tempPath = QDir::tempPath() + '/';
+  for ( const QString &name : { QStringLiteral( "landsat_native.tif" ), QStringLiteral( "landsat_gdal.tif" ) } )
+  {
+    QFile::remove( tempPath + name + ".ovr" );
+    QFile::remove( tempPath + name );
+    QVERIFY( QFile::copy( mTestDataDir + "landsat.tif", tempPath + name ) );
+  }
+
+  std::unique_ptr< QgsRasterLayer > layer = std::make_unique< QgsRasterLayer >( tempPath + "landsat_native.tif", QStringLiteral( "landsat" ) );
+  QVERIFY( layer->isValid() );
+  QList< QgsRasterPyramid > pyramidList = layer->dataProvider()->buildPyramidList( QList<int>() << 2 << 4 << 8 );
+  for ( QgsRasterPyramid &pyramid : pyramidList )
+    pyramid.setBuild( true );
+  QgsRasterBlockFeedback feedback;
+  QVERIFY( layer->dataProvider()->buildPyramids( pyramidList, resampling, QgsRaster::PyramidsGTiff, QStringList(), &feedback ).isEmpty() );
+  QCOMPARE( feedback.progress(), 100.0 );
+  layer.reset();
+  QVERIFY( QFile::exists( tempPath + "landsat_native.tif.ovr" ) );
+
+  GDALDatasetH gdalDataset = GDALOpen( QString( tempPath + "landsat_gdal.tif" ).toLocal8Bit().constData(), GA_ReadOnly );
+  QVERIFY( gdalDataset );
+  int levels[] = { 2, 4, 8 };
+  QCOMPARE( GDALBuildOverviews( gdalDataset, resampling.toLocal8Bit().constData(), 3, levels, 0, nullptr, nullptr, nullptr ), CE_None );
+  GDALDatasetH nativeDataset = GDALOpen( QString( tempPath + "landsat_native.tif" ).toLocal8Bit().constData(), GA_ReadOnly );
+  QVERIFY( nativeDataset );
+
+  for ( int bandNo = 1; bandNo <= GDALGetRasterCount( gdalDataset ); ++bandNo )
+  {
+    GDALRasterBandH gdalBand = GDALGetRasterBand( gdalDataset, bandNo );
+    GDALRasterBandH nativeBand = GDALGetRasterBand( nativeDataset, bandNo );
+    QCOMPARE( GDALGetOverviewCount( gdalBand ), 3 );
+    QCOMPARE( GDALGetOverviewCount( nativeBand ), 3 );
+
+    for ( int overview = 0; overview < 3; ++overview )
+    {
+      GDALRasterBandH gdalOverview = GDALGetOverview( gdalBand, overview );
+      GDALRasterBandH nativeOverview = GDALGetOverview( nativeBand, overview );
+      const int width = GDALGetRasterBandXSize( gdalOverview );
+      const int height = GDALGetRasterBandYSize( gdalOverview );
+      QCOMPARE( GDALGetRasterBandXSize( nativeOverview ), width );
+      QCOMPARE( GDALGetRasterBandYSize( nativeOverview ), height );
+      std::vector< double > gdalValues( static_cast< std::size_t >( width ) * height );
+      std::vector< double > nativeValues( gdalValues.size() );
+      QCOMPARE( GDALRasterIO( gdalOverview, GF_Read, 0, 0, width, height, gdalValues.data(), width, height, GDT_Float64, 0, 0 ), CE_None );
+      QCOMPARE( GDALRasterIO( nativeOverview, GF_Read, 0, 0, width, height, nativeValues.data(), width, height, GDT_Float64, 0, 0 ), CE_None );
+      for ( std::size_t i = 0; i < gdalValues.size(); ++i )
+      {
+        QVERIFY2( std::fabs( gdalValues[i] - nativeValues[i] ) <= tolerances.at( overview ),
+                  QStringLiteral( "band %1, overview %2, pixel %3: %4 != %5" ).arg( bandNo ).arg( overview ).arg( i ).arg( nativeValues[i] ).arg( gdalValues[i] ).toLocal8Bit().constData() );
+      }
+    }
+  }
+
+  GDALClose( gdalDataset );
+  GDALClose( nativeDataset );
+}
+
 void TestQgsRasterLayer::registry()
 {
   QString myTempPath = QDir::tempPath() + '/';
@@ -735,6 +958,66 @@ void TestQgsRasterLayer::multiBandColorRendererNoDataColor()
   mPngRasterLayer->dataProvider()->setNoDataValue( 3, -999 );
 }
 
+void TestQgsRasterLayer::multiBandColorRendererLookupTables()
+{
+  // compare the table based rendering of integer bands against a per pixel evaluation of the enhancements
+  QgsRasterDataProvider *provider = mpLandsatRasterLayer->dataProvider();
+  QgsMultiBandColorRenderer renderer( provider, 2, 3, 4 );
+  QgsContrastEnhancement *redEnhancement = new QgsContrastEnhancement( provider->dataType( 2 ) );
+  redEnhancement->setContrastEnhancementAlgorithm( QgsContrastEnhancement::StretchToMinimumMaximum );
+  redEnhancement->setMinimumValue( 100 );
+  redEnhancement->setMaximumValue( 150 );
+  renderer.setRedContrastEnhancement( redEnhancement );
+  QgsContrastEnhancement *greenEnhancement = new QgsContrastEnhancement( provider->dataType( 3 ) );
+  greenEnhancement->setContrastEnhancementAlgorithm( QgsContrastEnhancement::ClipToMinimumMaximum );
+  greenEnhancement->setMinimumValue( 110 );
+  greenEnhancement->setMaximumValue( 160 );
+  renderer.setGreenContrastEnhancement( greenEnhancement );
+  renderer.setOpacity( 0.6 );
+  renderer.setNodataColor( QColor( 255, 0, 255 ) );
+
+  const QgsRectangle extent = mpLandsatRasterLayer->extent();
+  const int width = 100;
+  const int height = 80;
+  std::unique_ptr< QgsRasterBlock > output( renderer.block( 1, extent, width, height ) );
+  QVERIFY( output );
+  QCOMPARE( output->dataType(), Qgis::ARGB32_Premultiplied );
+
+  std::unique_ptr< QgsRasterBlock > red( provider->block( 2, extent, width, height ) );
+  std::unique_ptr< QgsRasterBlock > green( provider->block( 3, extent, width, height ) );
+  std::unique_ptr< QgsRasterBlock > blue( provider->block( 4, extent, width, height ) );
+  QCOMPARE( red->dataType(), Qgis::Byte );
+
+  QgsContrastEnhancement redReference( *redEnhancement );
+  QgsContrastEnhancement greenReference( *greenEnhancement );
+  int notDisplayed = 0;
+  for ( qgssize i = 0; i < static_cast< qgssize >( width ) * height; ++i )
+  {
+    const double redVal = red->value( i );
+    const double greenVal = green->value( i );
+    const double blueVal = blue->value( i );
+    QRgb expected;
+    if ( red->isNoData( i ) || green->isNoData( i ) || blue->isNoData( i ) )
+    {
+      expected = renderer.nodataColor().rgba();
+    }
+    else if ( !redReference.isValueInDisplayableRange( redVal ) || !greenReference.isValueInDisplayableRange( greenVal ) )
+    {
+      expected = renderer.nodataColor().rgba();
+      notDisplayed++;
+    }
+    else
+    {
+      const double redEnhanced = redReference.enhanceContrast( redVal );
+      const double greenEnhanced = greenReference.enhanceContrast( greenVal );
+      expected = qRgba( 0.6 * redEnhanced, 0.6 * greenEnhanced, 0.6 * blueVal, 0.6 * 255 );
+    }
+    QCOMPARE( output->color( i ), expected );
+  }
+  // make sure the clipped green values were actually exercised
+  QVERIFY( notDisplayed > 0 );
+}
+
 void TestQgsRasterLayer::palettedRendererNoData()
 {
   const QString rasterFileName = mTestDataDir + "raster/with_color_table.tif";
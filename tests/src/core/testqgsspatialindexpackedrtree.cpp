@@ -0,0 +1,282 @@
+/***************************************************************************
+     testqgsspatialindexpackedrtree.cpp
+     ----------------------------------
+    Date                 : October 2021
+    Copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <qgsapplication.h>
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgsspatialindexpackedrtree.h"
+#include "qgsspatialindexsidecar.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+#include "qgsspatialindexpackedrtree_p.h"
+
+static QgsFeature _rectFeature( QgsFeatureId id, double x, double y, double size )
+{
+  QgsFeature f( id );
+  f.setGeometry( QgsGeometry::fromRect( QgsRectangle( x, y, x + size, y + size ) ) );
+  return f;
+}
+
+static QList<QgsFeature> _gridFeatures()
+{
+  // 100 x 100 grid of 0.5 sized squares, with ids numbered row by row
+  QList<QgsFeature> feats;
+  QgsFeatureId id = 1;
+  for ( int row = 0; row < 100; ++row )
+  {
+    for ( int col = 0; col < 100; ++col )
+    {
+      feats << _rectFeature( id++, col, row, 0.5 );
+    }
+  }
+  return feats;
+}
+
+class TestQgsSpatialIndexPackedRTree : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
+    }
+
+    void testEmpty()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+      QCOMPARE( index.size(), 0ULL );
+      QVERIFY( index.intersects( QgsRectangle( -100, -100, 100, 100 ) ).isEmpty() );
+      QVERIFY( index.nearestNeighbor( QgsPointXY( 0, 0 ), 3 ).isEmpty() );
+    }
+
+    void testHilbert()
+    {
+      // first order curve visits the quadrants in the order lower left, upper left, upper right, lower right
+      QVERIFY( QgsPackedHilbertRTree::hilbert( 0, 0 ) < QgsPackedHilbertRTree::hilbert( 0, 0xFFFF ) );
+      QVERIFY( QgsPackedHilbertRTree::hilbert( 0, 0xFFFF ) < QgsPackedHilbertRTree::hilbert( 0xFFFF, 0xFFFF ) );
+      QVERIFY( QgsPackedHilbertRTree::hilbert( 0xFFFF, 0xFFFF ) < QgsPackedHilbertRTree::hilbert( 0xFFFF, 0 ) );
+    }
+
+    void testIntersects()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+      const QList<QgsFeature> features = _gridFeatures();
+      for ( QgsFeature f : features )
+        vl->dataProvider()->addFeature( f );
+
+      // a feature without geometry should be skipped
+      QgsFeature noGeom( 100000 );
+      vl->dataProvider()->addFeature( noGeom );
+
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+      QCOMPARE( index.size(), 10000ULL );
+
+      QList<QgsFeatureId> ids = index.intersects( QgsRectangle( 9.9, 19.9, 11.1, 20.1 ) );
+      std::sort( ids.begin(), ids.end() );
+      QCOMPARE( ids, QList<QgsFeatureId>() << 2011 << 2012 );
+
+      ids = index.intersects( QgsRectangle( 10.6, 20.6, 10.9, 20.9 ) );
+      QVERIFY( ids.isEmpty() );
+
+      ids = index.intersects( QgsRectangle( -10, -10, 1000, 1000 ) );
+      QCOMPARE( ids.size(), 10000 );
+
+      // compare against brute force results
+      const QgsRectangle search( 33.2, 47.7, 58.3, 52.1 );
+      QList<QgsFeatureId> expected;
+      for ( const QgsFeature &f : features )
+      {
+        if ( f.geometry().boundingBox().intersects( search ) )
+          expected << f.id();
+      }
+      ids = index.intersects( search );
+      std::sort( ids.begin(), ids.end() );
+      QCOMPARE( ids, expected );
+    }
+
+    void testIntersectsVisitor()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+      for ( QgsFeature f : _gridFeatures() )
+        vl->dataProvider()->addFeature( f );
+
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+
+      int visited = 0;
+      QgsFeatureId visitedId = FID_NULL;
+      QgsRectangle visitedBounds;
+      index.intersects( QgsRectangle( 9.9, 19.9, 10.1, 20.1 ), [&visited, &visitedId, &visitedBounds]( QgsFeatureId id, const QgsRectangle & bounds )
+      {
+        visited++;
+        visitedId = id;
+        visitedBounds = bounds;
+        return true;
+      } );
+      QCOMPARE( visited, 1 );
+      QCOMPARE( visitedId, 2011LL );
+      QCOMPARE( visitedBounds, QgsRectangle( 10, 20, 10.5, 20.5 ) );
+
+      // early termination
+      visited = 0;
+      index.intersects( QgsRectangle( -10, -10, 1000, 1000 ), [&visited]( QgsFeatureId, const QgsRectangle & )
+      {
+        visited++;
+        return visited < 5;
+      } );
+      QCOMPARE( visited, 5 );
+    }
+
+    void testNearestNeighbor()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+      for ( QgsFeature f : _gridFeatures() )
+        vl->dataProvider()->addFeature( f );
+
+      QgsSpatialIndexPackedRTree index( *vl->dataProvider() );
+
+      QList<QgsFeatureId> ids = index.nearestNeighbor( QgsPointXY( 10.2, 20.2 ), 1 );
+      QCOMPARE( ids, QList<QgsFeatureId>() << 2011 );
+
+      ids = index.nearestNeighbor( QgsPointXY( 10.25, 20.9 ), 2 );
+      QCOMPARE( ids, QList<QgsFeatureId>() << 2111 << 2011 );
+
+      ids = index.nearestNeighbor( QgsPointXY( -5, -5 ), 3, 1 );
+      QVERIFY( ids.isEmpty() );
+
+      QList< double > distances;
+      index.nearestNeighbor( QgsPointXY( -3, 0.25 ), [&distances]( QgsFeatureId, double distance )
+      {
+        distances << distance;
+        return distances.size() < 3;
+      } );
+      QCOMPARE( distances.size(), 3 );
+      QGSCOMPARENEAR( distances.at( 0 ), 3, 0.000001 );
+      QGSCOMPARENEAR( distances.at( 1 ), std::sqrt( 9 + 0.75 * 0.75 ), 0.000001 );
+      QGSCOMPARENEAR( distances.at( 2 ), std::sqrt( 9 + 1.75 * 1.75 ), 0.000001 );
+    }
+
+    void testCopy()
+    {
+      std::unique_ptr< QgsVectorLayer > vl = std::make_unique< QgsVectorLayer >( "Polygon", QString(), QStringLiteral( "memory" ) );
+      for ( QgsFeature f : _gridFeatures() )
+        vl->dataProvider()->addFeature( f );
+
+      std::unique_ptr< QgsSpatialIndexPackedRTree > index( new QgsSpatialIndexPackedRTree( *vl->dataProvider() ) );
+
+      // create copy of the index
+      std::unique_ptr< QgsSpatialIndexPackedRTree > indexCopy( new QgsSpatialIndexPackedRTree( *index ) );
+
+      QVERIFY( index->d == indexCopy->d );
+      QVERIFY( index->d->ref == 2 );
+
+      index.reset();
+
+      // test that copied index still works
+      QCOMPARE( indexCopy->intersects( QgsRectangle( 10.2, 20.2, 10.3, 20.3 ) ), QList<QgsFeatureId>() << 2011 );
+      QVERIFY( indexCopy->d->ref == 1 );
+    }
+
+    void testSidecar()
+    {
+      QTemporaryDir dir;
+      const QString sourcePath = dir.filePath( QStringLiteral( "source.geojson" ) );
+      QFile source( sourcePath );
+      QVERIFY( source.open( QIODevice::WriteOnly ) );
+      source.write( "xxxx" );
+      source.close();
+
+      QVERIFY( !QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "layer" ) ) );
+      QVERIFY( !QgsSpatialIndexSidecar::load( sourcePath, QStringLiteral( "layer" ) ) );
+
+      QVector< QPair< QgsFeatureId, QgsRectangle > > entries;
+      for ( const QgsFeature &f : _gridFeatures() )
+        entries << qMakePair( f.id(), f.geometry().boundingBox() );
+      QVERIFY( QgsSpatialIndexSidecar::write( sourcePath, QStringLiteral( "layer" ), entries ) );
+      QVERIFY( QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "layer" ) ) );
+      // sidecars are specific to a layer
+      QVERIFY( !QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "other" ) ) );
+
+      std::unique_ptr< QgsSpatialIndexPackedRTree > index = QgsSpatialIndexSidecar::load( sourcePath, QStringLiteral( "layer" ) );
+      QVERIFY( index );
+      QCOMPARE( index->size(), 10000ULL );
+      QList<QgsFeatureId> ids = index->intersects( QgsRectangle( 9.9, 19.9, 11.1, 20.1 ) );
+      std::sort( ids.begin(), ids.end() );
+      QCOMPARE( ids, QList<QgsFeatureId>() << 2011 << 2012 );
+
+      // modifying the source must invalidate the sidecar
+      QVERIFY( source.open( QIODevice::Append ) );
+      source.write( "yy" );
+      source.close();
+      QVERIFY( !QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "layer" ) ) );
+      QVERIFY( !QgsSpatialIndexSidecar::load( sourcePath, QStringLiteral( "layer" ) ) );
+
+      // so must edits which are only written to a SQLite write-ahead log
+      QVERIFY( QgsSpatialIndexSidecar::write( sourcePath, QStringLiteral( "layer" ), entries ) );
+      QVERIFY( QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "layer" ) ) );
+      QFile wal( sourcePath + QStringLiteral( "-wal" ) );
+      QVERIFY( wal.open( QIODevice::WriteOnly ) );
+      wal.write( "wal" );
+      wal.close();
+      QVERIFY( !QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "layer" ) ) );
+      QVERIFY( QgsSpatialIndexSidecar::write( sourcePath, QStringLiteral( "layer" ), entries ) );
+      QVERIFY( QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "layer" ) ) );
+      QVERIFY( wal.open( QIODevice::Append ) );
+      wal.write( "more" );
+      wal.close();
+      QVERIFY( !QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "layer" ) ) );
+
+      // the least recently used sidecars are evicted to bound the size of the cache folder
+      QVERIFY( QgsSpatialIndexSidecar::write( sourcePath, QStringLiteral( "layer" ), entries ) );
+      QVERIFY( QgsSpatialIndexSidecar::write( sourcePath, QStringLiteral( "other" ), entries ) );
+      const QString layerSidecar = QgsSpatialIndexSidecar::sidecarPath( sourcePath, QStringLiteral( "layer" ) );
+      const QString otherSidecar = QgsSpatialIndexSidecar::sidecarPath( sourcePath, QStringLiteral( "other" ) );
+      QFile other( otherSidecar );
+      QVERIFY( other.open( QIODevice::ReadWrite ) );
+      QVERIFY( other.setFileTime( QDateTime::currentDateTime().addDays( -1 ), QFileDevice::FileModificationTime ) );
+      other.close();
+      // reading a sidecar marks it as used
+      QVERIFY( QgsSpatialIndexSidecar::isValid( sourcePath, QStringLiteral( "layer" ) ) );
+      QVERIFY( QFileInfo( layerSidecar ).lastModified() > QFileInfo( otherSidecar ).lastModified() );
+      QFile layer( layerSidecar );
+      QVERIFY( layer.open( QIODevice::ReadWrite ) );
+      QVERIFY( layer.setFileTime( QDateTime::currentDateTime().addDays( 1 ), QFileDevice::FileModificationTime ) );
+      layer.close();
+      QgsSpatialIndexSidecar::evictLeastRecentlyUsed( QFileInfo( layerSidecar ).size() );
+      QVERIFY( QFile::exists( layerSidecar ) );
+      QVERIFY( !QFile::exists( otherSidecar ) );
+
+      QVERIFY( QgsSpatialIndexSidecar::remove( sourcePath, QStringLiteral( "layer" ) ) );
+      QVERIFY( !QFile::exists( QgsSpatialIndexSidecar::sidecarPath( sourcePath, QStringLiteral( "layer" ) ) ) );
+    }
+
+};
+
+QGSTEST_MAIN( TestQgsSpatialIndexPackedRTree )
+
+#include "testqgsspatialindexpackedrtree.moc"
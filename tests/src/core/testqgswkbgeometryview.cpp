@@ -0,0 +1,151 @@
+/***************************************************************************
+     testqgswkbgeometryview.cpp
+     --------------------------
+    Date                 : October 2021
+    Copyright            : (C) 2021 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgswkbgeometryview.h"
+
+class TestQgsWkbGeometryView : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void initTestCase()
+    {
+      QgsApplication::init();
+      QgsApplication::initQgis();
+    }
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
+    }
+
+    void testNull()
+    {
+      QgsWkbGeometryView view;
+      QVERIFY( view.isNull() );
+      QCOMPARE( view.wkbType(), QgsWkbTypes::Unknown );
+      QVERIFY( view.boundingBox().isNull() );
+      QVERIFY( !view.boundingBoxIntersects( QgsRectangle( -10, -10, 10, 10 ) ) );
+      QVERIFY( view.geometry().isNull() );
+      QVERIFY( view.asWkb().isEmpty() );
+    }
+
+    void testInvalid()
+    {
+      QgsWkbGeometryView view( QByteArray( "xx" ) );
+      QVERIFY( !view.isNull() );
+      QCOMPARE( view.wkbType(), QgsWkbTypes::Unknown );
+      QVERIFY( view.boundingBox().isNull() );
+      QVERIFY( !view.boundingBoxIntersects( QgsRectangle( -10, -10, 10, 10 ) ) );
+    }
+
+    void testType_data()
+    {
+      QTest::addColumn<QString>( "wkt" );
+      QTest::addColumn<int>( "type" );
+
+      QTest::newRow( "point" ) << QStringLiteral( "Point (1 2)" ) << static_cast< int >( QgsWkbTypes::Point );
+      QTest::newRow( "pointz" ) << QStringLiteral( "PointZ (1 2 3)" ) << static_cast< int >( QgsWkbTypes::PointZ );
+      QTest::newRow( "linestringm" ) << QStringLiteral( "LineStringM (1 2 3, 4 5 6)" ) << static_cast< int >( QgsWkbTypes::LineStringM );
+      QTest::newRow( "multipolygonzm" ) << QStringLiteral( "MultiPolygonZM (((0 0 1 2, 1 0 1 2, 1 1 1 2, 0 0 1 2)))" ) << static_cast< int >( QgsWkbTypes::MultiPolygonZM );
+      QTest::newRow( "circularstring" ) << QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) << static_cast< int >( QgsWkbTypes::CircularString );
+    }
+
+    void testType()
+    {
+      QFETCH( QString, wkt );
+      QFETCH( int, type );
+
+      const QgsWkbGeometryView view( QgsGeometry::fromWkt( wkt ).asWkb() );
+      QCOMPARE( static_cast< int >( view.wkbType() ), type );
+      QVERIFY( !view.isMaterialized() );
+    }
+
+    void testBoundingBox_data()
+    {
+      QTest::addColumn<QString>( "wkt" );
+      QTest::addColumn<bool>( "requiresMaterialization" );
+
+      QTest::newRow( "point" ) << QStringLiteral( "Point (1 2)" ) << false;
+      QTest::newRow( "origin" ) << QStringLiteral( "Point (0 0)" ) << false;
+      QTest::newRow( "pointzm" ) << QStringLiteral( "PointZM (1 2 3 4)" ) << false;
+      QTest::newRow( "linestring" ) << QStringLiteral( "LineString (1 2, -3 4, 5 -6)" ) << false;
+      QTest::newRow( "linestringz" ) << QStringLiteral( "LineStringZ (1 2 100, -3 4 -100, 5 -6 50)" ) << false;
+      QTest::newRow( "polygon" ) << QStringLiteral( "Polygon ((0 0, 10 0, 10 5, 0 5, 0 0),(1 1, 2 1, 2 2, 1 1))" ) << false;
+      QTest::newRow( "triangle" ) << QStringLiteral( "Triangle ((0 0, 10 0, 10 5, 0 0))" ) << false;
+      QTest::newRow( "multipoint" ) << QStringLiteral( "MultiPoint ((1 2),(-3 7))" ) << false;
+      QTest::newRow( "multilinestringm" ) << QStringLiteral( "MultiLineStringM ((1 2 3, 4 5 6),(-10 -20 1, -5 -6 2))" ) << false;
+      QTest::newRow( "multipolygon" ) << QStringLiteral( "MultiPolygon (((0 0, 1 0, 1 1, 0 0)),((10 10, 11 10, 11 11, 10 10)))" ) << false;
+      QTest::newRow( "collection" ) << QStringLiteral( "GeometryCollection (Point (100 200), LineString (1 2, 3 4))" ) << false;
+      QTest::newRow( "circularstring" ) << QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) << true;
+      QTest::newRow( "compoundcurve" ) << QStringLiteral( "CompoundCurve ((0 0, 1 1),CircularString (1 1, 2 2, 3 1))" ) << true;
+      QTest::newRow( "curved collection" ) << QStringLiteral( "GeometryCollection (Point (100 200), CircularString (0 0, 1 1, 2 0))" ) << true;
+    }
+
+    void testBoundingBox()
+    {
+      QFETCH( QString, wkt );
+      QFETCH( bool, requiresMaterialization );
+
+      const QgsGeometry geom = QgsGeometry::fromWkt( wkt );
+      QVERIFY( !geom.isNull() );
+
+      const QgsWkbGeometryView view( geom.asWkb() );
+      const QgsRectangle bounds = view.boundingBox();
+      QCOMPARE( bounds.toString( 6 ), geom.boundingBox().toString( 6 ) );
+      QCOMPARE( view.isMaterialized(), requiresMaterialization );
+
+      QCOMPARE( view.boundingBoxIntersects( QgsRectangle( -1000, -1000, 1000, 1000 ) ), true );
+      QCOMPARE( view.boundingBoxIntersects( QgsRectangle( 1000, 1000, 2000, 2000 ) ), false );
+      QCOMPARE( view.boundingBoxIntersects( bounds ), geom.boundingBoxIntersects( bounds ) );
+    }
+
+    void testEmpty()
+    {
+      const QgsWkbGeometryView view( QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon EMPTY" ) ).asWkb() );
+      QCOMPARE( view.wkbType(), QgsWkbTypes::MultiPolygon );
+      QVERIFY( !view.boundingBoxIntersects( QgsRectangle( -1000, -1000, 1000, 1000 ) ) );
+      QVERIFY( !view.isMaterialized() );
+    }
+
+    void testAsWkbIsShared()
+    {
+      const QByteArray wkb = QgsGeometry::fromWkt( QStringLiteral( "LineString (1 2, 3 4)" ) ).asWkb();
+      const QgsWkbGeometryView view( wkb );
+      QCOMPARE( view.asWkb().constData(), wkb.constData() );
+      QVERIFY( !view.isMaterialized() );
+    }
+
+    void testGeometry()
+    {
+      const QgsGeometry geom = QgsGeometry::fromWkt( QStringLiteral( "PolygonZ ((0 0 1, 10 0 2, 10 5 3, 0 0 1))" ) );
+      const QgsWkbGeometryView view( geom.asWkb() );
+      QVERIFY( !view.isMaterialized() );
+      QCOMPARE( view.geometry().asWkt(), geom.asWkt() );
+      QVERIFY( view.isMaterialized() );
+      // bounding box after materialization
+      QCOMPARE( view.boundingBox(), geom.boundingBox() );
+    }
+
+};
+
+QGSTEST_MAIN( TestQgsWkbGeometryView )
+
+#include "testqgswkbgeometryview.moc"
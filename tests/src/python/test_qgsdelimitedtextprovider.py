@@ -951,6 +951,38 @@ class TestQgsDelimitedTextProviderOther(unittest.TestCase):
         vl.dataProvider().createSpatialIndex()
         self.assertEqual(vl.hasSpatialIndex(), QgsFeatureSource.SpatialIndexPresent)
 
+    def testSpatialIndexSidecarRecordOffsets(self):
+        """Test spatial queries reading records through the offsets stored with the spatial index sidecar"""
+        tmpdir = tempfile.mkdtemp()
+        basetestfile = os.path.join(tmpdir, 'sidecar_offsets.csv')
+        # multibyte characters and CRLF line endings, so that byte offsets differ from character offsets,
+        # and enough records that the wanted ones are further apart than the reader reads ahead
+        names = ['ñandú {} {}'.format(i, 'é' * 40) for i in range(3000)]
+        with open(basetestfile, 'w', encoding='utf-8', newline='') as f:
+            f.write('id,x,y,name\r\n')
+            for i, name in enumerate(names):
+                f.write('{},{},{},"{}"\r\n'.format(i, i % 50, i // 50, name))
+
+        url = MyUrl.fromLocalFile(basetestfile)
+        url.addQueryItem("type", "csv")
+        url.addQueryItem("xField", "x")
+        url.addQueryItem("yField", "y")
+        url.addQueryItem("spatialIndex", "yes")
+
+        request = QgsFeatureRequest().setFilterRect(QgsRectangle(10.5, 10.5, 12.5, 50.5))
+        expected = sorted(i for i in range(3000) if i % 50 in (11, 12) and 11 <= i // 50 <= 50)
+
+        # the first layer writes the sidecars, the second one reads them
+        for _ in range(2):
+            vl = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+            self.assertTrue(vl.isValid())
+            self.assertEqual(vl.hasSpatialIndex(), QgsFeatureSource.SpatialIndexPresent)
+            features = sorted(vl.getFeatures(request), key=lambda f: f['id'])
+            self.assertEqual([f['id'] for f in features], expected)
+            self.assertEqual([f['name'] for f in features], [names[i] for i in expected])
+            self.assertEqual([f.id() for f in features], [i + 2 for i in expected])
+            del vl
+
     def testEncodeDecodeUri(self):
         registry = QgsProviderRegistry.instance()
 